@@ -0,0 +1,266 @@
+/**************************************************************
+	Batch Transform
+
+	Builds the transposed World (Model * View * Proj) and Model
+	matrices for a whole batch of objects at once, instead of one
+	XMMatrix multiply chain per draw.
+
+	Objects come in as SoA arrays of positions and Y rotations,
+	which is all the cubes ever use. Every object gets
+	Model = RotationY(angle) * Translation(position), the same as
+	the scalar DirectXMath code in the frame loop.
+
+	AVX2 does 8 objects per step, SSE does 4, and anything left
+	over (or a build without SSE) goes through the scalar path.
+**************************************************************/
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Positions and Y rotations (radians) of every object in the batch
+struct TransformSoA
+{
+	std::vector<float> PositionX;
+	std::vector<float> PositionY;
+	std::vector<float> PositionZ;
+	std::vector<float> RotationY;
+
+	void Resize(size_t count)
+	{
+		PositionX.resize(count);
+		PositionY.resize(count);
+		PositionZ.resize(count);
+		RotationY.resize(count);
+	}
+
+	size_t Size() const { return PositionX.size(); }
+};
+
+// Outputs are written to 'base + i * stride', so they can land directly in a
+// larger per-object struct (e.g. InstanceData). Pass nullptr to skip one.
+struct TransformOutput
+{
+	void* World;
+	size_t WorldStride;
+	void* Model;
+	size_t ModelStride;
+};
+
+namespace BatchTransformDetail
+{
+	inline DirectX::XMFLOAT4X4* At(void* base, size_t stride, size_t i)
+	{
+		return reinterpret_cast<DirectX::XMFLOAT4X4*>(reinterpret_cast<uint8_t*>(base) + i * stride);
+	}
+
+	// One object at a time, written out long hand so it matches the SIMD paths
+	inline void TransformScalar(const TransformSoA& in, size_t first, size_t last,
+		const DirectX::XMFLOAT4X4& vp, const TransformOutput& out)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			float s, c;
+			DirectX::XMScalarSinCos(&s, &c, in.RotationY[i]);
+			const float px = in.PositionX[i], py = in.PositionY[i], pz = in.PositionZ[i];
+
+			if (out.Model)
+			{
+				DirectX::XMFLOAT4X4* m = At(out.Model, out.ModelStride, i);
+				*m = DirectX::XMFLOAT4X4(
+					c,    0.0f, s,    px,
+					0.0f, 1.0f, 0.0f, py,
+					-s,   0.0f, c,    pz,
+					0.0f, 0.0f, 0.0f, 1.0f);
+			}
+
+			if (out.World)
+			{
+				// Row r of the transpose is column r of Model * ViewProj
+				DirectX::XMFLOAT4X4* w = At(out.World, out.WorldStride, i);
+				for (int r = 0; r < 4; r++)
+				{
+					w->m[r][0] = c * vp.m[0][r] - s * vp.m[2][r];
+					w->m[r][1] = vp.m[1][r];
+					w->m[r][2] = s * vp.m[0][r] + c * vp.m[2][r];
+					w->m[r][3] = px * vp.m[0][r] + py * vp.m[1][r] + pz * vp.m[2][r] + vp.m[3][r];
+				}
+			}
+		}
+	}
+
+#if defined(_XM_SSE_INTRINSICS_)
+	// a0..a3 each hold one matrix row for 4 objects, store them as one row per object
+	inline void StoreRows(__m128 a0, __m128 a1, __m128 a2, __m128 a3,
+		void* base, size_t stride, size_t first, int row)
+	{
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		_mm_storeu_ps(At(base, stride, first + 0)->m[row], a0);
+		_mm_storeu_ps(At(base, stride, first + 1)->m[row], a1);
+		_mm_storeu_ps(At(base, stride, first + 2)->m[row], a2);
+		_mm_storeu_ps(At(base, stride, first + 3)->m[row], a3);
+	}
+
+	inline void TransformSSE(const TransformSoA& in, size_t first,
+		const DirectX::XMFLOAT4X4& vp, const TransformOutput& out)
+	{
+		alignas(16) float sinA[4], cosA[4];
+		for (int k = 0; k < 4; k++)
+			DirectX::XMScalarSinCos(&sinA[k], &cosA[k], in.RotationY[first + k]);
+
+		const __m128 s = _mm_load_ps(sinA);
+		const __m128 c = _mm_load_ps(cosA);
+		const __m128 px = _mm_loadu_ps(&in.PositionX[first]);
+		const __m128 py = _mm_loadu_ps(&in.PositionY[first]);
+		const __m128 pz = _mm_loadu_ps(&in.PositionZ[first]);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		if (out.Model)
+		{
+			StoreRows(c, zero, s, px, out.Model, out.ModelStride, first, 0);
+			StoreRows(zero, one, zero, py, out.Model, out.ModelStride, first, 1);
+			StoreRows(_mm_sub_ps(zero, s), zero, c, pz, out.Model, out.ModelStride, first, 2);
+			StoreRows(zero, zero, zero, one, out.Model, out.ModelStride, first, 3);
+		}
+
+		if (out.World)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				const __m128 v0 = _mm_set1_ps(vp.m[0][r]);
+				const __m128 v1 = _mm_set1_ps(vp.m[1][r]);
+				const __m128 v2 = _mm_set1_ps(vp.m[2][r]);
+				const __m128 v3 = _mm_set1_ps(vp.m[3][r]);
+
+				const __m128 a0 = _mm_sub_ps(_mm_mul_ps(c, v0), _mm_mul_ps(s, v2));
+				const __m128 a2 = _mm_add_ps(_mm_mul_ps(s, v0), _mm_mul_ps(c, v2));
+				const __m128 a3 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, v0), _mm_mul_ps(py, v1)),
+					_mm_add_ps(_mm_mul_ps(pz, v2), v3));
+
+				StoreRows(a0, v1, a2, a3, out.World, out.WorldStride, first, r);
+			}
+		}
+	}
+#endif
+
+#if defined(__AVX2__)
+	// Same as StoreRows, but for 8 objects: each 128 bit half is transposed on its own
+	inline void StoreRows8(__m256 a0, __m256 a1, __m256 a2, __m256 a3,
+		void* base, size_t stride, size_t first, int row)
+	{
+		StoreRows(_mm256_castps256_ps128(a0), _mm256_castps256_ps128(a1),
+			_mm256_castps256_ps128(a2), _mm256_castps256_ps128(a3), base, stride, first, row);
+		StoreRows(_mm256_extractf128_ps(a0, 1), _mm256_extractf128_ps(a1, 1),
+			_mm256_extractf128_ps(a2, 1), _mm256_extractf128_ps(a3, 1), base, stride, first + 4, row);
+	}
+
+	inline void TransformAVX2(const TransformSoA& in, size_t first,
+		const DirectX::XMFLOAT4X4& vp, const TransformOutput& out)
+	{
+		alignas(32) float sinA[8], cosA[8];
+		for (int k = 0; k < 8; k++)
+			DirectX::XMScalarSinCos(&sinA[k], &cosA[k], in.RotationY[first + k]);
+
+		const __m256 s = _mm256_load_ps(sinA);
+		const __m256 c = _mm256_load_ps(cosA);
+		const __m256 px = _mm256_loadu_ps(&in.PositionX[first]);
+		const __m256 py = _mm256_loadu_ps(&in.PositionY[first]);
+		const __m256 pz = _mm256_loadu_ps(&in.PositionZ[first]);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		if (out.Model)
+		{
+			StoreRows8(c, zero, s, px, out.Model, out.ModelStride, first, 0);
+			StoreRows8(zero, one, zero, py, out.Model, out.ModelStride, first, 1);
+			StoreRows8(_mm256_sub_ps(zero, s), zero, c, pz, out.Model, out.ModelStride, first, 2);
+			StoreRows8(zero, zero, zero, one, out.Model, out.ModelStride, first, 3);
+		}
+
+		if (out.World)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				const __m256 v0 = _mm256_set1_ps(vp.m[0][r]);
+				const __m256 v1 = _mm256_set1_ps(vp.m[1][r]);
+				const __m256 v2 = _mm256_set1_ps(vp.m[2][r]);
+				const __m256 v3 = _mm256_set1_ps(vp.m[3][r]);
+
+				const __m256 a0 = _mm256_sub_ps(_mm256_mul_ps(c, v0), _mm256_mul_ps(s, v2));
+				const __m256 a2 = _mm256_add_ps(_mm256_mul_ps(s, v0), _mm256_mul_ps(c, v2));
+				const __m256 a3 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, v0), _mm256_mul_ps(py, v1)),
+					_mm256_add_ps(_mm256_mul_ps(pz, v2), v3));
+
+				StoreRows8(a0, v1, a2, a3, out.World, out.WorldStride, first, r);
+			}
+		}
+	}
+#endif
+}
+
+inline void BatchTransform(const TransformSoA& in, DirectX::FXMMATRIX viewProj, const TransformOutput& out)
+{
+	DirectX::XMFLOAT4X4 vp;
+	DirectX::XMStoreFloat4x4(&vp, viewProj);
+
+	const size_t count = in.Size();
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8)
+		BatchTransformDetail::TransformAVX2(in, i, vp, out);
+#endif
+#if defined(_XM_SSE_INTRINSICS_)
+	for (; i + 4 <= count; i += 4)
+		BatchTransformDetail::TransformSSE(in, i, vp, out);
+#endif
+
+	BatchTransformDetail::TransformScalar(in, i, count, vp, out);
+}
+
+// Checks every path against the plain DirectXMath version the frame loop used to
+// do per draw. Returns the largest difference found over all matrix elements.
+inline float VerifyBatchTransform(DirectX::FXMMATRIX viewProj)
+{
+	const size_t count = 19;	// Hits the AVX2, SSE and scalar tails
+	TransformSoA in;
+	in.Resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		in.PositionX[i] = 2.0f * cosf(0.3f * i);
+		in.PositionY[i] = 0.25f * i - 1.0f;
+		in.PositionZ[i] = 2.0f * sinf(0.3f * i);
+		in.RotationY[i] = 0.7f * i - 3.0f;
+	}
+
+	std::vector<DirectX::XMFLOAT4X4> world(count), model(count);
+	BatchTransform(in, viewProj, { world.data(), sizeof(DirectX::XMFLOAT4X4), model.data(), sizeof(DirectX::XMFLOAT4X4) });
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const DirectX::XMMATRIX m = DirectX::XMMatrixRotationY(in.RotationY[i]) *
+			DirectX::XMMatrixTranslation(in.PositionX[i], in.PositionY[i], in.PositionZ[i]);
+
+		DirectX::XMFLOAT4X4 expectedWorld, expectedModel;
+		DirectX::XMStoreFloat4x4(&expectedWorld, DirectX::XMMatrixTranspose(m * viewProj));
+		DirectX::XMStoreFloat4x4(&expectedModel, DirectX::XMMatrixTranspose(m));
+
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				maxError = (std::max)(maxError, fabsf(world[i].m[r][c] - expectedWorld.m[r][c]));
+				maxError = (std::max)(maxError, fabsf(model[i].m[r][c] - expectedModel.m[r][c]));
+			}
+		}
+	}
+
+	return maxError;
+}
@@ -0,0 +1,243 @@
+/**************************************************************
+	Replays an allocation trace against BuddyAllocator blocks the
+	way ResourceHeapAllocator lays them out: a pool of 64 MB
+	blocks per kind of heap, the first block with room gets the
+	allocation, a new block when none has, and trailing empty
+	blocks released down to one.
+
+	The trace is the first argument, allocations.trace by default,
+	which a headless run of the app writes on exit. Without one a
+	synthetic trace is replayed instead, the way a level streaming
+	textures in and out would allocate: 4 KB to 4 MB textures, a
+	random live one freed for every new one once a few hundred
+	are around. It goes through SaveAllocationTrace and back in,
+	like a recorded one.
+
+	Reports the latency of every allocate and free, and how much
+	of the heap memory was handed out at its peak: ranges rounded
+	up to a power of two (internal), and blocks that couldn't be
+	released because something small was left in them (external).
+**************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include "BuddyAllocator.h"
+
+namespace
+{
+	const uint64_t BlockSize = 64 * 1024 * 1024;	// HEAPBLOCKSIZE in WinMain
+	const uint64_t MinBlockSize = 4096;				// D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
+	const uint32_t PoolCount = 3;					// ResourceHeapAllocator::POOL_COUNT
+	const size_t MinimumOperations = 2000000;		// Short traces are replayed until there are this many
+
+	std::vector<AllocationTraceEntry> MakeSyntheticTrace()
+	{
+		std::vector<AllocationTraceEntry> trace;
+		std::vector<uint32_t> live;
+		std::srand(1);
+		for (uint32_t id = 0; id < 100000; id++)
+		{
+			if (live.size() >= 256)
+			{
+				const size_t freed = std::rand() % live.size();
+				trace.push_back({ AllocationTraceEntry::FREE, 1, live[freed], 0, 0 });
+				live[freed] = live.back();
+				live.pop_back();
+			}
+
+			trace.push_back({ AllocationTraceEntry::ALLOCATE, 1, id, MinBlockSize << (std::rand() % 11), MinBlockSize });
+			live.push_back(id);
+		}
+		return trace;
+	}
+
+	struct Placement
+	{
+		uint32_t Pool;
+		uint32_t Block;
+		uint64_t Offset;
+		uint64_t Size;
+		uint64_t RangeSize;
+	};
+
+	struct Stats
+	{
+		std::vector<double> AllocateNs;
+		std::vector<double> FreeNs;
+		uint32_t Failed;
+		uint32_t Unmatched;
+		uint64_t PeakHeap;
+		uint64_t RequestedAtPeak;
+		uint64_t RangesAtPeak;
+		uint64_t LargestFreeRange;
+	};
+
+	class Pools
+	{
+	public:
+		// False if it doesn't fit in a block at all, ResourceHeapAllocator makes those committed
+		bool Allocate(uint32_t pool, uint64_t size, uint64_t alignment, Placement* placement)
+		{
+			std::vector<BuddyAllocator>& blocks = m_blocks[pool];
+			if (std::max(size, alignment) > BlockSize / 2)
+				return false;
+
+			placement->Pool = pool;
+			placement->Size = size;
+			for (uint32_t block = 0; block < blocks.size(); block++)
+			{
+				const uint64_t offset = blocks[block].Allocate(size, alignment);
+				if (offset != BuddyAllocator::InvalidOffset)
+				{
+					placement->Block = block;
+					placement->Offset = offset;
+					placement->RangeSize = blocks[block].GetRangeSize(size, alignment);
+					return true;
+				}
+			}
+
+			blocks.emplace_back();
+			blocks.back().Reset(BlockSize, MinBlockSize);
+			placement->Block = static_cast<uint32_t>(blocks.size() - 1);
+			placement->Offset = blocks.back().Allocate(size, alignment);
+			placement->RangeSize = blocks.back().GetRangeSize(size, alignment);
+			return true;
+		}
+
+		void Free(const Placement& placement)
+		{
+			std::vector<BuddyAllocator>& blocks = m_blocks[placement.Pool];
+			blocks[placement.Block].Free(placement.Offset);
+			while (blocks.size() > 1 && blocks.back().IsEmpty() && blocks[blocks.size() - 2].IsEmpty())
+				blocks.pop_back();
+		}
+
+		uint64_t GetHeapSize() const
+		{
+			size_t blockCount = 0;
+			for (const std::vector<BuddyAllocator>& blocks : m_blocks)
+				blockCount += blocks.size();
+			return blockCount * BlockSize;
+		}
+
+		uint64_t GetLargestFreeRange() const
+		{
+			uint64_t largest = 0;
+			for (const std::vector<BuddyAllocator>& blocks : m_blocks)
+			{
+				for (const BuddyAllocator& block : blocks)
+					largest = std::max(largest, block.GetLargestFreeRange());
+			}
+			return largest;
+		}
+
+	private:
+		std::vector<BuddyAllocator> m_blocks[PoolCount];
+	};
+
+	void Replay(const std::vector<AllocationTraceEntry>& trace, Stats& stats)
+	{
+		Pools pools;
+		std::unordered_map<uint32_t, Placement> live;
+		uint64_t requested = 0, ranges = 0;
+		for (const AllocationTraceEntry& entry : trace)
+		{
+			if (entry.Operation == AllocationTraceEntry::ALLOCATE)
+			{
+				Placement placement;
+				const auto start = std::chrono::steady_clock::now();
+				const bool placed = pools.Allocate(entry.Pool % PoolCount, entry.Size, entry.Alignment, &placement);
+				stats.AllocateNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+				if (!placed)
+				{
+					stats.Failed++;
+					continue;
+				}
+
+				live[entry.Id] = placement;
+				requested += placement.Size;
+				ranges += placement.RangeSize;
+				if (pools.GetHeapSize() > stats.PeakHeap)
+				{
+					stats.PeakHeap = pools.GetHeapSize();
+					stats.RequestedAtPeak = requested;
+					stats.RangesAtPeak = ranges;
+				}
+			}
+			else
+			{
+				auto found = live.find(entry.Id);
+				if (found == live.end())
+				{
+					stats.Unmatched++;		// Its allocation was committed, or before the trace started
+					continue;
+				}
+
+				const auto start = std::chrono::steady_clock::now();
+				pools.Free(found->second);
+				stats.FreeNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+				requested -= found->second.Size;
+				ranges -= found->second.RangeSize;
+				live.erase(found);
+			}
+		}
+		stats.LargestFreeRange = pools.GetLargestFreeRange();
+	}
+
+	void PrintLatency(const char* name, std::vector<double>& ns)
+	{
+		if (ns.empty())
+			return;
+		std::sort(ns.begin(), ns.end());
+		double total = 0.0;
+		for (double time : ns)
+			total += time;
+		std::printf("%-9s %8zu: mean %6.1f ns, median %6.1f ns, 99%% %7.1f ns, max %9.1f ns\n", name, ns.size(), total / ns.size(),
+			ns[ns.size() / 2], ns[ns.size() * 99 / 100], ns.back());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* fileName = argc > 1 ? argv[1] : "allocations.trace";
+	std::vector<AllocationTraceEntry> trace;
+	if (!LoadAllocationTrace(fileName, trace) || trace.empty())
+	{
+		std::printf("No trace in %s, replaying a synthetic one\n", fileName);
+		const char* syntheticName = "synthetic.trace";
+		if (!SaveAllocationTrace(syntheticName, MakeSyntheticTrace()) || !LoadAllocationTrace(syntheticName, trace))
+		{
+			std::printf("Couldn't write %s\n", syntheticName);
+			return 1;
+		}
+		std::remove(syntheticName);
+	}
+
+	size_t allocations = 0;
+	for (const AllocationTraceEntry& entry : trace)
+		allocations += entry.Operation == AllocationTraceEntry::ALLOCATE;
+	std::printf("%zu allocations, %zu frees, %llu MB blocks\n", allocations, trace.size() - allocations, (unsigned long long)(BlockSize >> 20));
+
+	// Latencies from every pass, the memory figures are the same each time
+	Stats stats = {};
+	const size_t passes = std::max<size_t>(1, MinimumOperations / trace.size());
+	for (size_t pass = 0; pass < passes; pass++)
+		Replay(trace, stats);
+	stats.Failed /= passes;
+	stats.Unmatched /= passes;
+
+	PrintLatency("Allocate", stats.AllocateNs);
+	PrintLatency("Free", stats.FreeNs);
+	if (stats.PeakHeap)
+	{
+		std::printf("Peak %llu MB of heaps: %llu MB in ranges, %llu MB asked for. %.1f%% lost to rounding up, %.1f%% to blocks kept for what's left in them\n",
+			(unsigned long long)(stats.PeakHeap >> 20), (unsigned long long)(stats.RangesAtPeak >> 20), (unsigned long long)(stats.RequestedAtPeak >> 20),
+			100.0 * (stats.RangesAtPeak - stats.RequestedAtPeak) / stats.PeakHeap, 100.0 * (stats.PeakHeap - stats.RangesAtPeak) / stats.PeakHeap);
+	}
+	std::printf("%u too big for a block, %u frees without an allocation, largest free range at the end %llu KB\n", stats.Failed,
+		stats.Unmatched, (unsigned long long)(stats.LargestFreeRange >> 10));
+	return 0;
+}
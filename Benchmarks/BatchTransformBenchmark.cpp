@@ -0,0 +1,71 @@
+/**************************************************************
+	Batch transform throughput per path, in World and Model
+	matrices a second, for scene sizes from a few hundred cubes
+	to a million. Built once as is and once with -mavx2.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "BatchTransform.h"
+
+template <typename Path>
+static double MatricesPerSecond(size_t count, Path path)
+{
+	const size_t repeats = 20000000 / count;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t repeat = 0; repeat < repeats; repeat++)
+		path();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return 2.0 * count * repeats / seconds;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		std::printf("No AVX2 on this cpu\n");
+		return 0;
+	}
+#endif
+
+	const DirectX::XMMATRIX viewProj = DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(0.0f, 2.5f, -4.33f, 1.0f),
+		DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f))
+		* DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(45.0f), 4.0f / 3.0f, 0.1f, 300.0f);
+	DirectX::XMFLOAT4X4 vp;
+	DirectX::XMStoreFloat4x4(&vp, viewProj);
+
+	for (size_t count : { 256, 16384, 1048576 })
+	{
+		TransformSoA in;
+		in.Resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			in.PositionX[i] = 0.01f * i;
+			in.PositionY[i] = 0.0f;
+			in.PositionZ[i] = 0.02f * i;
+			in.RotationY[i] = 0.001f * i;
+		}
+		std::vector<DirectX::XMFLOAT4X4> world(count), model(count);
+		const TransformOutput out = { world.data(), sizeof(DirectX::XMFLOAT4X4), model.data(), sizeof(DirectX::XMFLOAT4X4) };
+
+		std::printf("Batch transform, %zu objects:", count);
+		std::printf(" scalar %.1f M matrices/s", MatricesPerSecond(count, [&] { BatchTransformDetail::TransformScalar(in, 0, count, vp, out); }) / 1e6);
+#if defined(_XM_SSE_INTRINSICS_)
+		std::printf(", SSE %.1f M", MatricesPerSecond(count, [&]
+		{
+			for (size_t i = 0; i + 4 <= count; i += 4)
+				BatchTransformDetail::TransformSSE(in, i, vp, out);
+		}) / 1e6);
+#endif
+#if defined(__AVX2__)
+		std::printf(", AVX2 %.1f M", MatricesPerSecond(count, [&]
+		{
+			for (size_t i = 0; i + 8 <= count; i += 8)
+				BatchTransformDetail::TransformAVX2(in, i, vp, out);
+		}) / 1e6);
+#endif
+		std::printf("\n");
+	}
+	return 0;
+}
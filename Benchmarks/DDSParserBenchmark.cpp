@@ -0,0 +1,96 @@
+/**************************************************************
+	Parse throughput: ParseDDSHeader alone and the whole of
+	ParseDDSTexture (header, desc and the subresource table) over
+	the repo's .dds files and synthetic ones with long mip chains
+	and big arrays, where the subresource loop dominates. Files
+	are in memory, so this is only the parser.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "Tests/SyntheticDDS.h"
+
+using namespace DirectX;
+
+static bool ReadFile(const char* fileName, std::vector<uint8_t>& buffer)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	buffer.resize(size > 0 ? size : 0);
+	const bool read = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	fclose(file);
+	return read;
+}
+
+static void Benchmark(const std::string& name, const std::vector<uint8_t>& file)
+{
+	// Fewer repeats the more subresources there are to lay out
+	DDSTextureDesc desc = {};
+	std::vector<DDSSubresource> subresources;
+	if (ParseDDSTexture(file.data(), file.size(), 0, desc, subresources) != DDS_PARSE_OK)
+	{
+		std::printf("%s: rejected\n", name.c_str());
+		return;
+	}
+	const size_t repeats = 4000000 / (subresources.size() + 16);
+
+	size_t accepted = 0;
+	const auto headerStart = std::chrono::steady_clock::now();
+	for (size_t repeat = 0; repeat < repeats; repeat++)
+	{
+		const DDS_HEADER* header = nullptr;
+		const uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+		accepted += ParseDDSHeader(file.data(), file.size(), &header, &bitData, &bitSize) == DDS_PARSE_OK;
+	}
+	const double headerNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - headerStart).count() / repeats;
+
+	const auto textureStart = std::chrono::steady_clock::now();
+	for (size_t repeat = 0; repeat < repeats; repeat++)
+		accepted += ParseDDSTexture(file.data(), file.size(), 0, desc, subresources) == DDS_PARSE_OK;
+	const double textureNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - textureStart).count() / repeats;
+
+	if (accepted != repeats * 2)
+	{
+		std::printf("%s: rejected part way\n", name.c_str());
+		return;
+	}
+	std::printf("%s, %zu subresources: header %.1f ns, texture %.1f ns (%.0f textures/s, %.1f ns/subresource)\n", name.c_str(),
+		subresources.size(), headerNs, textureNs, 1e9 / textureNs, textureNs / subresources.size());
+}
+
+int main()
+{
+	for (const char* fileName : { "bricks.dds", "checkboard.dds" })
+	{
+		std::vector<uint8_t> file;
+		if (!ReadFile(fileName, file))
+		{
+			std::printf("Couldn't read %s\n", fileName);
+			return 1;
+		}
+		Benchmark(fileName, file);
+	}
+
+	SyntheticDDSDesc desc;
+	desc.Width = 4096; desc.Height = 4096; desc.MipCount = 13; desc.Format = DXGI_FORMAT_BC1_UNORM; desc.DX10Header = false;
+	Benchmark("4096x4096 BC1, legacy header", MakeSyntheticDDS(desc));
+
+	desc = SyntheticDDSDesc();
+	desc.Width = 256; desc.Height = 256; desc.MipCount = 9; desc.Format = DXGI_FORMAT_BC7_UNORM; desc.CubeMap = true; desc.ArraySize = 16;
+	Benchmark("16 256x256 BC7 cubes", MakeSyntheticDDS(desc));
+
+	desc = SyntheticDDSDesc();
+	desc.Dimension = DDS_DIMENSION_TEXTURE3D; desc.Width = 128; desc.Height = 128; desc.Depth = 128; desc.MipCount = 8;
+	Benchmark("128^3 RGBA8 volume", MakeSyntheticDDS(desc));
+
+	desc = SyntheticDDSDesc();
+	desc.Dimension = DDS_DIMENSION_TEXTURE1D; desc.Width = 256; desc.ArraySize = 2048; desc.MipCount = 9;
+	Benchmark("2048 slice 1D array", MakeSyntheticDDS(desc));
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/**************************************************************
+	Descriptor free list allocate/free rates on 1 to N threads,
+	N being the first argument or the core count, against a
+	std::mutex around a vector of free indices, which is what
+	it replaces. Two patterns per thread count:
+
+	pairs: allocate and free straight away, like a texture that
+	fails to load. Worst case for contention on the head.
+
+	bursts: 64 allocations then 64 frees, like a level's worth of
+	textures streaming in and out.
+**************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "DescriptorFreeList.h"
+
+namespace
+{
+	const uint32_t Capacity = 1000000;
+	const unsigned int OperationsPerThread = 2000000;
+	const unsigned int BurstSize = 64;
+
+	class MutexFreeList
+	{
+	public:
+		explicit MutexFreeList(uint32_t capacity)
+		{
+			for (uint32_t i = capacity; i > 0; i--)
+				m_free.push_back(i - 1);
+		}
+
+		uint32_t Allocate()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_free.empty())
+				return DescriptorFreeList::InvalidIndex;
+			const uint32_t index = m_free.back();
+			m_free.pop_back();
+			return index;
+		}
+
+		void Free(uint32_t index)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_free.push_back(index);
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<uint32_t> m_free;
+	};
+
+	// Millions of allocate+free pairs per second over all threads
+	template <typename List>
+	double Run(List& list, unsigned int threadCount, unsigned int burst)
+	{
+		std::atomic<unsigned int> ready(0);
+		std::atomic<bool> go(false);
+		std::atomic<unsigned int> failures(0);
+		std::vector<std::thread> threads;
+		for (unsigned int thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&]()
+			{
+				std::vector<uint32_t> held(burst);
+				ready++;
+				while (!go)
+					std::this_thread::yield();
+
+				for (unsigned int op = 0; op < OperationsPerThread; op += burst)
+				{
+					for (uint32_t& index : held)
+						failures += (index = list.Allocate()) == DescriptorFreeList::InvalidIndex;
+					for (uint32_t index : held)
+						list.Free(index);
+				}
+			});
+		}
+
+		while (ready < threadCount)
+			std::this_thread::yield();
+		const auto start = std::chrono::steady_clock::now();
+		go = true;
+		for (std::thread& thread : threads)
+			thread.join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (failures)
+			std::printf("%u allocations failed\n", failures.load());
+		return double(OperationsPerThread) * threadCount / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned int maxThreads = std::max(1u, argc > 1 ? (unsigned int)atoi(argv[1]) : std::thread::hardware_concurrency());
+
+	std::printf("%u allocate/free pairs per thread, M pairs/s\n", OperationsPerThread);
+	for (unsigned int burst : { 1u, BurstSize })
+	{
+		for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount++)
+		{
+			DescriptorFreeList lockFree(Capacity);
+			MutexFreeList locked(Capacity);
+			const double lockFreeRate = Run(lockFree, threadCount, burst);
+			const double lockedRate = Run(locked, threadCount, burst);
+			std::printf("%-6s %2u threads: free list %7.1f, mutex %7.1f, %.2fx\n", burst == 1 ? "pairs" : "bursts", threadCount,
+				lockFreeRate, lockedRate, lockFreeRate / lockedRate);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,186 @@
+/**************************************************************
+	What capturing a frame costs, per draw binding: the one draw
+	per cube path recorded through RecordBoundDraws into a null
+	list three times, without a writer (just the list), with one
+	(the list plus the encoding) and into a CaptureWriter alone
+	(the encoding). Then the captured stream is replayed through
+	D3D12ReplayBackend, root CBVs and root SRVs uploaded again.
+
+	The null lists only count, so the writer numbers are the
+	whole cost of -nocapture being off. Draw count is the first
+	argument, 100000 by default.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <wrl.h>
+#include "d3dx12.h"
+#include "CaptureD3D12.h"
+#include "DrawBinding.h"
+#include "NullD3D12.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	const unsigned int FrameCount = 20;
+	const unsigned int MaterialCount = 2;
+
+	// Never dereferenced, the null lists and the replay only pass them along
+	int FakePipelineStates[MaterialCount];
+
+	typedef std::chrono::steady_clock Clock;
+
+	double Milliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// A PSO switch whenever the material changes, like WinMain's chunks
+	template <typename CommandList>
+	void RecordFrame(CommandList& list, const DrawBindingFrame& frame)
+	{
+		int* pipelineState = nullptr;
+		RecordBoundDraws(list, frame, 0, frame.DrawCount, 36, [&](uint32_t draw)
+		{
+			if (&FakePipelineStates[draw % MaterialCount] != pipelineState)
+			{
+				pipelineState = &FakePipelineStates[draw % MaterialCount];
+				list.SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(pipelineState));
+			}
+		});
+	}
+
+	// CaptureWriter with CapturedCommandList's method names, the encoding without a list
+	struct WriterOnly
+	{
+		CaptureWriter& Writer;
+		const CaptureObjectTable& Objects;
+
+		void SetPipelineState(ID3D12PipelineState* pipelineState) { Writer.SetPipelineState(Objects.Find(pipelineState)); }
+		void SetGraphicsRoot32BitConstants(UINT parameter, UINT count, const void* data, UINT offset)
+		{
+			Writer.SetRootConstants(static_cast<uint8_t>(parameter), offset, data, count);
+		}
+		void SetGraphicsRootConstantBufferView(UINT parameter, UINT64, const void* data, UINT size)
+		{
+			Writer.SetRootConstantBuffer(static_cast<uint8_t>(parameter), data, size);
+		}
+		void SetGraphicsRootShaderResourceView(UINT parameter, UINT64, const void* data, UINT size)
+		{
+			Writer.SetRootShaderResource(static_cast<uint8_t>(parameter), data, size);
+		}
+		void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT firstIndex, INT baseVertex, UINT firstInstance)
+		{
+			Writer.DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int drawCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 0;
+	if (drawCount == 0)
+		drawCount = 100000;
+
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+	ComPtr<ID3D12CommandAllocator> allocator;
+	ComPtr<ID3D12GraphicsCommandList> list;
+	if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))
+		|| FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&list))))
+		return 1;
+
+	// Room for a frame of root CBVs and the structured buffer, the replay's uploads go here too
+	UploadRingBuffer constants, shaderResources;
+	if (FAILED(constants.Init(device.Get(), UINT64(drawCount) * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT))
+		|| FAILED(shaderResources.Init(device.Get(), UINT64(drawCount) * sizeof(InstanceData) + 256)))
+		return 1;
+
+	CaptureObjectTable objects;
+	for (int& pipelineState : FakePipelineStates)
+		objects.Register(&pipelineState);
+
+	std::vector<InstanceData> draws(drawCount);
+	for (unsigned int draw = 0; draw < drawCount; draw++)
+	{
+		draws[draw].Color = DirectX::XMFLOAT4(1.0f, 0.5f, 0.25f, 1.0f);
+		draws[draw].Model._41 = float(draw);
+		draws[draw].Material = draw % MaterialCount;
+	}
+	std::vector<uint64_t> drawAddresses(drawCount);
+
+	// Nothing executes on the null list, every frame's uploads are free as soon as it's done
+	UINT64 fenceValue = 0;
+	auto FinishFrame = [&]()
+	{
+		fenceValue++;
+		for (UploadRingBuffer* ring : { &constants, &shaderResources })
+		{
+			ring->FinishFrame(fenceValue);
+			ring->ReleaseCompletedFrames(fenceValue);
+		}
+	};
+
+	std::printf("%u draws per frame, %u frames\n", drawCount, FrameCount);
+	for (unsigned int binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+	{
+		DrawBindingFrame frame = { DrawBinding(binding), draws.data(), drawCount, nullptr, 0 };
+		UploadRingBuffer& ring = frame.Binding == DRAW_BINDING_ROOT_CBV ? constants : shaderResources;
+		if (!UploadDraws(frame, drawAddresses.data(), [&](UINT64 size, UINT64 alignment, D3D12_GPU_VIRTUAL_ADDRESS* address)
+			{
+				return ring.Allocate(size, alignment, address);
+			}))
+			return 1;
+		FinishFrame();
+
+		CaptureWriter writer;
+		double listMs = 0.0, capturedMs = 0.0, encodeMs = 0.0, replayMs = 0.0;
+		for (unsigned int pass = 0; pass < FrameCount; pass++)
+		{
+			// Clear() keeps the capacity, after the first frame the writer doesn't allocate,
+			// same as WinMain's
+			Clock::time_point start = Clock::now();
+			list->Reset(allocator.Get(), nullptr);
+			{
+				CapturedCommandList plain(list.Get(), objects, nullptr);
+				RecordFrame(plain, frame);
+			}
+			list->Close();
+			listMs += Milliseconds(start);
+
+			writer.Clear();
+			start = Clock::now();
+			list->Reset(allocator.Get(), nullptr);
+			{
+				CapturedCommandList captured(list.Get(), objects, &writer);
+				RecordFrame(captured, frame);
+			}
+			list->Close();
+			capturedMs += Milliseconds(start);
+
+			writer.Clear();
+			start = Clock::now();
+			writer.BeginList();
+			WriterOnly encoder = { writer, objects };
+			RecordFrame(encoder, frame);
+			encodeMs += Milliseconds(start);
+
+			start = Clock::now();
+			list->Reset(allocator.Get(), nullptr);
+			D3D12ReplayBackend replay(list.Get(), objects, constants, shaderResources);
+			if (!ReplayFrame(writer.GetBytes().data(), writer.GetBytes().size(), replay) || replay.Failed())
+				return 1;
+			list->Close();
+			replayMs += Milliseconds(start);
+			FinishFrame();
+		}
+
+		const double perDraw = 1000000.0 / (double(drawCount) * FrameCount);
+		std::printf("%s: %zu bytes/frame (%.1f/draw)\n", DrawBindingNames[binding], writer.GetBytes().size(), double(writer.GetBytes().size()) / drawCount);
+		std::printf("    list %.1f ns/draw, captured %.1f ns/draw, encode only %.1f ns/draw at %.0f MB/s, replay %.1f ns/draw\n",
+			listMs * perDraw, capturedMs * perDraw, encodeMs * perDraw, writer.GetBytes().size() * FrameCount / encodeMs / 1000.0, replayMs * perDraw);
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+/**************************************************************
+	Frame graph compile time and aliasing on synthetic graphs of
+	10 to 1000 passes. Every pass writes a 2 to 8 MB target and
+	reads the previous one, every tenth also reads one from eight
+	passes back, and a pass nothing reads is thrown in to be
+	culled. Built and compiled from scratch every frame, the way
+	the app does it.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <d3d12.h>
+#include "FrameGraph.h"
+
+namespace
+{
+	bool BuildSynthetic(FrameGraph& graph, uint32_t passCount)
+	{
+		graph.Reset();
+		const uint32_t output = graph.Import("Output", D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+		const uint32_t unused = graph.CreateTransient("Unused", 8 << 20, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+		const uint32_t firstTarget = graph.GetResourceCount();
+		for (uint32_t pass = 0; pass < passCount; pass++)
+			graph.CreateTransient("Target", (1 + pass % 4) * (2 << 20), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+		for (uint32_t pass = 0; pass < passCount; pass++)
+		{
+			graph.AddPass("Pass");
+			graph.Write(firstTarget + pass, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			if (pass > 0)
+				graph.Read(firstTarget + pass - 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			if (pass >= 8 && pass % 10 == 0)
+				graph.Read(firstTarget + pass - 8, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			if (pass == passCount / 2)
+			{
+				graph.AddPass("Culled");
+				graph.Write(unused, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			}
+		}
+		graph.AddPass("Present");
+		graph.Read(firstTarget + passCount - 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(output, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		return graph.Compile();
+	}
+}
+
+int main()
+{
+	FrameGraph graph;
+	for (uint32_t passCount : { 10, 30, 100, 300, 1000 })
+	{
+		const uint32_t frameCount = 100000 / passCount;
+		uint32_t failures = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+			failures += !BuildSynthetic(graph, passCount);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::printf("Frame graph, %4u passes: %8.1f us/frame, %.2f us/pass, %llu MB peak transient memory of %llu MB, %zu barriers, %u culled, %u failed\n",
+			passCount, 1e6 * seconds / frameCount, 1e6 * seconds / frameCount / passCount, (unsigned long long)(graph.GetPeakSize() >> 20),
+			(unsigned long long)(graph.GetUnaliasedSize() >> 20), graph.GetBarrierCount(), graph.GetCulledCount(), failures);
+	}
+	return 0;
+}
@@ -0,0 +1,37 @@
+/**************************************************************
+	PackOrbitInstances from 1k to 1M instances, the range the
+	instanced path is meant for. Reports instances/ms and the
+	bytes that go into the instance buffer per frame.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Instancing.h"
+
+int main()
+{
+	const DirectX::XMVECTOR palette[] =
+	{
+		DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+		DirectX::XMVectorSet(1.0f, 0.84f, 0.0f, 1.0f),
+		DirectX::XMVectorSet(0.58f, 0.44f, 0.86f, 1.0f),
+		DirectX::XMVectorSet(0.0f, 1.0f, 1.0f, 1.0f),
+	};
+	const uint32_t materials[] = { 1, 2 };
+
+	for (unsigned int count : { 1000, 10000, 100000, 1000000 })
+	{
+		std::vector<InstanceData> instances(count);
+		TransformSoA objects;
+		const unsigned int frames = 10000000 / count;
+
+		const auto packStart = std::chrono::steady_clock::now();
+		for (unsigned int frame = 0; frame < frames; frame++)
+			PackOrbitInstances(instances.data(), count, (float)frame, palette, 4, frame, materials, 2, objects);
+		const double packMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - packStart).count();
+
+		std::printf("Instance packing, %u instances: %.0f instances/ms, %.2f ms/frame, %.1f MB/frame into the instance buffer\n", count,
+			(double)count * frames / packMs, packMs / frames, count * sizeof(InstanceData) / (1024.0 * 1024.0));
+	}
+	return 0;
+}
@@ -0,0 +1,102 @@
+/**************************************************************
+	Recording a frame of draws on 1 to N threads, N being the
+	first argument or the core count: chunk lists from the
+	CommandListPool on the null device, recorded through the
+	ParallelRecorder the way WinMain's one draw per cube path does
+	it (a root CBV and a draw each, a PSO switch whenever the
+	material changes). The null lists only count, so this is the
+	cost of the split, the handoff and the call overhead, an upper
+	bound on what threading can save.
+**************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "CommandListPool.h"
+#include "NullD3D12.h"
+#include "ParallelRecorder.h"
+
+using Microsoft::WRL::ComPtr;
+
+int main(int argc, char** argv)
+{
+	const unsigned int drawCount = 100000;
+	const unsigned int frameCount = 50;
+	const unsigned int materialCount = 2;
+	const unsigned int maxThreads = std::max(1u, argc > 1 ? (unsigned int)atoi(argv[1]) : std::thread::hardware_concurrency());
+
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	ComPtr<ID3D12CommandQueue> queue;
+	ComPtr<ID3D12Fence> fence;
+	if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue))) || FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence))))
+		return 1;
+
+	std::printf("%u draws per frame, %u frames\n", drawCount, frameCount);
+	double singleThreadMs = 0.0;
+	for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount++)
+	{
+		ParallelRecorder recorder(threadCount, 64);
+		CommandListPool pool;
+		pool.Init(device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+		std::vector<PooledCommandList> chunkLists;
+		std::vector<ID3D12CommandList*> submitLists;
+		UINT64 fenceValue = 0;
+
+		double recordMs = 0.0;
+		for (unsigned int frame = 0; frame < frameCount; frame++)
+		{
+			// The null queue finishes right away, the pool recycles every frame
+			while (fence->GetCompletedValue() < fenceValue)
+				std::this_thread::yield();
+			pool.ReleaseCompleted(fenceValue);
+
+			const auto start = std::chrono::steady_clock::now();
+			chunkLists.resize(recorder.GetChunkCount(drawCount));
+			for (PooledCommandList& chunkList : chunkLists)
+			{
+				if (FAILED(pool.Acquire(nullptr, &chunkList)))
+					return 1;
+			}
+
+			recorder.Record(drawCount, [&](unsigned int chunk, unsigned int firstDraw, unsigned int endDraw)
+			{
+				ID3D12GraphicsCommandList* list = chunkLists[chunk].List;
+				unsigned int material = ~0u;
+				for (unsigned int draw = firstDraw; draw < endDraw; draw++)
+				{
+					if (draw % materialCount != material)
+					{
+						material = draw % materialCount;
+						list->SetPipelineState(nullptr);
+					}
+					list->SetGraphicsRootConstantBufferView(0, 0x10000 + 256 * UINT64(draw));
+					list->DrawIndexedInstanced(36, 1, 0, 0, draw);
+				}
+				list->Close();
+			});
+			recordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			submitLists.clear();
+			for (PooledCommandList& chunkList : chunkLists)
+				submitLists.push_back(chunkList.List);
+			queue->ExecuteCommandLists(UINT(submitLists.size()), submitLists.data());
+			queue->Signal(fence.Get(), ++fenceValue);
+			pool.FinishFrame(fenceValue);
+		}
+
+		if (threadCount == 1)
+			singleThreadMs = recordMs;
+		std::printf("%2u threads: %7.3f ms/frame, %8.0f draws/ms, %.2fx, %zu pooled lists\n", threadCount, recordMs / frameCount,
+			double(drawCount) * frameCount / recordMs, singleThreadMs / recordMs, pool.GetListCount());
+
+		while (fence->GetCompletedValue() < fenceValue)
+			std::this_thread::yield();
+	}
+	return 0;
+}
@@ -0,0 +1,42 @@
+/**************************************************************
+	Ring allocator throughput the way the constant buffer ring
+	is used: 256 byte aligned slices, frames released three
+	fences late, and a ring small enough that it wraps around
+	every few frames.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include "RingAllocator.h"
+
+int main()
+{
+	for (uint32_t slicesPerFrame : { 16, 256, 4096 })
+	{
+		const uint64_t sliceSize = 288;		// A ConstantBuffer, rounded up to 512 by the alignment
+		RingAllocator ring(4 * slicesPerFrame * 512 + 4096);
+
+		const uint32_t frameCount = 10000000 / slicesPerFrame;
+		uint64_t fenceValue = 0, failures = 0, wraps = 0, lastOffset = 0, checksum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			ring.ReleaseCompletedFrames(fenceValue > 3 ? fenceValue - 3 : 0);
+			for (uint32_t slice = 0; slice < slicesPerFrame; slice++)
+			{
+				const uint64_t offset = ring.Allocate(sliceSize, 256);
+				failures += offset == RingAllocator::InvalidOffset;
+				wraps += offset < lastOffset;
+				lastOffset = offset;
+				checksum += offset;
+			}
+			ring.FinishFrame(++fenceValue);
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const double allocations = (double)frameCount * slicesPerFrame;
+		std::printf("Ring allocator, %u slices/frame: %.1f M allocations/s, %.2f ns each, %llu wraps, %llu failed (%llx)\n", slicesPerFrame,
+			allocations / seconds / 1e6, 1e9 * seconds / allocations, (unsigned long long)wraps, (unsigned long long)failures,
+			(unsigned long long)checksum);
+	}
+	return 0;
+}
@@ -0,0 +1,106 @@
+/**************************************************************
+	Lists the PSMain permutations WinMain compiles, from the
+	same AddPixelShaderOptions() so the keys match its log.
+
+	When cmake found dxc (DXC_PATH) every permutation is also
+	compiled with it to ps_6_0 and the instructions in PSMain's
+	DXIL are counted: every line of the function body but the
+	labels and comments. That's not the DXBC count WinMain logs
+	from FXC, but it ranks the variants the same way and it runs
+	without Windows. Without dxc only the permutations are listed.
+
+	The shader is the first argument, Shaders.hlsl by default,
+	which is where the source directory has it.
+**************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ShaderPermutationKeys.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace
+{
+#ifdef DXC_PATH
+	// -1 if dxc failed or there was no PSMain in what it printed
+	int CountInstructions(const ShaderPermutationKeys& keys, uint32_t key, const char* fileName)
+	{
+		std::string command = std::string("\"") + DXC_PATH + "\" -T ps_6_0 -E PSMain";
+		for (uint32_t option = 0; option < keys.GetOptionCount(); option++)
+			command += std::string(" -D ") + keys.GetDefine(option) + "=" + std::to_string(keys.GetValue(key, option));
+		command += std::string(" \"") + fileName + "\"";
+
+		FILE* output = popen(command.c_str(), "r");
+		if (!output)
+			return -1;
+
+		int count = -1;
+		bool inFunction = false;
+		char line[4096];
+		while (std::fgets(line, sizeof(line), output))
+		{
+			if (!inFunction)
+			{
+				if (std::strncmp(line, "define ", 7) == 0 && std::strstr(line, "@PSMain("))
+				{
+					inFunction = true;
+					count = 0;
+				}
+				continue;
+			}
+			if (line[0] == '}')
+			{
+				inFunction = false;
+				continue;
+			}
+
+			const char* text = line + std::strspn(line, " \t");
+			const size_t length = std::strcspn(text, ";\r\n");
+			if (length && text[length - 1] != ':')
+				count++;
+		}
+		return pclose(output) == 0 ? count : -1;
+	}
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	const char* fileName = argc > 1 ? argv[1] : "Shaders.hlsl";
+
+	ShaderPermutationKeys pixelShaders;
+	AddPixelShaderOptions(pixelShaders);
+	std::printf("PSMain in %s, %u permutations\n", fileName, pixelShaders.GetPermutationCount());
+
+#ifdef DXC_PATH
+	int failed = 0;
+	for (uint32_t key = 0; key < pixelShaders.GetPermutationCount(); key++)
+	{
+		const int count = CountInstructions(pixelShaders, key, fileName);
+		if (count < 0)
+		{
+			std::printf("  %2u %s: dxc failed\n", key, pixelShaders.GetName(key).c_str());
+			failed++;
+			continue;
+		}
+
+		// Next to the full precision one it would replace
+		const uint32_t fullPrecision = pixelShaders.WithValue(key, PIXEL_SHADER_HALF_PRECISION, 0);
+		const int fullCount = key == fullPrecision ? count : CountInstructions(pixelShaders, fullPrecision, fileName);
+		if (key != fullPrecision && fullCount > 0)
+			std::printf("  %2u %s: %d instructions, %+d against full precision\n", key, pixelShaders.GetName(key).c_str(), count, count - fullCount);
+		else
+			std::printf("  %2u %s: %d instructions\n", key, pixelShaders.GetName(key).c_str(), count);
+	}
+	return failed ? 1 : 0;
+#else
+	for (uint32_t key = 0; key < pixelShaders.GetPermutationCount(); key++)
+		std::printf("  %2u %s\n", key, pixelShaders.GetName(key).c_str());
+	std::printf("No dxc when cmake ran, so no instruction counts\n");
+	return 0;
+#endif
+}
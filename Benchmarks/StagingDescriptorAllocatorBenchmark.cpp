@@ -0,0 +1,177 @@
+/**************************************************************
+	Staging descriptor allocator patterns on the null device, 1 to
+	N threads, N being the first argument or the core count. Each
+	pattern runs once with every call taking the allocator's lock
+	and once through a Cache per thread:
+
+	churn: one view created and dropped at a time, like a render
+	target that's resized.
+
+	bursts: 256 views then all of them freed, like a level's
+	textures streaming in and out.
+
+	long lived: a quarter of the allocations stay, up to 4096 of
+	them, the rest churns around them, so the free slots end up
+	spread over every page.
+
+	The heap per view the allocator replaced is timed first for
+	reference, on the null device that's only its bookkeeping.
+**************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "NullD3D12.h"
+#include "StagingDescriptorAllocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	const unsigned int OperationsPerThread = 1000000;
+	const UINT PageSize = 256;
+
+	enum Pattern
+	{
+		PATTERN_CHURN,
+		PATTERN_BURSTS,
+		PATTERN_LONG_LIVED,
+		PATTERN_COUNT
+	};
+
+	const char* const PatternNames[PATTERN_COUNT] = { "churn", "bursts", "long lived" };
+
+	template <typename Source>
+	void RunPattern(Source& source, Pattern pattern, unsigned int thread, std::atomic<unsigned int>& failures)
+	{
+		std::vector<StagingDescriptor> held;
+		std::vector<StagingDescriptor> kept;
+		unsigned int random = 12345 + thread;
+		for (unsigned int op = 0; op < OperationsPerThread; op++)
+		{
+			const StagingDescriptor descriptor = source.Allocate();
+			failures += !descriptor.IsValid();
+
+			switch (pattern)
+			{
+			case PATTERN_CHURN:
+				source.Free(descriptor);
+				break;
+			case PATTERN_BURSTS:
+				held.push_back(descriptor);
+				if (held.size() == 256)
+				{
+					for (const StagingDescriptor& view : held)
+						source.Free(view);
+					held.clear();
+				}
+				break;
+			case PATTERN_LONG_LIVED:
+				random = random * 1664525 + 1013904223;
+				if (kept.size() < 4096 && (random >> 24) < 64)
+				{
+					kept.push_back(descriptor);
+					break;
+				}
+				held.push_back(descriptor);
+				if (held.size() == 64)
+				{
+					for (const StagingDescriptor& view : held)
+						source.Free(view);
+					held.clear();
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		for (const StagingDescriptor& view : held)
+			source.Free(view);
+		for (const StagingDescriptor& view : kept)
+			source.Free(view);
+	}
+
+	// Million allocations per second over all threads
+	double Run(ID3D12Device* device, Pattern pattern, unsigned int threadCount, bool cached, UINT* pageCount)
+	{
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PageSize);
+
+		std::atomic<unsigned int> ready(0), failures(0);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> threads;
+		for (unsigned int thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&, thread]()
+			{
+				std::unique_ptr<StagingDescriptorAllocator::Cache> cache(cached ? new StagingDescriptorAllocator::Cache(allocator) : nullptr);
+				ready++;
+				while (!go)
+					std::this_thread::yield();
+
+				if (cache)
+					RunPattern(*cache, pattern, thread, failures);
+				else
+					RunPattern(allocator, pattern, thread, failures);
+			});
+		}
+
+		while (ready < threadCount)
+			std::this_thread::yield();
+		const auto start = std::chrono::steady_clock::now();
+		go = true;
+		for (std::thread& thread : threads)
+			thread.join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (failures || allocator.GetAllocatedCount())
+			std::printf("%u allocations failed, %u never freed\n", failures.load(), allocator.GetAllocatedCount());
+		*pageCount = allocator.GetPageCount();
+		return double(OperationsPerThread) * threadCount / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned int maxThreads = std::max(1u, argc > 1 ? (unsigned int)atoi(argv[1]) : std::thread::hardware_concurrency());
+
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+
+	// A heap per view, what RTVs and DSVs used to get
+	{
+		const unsigned int viewCount = 100000;
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = 1;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned int view = 0; view < viewCount; view++)
+		{
+			ComPtr<ID3D12DescriptorHeap> heap;
+			if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap))))
+				return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("Heap per view: %.2f M views/s\n", viewCount / seconds / 1e6);
+	}
+
+	std::printf("%u allocations per thread, pages of %u descriptors, M allocations/s\n", OperationsPerThread, PageSize);
+	for (unsigned int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+	{
+		for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount++)
+		{
+			UINT lockedPages = 0, cachedPages = 0;
+			const double locked = Run(device.Get(), Pattern(pattern), threadCount, false, &lockedPages);
+			const double cached = Run(device.Get(), Pattern(pattern), threadCount, true, &cachedPages);
+			std::printf("%-10s %2u threads: locked %6.1f (%u pages), cached %6.1f (%u pages), %.2fx\n", PatternNames[pattern], threadCount,
+				locked, lockedPages, cached, cachedPages, cached / locked);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,215 @@
+/**************************************************************
+	Staging memory over a load trace: a level load of 96 textures
+	up front, then one streamed in every few frames, two frames in
+	flight on a copy queue that takes a millisecond per batch.
+	Replayed twice on the null device, once the old way (an upload
+	heap per texture, sized by GetRequiredIntermediateSize and kept
+	alive until its fence) and once through the StagingPool, with
+	the block size and count WinMain uses. Reports the peak upload
+	memory and how many upload allocations each took.
+**************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "NullD3D12.h"
+#include "UploadManager.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	struct TraceEntry
+	{
+		UINT Frame;
+		UINT Size;
+		DXGI_FORMAT Format;
+	};
+
+	// Mostly block compressed, a few uncompressed ones (UI, lookup tables), power
+	// of two sizes weighted towards the middle
+	std::vector<TraceEntry> MakeLoadTrace()
+	{
+		std::srand(9);
+		const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM,
+			DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM };
+		const UINT sizes[] = { 256, 512, 512, 1024, 1024, 1024, 2048, 2048 };
+
+		std::vector<TraceEntry> trace;
+		for (int i = 0; i < 96; i++)
+		{
+			const DXGI_FORMAT format = formats[std::rand() % _countof(formats)];
+			const UINT size = sizes[std::rand() % _countof(sizes)];
+			trace.push_back({ UINT(i / 8), format == DXGI_FORMAT_R8G8B8A8_UNORM ? std::min(size, 1024u) : size, format });
+		}
+		for (UINT frame = 12; frame < 600; frame += 1 + std::rand() % 5)
+			trace.push_back({ frame, sizes[std::rand() % 6], formats[std::rand() % 5] });
+		return trace;
+	}
+
+	struct Result
+	{
+		UINT64 PeakBytes;
+		UINT64 Allocations;
+		UINT Submits;
+		UINT Stalls;
+		double Seconds;
+	};
+
+	// Plays the trace, 'upload' records one texture's copies
+	template <typename Upload>
+	double Replay(ID3D12Device* device, UploadManager& uploads, const std::vector<TraceEntry>& trace, Upload upload)
+	{
+		std::vector<UINT8> bits(2048 * 2048 * 4);
+		for (UINT8& byte : bits)
+			byte = UINT8(std::rand());
+
+		std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> textures;		// Dropped once uploaded
+		const UINT frameCount = trace.back().Frame + 1;
+		size_t next = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (UINT frame = 0; frame < frameCount; frame++)
+		{
+			uploads.ReleaseCompleted();
+			while (!textures.empty() && textures.front().first <= uploads.GetCompletedFenceValue())
+				textures.pop_front();
+
+			for (; next < trace.size() && trace[next].Frame == frame; next++)
+			{
+				const UINT size = trace[next].Size;
+				const UINT mips = 1 + UINT(std::log2(size));
+				const CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(trace[next].Format, size, size, 1, UINT16(mips));
+				const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+				ComPtr<ID3D12Resource> texture;
+				if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON,
+					nullptr, IID_PPV_ARGS(&texture))))
+					return -1.0;
+
+				std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+				for (UINT mip = 0; mip < mips; mip++)
+				{
+					size_t bytes, rowBytes, rows;
+					DirectX::GetSurfaceInfo(std::max(size >> mip, 1u), std::max(size >> mip, 1u), trace[next].Format, &bytes, &rowBytes, &rows);
+					subresources.push_back({ bits.data(), LONG_PTR(rowBytes), LONG_PTR(bytes) });
+				}
+				if (FAILED(upload(texture.Get(), subresources)))
+					return -1.0;
+				textures.push_back({ 0, texture });
+			}
+
+			const UINT64 fence = uploads.Submit();
+			for (auto& texture : textures)
+				texture.first = texture.first ? texture.first : fence;
+
+			// Two frames in flight
+			while (uploads.GetCompletedFenceValue() + 2 < fence)
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+		uploads.Flush();
+		uploads.ReleaseCompleted();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	Result ReplayUploadHeaps(NullD3D12::Device* device, const std::vector<TraceEntry>& trace)
+	{
+		UploadManager uploads;
+		uploads.Init(device, 4 * 1024 * 1024, 4);
+
+		Result result = {};
+		UINT64 live = 0;
+		std::deque<std::pair<UINT64, UINT64>> inFlight;		// Fence value, heap size
+		result.Seconds = Replay(device, uploads, trace, [&](ID3D12Resource* texture, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+		{
+			while (!inFlight.empty() && inFlight.front().first <= uploads.GetCompletedFenceValue())
+			{
+				live -= inFlight.front().second;
+				inFlight.pop_front();
+			}
+
+			const UINT64 size = GetRequiredIntermediateSize(texture, 0, UINT(subresources.size()));
+			const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+			const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+			ComPtr<ID3D12Resource> uploadHeap;
+			HRESULT hr = device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+				D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&uploadHeap));
+			if (FAILED(hr))
+				return hr;
+
+			if (!UpdateSubresources(uploads.GetCommandList(), texture, uploadHeap.Get(), 0, 0, UINT(subresources.size()),
+				const_cast<D3D12_SUBRESOURCE_DATA*>(subresources.data())))
+				return E_FAIL;
+			uploads.KeepAlive(uploadHeap.Get());
+
+			// Nothing here ever stalls, so the batch being recorded signals one past the last submit
+			inFlight.push_back({ uploads.GetSubmitCount() + 1, size });
+			live += size;
+			result.PeakBytes = std::max(result.PeakBytes, live);
+			result.Allocations++;
+			return S_OK;
+		});
+		result.Submits = uploads.GetSubmitCount();
+		return result;
+	}
+
+	Result ReplayStagingPool(NullD3D12::Device* device, const std::vector<TraceEntry>& trace)
+	{
+		UploadManager uploads;
+		uploads.Init(device, 4 * 1024 * 1024, 4);
+
+		Result result = {};
+		result.Seconds = Replay(device, uploads, trace, [&](ID3D12Resource* texture, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+		{
+			return uploads.UploadTexture(texture, subresources.data(), UINT(subresources.size()));
+		});
+
+		// Dedicated heaps for the mips that don't fit in a block are counted on top, all of
+		// them as if they were alive at once, so if anything the pool's peak is overstated
+		const StagingPool& staging = uploads.GetStaging();
+		result.PeakBytes = staging.GetPeakUsedSize() + uploads.GetDedicatedSize();
+		result.Allocations = staging.GetAllocationCount() + uploads.GetDedicatedCount();
+		result.Submits = uploads.GetSubmitCount();
+		result.Stalls = uploads.GetStallCount();
+		std::printf("Staging pool: %llu KB committed in %u blocks, %u subresources on %llu KB of dedicated heaps\n",
+			(unsigned long long)staging.GetCommittedSize() / 1024, UINT(staging.GetCommittedSize() / staging.GetBlockSize()),
+			uploads.GetDedicatedCount(), (unsigned long long)uploads.GetDedicatedSize() / 1024);
+		return result;
+	}
+}
+
+int main()
+{
+	const std::vector<TraceEntry> trace = MakeLoadTrace();
+	UINT64 textureBytes = 0;
+	for (const TraceEntry& entry : trace)
+	{
+		size_t bytes, rowBytes, rows;
+		DirectX::GetSurfaceInfo(entry.Size, entry.Size, entry.Format, &bytes, &rowBytes, &rows);
+		textureBytes += bytes * 4 / 3;
+	}
+	std::printf("Trace: %zu textures over %u frames, about %llu MB\n", trace.size(), trace.back().Frame + 1,
+		(unsigned long long)(textureBytes >> 20));
+
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+	device->QueueLatency = std::chrono::milliseconds(1);
+
+	const Result results[2] = { ReplayUploadHeaps(device.Get(), trace), ReplayStagingPool(device.Get(), trace) };
+	const char* names[2] = { "Upload heap per texture", "Staging pool" };
+	for (int i = 0; i < 2; i++)
+	{
+		if (results[i].Seconds < 0.0)
+		{
+			std::printf("%s: replay failed\n", names[i]);
+			return 1;
+		}
+		std::printf("%-24s peak %7.1f MB, %5llu allocations, %4u submits, %3u stalls, %.2f s\n", names[i],
+			results[i].PeakBytes / (1024.0 * 1024.0), (unsigned long long)results[i].Allocations, results[i].Submits,
+			results[i].Stalls, results[i].Seconds);
+	}
+	return 0;
+}
@@ -0,0 +1,137 @@
+/**************************************************************
+	Bindless Heap
+
+	The one shader visible CBV/SRV/UAV heap. Shaders see all of
+	it as an unbounded array (Texture2D textures[] : register(t0,
+	space1)) bound once at the start of the heap, and pick their
+	texture by index, so adding a texture never touches the root
+	signature or the descriptor tables. Only plain 2D textures can
+	go in, see CanSample().
+
+	Slots come from a DescriptorFreeList, so any thread can
+	allocate one. Freeing is up to the caller: a slot can only go
+	back once no frame in flight reads it anymore. Every slot
+	starts out as a null SRV, a stray index samples black instead
+	of reading garbage.
+
+	Views are created in a StagingDescriptorAllocator and queued
+	with QueueCopy(). FlushCopies() then moves everything queued
+	in one CopyDescriptors call, right before the frame that uses
+	them is submitted.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <mutex>
+#include <vector>
+#include "DescriptorFreeList.h"
+
+class BindlessHeap
+{
+public:
+	static constexpr UINT InvalidIndex = DescriptorFreeList::InvalidIndex;
+
+	BindlessHeap() : m_device(nullptr), m_heap(nullptr), m_descriptorSize(0), m_copyCount(0), m_copyBatchCount(0) { }
+
+	~BindlessHeap()
+	{
+		if (m_heap) m_heap->Release();
+	}
+
+	BindlessHeap(const BindlessHeap&) = delete;
+	BindlessHeap& operator=(const BindlessHeap&) = delete;
+
+	HRESULT Init(ID3D12Device* device, UINT capacity)
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = capacity;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+		HRESULT hr = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_heap));
+		if (FAILED(hr))
+			return hr;
+
+		m_device = device;
+		m_descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		m_cpuStart = m_heap->GetCPUDescriptorHandleForHeapStart();
+		m_gpuStart = m_heap->GetGPUDescriptorHandleForHeapStart();
+		m_freeList.Reset(capacity);
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC nullDesc = {};
+		nullDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		nullDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		nullDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		nullDesc.Texture2D.MipLevels = 1;
+		for (UINT i = 0; i < capacity; i++)
+			device->CreateShaderResourceView(nullptr, &nullDesc, GetCpuHandle(i));
+
+		return S_OK;
+	}
+
+	// Shaders only see the heap as Texture2D, a 1D, 3D, array or cube view in a slot
+	// would be sampled as garbage. Check before QueueCopy().
+	static bool CanSample(const D3D12_SHADER_RESOURCE_VIEW_DESC& desc)
+	{
+		return desc.ViewDimension == D3D12_SRV_DIMENSION_TEXTURE2D;
+	}
+
+	// Returns InvalidIndex when the heap is full
+	UINT Allocate() { return m_freeList.Allocate(); }
+	void Free(UINT index) { m_freeList.Free(index); }
+
+	// 'source' has to stay untouched until the next FlushCopies(). Thread safe.
+	void QueueCopy(UINT index, D3D12_CPU_DESCRIPTOR_HANDLE source)
+	{
+		std::lock_guard<std::mutex> lock(m_copyMutex);
+		m_copySources.push_back(source);
+		m_copyDestinations.push_back(GetCpuHandle(index));
+	}
+
+	// Render thread only, before submitting anything that reads the copied slots
+	void FlushCopies()
+	{
+		std::lock_guard<std::mutex> lock(m_copyMutex);
+		if (m_copySources.empty())
+			return;
+
+		// Every range is one descriptor long, so a null size array means just that
+		const UINT count = static_cast<UINT>(m_copySources.size());
+		m_device->CopyDescriptors(count, m_copyDestinations.data(), nullptr, count, m_copySources.data(), nullptr,
+			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+		m_copyCount += count;
+		m_copyBatchCount++;
+		m_copySources.clear();
+		m_copyDestinations.clear();
+	}
+
+	UINT64 GetCopyCount() const { return m_copyCount; }
+	UINT64 GetCopyBatchCount() const { return m_copyBatchCount; }
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(UINT index) const
+	{
+		return { m_cpuStart.ptr + SIZE_T(index) * m_descriptorSize };
+	}
+
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(UINT index) const
+	{
+		return { m_gpuStart.ptr + UINT64(index) * m_descriptorSize };
+	}
+
+	ID3D12DescriptorHeap* GetHeap() const { return m_heap; }
+	UINT GetCapacity() const { return m_freeList.GetCapacity(); }
+
+private:
+	ID3D12Device* m_device;
+	ID3D12DescriptorHeap* m_heap;
+	UINT m_descriptorSize;
+	D3D12_CPU_DESCRIPTOR_HANDLE m_cpuStart;
+	D3D12_GPU_DESCRIPTOR_HANDLE m_gpuStart;
+	DescriptorFreeList m_freeList;
+
+	std::mutex m_copyMutex;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_copySources;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_copyDestinations;
+	UINT64 m_copyCount;
+	UINT64 m_copyBatchCount;
+};
@@ -0,0 +1,223 @@
+/**************************************************************
+	Buddy Allocator
+
+	Hands out ranges of one block of memory in power of two sizes,
+	from a minimum size up to the whole block. A range is always
+	aligned to its own size, so an alignment request only ever
+	makes it bigger, never adds padding. Splitting a range in two
+	gives two buddies, and a freed range merges with its buddy
+	again if that's free too, so the block doesn't fragment into
+	pieces nothing fits in.
+
+	Free ranges of every size are kept in linked lists threaded
+	through arrays with an entry per minimum sized unit, and a bit
+	per size says which lists aren't empty. Allocate and Free are
+	a handful of array operations per size level, never a search.
+
+	Nothing D3D12 specific in here, the offsets can be into any
+	kind of memory. See ResourceHeapAllocator.h for the one that
+	places resources in ID3D12Heaps, and AllocationTrace below
+	for recording what it did so it can be replayed elsewhere.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class BuddyAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = ~0ull;
+
+	BuddyAllocator() : m_minBlockSize(0), m_levelCount(0), m_freeMask(0), m_allocatedSize(0), m_allocationCount(0) { }
+
+	// Both have to be powers of two, 'size' a multiple of 'minBlockSize'
+	void Reset(uint64_t size, uint64_t minBlockSize)
+	{
+		m_minBlockSize = minBlockSize;
+		m_levelCount = 1;
+		while ((minBlockSize << (m_levelCount - 1)) < size)
+			m_levelCount++;
+
+		const uint32_t unitCount = static_cast<uint32_t>(size / minBlockSize);
+		m_next.assign(unitCount, InvalidUnit);
+		m_previous.assign(unitCount, InvalidUnit);
+		m_level.assign(unitCount, 0);
+		m_free.assign(unitCount, false);
+		m_freeHeads.assign(m_levelCount, InvalidUnit);
+		m_freeMask = 0;
+		m_allocatedSize = 0;
+		m_allocationCount = 0;
+
+		Push(0, m_levelCount - 1);
+	}
+
+	// Size of the range Allocate() would hand out, 0 if it's bigger than the whole block
+	uint64_t GetRangeSize(uint64_t size, uint64_t alignment) const
+	{
+		const uint32_t level = LevelFor(size, alignment);
+		return level < m_levelCount ? m_minBlockSize << level : 0;
+	}
+
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1)
+	{
+		const uint32_t level = LevelFor(size, alignment);
+		if (level >= m_levelCount)
+			return InvalidOffset;
+
+		// Smallest free range that's big enough
+		uint32_t found = level;
+		while (found < m_levelCount && !(m_freeMask & (1u << found)))
+			found++;
+		if (found == m_levelCount)
+			return InvalidOffset;
+
+		const uint32_t unit = m_freeHeads[found];
+		Remove(unit, found);
+
+		// Split it down, the upper halves go back on the free lists
+		while (found > level)
+		{
+			found--;
+			Push(unit + (1u << found), found);
+		}
+
+		m_level[unit] = static_cast<uint8_t>(level);
+		m_allocatedSize += m_minBlockSize << level;
+		m_allocationCount++;
+		return unit * m_minBlockSize;
+	}
+
+	void Free(uint64_t offset)
+	{
+		uint32_t unit = static_cast<uint32_t>(offset / m_minBlockSize);
+		uint32_t level = m_level[unit];
+		m_allocatedSize -= m_minBlockSize << level;
+		m_allocationCount--;
+
+		while (level + 1 < m_levelCount)
+		{
+			const uint32_t buddy = unit ^ (1u << level);
+			if (!m_free[buddy] || m_level[buddy] != level)
+				break;
+
+			Remove(buddy, level);
+			unit = unit < buddy ? unit : buddy;
+			level++;
+		}
+
+		Push(unit, level);
+	}
+
+	uint64_t GetSize() const { return m_levelCount ? m_minBlockSize << (m_levelCount - 1) : 0; }
+	uint64_t GetAllocatedSize() const { return m_allocatedSize; }
+	uint64_t GetFreeSize() const { return GetSize() - m_allocatedSize; }
+	uint32_t GetAllocationCount() const { return m_allocationCount; }
+	bool IsEmpty() const { return m_allocationCount == 0; }
+
+	uint64_t GetLargestFreeRange() const
+	{
+		for (uint32_t level = m_levelCount; level-- > 0;)
+		{
+			if (m_freeMask & (1u << level))
+				return m_minBlockSize << level;
+		}
+		return 0;
+	}
+
+private:
+	static constexpr uint32_t InvalidUnit = ~0u;
+
+	uint32_t LevelFor(uint64_t size, uint64_t alignment) const
+	{
+		const uint64_t needed = size > alignment ? size : alignment;
+		uint32_t level = 0;
+		while ((m_minBlockSize << level) < needed && level < 63)
+			level++;
+		return level;
+	}
+
+	void Push(uint32_t unit, uint32_t level)
+	{
+		const uint32_t head = m_freeHeads[level];
+		m_next[unit] = head;
+		m_previous[unit] = InvalidUnit;
+		if (head != InvalidUnit)
+			m_previous[head] = unit;
+
+		m_freeHeads[level] = unit;
+		m_freeMask |= 1u << level;
+		m_level[unit] = static_cast<uint8_t>(level);
+		m_free[unit] = true;
+	}
+
+	void Remove(uint32_t unit, uint32_t level)
+	{
+		const uint32_t next = m_next[unit];
+		const uint32_t previous = m_previous[unit];
+		if (previous != InvalidUnit)
+			m_next[previous] = next;
+		else
+			m_freeHeads[level] = next;
+		if (next != InvalidUnit)
+			m_previous[next] = previous;
+
+		if (m_freeHeads[level] == InvalidUnit)
+			m_freeMask &= ~(1u << level);
+		m_free[unit] = false;
+	}
+
+	uint64_t m_minBlockSize;
+	uint32_t m_levelCount;
+	uint32_t m_freeMask;
+	uint64_t m_allocatedSize;
+	uint32_t m_allocationCount;
+
+	// Per minimum sized unit, only meaningful for the first unit of a range
+	std::vector<uint32_t> m_next;
+	std::vector<uint32_t> m_previous;
+	std::vector<uint8_t> m_level;
+	std::vector<bool> m_free;
+
+	std::vector<uint32_t> m_freeHeads;
+};
+
+// What an allocator was asked to do, in order, so the same requests can be
+// replayed against another allocator (or on another platform) later.
+// 'Id' pairs every free with its allocation.
+struct AllocationTraceEntry
+{
+	enum Op : uint8_t { ALLOCATE, FREE };
+
+	uint8_t Operation;
+	uint8_t Pool;			// Which kind of heap it went to
+	uint32_t Id;
+	uint64_t Size;
+	uint64_t Alignment;
+};
+
+inline bool SaveAllocationTrace(const char* fileName, const std::vector<AllocationTraceEntry>& entries)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+		return false;
+
+	const bool written = fwrite(entries.data(), sizeof(AllocationTraceEntry), entries.size(), file) == entries.size();
+	return fclose(file) == 0 && written;
+}
+
+inline bool LoadAllocationTrace(const char* fileName, std::vector<AllocationTraceEntry>& entries)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+		return false;
+
+	entries.clear();
+	AllocationTraceEntry entry;
+	while (fread(&entry, sizeof(entry), 1, file) == 1)
+		entries.push_back(entry);
+
+	const bool read = !ferror(file);
+	fclose(file);
+	return read;
+}
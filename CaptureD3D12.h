@@ -0,0 +1,386 @@
+/**************************************************************
+	Capture D3D12
+
+	The D3D12 ends of FrameCapture.h:
+
+	CapturedCommandList forwards every call to a real command list
+	and, when it has a writer, encodes it as well. Encoding is a
+	few table lookups and a memcpy per call, so capture can stay
+	on all the time.
+
+	D3D12ReplayBackend turns a stream back into calls on a command
+	list. Constant buffer and root SRV payloads are re-uploaded
+	into the rings it's given.
+
+	Both resolve objects through the same CaptureObjectTable, so
+	register everything a frame touches before capturing:
+	pipeline states and root signatures by pointer, buffers by
+	their gpu virtual address range, descriptor heaps by the
+	cpu and gpu handle ranges they cover.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <cassert>
+#include "FrameCapture.h"
+#include "UploadRingBuffer.h"
+
+// Registers both handle ranges of a heap, the cpu range first
+inline void RegisterCaptureHeap(CaptureObjectTable& objects, ID3D12Device* device, ID3D12DescriptorHeap* heap)
+{
+	const D3D12_DESCRIPTOR_HEAP_DESC desc = heap->GetDesc();
+	const UINT64 size = UINT64(desc.NumDescriptors) * device->GetDescriptorHandleIncrementSize(desc.Type);
+
+	objects.Register(heap, heap->GetCPUDescriptorHandleForHeapStart().ptr, size);
+	if (desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+		objects.Register(heap, heap->GetGPUDescriptorHandleForHeapStart().ptr, size);
+}
+
+inline void RegisterCaptureBuffer(CaptureObjectTable& objects, ID3D12Resource* buffer)
+{
+	objects.Register(buffer, buffer->GetGPUVirtualAddress(), buffer->GetDesc().Width);
+}
+
+class CapturedCommandList
+{
+public:
+	// 'writer' can be null, then this is just the command list
+	CapturedCommandList(ID3D12GraphicsCommandList* commandList, const CaptureObjectTable& objects, CaptureWriter* writer)
+		: m_commandList(commandList), m_objects(objects), m_writer(writer)
+	{
+		if (m_writer)
+			m_writer->BeginList();
+	}
+
+	ID3D12GraphicsCommandList* Get() const { return m_commandList; }
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState)
+	{
+		m_commandList->SetPipelineState(pipelineState);
+		if (m_writer)
+			m_writer->SetPipelineState(FindObject(pipelineState));
+	}
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature)
+	{
+		m_commandList->SetGraphicsRootSignature(rootSignature);
+		if (m_writer)
+			m_writer->SetRootSignature(FindObject(rootSignature));
+	}
+
+	// Only one heap, that's all the app binds
+	void SetDescriptorHeap(ID3D12DescriptorHeap* heap)
+	{
+		m_commandList->SetDescriptorHeaps(1, &heap);
+		if (m_writer)
+			m_writer->SetDescriptorHeap(FindObject(heap));
+	}
+
+	void SetGraphicsRootDescriptorTable(UINT parameter, D3D12_GPU_DESCRIPTOR_HANDLE table)
+	{
+		m_commandList->SetGraphicsRootDescriptorTable(parameter, table);
+		if (m_writer)
+			m_writer->SetRootDescriptorTable(static_cast<uint8_t>(parameter), FindAddress(table.ptr));
+	}
+
+	// 'data' is a cpu copy of what's at 'address', reading it back from the upload heap would be slow
+	void SetGraphicsRootConstantBufferView(UINT parameter, D3D12_GPU_VIRTUAL_ADDRESS address, const void* data, UINT size)
+	{
+		m_commandList->SetGraphicsRootConstantBufferView(parameter, address);
+		if (m_writer)
+			m_writer->SetRootConstantBuffer(static_cast<uint8_t>(parameter), data, size);
+	}
+
+	void SetGraphicsRootShaderResourceView(UINT parameter, D3D12_GPU_VIRTUAL_ADDRESS address, const void* data, UINT size)
+	{
+		m_commandList->SetGraphicsRootShaderResourceView(parameter, address);
+		if (m_writer)
+			m_writer->SetRootShaderResource(static_cast<uint8_t>(parameter), data, size);
+	}
+
+	void SetGraphicsRoot32BitConstants(UINT parameter, UINT count, const void* data, UINT offset)
+	{
+		m_commandList->SetGraphicsRoot32BitConstants(parameter, count, data, offset);
+		if (m_writer)
+			m_writer->SetRootConstants(static_cast<uint8_t>(parameter), offset, data, count);
+	}
+
+	void IASetVertexBuffer(UINT slot, const D3D12_VERTEX_BUFFER_VIEW& view)
+	{
+		m_commandList->IASetVertexBuffers(slot, 1, &view);
+		if (m_writer)
+			m_writer->SetVertexBuffer(static_cast<uint8_t>(slot), FindAddress(view.BufferLocation), view.SizeInBytes, view.StrideInBytes);
+	}
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view)
+	{
+		m_commandList->IASetIndexBuffer(&view);
+		if (m_writer)
+			m_writer->SetIndexBuffer(FindAddress(view.BufferLocation), view.SizeInBytes, view.Format);
+	}
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+	{
+		m_commandList->IASetPrimitiveTopology(topology);
+		if (m_writer)
+			m_writer->SetTopology(topology);
+	}
+
+	void RSSetViewport(const D3D12_VIEWPORT& viewport)
+	{
+		m_commandList->RSSetViewports(1, &viewport);
+		if (m_writer)
+		{
+			const float values[6] = { viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+			m_writer->SetViewport(values);
+		}
+	}
+
+	void RSSetScissorRect(const D3D12_RECT& rect)
+	{
+		m_commandList->RSSetScissorRects(1, &rect);
+		if (m_writer)
+		{
+			const int32_t values[4] = { rect.left, rect.top, rect.right, rect.bottom };
+			m_writer->SetScissorRect(values);
+		}
+	}
+
+	void OMSetRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE renderTarget, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil)
+	{
+		m_commandList->OMSetRenderTargets(1, &renderTarget, false, depthStencil);
+		if (m_writer)
+		{
+			const CaptureRef none = { CaptureObjectTable::InvalidId, 0 };
+			m_writer->SetRenderTarget(FindAddress(renderTarget.ptr), depthStencil ? FindAddress(depthStencil->ptr) : none);
+		}
+	}
+
+	void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTarget, const float color[4])
+	{
+		m_commandList->ClearRenderTargetView(renderTarget, color, 0, nullptr);
+		if (m_writer)
+			m_writer->ClearRenderTarget(FindAddress(renderTarget.ptr), color);
+	}
+
+	void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencil, D3D12_CLEAR_FLAGS flags, float depth, UINT8 stencil)
+	{
+		m_commandList->ClearDepthStencilView(depthStencil, flags, depth, stencil, 0, nullptr);
+		if (m_writer)
+			m_writer->ClearDepthStencil(FindAddress(depthStencil.ptr), flags, depth, stencil);
+	}
+
+	void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT firstIndex, INT baseVertex, UINT firstInstance)
+	{
+		m_commandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+		if (m_writer)
+			m_writer->DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+	}
+
+	void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT firstVertex, UINT firstInstance)
+	{
+		m_commandList->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+		if (m_writer)
+			m_writer->Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+	}
+
+	void ResourceBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after,
+		UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = resource;
+		barrier.Transition.Subresource = subresource;
+		barrier.Transition.StateBefore = before;
+		barrier.Transition.StateAfter = after;
+		m_commandList->ResourceBarrier(1, &barrier);
+
+		if (m_writer)
+			m_writer->Barrier(FindObject(resource), subresource, before, after, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+	}
+
+	// Transitions and aliasing barriers, which is all a ResourceStateTracker flushes
+	void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers)
+	{
+		m_commandList->ResourceBarrier(count, barriers);
+		if (!m_writer)
+			return;
+
+		for (UINT i = 0; i < count; i++)
+		{
+			if (barriers[i].Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING)
+			{
+				const D3D12_RESOURCE_ALIASING_BARRIER& aliasing = barriers[i].Aliasing;
+				m_writer->AliasingBarrier(aliasing.pResourceBefore ? FindObject(aliasing.pResourceBefore) : CaptureObjectTable::InvalidId,
+					FindObject(aliasing.pResourceAfter));
+				continue;
+			}
+
+			assert(barriers[i].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+			const D3D12_RESOURCE_TRANSITION_BARRIER& transition = barriers[i].Transition;
+			m_writer->Barrier(FindObject(transition.pResource), transition.Subresource, transition.StateBefore, transition.StateAfter,
+				static_cast<uint8_t>(barriers[i].Flags));
+		}
+	}
+
+private:
+	// Anything that isn't registered would replay as garbage, catch it here instead
+	uint16_t FindObject(const void* object) const
+	{
+		const uint16_t id = m_objects.Find(object);
+		assert(id != CaptureObjectTable::InvalidId);
+		return id;
+	}
+
+	CaptureRef FindAddress(UINT64 address) const
+	{
+		const CaptureRef ref = m_objects.Find(address);
+		assert(ref.Object != CaptureObjectTable::InvalidId);
+		return ref;
+	}
+
+	ID3D12GraphicsCommandList* m_commandList;
+	const CaptureObjectTable& m_objects;
+	CaptureWriter* m_writer;
+};
+
+class D3D12ReplayBackend
+{
+public:
+	// Payloads are uploaded into the two rings, which have to be fenced like any other frame data
+	D3D12ReplayBackend(ID3D12GraphicsCommandList* commandList, const CaptureObjectTable& objects,
+		UploadRingBuffer& constants, UploadRingBuffer& shaderResources)
+		: m_commandList(commandList), m_objects(objects), m_constants(constants), m_shaderResources(shaderResources), m_failed(false) { }
+
+	// Set if the payload ring ran out of space
+	bool Failed() const { return m_failed; }
+
+	// Every list in the stream replays into the same command list. Each of them sets
+	// all of its own state, so nothing leaks from one into the next.
+	void BeginList() { }
+
+	void SetPipelineState(uint16_t id) { m_commandList->SetPipelineState(static_cast<ID3D12PipelineState*>(m_objects.GetObject(id))); }
+	void SetRootSignature(uint16_t id) { m_commandList->SetGraphicsRootSignature(static_cast<ID3D12RootSignature*>(m_objects.GetObject(id))); }
+
+	void SetDescriptorHeap(uint16_t id)
+	{
+		ID3D12DescriptorHeap* heap = static_cast<ID3D12DescriptorHeap*>(m_objects.GetObject(id));
+		m_commandList->SetDescriptorHeaps(1, &heap);
+	}
+
+	void SetRootDescriptorTable(uint8_t parameter, const CaptureRef& table)
+	{
+		m_commandList->SetGraphicsRootDescriptorTable(parameter, { m_objects.GetAddress(table) });
+	}
+
+	void SetRootConstantBuffer(uint8_t parameter, const void* data, uint32_t size)
+	{
+		m_commandList->SetGraphicsRootConstantBufferView(parameter, Upload(m_constants, data, size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT));
+	}
+
+	void SetRootShaderResource(uint8_t parameter, const void* data, uint32_t size)
+	{
+		m_commandList->SetGraphicsRootShaderResourceView(parameter, Upload(m_shaderResources, data, size, 256));
+	}
+
+	// Root constants live in the command list, nothing to upload
+	void SetRootConstants(uint8_t parameter, uint32_t offset, const void* values, uint32_t count)
+	{
+		m_commandList->SetGraphicsRoot32BitConstants(parameter, count, values, offset);
+	}
+
+	void SetVertexBuffer(uint8_t slot, const CaptureRef& buffer, uint32_t size, uint32_t stride)
+	{
+		const D3D12_VERTEX_BUFFER_VIEW view = { m_objects.GetAddress(buffer), size, stride };
+		m_commandList->IASetVertexBuffers(slot, 1, &view);
+	}
+
+	void SetIndexBuffer(const CaptureRef& buffer, uint32_t size, uint32_t format)
+	{
+		const D3D12_INDEX_BUFFER_VIEW view = { m_objects.GetAddress(buffer), size, static_cast<DXGI_FORMAT>(format) };
+		m_commandList->IASetIndexBuffer(&view);
+	}
+
+	void SetTopology(uint32_t topology) { m_commandList->IASetPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(topology)); }
+
+	void SetViewport(const float values[6])
+	{
+		const D3D12_VIEWPORT viewport = { values[0], values[1], values[2], values[3], values[4], values[5] };
+		m_commandList->RSSetViewports(1, &viewport);
+	}
+
+	void SetScissorRect(const int32_t values[4])
+	{
+		const D3D12_RECT rect = { values[0], values[1], values[2], values[3] };
+		m_commandList->RSSetScissorRects(1, &rect);
+	}
+
+	void SetRenderTarget(const CaptureRef& renderTarget, const CaptureRef& depthStencil)
+	{
+		const D3D12_CPU_DESCRIPTOR_HANDLE rtv = { static_cast<SIZE_T>(m_objects.GetAddress(renderTarget)) };
+		if (depthStencil.Object == CaptureObjectTable::InvalidId)
+		{
+			m_commandList->OMSetRenderTargets(1, &rtv, false, nullptr);
+			return;
+		}
+
+		const D3D12_CPU_DESCRIPTOR_HANDLE dsv = { static_cast<SIZE_T>(m_objects.GetAddress(depthStencil)) };
+		m_commandList->OMSetRenderTargets(1, &rtv, false, &dsv);
+	}
+
+	void ClearRenderTarget(const CaptureRef& renderTarget, const float color[4])
+	{
+		m_commandList->ClearRenderTargetView({ static_cast<SIZE_T>(m_objects.GetAddress(renderTarget)) }, color, 0, nullptr);
+	}
+
+	void ClearDepthStencil(const CaptureRef& depthStencil, uint32_t flags, float depth, uint8_t stencil)
+	{
+		m_commandList->ClearDepthStencilView({ static_cast<SIZE_T>(m_objects.GetAddress(depthStencil)) },
+			static_cast<D3D12_CLEAR_FLAGS>(flags), depth, stencil, 0, nullptr);
+	}
+
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+	{
+		m_commandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+	}
+
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		m_commandList->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+	}
+
+	void Barrier(uint16_t resource, uint32_t subresource, uint32_t before, uint32_t after, uint8_t flags)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Flags = static_cast<D3D12_RESOURCE_BARRIER_FLAGS>(flags);
+		barrier.Transition.pResource = static_cast<ID3D12Resource*>(m_objects.GetObject(resource));
+		barrier.Transition.Subresource = subresource;
+		barrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(before);
+		barrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(after);
+		m_commandList->ResourceBarrier(1, &barrier);
+	}
+
+	void AliasingBarrier(uint16_t before, uint16_t after)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+		barrier.Aliasing.pResourceBefore = before == CaptureObjectTable::InvalidId ? nullptr : static_cast<ID3D12Resource*>(m_objects.GetObject(before));
+		barrier.Aliasing.pResourceAfter = static_cast<ID3D12Resource*>(m_objects.GetObject(after));
+		m_commandList->ResourceBarrier(1, &barrier);
+	}
+
+private:
+	D3D12_GPU_VIRTUAL_ADDRESS Upload(UploadRingBuffer& ring, const void* data, uint32_t size, UINT64 alignment)
+	{
+		const D3D12_GPU_VIRTUAL_ADDRESS address = ring.Upload(data, size, alignment);
+		if (!address)
+			m_failed = true;
+		return address;
+	}
+
+	ID3D12GraphicsCommandList* m_commandList;
+	const CaptureObjectTable& m_objects;
+	UploadRingBuffer& m_constants;
+	UploadRingBuffer& m_shaderResources;
+	bool m_failed;
+};
@@ -0,0 +1,126 @@
+/**************************************************************
+	Command List Pool
+
+	Allocator + command list pairs for threads that record part of
+	a frame. Every pair handed out by Acquire() is reset and open,
+	and comes back to the pool once the fence value of the frame it
+	was submitted with has completed, the same way the per-frame
+	allocators are recycled. New pairs are only created when none
+	are free, so after a few frames the pool stops growing.
+
+	Acquire() and the fence calls are not thread safe, acquire
+	everything on the render thread and hand the lists out.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <deque>
+#include <vector>
+
+struct PooledCommandList
+{
+	ID3D12CommandAllocator* Allocator;
+	ID3D12GraphicsCommandList* List;
+};
+
+class CommandListPool
+{
+public:
+	CommandListPool() : m_device(nullptr), m_type(D3D12_COMMAND_LIST_TYPE_DIRECT) { }
+
+	~CommandListPool()
+	{
+		for (PooledCommandList& pooled : m_free)
+			Destroy(pooled);
+		for (PooledCommandList& pooled : m_open)
+			Destroy(pooled);
+		for (PendingList& pending : m_inFlight)
+			Destroy(pending.Pooled);
+	}
+
+	CommandListPool(const CommandListPool&) = delete;
+	CommandListPool& operator=(const CommandListPool&) = delete;
+
+	void Init(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type)
+	{
+		m_device = device;
+		m_type = type;
+	}
+
+	HRESULT Acquire(ID3D12PipelineState* initialState, PooledCommandList* pooled)
+	{
+		if (m_free.empty())
+		{
+			PooledCommandList created = {};
+			HRESULT hr = m_device->CreateCommandAllocator(m_type, IID_PPV_ARGS(&created.Allocator));
+			if (FAILED(hr))
+				return hr;
+
+			hr = m_device->CreateCommandList(0, m_type, created.Allocator, initialState, IID_PPV_ARGS(&created.List));
+			if (FAILED(hr))
+			{
+				created.Allocator->Release();
+				return hr;
+			}
+
+			// Created lists start out open, that's all Acquire() promises anyway
+			m_open.push_back(created);
+			*pooled = created;
+			return S_OK;
+		}
+
+		PooledCommandList recycled = m_free.back();
+		m_free.pop_back();
+
+		HRESULT hr = recycled.Allocator->Reset();
+		if (SUCCEEDED(hr))
+			hr = recycled.List->Reset(recycled.Allocator, initialState);
+		if (FAILED(hr))
+		{
+			m_free.push_back(recycled);
+			return hr;
+		}
+
+		m_open.push_back(recycled);
+		*pooled = recycled;
+		return S_OK;
+	}
+
+	// Everything acquired since the last call was submitted with 'fenceValue'.
+	// The lists have to be closed by now.
+	void FinishFrame(UINT64 fenceValue)
+	{
+		for (PooledCommandList& pooled : m_open)
+			m_inFlight.push_back({ pooled, fenceValue });
+		m_open.clear();
+	}
+
+	void ReleaseCompleted(UINT64 completedFenceValue)
+	{
+		while (!m_inFlight.empty() && m_inFlight.front().FenceValue <= completedFenceValue)
+		{
+			m_free.push_back(m_inFlight.front().Pooled);
+			m_inFlight.pop_front();
+		}
+	}
+
+	size_t GetListCount() const { return m_free.size() + m_open.size() + m_inFlight.size(); }
+
+private:
+	struct PendingList
+	{
+		PooledCommandList Pooled;
+		UINT64 FenceValue;
+	};
+
+	static void Destroy(PooledCommandList& pooled)
+	{
+		pooled.List->Release();
+		pooled.Allocator->Release();
+	}
+
+	ID3D12Device* m_device;
+	D3D12_COMMAND_LIST_TYPE m_type;
+	std::vector<PooledCommandList> m_free;
+	std::vector<PooledCommandList> m_open;
+	std::deque<PendingList> m_inFlight;
+};
@@ -0,0 +1,36 @@
+/**************************************************************
+	Content Hash
+
+	64 bit FNV-1a over bytes, for naming things by what's in
+	them: cached shaders, pipeline states. Not cryptographic, it
+	only has to tell different inputs apart and give the same
+	value for the same input on every run and every machine.
+	Hash a value's fields one by one rather than the whole
+	struct, padding bytes aren't guaranteed to match.
+**************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+static constexpr uint64_t ContentHashSeed = 14695981039346656037ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = ContentHashSeed)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+// With the terminator, so "ab" + "c" and "a" + "bc" differ
+inline uint64_t HashString(const char* text, uint64_t hash = ContentHashSeed)
+{
+	return HashBytes(text, text ? strlen(text) + 1 : 0, hash);
+}
+
+template <typename T>
+inline uint64_t HashValue(const T& value, uint64_t hash = ContentHashSeed)
+{
+	return HashBytes(&value, sizeof(T), hash);
+}
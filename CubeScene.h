@@ -0,0 +1,1091 @@
+/**************************************************************
+	Cube Scene
+
+	The app's scene on whatever device it's handed: the cubes and
+	their light, the frame graph with its scene and upscale
+	passes, the material textures streamed in, and everything a
+	frame records, from the per frame constants to the lists the
+	parallel recorder fills. WinMain runs it in the window (or
+	headless on WARP), FrameLoopTest runs it on the null device.
+
+	Root signatures and pipeline states need the real runtime, so
+	they come from the caller: the fixed ones through
+	SetPipelines(), the specialized ones as requests the scene
+	queues and swaps in once they're compiled. The three steps
+	a frame takes line up with FrameLoop::RunFrame:
+
+		Update   once the slot is free, with its completed fence value
+		Record   appends the frame's closed lists, main list first
+		Finish   with the fence value the frame was signaled with
+
+	Render thread only, the recording threads are its own.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include <DirectXColors.h>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "d3dx12.h"
+#include "BatchTransform.h"
+#include "BindlessHeap.h"
+#include "CaptureD3D12.h"
+#include "CommandListPool.h"
+#include "DrawBinding.h"
+#include "DynamicResolution.h"
+#include "FrameGraphD3D12.h"
+#include "Instancing.h"
+#include "ParallelRecorder.h"
+#include "PipelineCompileQueue.h"
+#include "ResourceHeapAllocator.h"
+#include "ResourceStateTracker.h"
+#include "ShaderPermutationKeys.h"
+#include "StagingDescriptorAllocator.h"
+#include "TextureStreamer.h"
+#include "UploadManager.h"
+#include "UploadRingBuffer.h"
+
+#define CBUFFERRINGSIZE (64 * 1024)
+#define INSTANCECOUNT 2			// Raise this for stress scenes, only used by the instanced path
+#define DRAWCOUNT 2				// Same for the one-draw-per-cube path
+#define RECORDMINDRAWS 64		// Fewer draws than this per thread aren't worth a command list of their own
+#define BINDLESSHEAPSIZE 4096	// Textures the shaders can index at once
+#define MATERIALCOUNT 2
+#define FILLLIGHTCOUNT PixelShaderFillLightCount	// See ShaderPermutationKeys.h
+#define DESCRIPTORPAGESIZE 64	// Cpu descriptors per page of the staging allocators
+#define TARGETGPUMS 14.0f		// Gpu time per frame dynamic resolution aims for, some room left under vsync
+
+struct CubeSceneSettings
+{
+	const MappedFile::PathChar* MaterialFiles[MATERIALCOUNT] = {};
+	UINT DrawCount = DRAWCOUNT;
+	UINT InstanceCount = INSTANCECOUNT;
+	UINT RecordThreads = 0;			// Including the render thread, 0 is one per core
+	bool Capture = true;			// Every frame into a compact command stream, see CaptureD3D12.h
+	void (*Log)(const char* text) = nullptr;	// Textures and pipelines as they come in, can be null
+};
+
+// What the caller made for the scene. The material and instanced pipelines are
+// ids RequestPipeline() handed out.
+struct CubeScenePipelines
+{
+	ID3D12RootSignature* RootSignature;
+	ID3D12RootSignature* DrawRootSignatures[DRAW_BINDING_COUNT];	// Base plus each DrawBinding's parameter
+	ID3D12PipelineState* InitialState;		// Lists start out with it, every draw sets the PSO it needs anyway
+	ID3D12PipelineState* UpscaleState;
+	uint32_t MaterialPipelines[DRAW_BINDING_COUNT][MATERIALCOUNT];
+	uint32_t InstancedPipeline;
+};
+
+class CubeScene
+{
+public:
+	CubeScene()
+		: m_device(nullptr), m_uploads(nullptr), m_resourceHeaps(nullptr), m_commandList(nullptr), m_pipelines(),
+		m_vertexBuffer(nullptr), m_indexBuffer(nullptr), m_timestampHeap(nullptr), m_timestampReadback(nullptr)
+	{
+	}
+
+	~CubeScene()
+	{
+		if (m_commandList) m_commandList->Release();
+		if (m_timestampHeap) m_timestampHeap->Release();
+		if (m_timestampReadback) m_timestampReadback->Release();
+		for (ID3D12Resource* buffer : { m_vertexBuffer, m_indexBuffer })
+		{
+			if (buffer && m_resourceHeaps)
+				m_resourceHeaps->Free(buffer);
+			else if (buffer)
+				buffer->Release();
+		}
+	}
+
+	CubeScene(const CubeScene&) = delete;
+	CubeScene& operator=(const CubeScene&) = delete;
+
+	// The back buffers start out in PRESENT and are only referenced. 'uploads' has its
+	// copies waited on by 'queue', 'heaps' is the one 'uploads' places its buffers in
+	// and can be null. The main list is created with 'allocator' and left closed.
+	HRESULT Init(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12CommandAllocator* allocator, ID3D12Resource* const* backBuffers,
+		UINT backBufferCount, UploadManager* uploads, ResourceHeapAllocator* heaps, const CubeSceneSettings& settings)
+	{
+		m_device = device;
+		m_uploads = uploads;
+		m_resourceHeaps = heaps;
+		m_settings = settings;
+		m_backBuffers.assign(backBuffers, backBuffers + backBufferCount);
+
+		HRESULT hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator, nullptr, IID_PPV_ARGS(&m_commandList));
+		if (FAILED(hr))
+			return hr;
+		m_commandList->Close();
+
+		// Every RTV, DSV and SRV view is created in one of these cpu only allocators
+		// instead of a heap of its own
+		m_rtvDescriptors.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, DESCRIPTORPAGESIZE);
+		m_dsvDescriptors.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DESCRIPTORPAGESIZE);
+		m_srvDescriptors.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, DESCRIPTORPAGESIZE);
+
+		// Frames ask for the state they need, the tracker turns that into barriers
+		m_renderTargetViews.resize(backBufferCount);
+		for (UINT frame = 0; frame < backBufferCount; frame++)
+		{
+			m_resourceStates.Register(m_backBuffers[frame], D3D12_RESOURCE_STATE_PRESENT);
+			m_renderTargetViews[frame] = m_rtvDescriptors.Allocate();
+			if (!m_renderTargetViews[frame].IsValid())
+				return E_OUTOFMEMORY;
+			device->CreateRenderTargetView(m_backBuffers[frame], nullptr, m_renderTargetViews[frame].Handle);
+		}
+
+		// 4-Component vectors representing our view matrix info
+		m_eye = DirectX::XMFLOAT4(0.0f, 0.0f, -2.0f, 1.0f);
+		m_focus = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		m_up = DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+		m_model = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f);
+		m_view = DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat4(&m_eye), DirectX::XMLoadFloat4(&m_focus), DirectX::XMLoadFloat4(&m_up));
+		m_proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(45.0f), 4.0f / 3.0f, 0.1f, 300.0f);
+
+		m_cBuffer = {};
+		m_cBuffer.World = DirectX::XMMatrixTranspose(m_model * m_view * m_proj);
+		m_cBuffer.light.Position = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		m_cBuffer.light.Color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+
+		// Dim lights above, below and behind the rings, only seen by materials that ask for them
+		m_cBuffer.fillLights[0] = { DirectX::XMFLOAT4(0.0f, 4.0f, -2.0f, 1.0f), DirectX::XMFLOAT4(0.4f, 0.4f, 0.5f, 1.0f) };
+		m_cBuffer.fillLights[1] = { DirectX::XMFLOAT4(0.0f, -4.0f, -2.0f, 1.0f), DirectX::XMFLOAT4(0.3f, 0.2f, 0.2f, 1.0f) };
+		m_cBuffer.fillLights[2] = { DirectX::XMFLOAT4(0.0f, 0.0f, 6.0f, 1.0f), DirectX::XMFLOAT4(0.2f, 0.3f, 0.2f, 1.0f) };
+
+		// Constant buffers get 256 byte aligned slices of this buffer: the frame's and the
+		// upscale's, plus one per draw with the root CBV binding. Slices are handed back
+		// to the ring once the fence of the frame that used them has completed.
+		const UINT64 cbvRingSize = backBufferCount * (2 * RingAllocator::AlignUp(sizeof(ConstantBuffer), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+			+ settings.DrawCount * RingAllocator::AlignUp(sizeof(InstanceData), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT));
+		hr = m_cbvRing.Init(device, cbvRingSize > CBUFFERRINGSIZE ? cbvRingSize : CBUFFERRINGSIZE);
+		if (FAILED(hr))
+			return hr;
+
+		// Enough room for every instance, or every draw with the structured buffer binding,
+		// of every frame in flight
+		hr = m_instanceRing.Init(device, backBufferCount * (RingAllocator::AlignUp(sizeof(InstanceData) * settings.InstanceCount, 256)
+			+ RingAllocator::AlignUp(sizeof(InstanceData) * settings.DrawCount, 256)));
+		if (FAILED(hr))
+			return hr;
+
+		// Every texture lives in one big shader visible heap and shaders pick theirs by
+		// slot, so the heap and its table are bound once per command list and never change
+		hr = m_bindless.Init(device, BINDLESSHEAPSIZE);
+		if (FAILED(hr))
+			return hr;
+
+		// The textures are read and parsed on a worker while the caller builds everything
+		// else, Record() records their uploads and Update() swaps them in once the gpu has
+		// them. Until then a material points at a slot that only ever holds a null view. A
+		// loaded texture gets a fresh slot, so no descriptor a frame in flight still
+		// reads is ever rewritten.
+		m_textureStreamer.reset(new TextureStreamer(device, heaps));
+		m_nullTexture = m_bindless.Allocate();
+		m_cBuffer.Material = m_nullTexture;
+		for (UINT material = 0; material < MATERIALCOUNT; material++)
+		{
+			m_materialFutures[material] = m_textureStreamer->LoadAsync(settings.MaterialFiles[material]);
+			m_materialTextures[material] = m_nullTexture;
+		}
+
+		// The depth buffer only lives for the frame, so it's a transient of the frame
+		// graph rather than a resource of its own. The graph places it and the view is
+		// pointed at whatever resource it ends up in.
+		m_depthStencilView = m_dsvDescriptors.Allocate();
+		if (!m_depthStencilView.IsValid())
+			return E_OUTOFMEMORY;
+
+		const DXGI_FORMAT depthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		m_depthStencilDesc = {};
+		m_depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		m_depthStencilDesc.Width = 800;
+		m_depthStencilDesc.Height = 600;
+		m_depthStencilDesc.DepthOrArraySize = 1;
+		m_depthStencilDesc.MipLevels = 1;
+		m_depthStencilDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
+		m_depthStencilDesc.SampleDesc.Count = 1;
+		m_depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+		m_depthClear.Format = depthStencilFormat;
+		m_depthClear.DepthStencil.Depth = 1.0f;
+		m_depthClear.DepthStencil.Stencil = 0;
+
+		// Create descriptor to mip level 0 of entire resource using the format of the resource.
+		m_dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+		m_dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+		m_dsvDesc.Format = depthStencilFormat;
+		m_dsvDesc.Texture2D.MipSlice = 0;
+
+		// The scene is drawn into a full size target of its own, but only into the top
+		// left part of it dynamic resolution picks, and then stretched over the back buffer
+		m_sceneColorDesc = m_depthStencilDesc;
+		m_sceneColorDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		m_sceneColorDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		m_sceneColorClear = CD3DX12_CLEAR_VALUE(m_sceneColorDesc.Format, ClearColor);
+
+		m_sceneColorView = m_rtvDescriptors.Allocate();
+		m_sceneColorShaderView = m_srvDescriptors.Allocate();
+		if (!m_sceneColorView.IsValid() || !m_sceneColorShaderView.IsValid())
+			return E_OUTOFMEMORY;
+
+		m_frameGraph.Init(device, &m_resourceStates);
+		hr = BuildFrameGraph(m_backBuffers[0]);
+		if (FAILED(hr))
+			return hr;
+
+		hr = CreateCube(queue);
+		if (FAILED(hr))
+			return hr;
+
+		m_viewport = {};
+		m_viewport.Width = 800;
+		m_viewport.Height = 600;
+		m_viewport.MinDepth = 0.0f;
+		m_viewport.MaxDepth = 1.0f;
+		m_scissorRect = CD3DX12_RECT(0, 0, 800, 600);
+
+		// The gpu time of every frame is measured with a timestamp at the start of its
+		// first list and one at the end of its last, and read back once its slot comes
+		// around again. Dynamic resolution picks the scene's size from that.
+		D3D12_QUERY_HEAP_DESC timestampHeapDesc = {};
+		timestampHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+		timestampHeapDesc.Count = 2 * backBufferCount;
+		hr = device->CreateQueryHeap(&timestampHeapDesc, IID_PPV_ARGS(&m_timestampHeap));
+		if (FAILED(hr))
+			return hr;
+
+		const CD3DX12_HEAP_PROPERTIES readbackProperties(D3D12_HEAP_TYPE_READBACK);
+		const CD3DX12_RESOURCE_DESC readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(2 * backBufferCount * sizeof(UINT64));
+		hr = device->CreateCommittedResource(&readbackProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr, IID_PPV_ARGS(&m_timestampReadback));
+		if (FAILED(hr))
+			return hr;
+
+		hr = queue->GetTimestampFrequency(&m_timestampFrequency);
+		if (FAILED(hr))
+			return hr;
+		m_hasTimestamps.assign(backBufferCount, false);
+
+		m_dynamicResolution.Reset(DynamicResolution::DefaultSettings(TARGETGPUMS));
+
+		// Draws are split into chunks recorded on several threads, each into a list of
+		// its own. Constant buffers are allocated up front on the render thread since the
+		// ring isn't thread safe, the recording threads only read the addresses.
+		m_recorder.reset(new ParallelRecorder(settings.RecordThreads, RECORDMINDRAWS));
+		m_commandListPool.Init(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+		m_drawData.resize(settings.DrawCount);
+		m_drawAddresses.resize(settings.DrawCount);
+
+		// One capture writer per recording thread plus one each for the main and present
+		// lists. The pipelines are registered by whoever made them.
+		RegisterCaptureBuffer(m_captureObjects, m_vertexBuffer);
+		RegisterCaptureBuffer(m_captureObjects, m_indexBuffer);
+		for (UINT page = 0; page < m_rtvDescriptors.GetPageCount(); page++)
+			RegisterCaptureHeap(m_captureObjects, device, m_rtvDescriptors.GetPageHeap(page));
+		for (UINT page = 0; page < m_dsvDescriptors.GetPageCount(); page++)
+			RegisterCaptureHeap(m_captureObjects, device, m_dsvDescriptors.GetPageHeap(page));
+		RegisterCaptureHeap(m_captureObjects, device, m_bindless.GetHeap());
+		// The graph's targets are registered as they are now. BuildFrameGraph() swaps in
+		// the new resource under the same id if the graph has to recreate one.
+		for (ID3D12Resource* backBuffer : m_backBuffers)
+			m_captureObjects.Register(backBuffer);
+		m_depthCaptureId = m_captureObjects.Register(m_depthStencilResource);
+		m_sceneColorCaptureId = m_captureObjects.Register(m_sceneColorResource);
+		m_captureWriters.resize(m_recorder->GetThreadCount() + 2);
+
+		// The batch kernel has to agree with the plain DirectXMath path it replaced.
+		// Checked in every build, it's a few dozen matrices.
+		const float batchTransformError = VerifyBatchTransform(m_view * m_proj);
+		if (batchTransformError >= 1e-4f)
+		{
+			Log("BatchTransform is off by " + std::to_string(batchTransformError) + "\n");
+			return E_FAIL;
+		}
+		return S_OK;
+	}
+
+	// The capture table, for the caller's root signatures and pipeline states. Anything
+	// a draw can be recorded with has to be in it.
+	CaptureObjectTable& GetCaptureObjects() { return m_captureObjects; }
+
+	// Queues a specialized pipeline, 'fallback' is drawn with until 'compile' is done.
+	// Every request gets its capture id here, in request order, pointing at the
+	// fallback until the specialized PSO is put in its place. Ids handed out as
+	// compiles finished would differ from run to run, and so would frame.cap. Register
+	// the fallbacks themselves first, so a draw still using one finds the fallback's own id.
+	uint32_t RequestPipeline(ID3D12PipelineState* fallback, std::function<ID3D12PipelineState*()> compile)
+	{
+		m_pipelineCaptureIds.push_back(m_captureObjects.Register(fallback));
+		return m_pipelineQueue.Request(fallback, std::move(compile));
+	}
+
+	void SetPipelines(const CubeScenePipelines& pipelines) { m_pipelines = pipelines; }
+
+	// What the app's keys switch between
+	void SetInstanced(bool instanced) { m_bInstanced = instanced; }
+	bool IsInstanced() const { return m_bInstanced; }
+	void SetDrawBinding(DrawBinding binding) { m_drawBinding = binding; }
+	DrawBinding GetDrawBinding() const { return m_drawBinding; }
+	void SetDynamicResolution(bool enabled) { m_bDynamicResolution = enabled; }
+	bool IsDynamicResolution() const { return m_bDynamicResolution; }
+
+	// 'frameIndex' is the slot whose last frame has just completed
+	HRESULT Update(UINT frameIndex, UINT64 completedFence)
+	{
+		// Outer camera
+		m_eye.x = 5.0f * (std::cos(DirectX::XMConvertToRadians(m_yaw)) * std::cos(DirectX::XMConvertToRadians(m_pitch)));
+		m_eye.y = 5.0f * (std::sin(DirectX::XMConvertToRadians(m_pitch)));
+		m_eye.z = 5.0f * (std::sin(DirectX::XMConvertToRadians(m_yaw)) * std::cos(DirectX::XMConvertToRadians(m_pitch)));
+		m_cBuffer.Eye = m_eye;
+
+		if (m_frameCount % 60 == 0)
+		{
+			m_colorIndex[0] = (m_colorIndex[0] + 1) % _countof(m_randomColors);
+			m_colorIndex[1] = (m_colorIndex[1] + 1) % _countof(m_randomColors);
+		}
+
+		// Camera eye position, Camera eye focus position, Camera orientation
+		m_view = DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat4(&m_eye), DirectX::XMLoadFloat4(&m_focus), DirectX::XMLoadFloat4(&m_up));
+		m_cBuffer.World = DirectX::XMMatrixTranspose(m_model * m_view * m_proj);
+
+		// The frame that last used this slot is done, so its timestamps are in
+		if (m_hasTimestamps[frameIndex])
+		{
+			UINT64* timestamps = nullptr;
+			CD3DX12_RANGE readRange(2 * frameIndex * sizeof(UINT64), 2 * (frameIndex + 1) * sizeof(UINT64));
+			HRESULT hr = m_timestampReadback->Map(0, &readRange, reinterpret_cast<void**>(&timestamps));
+			if (FAILED(hr))
+				return hr;
+			const float gpuMs = float(1000.0 * (timestamps[2 * frameIndex + 1] - timestamps[2 * frameIndex]) / m_timestampFrequency);
+			CD3DX12_RANGE writeRange(0, 0);
+			m_timestampReadback->Unmap(0, &writeRange);
+
+			m_dynamicResolution.Update(gpuMs);
+			m_gpuMsTotal += gpuMs;
+			m_gpuFrameCount++;
+		}
+
+		m_cbvRing.ReleaseCompletedFrames(completedFence);
+		m_commandListPool.ReleaseCompleted(completedFence);
+		m_frameGraph.ReleaseCompleted(completedFence);
+		if (m_resourceHeaps)
+			m_resourceHeaps->ReleaseCompleted(completedFence);
+		for (size_t retired = m_retiredTextures.size(); retired-- > 0;)
+		{
+			const RetiredTexture& texture = m_retiredTextures[retired];
+			if (texture.FenceValue && texture.FenceValue <= completedFence)
+			{
+				m_bindless.Free(texture.Index);
+				m_retiredTextures.erase(m_retiredTextures.begin() + retired);
+			}
+		}
+		m_instanceRing.ReleaseCompletedFrames(completedFence);
+		m_uploads->ReleaseCompleted();
+		m_textureStreamer->Update(m_uploads->GetCompletedFenceValue());
+
+		for (UINT material = 0; material < MATERIALCOUNT; material++)
+		{
+			std::future<TextureLoadResult>& future = m_materialFutures[material];
+			if (!future.valid() || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			const TextureLoadResult loaded = future.get();
+			if (FAILED(loaded.Result))
+				return loaded.Result;
+
+			// The material keeps the null texture if the file isn't a plain 2D one
+			D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc = {};
+			DirectX::GetShaderResourceViewDesc12(loaded.Texture.Get(), loaded.IsCubeMap, &shaderResourceViewDesc);
+			if (!BindlessHeap::CanSample(shaderResourceViewDesc))
+			{
+				Log("Material " + std::to_string(material) + " isn't a 2D texture, skipped\n");
+				continue;
+			}
+
+			const UINT texture = m_bindless.Allocate();
+			const StagingDescriptor view = m_srvDescriptors.Allocate();
+			if (texture == BindlessHeap::InvalidIndex || !view.IsValid())
+				return E_OUTOFMEMORY;
+
+			// Written on the cpu side and copied over with everything else queued this
+			// frame, just before the frame that first samples it is submitted
+			m_materialResources[material] = loaded.Texture;
+			m_materialViews[material] = view;
+			m_device->CreateShaderResourceView(loaded.Texture.Get(), &shaderResourceViewDesc, view.Handle);
+			m_bindless.QueueCopy(texture, view.Handle);
+			m_materialTextures[material] = texture;
+
+			Log(m_textureStreamer->GetStatsString());
+
+			const StagingPool& staging = m_uploads->GetStaging();
+			Log("Staging: peak " + std::to_string(staging.GetPeakUsedSize() / 1024) + " KB of "
+				+ std::to_string(staging.GetCommittedSize() / 1024) + " KB, " + std::to_string(staging.GetAllocationCount()) + " allocations, "
+				+ std::to_string(m_uploads->GetStallCount()) + " stalls, " + std::to_string(m_uploads->GetDedicatedCount()) + " oversized\n");
+		}
+
+		// Specialized PSOs finished since last frame take over from here, in the
+		// capture slot their request was given
+		m_pipelineQueue.Update([&](uint32_t pipeline, ID3D12PipelineState* pipelineState)
+		{
+			m_captureObjects.Set(m_pipelineCaptureIds[pipeline], pipelineState);
+			Log("Pipeline " + std::to_string(pipeline) + " ready at frame " + std::to_string(m_frameCount) + "\n");
+		});
+
+		// The most drawn with gets compiled first
+		const UINT drawCount = m_settings.DrawCount;
+		for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+		{
+			for (UINT material = 0; material < MATERIALCOUNT; material++)
+				m_pipelineQueue.SetPriority(m_pipelines.MaterialPipelines[binding][material], m_bInstanced || binding != m_drawBinding ? 0
+					: drawCount / MATERIALCOUNT + (material < drawCount % MATERIALCOUNT));
+		}
+		m_pipelineQueue.SetPriority(m_pipelines.InstancedPipeline, m_bInstanced ? m_settings.InstanceCount : 0);
+		return S_OK;
+	}
+
+	// Closed lists go into 'lists', main first, then chunk by chunk, then the present list.
+	// 'allocator' is the slot's, already reset.
+	HRESULT Record(UINT frameIndex, ID3D12CommandAllocator* allocator, std::vector<ID3D12CommandList*>& lists)
+	{
+		m_commandList->Reset(allocator, m_pipelines.InitialState);
+		m_commandList->EndQuery(m_timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex);
+
+		// Copies for any texture the workers finished parsing since last frame. The
+		// SRV only switches over once the copy fence has passed, so no gpu wait needed.
+		if (m_textureStreamer->RecordUploads(*m_uploads))
+			m_textureStreamer->Submitted(m_uploads->Submit());
+
+		// How much of the scene target this frame draws to. Same fraction on both
+		// axes, so the projection doesn't change.
+		const UINT sceneWidth = m_bDynamicResolution ? m_dynamicResolution.GetScaledSize(800) : 800;
+		const UINT sceneHeight = m_bDynamicResolution ? m_dynamicResolution.GetScaledSize(600) : 600;
+		m_sceneScaleTotal += sceneWidth / 800.0;
+
+		D3D12_VIEWPORT sceneViewport = m_viewport;
+		sceneViewport.Width = (float)sceneWidth;
+		sceneViewport.Height = (float)sceneHeight;
+		const CD3DX12_RECT sceneScissorRect(0, 0, sceneWidth, sceneHeight);
+
+		// Command lists don't inherit anything from each other, so every list that
+		// draws needs the whole pipeline state set again
+		const D3D12_CPU_DESCRIPTOR_HANDLE sceneRtvHandle = m_sceneColorView.Handle;
+		const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_depthStencilView.Handle;
+		const D3D12_GPU_DESCRIPTOR_HANDLE srvTable = m_bindless.GetGpuHandle(0);
+		auto SetDrawState = [&](CapturedCommandList& commandList, ID3D12RootSignature* rootSignature)
+		{
+			commandList.OMSetRenderTarget(sceneRtvHandle, &dsvHandle);
+			commandList.SetGraphicsRootSignature(rootSignature);
+			commandList.IASetVertexBuffer(0, m_vertexBufferView);
+			commandList.IASetIndexBuffer(m_indexBufferView);
+			commandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			commandList.RSSetScissorRect(sceneScissorRect);
+			commandList.RSSetViewport(sceneViewport);
+			commandList.SetDescriptorHeap(m_bindless.GetHeap());
+			commandList.SetGraphicsRootDescriptorTable(1, srvTable);
+		};
+
+		// Stretches the scene over the back buffer, takes the back buffer to PRESENT
+		// and writes the frame's second timestamp. Has to go in the last list.
+		auto RecordUpscale = [&](CapturedCommandList& commandList)
+		{
+			ConstantBuffer upscaleConstants = m_cBuffer;
+			upscaleConstants.Upscale = DirectX::XMFLOAT4(sceneWidth / 800.0f, sceneHeight / 600.0f, 1.0f / 800.0f, 1.0f / 600.0f);
+			upscaleConstants.Material = m_sceneColorTexture;
+			const D3D12_GPU_VIRTUAL_ADDRESS upscaleAddress = AllocateConstantBuffer(upscaleConstants);
+			if (!upscaleAddress)
+				return E_OUTOFMEMORY;
+
+			m_frameGraph.BeginPass(m_upscalePass, commandList);
+			commandList.OMSetRenderTarget(m_renderTargetViews[frameIndex].Handle, nullptr);
+			commandList.SetPipelineState(m_pipelines.UpscaleState);
+			commandList.SetGraphicsRootSignature(m_pipelines.RootSignature);
+			commandList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			commandList.RSSetScissorRect(m_scissorRect);
+			commandList.RSSetViewport(m_viewport);
+			commandList.SetDescriptorHeap(m_bindless.GetHeap());
+			commandList.SetGraphicsRootDescriptorTable(1, srvTable);
+			commandList.SetGraphicsRootConstantBufferView(0, upscaleAddress, &upscaleConstants, sizeof(ConstantBuffer));
+			commandList.DrawInstanced(3, 1, 0, 0);
+			m_frameGraph.EndFrame(commandList);
+
+			// Not captured, a replayed frame isn't timed on the gpu
+			commandList.Get()->EndQuery(m_timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex + 1);
+			commandList.Get()->ResolveQueryData(m_timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 2 * frameIndex, 2,
+				m_timestampReadback, 2 * frameIndex * sizeof(UINT64));
+			m_hasTimestamps[frameIndex] = true;
+			return S_OK;
+		};
+
+		for (CaptureWriter& writer : m_captureWriters)
+			writer.Clear();
+
+		CapturedCommandList mainList(m_commandList, m_captureObjects, m_settings.Capture ? &m_captureWriters[0] : nullptr);
+		const Clock::time_point graphStart = Clock::now();
+		HRESULT hr = BuildFrameGraph(m_backBuffers[frameIndex]);
+		if (FAILED(hr))
+			return hr;
+		m_graphSeconds += std::chrono::duration<double>(Clock::now() - graphStart).count();
+
+		m_frameGraph.BeginPass(m_scenePass, mainList);
+		SetDrawState(mainList, m_pipelines.RootSignature);
+
+		mainList.ClearRenderTargetView(sceneRtvHandle, ClearColor);
+		mainList.ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0);
+
+		lists.push_back(m_commandList);
+
+		const UINT drawCount = m_settings.DrawCount;
+		const UINT instanceCount = m_settings.InstanceCount;
+		if (m_bInstanced)
+		{
+			// Pack every cube into the instance buffer and draw them all at once
+			m_cBuffer.ViewProj = DirectX::XMMatrixTranspose(m_view * m_proj);
+
+			D3D12_GPU_VIRTUAL_ADDRESS instanceAddress = 0;
+			InstanceData* instanceData = reinterpret_cast<InstanceData*>(
+				m_instanceRing.Allocate(sizeof(InstanceData) * instanceCount, 256, &instanceAddress));
+			const D3D12_GPU_VIRTUAL_ADDRESS frameConstants = AllocateConstantBuffer(m_cBuffer);
+			if (!instanceData || !frameConstants)
+				return E_OUTOFMEMORY;
+
+			const Clock::time_point packStart = Clock::now();
+			PackOrbitInstances(instanceData, instanceCount, (float)m_frameCount, m_randomColors, _countof(m_randomColors), m_colorIndex[0],
+				m_materialTextures, MATERIALCOUNT, m_cubeTransforms);
+			m_packSeconds += std::chrono::duration<double>(Clock::now() - packStart).count();
+			m_packedInstances += instanceCount;
+
+			// The capture reads the instances back out of the upload heap, which is slow
+			// but only this path does it
+			mainList.SetPipelineState(m_pipelineQueue.Get(m_pipelines.InstancedPipeline));
+			mainList.SetGraphicsRootConstantBufferView(0, frameConstants, &m_cBuffer, sizeof(ConstantBuffer));
+			mainList.SetGraphicsRootShaderResourceView(2, instanceAddress, instanceData, sizeof(InstanceData) * instanceCount);
+			mainList.DrawIndexedInstanced(m_indexCount, instanceCount, 0, 0, 0);
+			m_recordedDraws++;
+
+			hr = RecordUpscale(mainList);
+			if (FAILED(hr))
+				return hr;
+		}
+		else
+		{
+			// The cubes orbit the light in rings of 16, evenly spaced. With two of
+			// them that's 180 degrees apart, 2 units out.
+			const UINT perRing = drawCount < INSTANCESPERRING ? drawCount : INSTANCESPERRING;
+			m_cubeTransforms.Resize(drawCount);
+			for (UINT cube = 0; cube < drawCount; cube++)
+			{
+				const float radius = 2.0f + 1.5f * (cube / INSTANCESPERRING);
+				const float angle = DirectX::XMConvertToRadians((float)m_frameCount + 180.0f + (360.0f * (cube % INSTANCESPERRING)) / perRing);
+				m_cubeTransforms.PositionX[cube] = radius * std::cos(angle);
+				m_cubeTransforms.PositionY[cube] = 0.0f;
+				m_cubeTransforms.PositionZ[cube] = radius * std::sin(angle);
+				m_cubeTransforms.RotationY[cube] = 0.0f;
+			}
+
+			// Only the model matrix, ViewProj is applied in the vertex shader like the instanced path
+			BatchTransform(m_cubeTransforms, DirectX::XMMatrixIdentity(), { nullptr, 0, &m_drawData[0].Model, sizeof(InstanceData) });
+
+			for (UINT cube = 0; cube < drawCount; cube++)
+			{
+				DirectX::XMStoreFloat4(&m_drawData[cube].Color, cube > 0 ? m_randomColors[(m_colorIndex[1] + (cube - 1) * 9) % _countof(m_randomColors)]
+					: DirectX::XMLoadFloat4(&m_cBuffer.light.Color));
+				m_drawData[cube].Material = m_materialTextures[cube % MATERIALCOUNT];
+			}
+
+			// The rings aren't thread safe, so everything is uploaded here before the
+			// recording threads start. Per frame constants are one buffer for all draws.
+			m_cBuffer.ViewProj = DirectX::XMMatrixTranspose(m_view * m_proj);
+			const D3D12_GPU_VIRTUAL_ADDRESS frameConstants = AllocateConstantBuffer(m_cBuffer);
+			DrawBindingFrame drawFrame = { m_drawBinding, m_drawData.data(), drawCount, nullptr, 0 };
+			UploadRingBuffer& drawRing = m_drawBinding == DRAW_BINDING_ROOT_CBV ? m_cbvRing : m_instanceRing;
+			if (!frameConstants || !UploadDraws(drawFrame, m_drawAddresses.data(), [&](UINT64 size, UINT64 alignment, D3D12_GPU_VIRTUAL_ADDRESS* address)
+				{
+					return drawRing.Allocate(size, alignment, address);
+				}))
+				return E_OUTOFMEMORY;
+
+			// One list per chunk, acquired here so the recording threads never touch the pool
+			const UINT chunkCount = m_recorder->GetChunkCount(drawCount);
+			m_chunkLists.resize(chunkCount);
+			for (UINT chunk = 0; chunk < chunkCount; chunk++)
+			{
+				hr = m_commandListPool.Acquire(m_pipelines.InitialState, &m_chunkLists[chunk]);
+				if (FAILED(hr))
+					return hr;
+			}
+
+			m_recorder->Record(drawCount, [&](UINT chunk, UINT firstDraw, UINT endDraw)
+			{
+				CapturedCommandList chunkList(m_chunkLists[chunk].List, m_captureObjects, m_settings.Capture ? &m_captureWriters[chunk + 1] : nullptr);
+				SetDrawState(chunkList, m_pipelines.DrawRootSignatures[drawFrame.Binding]);
+				chunkList.SetGraphicsRootConstantBufferView(0, frameConstants, &m_cBuffer, sizeof(ConstantBuffer));
+
+				ID3D12PipelineState* pipelineState = nullptr;
+				RecordBoundDraws(chunkList, drawFrame, firstDraw, endDraw, m_indexCount, [&](uint32_t cube)
+				{
+					// Neighbours usually differ in material, but two that share a PSO (or a fallback) don't switch
+					ID3D12PipelineState* cubePipelineState = m_pipelineQueue.Get(m_pipelines.MaterialPipelines[drawFrame.Binding][cube % MATERIALCOUNT]);
+					if (cubePipelineState != pipelineState)
+					{
+						pipelineState = cubePipelineState;
+						chunkList.SetPipelineState(pipelineState);
+					}
+				});
+				chunkList.Get()->Close();
+			});
+
+			// Chunk order is draw order, so the frame looks the same as one list would
+			for (PooledCommandList& chunkList : m_chunkLists)
+				lists.push_back(chunkList.List);
+			m_recordedDraws += drawCount;
+
+			// The chunks are recorded on other threads and can't transition, so the
+			// upscale and the back buffer's way back to PRESENT go in a short list of
+			// their own after them
+			hr = m_commandListPool.Acquire(nullptr, &m_presentList);
+			if (FAILED(hr))
+				return hr;
+			CapturedCommandList presentList(m_presentList.List, m_captureObjects, m_settings.Capture ? &m_captureWriters.back() : nullptr);
+			hr = RecordUpscale(presentList);
+			if (FAILED(hr))
+				return hr;
+			presentList.Get()->Close();
+			lists.push_back(m_presentList.List);
+		}
+		m_commandList->Close();
+
+		// Lists are submitted main first, then chunk by chunk, then the present list,
+		// so that's the order their streams go into the frame's capture
+		if (m_settings.Capture)
+		{
+			m_frameCapture.clear();
+			for (CaptureWriter& writer : m_captureWriters)
+				m_frameCapture.insert(m_frameCapture.end(), writer.GetBytes().begin(), writer.GetBytes().end());
+			m_capturedBytes += m_frameCapture.size();
+		}
+
+		// Descriptors queued this frame have to be in the shader visible heap before it executes
+		m_bindless.FlushCopies();
+		return S_OK;
+	}
+
+	// Everything allocated this frame is tagged with the fence value it was signaled
+	// with. Nothing waits here, the slot is checked again when we come back around to it.
+	void Finish(UINT64 fenceValue)
+	{
+		m_cbvRing.FinishFrame(fenceValue);
+		m_instanceRing.FinishFrame(fenceValue);
+		m_commandListPool.FinishFrame(fenceValue);
+		m_frameGraph.FinishFrame(fenceValue);
+		if (m_resourceHeaps)
+			m_resourceHeaps->FinishFrame(fenceValue);
+		for (RetiredTexture& texture : m_retiredTextures)
+		{
+			if (!texture.FenceValue)
+				texture.FenceValue = fenceValue;
+		}
+
+		if (++m_frameCount % 60 == 0 && m_packSeconds > 0.0)
+		{
+			Log("Instance packing: " + std::to_string(m_packedInstances / (1000.0 * m_packSeconds)) + " instances/ms\n");
+			m_packSeconds = 0.0;
+			m_packedInstances = 0;
+		}
+	}
+
+	// Replays the last captured frame into the main list, uploading its payloads into
+	// the same rings the frames use. Hand the main list to FinishReplay's frame.
+	HRESULT Replay(ID3D12CommandAllocator* allocator, UINT64 completedFence)
+	{
+		m_cbvRing.ReleaseCompletedFrames(completedFence);
+		m_instanceRing.ReleaseCompletedFrames(completedFence);
+
+		m_commandList->Reset(allocator, m_pipelines.InitialState);
+		D3D12ReplayBackend replayBackend(m_commandList, m_captureObjects, m_cbvRing, m_instanceRing);
+		const bool replayed = ReplayFrame(m_frameCapture.data(), m_frameCapture.size(), replayBackend) && !replayBackend.Failed();
+		m_commandList->Close();
+		return replayed ? S_OK : E_FAIL;
+	}
+
+	void FinishReplay(UINT64 fenceValue)
+	{
+		m_cbvRing.FinishFrame(fenceValue);
+		m_instanceRing.FinishFrame(fenceValue);
+	}
+
+	ID3D12GraphicsCommandList* GetCommandList() const { return m_commandList; }
+	const std::vector<uint8_t>& GetFrameCapture() const { return m_frameCapture; }		// Empty without capture
+	PipelineCompileQueue<ID3D12PipelineState*>& GetPipelineQueue() { return m_pipelineQueue; }
+
+	UINT64 GetFrameCount() const { return m_frameCount; }
+	UINT64 GetRecordedDraws() const { return m_recordedDraws; }
+	UINT GetLoadedMaterialCount() const
+	{
+		UINT loaded = 0;
+		for (UINT material = 0; material < MATERIALCOUNT; material++)
+			loaded += m_materialTextures[material] != m_nullTexture;
+		return loaded;
+	}
+
+	// What a headless run reports at the end, one line each. 'recordSeconds' is the
+	// frame loop's record phase over the same frames.
+	std::string GetStatsString(double recordSeconds) const
+	{
+		if (!m_frameCount)
+			return std::string();
+
+		const double recordMs = 1000.0 * recordSeconds;
+		std::string stats = "Recording: " + std::to_string(m_recordedDraws / recordMs) + " draws/ms on " + std::to_string(m_recorder->GetThreadCount())
+			+ " threads, " + std::to_string(m_commandListPool.GetListCount()) + " pooled command lists\n";
+		if (m_settings.Capture)
+			stats += "Capture: " + std::to_string(m_capturedBytes / m_frameCount) + " bytes/frame\n";
+		stats += "Descriptors: " + std::to_string(m_rtvDescriptors.GetAllocatedCount()) + " RTV, "
+			+ std::to_string(m_dsvDescriptors.GetAllocatedCount()) + " DSV, " + std::to_string(m_srvDescriptors.GetAllocatedCount()) + " SRV staged, "
+			+ std::to_string(m_bindless.GetCopyCount()) + " copied in " + std::to_string(m_bindless.GetCopyBatchCount()) + " batches\n";
+		stats += "Barriers: " + std::to_string(m_resourceStates.GetRequestedCount()) + " transitions asked for, "
+			+ std::to_string(m_resourceStates.GetIssuedCount()) + " barriers in " + std::to_string(m_resourceStates.GetBatchCount()) + " calls, "
+			+ std::to_string(m_resourceStates.GetSkippedCount()) + " redundant, " + std::to_string(m_resourceStates.GetMergedCount()) + " merged\n";
+		stats += "Frame graph: " + std::to_string(1000000.0 * m_graphSeconds / m_frameCount) + " us/frame to build and compile, "
+			+ std::to_string(m_frameGraph.GetHeapSize() / 1024) + " KB transient heap, " + std::to_string(m_frameGraph.GetCreatedCount()) + " placed resources created\n";
+		if (m_gpuFrameCount)
+			stats += "Dynamic resolution: " + std::to_string(m_gpuMsTotal / m_gpuFrameCount) + " ms/frame gpu, average scale "
+				+ std::to_string(m_sceneScaleTotal / m_frameCount) + "\n";
+		stats += "Pipeline queue: " + std::to_string(m_pipelineQueue.GetReadyCount()) + " of " + std::to_string(m_pipelineQueue.GetRequestCount())
+			+ " specialized PSOs swapped in, " + std::to_string(m_pipelineQueue.GetFailedCount()) + " failed\n";
+		return stats;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Light
+	{
+		DirectX::XMFLOAT4 Position;
+		DirectX::XMFLOAT4 Color;
+	};
+
+	// Shaders.hlsl's cbuffer, for the frame and for the upscale
+	struct ConstantBuffer
+	{
+		DirectX::XMMATRIX World;
+		DirectX::XMMATRIX Model;
+		DirectX::XMMATRIX ViewProj;
+
+		Light light;
+		Light fillLights[FILLLIGHTCOUNT];
+
+		DirectX::XMFLOAT4 Eye;
+
+		DirectX::XMFLOAT4 Upscale;
+
+		UINT Material;
+	};
+
+	struct Vertex
+	{
+		DirectX::XMFLOAT3 Position;
+		DirectX::XMFLOAT2 TexCoord;
+		DirectX::XMFLOAT3 Normal;
+
+		Vertex(float px, float py, float pz, float u, float v, float nx, float ny, float nz)
+			: Position(px, py, pz), TexCoord(u, v), Normal(nx, ny, nz) { }
+
+		Vertex() { }
+	};
+
+	// Bindless slots the scene target had before the graph's heap grew, freed once the
+	// frames that sampled them are done. FenceValue is 0 until the frame is submitted.
+	struct RetiredTexture
+	{
+		UINT Index;
+		UINT64 FenceValue;
+	};
+
+	static constexpr float ClearColor[4] = { 0.0f, 0.0f, 0.2f, 1.0f };
+
+	void Log(const std::string& text) const
+	{
+		if (m_settings.Log)
+			m_settings.Log(text.c_str());
+	}
+
+	// 0 if the ring is too small for the amount of draws in flight
+	D3D12_GPU_VIRTUAL_ADDRESS AllocateConstantBuffer(const ConstantBuffer& constants)
+	{
+		return m_cbvRing.Upload(&constants, sizeof(ConstantBuffer), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	}
+
+	// The scene pass draws into the scene target and the depth buffer, the upscale
+	// pass reads the scene target and writes the back buffer. Built again every
+	// frame, the placed targets carry over as long as nothing about them changes.
+	HRESULT BuildFrameGraph(ID3D12Resource* backBuffer)
+	{
+		m_frameGraph.Reset();
+		const uint32_t backBufferTarget = m_frameGraph.Import("Back buffer", backBuffer, D3D12_RESOURCE_STATE_PRESENT);
+		const uint32_t sceneTarget = m_frameGraph.CreateTexture("Scene color", m_sceneColorDesc, &m_sceneColorClear);
+		const uint32_t depthTarget = m_frameGraph.CreateTexture("Depth", m_depthStencilDesc, &m_depthClear);
+
+		m_scenePass = m_frameGraph.AddPass("Scene");
+		m_frameGraph.Write(sceneTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		m_frameGraph.Write(depthTarget, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		m_upscalePass = m_frameGraph.AddPass("Upscale");
+		m_frameGraph.Read(sceneTarget, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		m_frameGraph.Write(backBufferTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		HRESULT hr = m_frameGraph.Compile();
+		if (FAILED(hr))
+			return hr;
+
+		ID3D12Resource* depthResource = m_frameGraph.GetResource(depthTarget);
+		if (depthResource != m_depthStencilResource)
+		{
+			m_depthStencilResource = depthResource;
+			m_device->CreateDepthStencilView(m_depthStencilResource, &m_dsvDesc, m_depthStencilView.Handle);
+			if (m_depthCaptureId != CaptureObjectTable::InvalidId)
+				m_captureObjects.Set(m_depthCaptureId, m_depthStencilResource);
+		}
+
+		// A new resource gets a new bindless slot, frames still in flight may read the
+		// old one, so it's only retired. Only happens when the graph's heap has to grow.
+		ID3D12Resource* sceneResource = m_frameGraph.GetResource(sceneTarget);
+		if (sceneResource != m_sceneColorResource)
+		{
+			m_sceneColorResource = sceneResource;
+			m_device->CreateRenderTargetView(m_sceneColorResource, nullptr, m_sceneColorView.Handle);
+			m_device->CreateShaderResourceView(m_sceneColorResource, nullptr, m_sceneColorShaderView.Handle);
+			if (m_sceneColorCaptureId != CaptureObjectTable::InvalidId)
+				m_captureObjects.Set(m_sceneColorCaptureId, m_sceneColorResource);
+
+			if (m_sceneColorTexture != BindlessHeap::InvalidIndex)
+				m_retiredTextures.push_back({ m_sceneColorTexture, 0 });
+			m_sceneColorTexture = m_bindless.Allocate();
+			if (m_sceneColorTexture == BindlessHeap::InvalidIndex)
+				return E_OUTOFMEMORY;
+			m_bindless.QueueCopy(m_sceneColorTexture, m_sceneColorShaderView.Handle);
+		}
+		return S_OK;
+	}
+
+	// Copied into default heaps on the copy queue, 'queue' holds off on anything
+	// submitted after this until the copies are done. Nothing on the cpu waits.
+	HRESULT CreateCube(ID3D12CommandQueue* queue)
+	{
+		// Frank luna and hooman used the std::array so I'm following in their
+		// footsteps :)
+		std::array<Vertex, 24> vertices;
+		// Fill in the front face vertex data.
+		vertices[0] =  Vertex(-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f);
+		vertices[1] =  Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
+		vertices[2] =  Vertex(+0.5f, +0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f);
+		vertices[3] =  Vertex(+0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, 0.0f, -1.0f);
+
+		vertices[4] =  Vertex(-0.5f, -0.5f, +0.5f, 1.0f, 1.0f, 0.0f, 0.0f, +1.0f);
+		vertices[5] =  Vertex(+0.5f, -0.5f, +0.5f, 0.0f, 1.0f, 0.0f, 0.0f, +1.0f);
+		vertices[6] =  Vertex(+0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, 0.0f, +1.0f);
+		vertices[7] =  Vertex(-0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, 0.0f, +1.0f);
+
+		vertices[8] =  Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 1.0f, 0.0f, +1.0f, 0.0f);
+		vertices[9] =  Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, +1.0f, 0.0f);
+		vertices[10] = Vertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, +1.0f, 0.0f);
+		vertices[11] = Vertex(+0.5f, +0.5f, -0.5f, 1.0f, 1.0f, 0.0f, +1.0f, 0.0f);
+
+		vertices[12] = Vertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, -1.0f, 0.0f);
+		vertices[13] = Vertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f);
+		vertices[14] = Vertex(+0.5f, -0.5f, +0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f);
+		vertices[15] = Vertex(-0.5f, -0.5f, +0.5f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f);
+
+		vertices[16] = Vertex(-0.5f, -0.5f, +0.5f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
+		vertices[17] = Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
+		vertices[18] = Vertex(-0.5f, +0.5f, -0.5f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
+		vertices[19] = Vertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f);
+
+		vertices[20] = Vertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, +1.0f, 0.0f, 0.0f);
+		vertices[21] = Vertex(+0.5f, +0.5f, -0.5f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f);
+		vertices[22] = Vertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, +1.0f, 0.0f, 0.0f);
+		vertices[23] = Vertex(+0.5f, -0.5f, +0.5f, 1.0f, 1.0f, +1.0f, 0.0f, 0.0f);
+
+		std::array<std::uint16_t, 36> indices;
+		// Fill in the front face index data
+		indices[0] = 0; indices[1] = 1; indices[2] = 2;
+		indices[3] = 0; indices[4] = 2; indices[5] = 3;
+
+		// Fill in the back face index data
+		indices[6] = 4; indices[7] = 5; indices[8] = 6;
+		indices[9] = 4; indices[10] = 6; indices[11] = 7;
+
+		// Fill in the top face index data
+		indices[12] = 8; indices[13] = 9; indices[14] = 10;
+		indices[15] = 8; indices[16] = 10; indices[17] = 11;
+
+		// Fill in the bottom face index data
+		indices[18] = 12; indices[19] = 13; indices[20] = 14;
+		indices[21] = 12; indices[22] = 14; indices[23] = 15;
+
+		// Fill in the left face index data
+		indices[24] = 16; indices[25] = 17; indices[26] = 18;
+		indices[27] = 16; indices[28] = 18; indices[29] = 19;
+
+		// Fill in the right face index data
+		indices[30] = 20; indices[31] = 21; indices[32] = 22;
+		indices[33] = 20; indices[34] = 22; indices[35] = 23;
+
+		const UINT vBufferSize = sizeof(Vertex) * (UINT)std::size(vertices);
+		const UINT iBufferSize = sizeof(std::uint16_t) * (UINT)std::size(indices);
+		m_indexCount = (UINT)std::size(indices);
+
+		HRESULT hr = m_uploads->CreateBuffer(vertices.data(), vBufferSize, &m_vertexBuffer);
+		if (FAILED(hr))
+			return hr;
+
+		m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
+		m_vertexBufferView.SizeInBytes = vBufferSize;
+		m_vertexBufferView.StrideInBytes = sizeof(Vertex);
+
+		hr = m_uploads->CreateBuffer(indices.data(), iBufferSize, &m_indexBuffer);
+		if (FAILED(hr))
+			return hr;
+
+		m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
+		m_indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+		m_indexBufferView.SizeInBytes = iBufferSize;
+
+		m_uploads->GpuWait(queue, m_uploads->Submit());
+		return S_OK;
+	}
+
+	ID3D12Device* m_device;
+	UploadManager* m_uploads;
+	ResourceHeapAllocator* m_resourceHeaps;
+	CubeSceneSettings m_settings;
+
+	// Constant Buffer and instance data (one upload buffer each, mapped for the lifetime of the scene)
+	UploadRingBuffer m_cbvRing;
+	UploadRingBuffer m_instanceRing;
+
+	StagingDescriptorAllocator m_rtvDescriptors;
+	StagingDescriptorAllocator m_dsvDescriptors;
+	StagingDescriptorAllocator m_srvDescriptors;
+	ResourceStateTracker m_resourceStates;
+
+	std::vector<ID3D12Resource*> m_backBuffers;
+	std::vector<StagingDescriptor> m_renderTargetViews;
+	ID3D12GraphicsCommandList* m_commandList;
+
+	ConstantBuffer m_cBuffer;
+	DirectX::XMFLOAT4 m_eye, m_focus, m_up;
+	DirectX::XMMATRIX m_model, m_view, m_proj;
+	float m_pitch = 30.0f;
+	float m_yaw = -90.0f;
+
+	BindlessHeap m_bindless;
+	std::unique_ptr<TextureStreamer> m_textureStreamer;
+	std::future<TextureLoadResult> m_materialFutures[MATERIALCOUNT];
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_materialResources[MATERIALCOUNT];
+	StagingDescriptor m_materialViews[MATERIALCOUNT] = {};		// Kept so the view can be copied again
+	UINT32 m_materialTextures[MATERIALCOUNT] = {};
+	UINT m_nullTexture = BindlessHeap::InvalidIndex;
+
+	D3D12_RESOURCE_DESC m_depthStencilDesc;
+	D3D12_CLEAR_VALUE m_depthClear;
+	D3D12_DEPTH_STENCIL_VIEW_DESC m_dsvDesc;
+	StagingDescriptor m_depthStencilView = {};
+	ID3D12Resource* m_depthStencilResource = nullptr;
+	D3D12_RESOURCE_DESC m_sceneColorDesc;
+	CD3DX12_CLEAR_VALUE m_sceneColorClear;
+	StagingDescriptor m_sceneColorView = {};
+	StagingDescriptor m_sceneColorShaderView = {};
+	ID3D12Resource* m_sceneColorResource = nullptr;
+	UINT32 m_sceneColorTexture = BindlessHeap::InvalidIndex;
+	std::vector<RetiredTexture> m_retiredTextures;
+
+	FrameGraphD3D12 m_frameGraph;
+	UINT m_scenePass = 0;
+	UINT m_upscalePass = 0;
+	double m_graphSeconds = 0.0;
+
+	// Everything a frame references, by id, so captured frames don't hold pointers.
+	// The graph's targets keep their ids when they're recreated.
+	CaptureObjectTable m_captureObjects;
+	uint16_t m_depthCaptureId = CaptureObjectTable::InvalidId;
+	uint16_t m_sceneColorCaptureId = CaptureObjectTable::InvalidId;
+
+	CubeScenePipelines m_pipelines;
+	PipelineCompileQueue<ID3D12PipelineState*> m_pipelineQueue;
+	std::vector<uint16_t> m_pipelineCaptureIds;		// By request
+
+	ID3D12Resource* m_vertexBuffer;
+	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView = {};
+	ID3D12Resource* m_indexBuffer;
+	D3D12_INDEX_BUFFER_VIEW m_indexBufferView = {};
+	UINT m_indexCount = 0;
+	D3D12_VIEWPORT m_viewport;
+	CD3DX12_RECT m_scissorRect;
+
+	ID3D12QueryHeap* m_timestampHeap;
+	ID3D12Resource* m_timestampReadback;
+	UINT64 m_timestampFrequency = 1;
+	std::vector<bool> m_hasTimestamps;		// Per slot, its last frame wrote both timestamps
+
+	DynamicResolution m_dynamicResolution;
+	bool m_bDynamicResolution = true;
+	double m_gpuMsTotal = 0.0, m_sceneScaleTotal = 0.0;
+	UINT64 m_gpuFrameCount = 0;
+
+	bool m_bInstanced = false;
+	DrawBinding m_drawBinding = DRAW_BINDING_ROOT_CBV;
+	UINT64 m_frameCount = 0;
+	double m_packSeconds = 0.0;
+	UINT64 m_packedInstances = 0;
+
+	// Cube transforms are built for the whole scene in one batch before any draw
+	TransformSoA m_cubeTransforms;
+	std::vector<InstanceData> m_drawData;
+
+	std::unique_ptr<ParallelRecorder> m_recorder;
+	CommandListPool m_commandListPool;
+	std::vector<uint64_t> m_drawAddresses;		// Root CBV binding only
+	std::vector<PooledCommandList> m_chunkLists;
+	PooledCommandList m_presentList = {};
+	UINT64 m_recordedDraws = 0;
+
+	std::vector<CaptureWriter> m_captureWriters;
+	std::vector<uint8_t> m_frameCapture;
+	UINT64 m_capturedBytes = 0;
+
+	DirectX::XMVECTOR m_randomColors[20] =
+	{
+		DirectX::Colors::Blue,
+		DirectX::Colors::DarkGreen,
+		DirectX::Colors::Aqua,
+		DirectX::Colors::Gold,
+		DirectX::Colors::MediumPurple,
+
+		DirectX::Colors::Lavender,
+		DirectX::Colors::Lavender,
+		DirectX::Colors::DarkTurquoise,
+		DirectX::Colors::DarkTurquoise,
+		DirectX::Colors::Cyan,
+
+		DirectX::Colors::ForestGreen,
+		DirectX::Colors::Wheat,
+		DirectX::Colors::Plum,
+		DirectX::Colors::Tomato,
+		DirectX::Colors::Silver,
+
+		DirectX::Colors::OrangeRed,
+		DirectX::Colors::Violet,
+		DirectX::Colors::RoyalBlue,
+		DirectX::Colors::LimeGreen,
+		DirectX::Colors::Bisque
+	};
+	UINT m_colorIndex[2] = { 0, 9 };
+};
@@ -0,0 +1,206 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParser.h
+//
+// Platform neutral part of the DDS loader: header validation, format lookup and
+// subresource layout. Nothing in here touches a file, a Win32 API or a D3D device,
+// so it builds anywhere <dxgiformat.h> is available (on Linux that's the stand-in
+// in the repo's Linux directory).
+//
+// Split out of DDSTextureLoader.cpp, see there for the original copyright notice.
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef DDS_PARSER_H
+#define DDS_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <dxgiformat.h>
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+namespace DirectX
+{
+    enum DDS_ALPHA_MODE
+    {
+        DDS_ALPHA_MODE_UNKNOWN       = 0,
+        DDS_ALPHA_MODE_STRAIGHT      = 1,
+        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+        DDS_ALPHA_MODE_OPAQUE        = 3,
+        DDS_ALPHA_MODE_CUSTOM        = 4,
+    };
+
+    enum DDS_PARSE_RESULT
+    {
+        DDS_PARSE_OK = 0,
+        DDS_PARSE_FAIL,                 // Not a DDS file, or the header is broken
+        DDS_PARSE_INVALID_DATA,         // Header is readable but contradicts itself
+        DDS_PARSE_NOT_SUPPORTED,        // Valid DDS, but not something we can create
+        DDS_PARSE_END_OF_FILE,          // Header promises more data than the file has
+    };
+
+    // Values match D3D12_RESOURCE_DIMENSION
+    enum DDS_DIMENSION
+    {
+        DDS_DIMENSION_UNKNOWN   = 0,
+        DDS_DIMENSION_TEXTURE1D = 2,
+        DDS_DIMENSION_TEXTURE2D = 3,
+        DDS_DIMENSION_TEXTURE3D = 4,
+    };
+
+    // Everything needed to create the resource, with no D3D types involved
+    struct DDSTextureDesc
+    {
+        DDS_DIMENSION   dimension;
+        uint32_t        width;
+        uint32_t        height;
+        uint32_t        depth;
+        uint32_t        arraySize;      // Already multiplied by 6 for cube maps
+        uint32_t        mipCount;       // Mips actually kept, after maxsize
+        uint32_t        skipMip;        // Top mips dropped because of maxsize
+        DXGI_FORMAT     format;
+        bool            isCubeMap;
+        DDS_ALPHA_MODE  alphaMode;
+    };
+
+    // Same meaning as D3D12_SUBRESOURCE_DATA, pointing into the source data
+    struct DDSSubresource
+    {
+        const void*     data;
+        size_t          rowPitch;
+        size_t          slicePitch;
+    };
+
+    size_t BitsPerPixel( DXGI_FORMAT fmt );
+
+    void GetSurfaceInfo( size_t width,
+                         size_t height,
+                         DXGI_FORMAT fmt,
+                         size_t* outNumBytes,
+                         size_t* outRowBytes,
+                         size_t* outNumRows );
+
+    DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf );
+
+    DXGI_FORMAT MakeSRGB( DXGI_FORMAT format );
+
+    DDS_ALPHA_MODE GetAlphaMode( const DDS_HEADER* header );
+
+    // Checks the magic number and headers, and finds where the texture bits start
+    DDS_PARSE_RESULT ParseDDSHeader( const uint8_t* ddsData,
+                                     size_t ddsDataSize,
+                                     const DDS_HEADER** header,
+                                     const uint8_t** bitData,
+                                     size_t* bitSize );
+
+    // Works out dimension, size, format and array size from a validated header.
+    // mipCount and skipMip are for the full chain, maxsize is applied later.
+    DDS_PARSE_RESULT GetDDSTextureDesc( const DDS_HEADER* header,
+                                        DDSTextureDesc& desc );
+
+    // Lays out every subresource (array slice major, mip minor) over bitData,
+    // dropping top mips larger than maxsize. Updates desc to the kept mips.
+    DDS_PARSE_RESULT FillDDSSubresources( DDSTextureDesc& desc,
+                                          size_t maxsize,
+                                          const uint8_t* bitData,
+                                          size_t bitSize,
+                                          std::vector<DDSSubresource>& subresources );
+
+    // All of the above in one go
+    DDS_PARSE_RESULT ParseDDSTexture( const uint8_t* ddsData,
+                                      size_t ddsDataSize,
+                                      size_t maxsize,
+                                      DDSTextureDesc& desc,
+                                      std::vector<DDSSubresource>& subresources );
+}
+
+#endif
@@ -24,7 +24,7 @@
 
 #include <wrl.h>
 #include <d3d11_1.h>
-#include "d3dx12.h"
+#include "DDSTextureLoader12.h"   // The D3D12 functions, which build without D3D11
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -46,13 +46,10 @@
 
 namespace DirectX
 {
-    enum DDS_ALPHA_MODE
+    enum DDS_LOADER_FLAGS
     {
-        DDS_ALPHA_MODE_UNKNOWN       = 0,
-        DDS_ALPHA_MODE_STRAIGHT      = 1,
-        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
-        DDS_ALPHA_MODE_OPAQUE        = 3,
-        DDS_ALPHA_MODE_CUSTOM        = 4,
+        DDS_LOADER_DEFAULT           = 0,
+        DDS_LOADER_MEMORY_MAPPED     = 0x1,  // Map the file and upload straight from the mapping, no heap copy
     };
 
     // Standard version
@@ -65,16 +62,6 @@ namespace DirectX
                                         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                       );
 
-	HRESULT CreateDDSTextureFromMemory12(_In_ ID3D12Device* device,
-		                                 _In_ ID3D12GraphicsCommandList* cmdList,
-		                                 _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
-		                                 _In_ size_t ddsDataSize,
-		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
-		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
-		                                 _In_ size_t maxsize = 0,
-		                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-		                                 );
-
     HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
                                       _In_z_ const wchar_t* szFileName,
                                       _Outptr_opt_ ID3D11Resource** texture,
@@ -89,7 +76,8 @@ namespace DirectX
 		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
 		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
 		                               _In_ size_t maxsize = 0,
-		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+		                               _In_ unsigned int loadFlags = DDS_LOADER_DEFAULT
 		                               );
 
     // Standard version with optional auto-gen mipmap support
@@ -0,0 +1,399 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureLoader12.cpp
+//
+// The Direct3D 12 half of the DDS loader: resource descriptions, resource creation
+// and the upload through a command list. Nothing here touches files or D3D11, so it
+// builds anywhere there is a d3d12.h (see Linux/ for the stand-in).
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "DDSTextureLoader12.h"
+
+using namespace Microsoft::WRL;
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+static HRESULT GetTextureResourceDesc12(
+	_In_ uint32_t resDim,
+	_In_ size_t width,
+	_In_ size_t height,
+	_In_ size_t depth,
+	_In_ size_t mipCount,
+	_In_ size_t arraySize,
+	_In_ DXGI_FORMAT format,
+	D3D12_RESOURCE_DESC* texDesc
+	)
+{
+	switch (resDim)
+	{
+	case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+		// 1D arrays are just DepthOrArraySize > 1
+		*texDesc = CD3DX12_RESOURCE_DESC::Tex1D(format, width, (uint16_t)arraySize, (uint16_t)mipCount);
+		return S_OK;
+
+	case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
+		// Cube maps (and cube arrays) are 2D arrays with 6 slices per cube, the
+		// parser has already multiplied arraySize out. Only the SRV tells them apart.
+		*texDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, (uint32_t)height, (uint16_t)arraySize, (uint16_t)mipCount);
+		return S_OK;
+
+	case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+		*texDesc = CD3DX12_RESOURCE_DESC::Tex3D(format, width, (uint32_t)height, (uint16_t)depth, (uint16_t)mipCount);
+		return S_OK;
+
+	default:
+		return E_FAIL;
+	}
+}
+
+static HRESULT CreateTextureResource12(
+	ID3D12Device* device,
+	_In_ uint32_t resDim,
+	_In_ size_t width,
+	_In_ size_t height,
+	_In_ size_t depth,
+	_In_ size_t mipCount,
+	_In_ size_t arraySize,
+	_In_ DXGI_FORMAT format,
+	ComPtr<ID3D12Resource>& texture
+	)
+{
+	if (device == nullptr)
+		return E_POINTER;
+
+	D3D12_RESOURCE_DESC texDesc;
+	HRESULT hr = GetTextureResourceDesc12(resDim, width, height, depth, mipCount, arraySize, format, &texDesc);
+	if (FAILED(hr))
+		return hr;
+
+	const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	hr = device->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&texture)
+		);
+
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+	}
+
+	return hr;
+}
+
+static HRESULT CreateD3DResources12(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	_In_ uint32_t resDim,
+	_In_ size_t width,
+	_In_ size_t height,
+	_In_ size_t depth,
+	_In_ size_t mipCount,
+	_In_ size_t arraySize,
+	_In_ DXGI_FORMAT format,
+	_In_ bool forceSRGB,
+	_In_ bool isCubeMap,
+	_In_reads_opt_(mipCount*arraySize) D3D12_SUBRESOURCE_DATA* initData,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap
+	)
+{
+	UNREFERENCED_PARAMETER(isCubeMap);		// Only the SRV cares, see GetShaderResourceViewDesc12
+
+	if (device == nullptr)
+		return E_POINTER;
+
+	if (forceSRGB)
+		format = MakeSRGB(format);
+
+	HRESULT hr = CreateTextureResource12(device, resDim, width, height, depth, mipCount, arraySize, format, texture);
+	if (FAILED(hr))
+		return hr;
+
+	// Volume textures have one subresource per mip, their depth slices live inside it
+	const D3D12_RESOURCE_DESC texDesc = texture->GetDesc();
+	const UINT numSubresources = (texDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+		? texDesc.MipLevels
+		: texDesc.DepthOrArraySize * texDesc.MipLevels;
+	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(texture.Get(), 0, numSubresources);
+
+	const CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	const CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
+	hr = device->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&uploadBufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&textureUploadHeap));
+	if (FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	// The texture starts out in COMMON, so the copy promotes it to COPY_DEST
+	// on any queue without a barrier. On a copy queue it decays back to
+	// COMMON by itself, and the graphics queue promotes it to a shader
+	// resource on first use. Copy lists can't transition to
+	// PIXEL_SHADER_RESOURCE anyway.
+	const bool copyQueue = cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY;
+
+	// Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
+	UpdateSubresources(cmdList, texture.Get(), textureUploadHeap.Get(), 0, 0, numSubresources, initData);
+
+	if (!copyQueue)
+	{
+		const CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		cmdList->ResourceBarrier(1, &barrier);
+	}
+
+	return S_OK;
+}
+
+static HRESULT CreateTextureFromDDS12(
+	_In_ ID3D12Device* device,
+	_In_opt_ ID3D12GraphicsCommandList* cmdList,
+	_In_ const DDS_HEADER* header,
+	_In_reads_bytes_(bitSize) const uint8_t* bitData,
+	_In_ size_t bitSize,
+	_In_ size_t maxsize,
+	_In_ bool forceSRGB,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap)
+{
+	UNREFERENCED_PARAMETER(forceSRGB);
+
+	DDSTextureDesc desc;
+	DDS_PARSE_RESULT result = GetDDSTextureDesc(header, desc);
+	if (result != DDS_PARSE_OK)
+	{
+		return HResultFromDDSParseResult(result);
+	}
+
+	std::vector<DDSSubresource> subresources;
+	result = FillDDSSubresources(desc, maxsize, bitData, bitSize, subresources);
+	if (result != DDS_PARSE_OK)
+	{
+		return HResultFromDDSParseResult(result);
+	}
+
+	return CreateDDSTextureFromDesc12(device, cmdList, desc,
+		subresources.data(), subresources.size(), texture, textureUploadHeap);
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureResource12(
+	ID3D12Device* device,
+	const DDSTextureDesc& desc,
+	ComPtr<ID3D12Resource>& texture
+	)
+{
+	if (!device)
+	{
+		return E_INVALIDARG;
+	}
+
+	return CreateTextureResource12(
+		device,
+		desc.dimension, desc.width, desc.height, desc.depth,
+		desc.mipCount,
+		desc.arraySize,
+		desc.format,
+		texture);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSResourceDesc12(
+	const DDSTextureDesc& desc,
+	D3D12_RESOURCE_DESC* resourceDesc
+	)
+{
+	return GetTextureResourceDesc12(
+		desc.dimension, desc.width, desc.height, desc.depth,
+		desc.mipCount,
+		desc.arraySize,
+		desc.format,
+		resourceDesc);
+}
+
+_Use_decl_annotations_
+void DirectX::GetShaderResourceViewDesc12(
+	ID3D12Resource* texture,
+	bool isCubeMap,
+	D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc
+	)
+{
+	const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+	ZeroMemory(srvDesc, sizeof(D3D12_SHADER_RESOURCE_VIEW_DESC));
+	srvDesc->Format = desc.Format;
+	srvDesc->Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	switch (desc.Dimension)
+	{
+	case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+		if (desc.DepthOrArraySize > 1)
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+			srvDesc->Texture1DArray.MipLevels = desc.MipLevels;
+			srvDesc->Texture1DArray.ArraySize = desc.DepthOrArraySize;
+		}
+		else
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+			srvDesc->Texture1D.MipLevels = desc.MipLevels;
+		}
+		break;
+
+	case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
+		if (isCubeMap && desc.DepthOrArraySize > 6)
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+			srvDesc->TextureCubeArray.MipLevels = desc.MipLevels;
+			srvDesc->TextureCubeArray.NumCubes = desc.DepthOrArraySize / 6;
+		}
+		else if (isCubeMap)
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc->TextureCube.MipLevels = desc.MipLevels;
+		}
+		else if (desc.DepthOrArraySize > 1)
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc->Texture2DArray.MipLevels = desc.MipLevels;
+			srvDesc->Texture2DArray.ArraySize = desc.DepthOrArraySize;
+		}
+		else
+		{
+			srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc->Texture2D.MipLevels = desc.MipLevels;
+		}
+		break;
+
+	case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+		srvDesc->ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+		srvDesc->Texture3D.MipLevels = desc.MipLevels;
+		break;
+	}
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromDesc12(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const DDSTextureDesc& desc,
+	const DDSSubresource* subresources,
+	size_t subresourceCount,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap
+	)
+{
+	if (!device || !cmdList || !subresources)
+	{
+		return E_INVALIDARG;
+	}
+
+	if (subresourceCount != size_t(desc.mipCount) * desc.arraySize)
+	{
+		return E_INVALIDARG;
+	}
+
+	// Create the texture
+	std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData(
+		new (std::nothrow) D3D12_SUBRESOURCE_DATA[subresourceCount]
+		);
+
+	if (!initData)
+	{
+		return E_OUTOFMEMORY;
+	}
+
+	for (size_t i = 0; i < subresourceCount; i++)
+	{
+		initData[i].pData = subresources[i].data;
+		initData[i].RowPitch = static_cast<LONG_PTR>(subresources[i].rowPitch);
+		initData[i].SlicePitch = static_cast<LONG_PTR>(subresources[i].slicePitch);
+	}
+
+	return CreateD3DResources12(
+		device, cmdList,
+		desc.dimension, desc.width, desc.height, desc.depth,
+		desc.mipCount,
+		desc.arraySize,
+		desc.format,
+		false, // forceSRGB
+		desc.isCubeMap,
+		initData.get(),
+		texture, 
+		textureUploadHeap);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemory12(
+	ID3D12Device* device,
+	_In_ ID3D12GraphicsCommandList* cmdList,
+	_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+	_In_ size_t ddsDataSize,
+	ComPtr<ID3D12Resource>& texture,
+	ComPtr<ID3D12Resource>& textureUploadHeap,
+	_In_ size_t maxsize,
+	_Out_opt_ DDS_ALPHA_MODE* alphaMode
+	)
+{
+	if (alphaMode)
+		(*alphaMode) = DDS_ALPHA_MODE_UNKNOWN;
+
+	if (!device || !cmdList || !ddsData || !ddsDataSize)
+	{
+		return E_INVALIDARG;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
+
+	HRESULT hr = HResultFromDDSParseResult(ParseDDSHeader(ddsData, ddsDataSize, &header, &bitData, &bitSize));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	hr = CreateTextureFromDDS12(
+		device,
+		cmdList,
+		header,
+		bitData,
+		bitSize,
+		maxsize,
+		false,
+		texture,
+		textureUploadHeap
+		);
+
+	if (SUCCEEDED(hr))
+	{
+		if (alphaMode)
+			(*alphaMode) = GetAlphaMode(header);
+	}
+
+	return hr;
+}
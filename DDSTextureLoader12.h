@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureLoader12.h
+//
+// Functions for creating a Direct3D 12 texture from a DDS file that is already in
+// memory or already parsed. Only needs d3d12.h, DDSTextureLoader.h adds the D3D11
+// loader and the file loading on top.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef DDS_TEXTURE_LOADER_12_H
+#define DDS_TEXTURE_LOADER_12_H
+
+#include <d3d12.h>
+#include <wrl.h>
+#include <stdint.h>
+#include "d3dx12.h"
+#include "DDSParser.h"   // DDS_ALPHA_MODE and the device independent parsing
+
+#ifndef _Use_decl_annotations_
+#define _Use_decl_annotations_
+#endif
+
+namespace DirectX
+{
+    // Maps the platform neutral parser results back to what this loader always returned
+    inline HRESULT HResultFromDDSParseResult( DDS_PARSE_RESULT result )
+    {
+        switch( result )
+        {
+        case DDS_PARSE_OK:              return S_OK;
+        case DDS_PARSE_INVALID_DATA:    return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        case DDS_PARSE_NOT_SUPPORTED:   return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+        case DDS_PARSE_END_OF_FILE:     return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+        default:                        return E_FAIL;
+        }
+    }
+
+	HRESULT CreateDDSTextureFromMemory12(_In_ ID3D12Device* device,
+		                                 _In_ ID3D12GraphicsCommandList* cmdList,
+		                                 _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+		                                 _In_ size_t ddsDataSize,
+		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                                 _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
+		                                 _In_ size_t maxsize = 0,
+		                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+		                                 );
+
+	// Only creates the texture (in D3D12_RESOURCE_STATE_COMMON), filling it is up to the
+	// caller. For uploaders that manage their own staging memory.
+	HRESULT CreateDDSTextureResource12(_In_ ID3D12Device* device,
+		                               _In_ const DDSTextureDesc& desc,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture
+		                               );
+
+	// The description CreateDDSTextureResource12 creates the texture with, for callers
+	// that want to put it in memory of their own
+	HRESULT GetDDSResourceDesc12(_In_ const DDSTextureDesc& desc,
+		                         _Out_ D3D12_RESOURCE_DESC* resourceDesc
+		                         );
+
+	// Fills in an SRV covering every mip and slice of 'texture', whatever its dimension.
+	// Cube maps look like 2D arrays to D3D12, so the caller has to say which it is.
+	void GetShaderResourceViewDesc12(_In_ ID3D12Resource* texture,
+		                             _In_ bool isCubeMap,
+		                             _Out_ D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc
+		                             );
+
+	// Creates the texture from a DDS that was already parsed (see DDSParser.h), so file I/O
+	// and parsing can happen somewhere else, e.g. on a worker thread
+	HRESULT CreateDDSTextureFromDesc12(_In_ ID3D12Device* device,
+		                               _In_ ID3D12GraphicsCommandList* cmdList,
+		                               _In_ const DDSTextureDesc& desc,
+		                               _In_reads_(subresourceCount) const DDSSubresource* subresources,
+		                               _In_ size_t subresourceCount,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap
+		                               );
+}
+
+#endif
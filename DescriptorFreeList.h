@@ -0,0 +1,81 @@
+/**************************************************************
+	Descriptor Free List
+
+	Hands out indices in [0, capacity) and takes them back, from
+	any number of threads at once without a lock. An index stays
+	put until it's freed, so it can live in constant buffers and
+	materials for as long as the thing it describes does.
+
+	Free indices form a linked list threaded through 'm_next'.
+	The head packs the first free index with a counter that goes
+	up on every change, so a head that was popped and pushed back
+	in between (ABA) still fails the compare exchange.
+
+	Nothing D3D12 specific in here, see BindlessHeap for the heap
+	it manages.
+**************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+class DescriptorFreeList
+{
+public:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	explicit DescriptorFreeList(uint32_t capacity = 0) { Reset(capacity); }
+
+	DescriptorFreeList(const DescriptorFreeList&) = delete;
+	DescriptorFreeList& operator=(const DescriptorFreeList&) = delete;
+
+	// Frees everything. Not thread safe.
+	void Reset(uint32_t capacity)
+	{
+		m_capacity = capacity;
+		m_next.reset(capacity ? new std::atomic<uint32_t>[capacity] : nullptr);
+		for (uint32_t i = 0; i < capacity; i++)
+			m_next[i].store(i + 1 < capacity ? i + 1 : InvalidIndex, std::memory_order_relaxed);
+
+		m_head.store(Pack(capacity ? 0 : InvalidIndex, 0), std::memory_order_release);
+	}
+
+	// Returns InvalidIndex when every index is in use
+	uint32_t Allocate()
+	{
+		uint64_t head = m_head.load(std::memory_order_acquire);
+		for (;;)
+		{
+			const uint32_t index = IndexOf(head);
+			if (index == InvalidIndex)
+				return InvalidIndex;
+
+			// May be stale if another thread popped 'index' meanwhile, the tag catches that
+			const uint32_t next = m_next[index].load(std::memory_order_relaxed);
+			if (m_head.compare_exchange_weak(head, Pack(next, TagOf(head) + 1), std::memory_order_acquire, std::memory_order_acquire))
+				return index;
+		}
+	}
+
+	void Free(uint32_t index)
+	{
+		uint64_t head = m_head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			m_next[index].store(IndexOf(head), std::memory_order_relaxed);
+			if (m_head.compare_exchange_weak(head, Pack(index, TagOf(head) + 1), std::memory_order_release, std::memory_order_relaxed))
+				return;
+		}
+	}
+
+	uint32_t GetCapacity() const { return m_capacity; }
+
+private:
+	static uint64_t Pack(uint32_t index, uint32_t tag) { return (uint64_t(tag) << 32) | index; }
+	static uint32_t IndexOf(uint64_t head) { return static_cast<uint32_t>(head); }
+	static uint32_t TagOf(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+	std::atomic<uint64_t> m_head;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+	uint32_t m_capacity;
+};
@@ -0,0 +1,131 @@
+/**************************************************************
+	Draw Binding
+
+	Three ways for the one-draw-per-cube path to hand each draw
+	its InstanceData, the same struct the instanced path reads:
+
+	Root constants: all 21 dwords go into the command list with
+	the draw. Nothing is uploaded, but they're the biggest root
+	argument there is.
+
+	Root CBV: every draw gets its own 256 byte slice of the
+	constant buffer ring, the command list only holds the address.
+
+	Structured buffer: every draw's data in one block of the
+	instance ring, bound once per command list and indexed by a
+	single root constant (SV_InstanceID doesn't count the start
+	instance, so that can't carry it).
+
+	Per frame data, the lights, the eye and ViewProj, is one
+	constant buffer for the whole frame in all three. Each binding
+	has a root signature of its own, the base one plus parameter
+	DrawBindingParameter, and a VSMain compiled with BINDING set
+	to match (see Shaders.hlsl).
+
+	Nothing D3D specific: uploads go through whatever allocate
+	function the caller passes, and recording works on anything
+	with the same Set calls as CapturedCommandList, so the cost of
+	each can be measured without a device.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "Instancing.h"
+
+enum DrawBinding : uint32_t
+{
+	DRAW_BINDING_ROOT_CONSTANTS,
+	DRAW_BINDING_ROOT_CBV,
+	DRAW_BINDING_STRUCTURED_BUFFER,
+	DRAW_BINDING_COUNT
+};
+
+static const char* const DrawBindingNames[DRAW_BINDING_COUNT] = { "root constants", "root CBV", "structured buffer" };
+
+// Parameter the per draw data goes in, after the base root signature's CBV, table and SRV.
+// The structured buffer is the base signature's SRV.
+static constexpr uint32_t DrawBindingParameter = 3;
+static constexpr uint32_t DrawBufferParameter = 2;
+static constexpr uint32_t DrawRootConstantCount = sizeof(InstanceData) / sizeof(uint32_t);
+static_assert(sizeof(InstanceData) % sizeof(uint32_t) == 0, "InstanceData has to be whole dwords to go in root constants");
+
+// Where a frame's draw data ended up, UploadDraws() fills in the addresses
+struct DrawBindingFrame
+{
+	DrawBinding Binding;
+	const InstanceData* Draws;		// Cpu side, root constants are read from here and the capture copies it
+	uint32_t DrawCount;
+	const uint64_t* DrawAddresses;	// Root CBV, one per draw
+	uint64_t BufferAddress;			// Structured buffer, where draw 0 is
+};
+
+// Copies the draws where frame.Binding reads them from. 'allocate(size, alignment, &gpuAddress)'
+// hands out upload memory like UploadRingBuffer::Allocate(), 'drawAddresses' has room
+// for one address per draw. False if an allocation failed.
+template <typename AllocateFunc>
+bool UploadDraws(DrawBindingFrame& frame, uint64_t* drawAddresses, AllocateFunc allocate)
+{
+	switch (frame.Binding)
+	{
+	case DRAW_BINDING_ROOT_CONSTANTS:
+		return true;
+
+	case DRAW_BINDING_ROOT_CBV:
+		for (uint32_t draw = 0; draw < frame.DrawCount; draw++)
+		{
+			void* data = allocate(sizeof(InstanceData), 256, &drawAddresses[draw]);
+			if (!data)
+				return false;
+			memcpy(data, &frame.Draws[draw], sizeof(InstanceData));
+		}
+		frame.DrawAddresses = drawAddresses;
+		return true;
+
+	case DRAW_BINDING_STRUCTURED_BUFFER:
+	{
+		void* data = allocate(sizeof(InstanceData) * frame.DrawCount, 256, &frame.BufferAddress);
+		if (!data)
+			return false;
+		memcpy(data, frame.Draws, sizeof(InstanceData) * frame.DrawCount);
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+// Records draws 'firstDraw' to 'endDraw' - 1 into one command list. The root signature
+// for frame.Binding has to be set already. 'beforeDraw(draw)' runs ahead of each one,
+// for anything else that changes between draws like the PSO.
+template <typename CommandList, typename BeforeDrawFunc>
+void RecordBoundDraws(CommandList& list, const DrawBindingFrame& frame, uint32_t firstDraw, uint32_t endDraw, uint32_t indexCount,
+	BeforeDrawFunc beforeDraw)
+{
+	// Only this list's part of the buffer, so a capture doesn't copy all of it per list
+	if (frame.Binding == DRAW_BINDING_STRUCTURED_BUFFER)
+		list.SetGraphicsRootShaderResourceView(DrawBufferParameter, frame.BufferAddress + sizeof(InstanceData) * firstDraw,
+			&frame.Draws[firstDraw], static_cast<uint32_t>(sizeof(InstanceData) * (endDraw - firstDraw)));
+
+	for (uint32_t draw = firstDraw; draw < endDraw; draw++)
+	{
+		beforeDraw(draw);
+
+		if (frame.Binding == DRAW_BINDING_ROOT_CONSTANTS)
+		{
+			list.SetGraphicsRoot32BitConstants(DrawBindingParameter, DrawRootConstantCount, &frame.Draws[draw], 0);
+		}
+		else if (frame.Binding == DRAW_BINDING_ROOT_CBV)
+		{
+			list.SetGraphicsRootConstantBufferView(DrawBindingParameter, frame.DrawAddresses[draw], &frame.Draws[draw],
+				static_cast<uint32_t>(sizeof(InstanceData)));
+		}
+		else
+		{
+			const uint32_t index = draw - firstDraw;
+			list.SetGraphicsRoot32BitConstants(DrawBindingParameter, 1, &index, 0);
+		}
+
+		list.DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+	}
+}
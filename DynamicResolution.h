@@ -0,0 +1,110 @@
+/**************************************************************
+	Dynamic Resolution
+
+	Picks how much of the render target the scene is drawn into,
+	from how long the gpu took for the frames before. The targets
+	keep their full size, only the viewport shrinks, and the
+	upscale pass stretches that part over the back buffer.
+
+	Gpu time goes up with the pixel count, so what's controlled
+	is the area fraction, the scale on each axis is its square
+	root. The controller is a PI controller in velocity form on
+	the log of the area:
+
+		e = (target - time) / target
+		log(area) += Kp * (e - previous e) + Ki * e
+
+	Working on the log makes one step the same relative change
+	at any resolution, and the velocity form can't wind up while
+	the area is clamped at either end. Frame times only arrive
+	BUFFERCOUNT frames late, so the gains are kept low, the times
+	are smoothed first, and errors inside a small dead band leave
+	it where it is so noise doesn't make the resolution flicker.
+
+	Nothing D3D12 specific, it's fed milliseconds and hands back
+	a scale, so it can be driven by recorded or made up traces.
+**************************************************************/
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+class DynamicResolution
+{
+public:
+	struct Settings
+	{
+		float TargetMs;			// Gpu time per frame to aim for
+		float MinScale;			// Per axis
+		float MaxScale;
+		float ProportionalGain;
+		float IntegralGain;
+		float Smoothing;		// Weight of the newest time in the running average
+		float DeadBand;			// Relative error that counts as on target
+	};
+
+	static Settings DefaultSettings(float targetMs)
+	{
+		Settings settings;
+		settings.TargetMs = targetMs;
+		settings.MinScale = 0.5f;
+		settings.MaxScale = 1.0f;
+		settings.ProportionalGain = 0.3f;
+		settings.IntegralGain = 0.1f;
+		settings.Smoothing = 0.3f;
+		settings.DeadBand = 0.05f;
+		return settings;
+	}
+
+	DynamicResolution() { Reset(DefaultSettings(16.0f)); }
+
+	void Reset(const Settings& settings)
+	{
+		m_settings = settings;
+		m_logArea = 2.0f * std::log(settings.MaxScale);
+		m_smoothedMs = 0.0f;
+		m_previousError = 0.0f;
+		m_frameCount = 0;
+	}
+
+	// One frame's gpu time in, the scale for the next frame to be recorded out
+	float Update(float gpuMs)
+	{
+		m_smoothedMs = m_frameCount++ ? m_smoothedMs + m_settings.Smoothing * (gpuMs - m_smoothedMs) : gpuMs;
+
+		// Inside the dead band nothing moves at all. Counting it as an error of zero
+		// would have the proportional term kick back the other way on the way in.
+		const float error = (m_settings.TargetMs - m_smoothedMs) / m_settings.TargetMs;
+		if (std::fabs(error) < m_settings.DeadBand)
+		{
+			m_previousError = 0.0f;
+			return GetScale();
+		}
+
+		m_logArea += m_settings.ProportionalGain * (error - m_previousError) + m_settings.IntegralGain * error;
+		m_previousError = error;
+
+		const float minLogArea = 2.0f * std::log(m_settings.MinScale);
+		const float maxLogArea = 2.0f * std::log(m_settings.MaxScale);
+		m_logArea = m_logArea < minLogArea ? minLogArea : m_logArea > maxLogArea ? maxLogArea : m_logArea;
+		return GetScale();
+	}
+
+	float GetScale() const { return std::exp(0.5f * m_logArea); }
+	float GetSmoothedMs() const { return m_smoothedMs; }
+	const Settings& GetSettings() const { return m_settings; }
+
+	// 'fullSize' scaled and rounded down to a multiple of 8 pixels, so small changes
+	// in the scale don't move the viewport every frame
+	uint32_t GetScaledSize(uint32_t fullSize) const
+	{
+		const uint32_t size = static_cast<uint32_t>(fullSize * GetScale()) & ~7u;
+		return size ? size : (fullSize < 8 ? fullSize : 8);
+	}
+
+private:
+	Settings m_settings;
+	float m_logArea;
+	float m_smoothedMs;
+	float m_previousError;
+	uint32_t m_frameCount;
+};
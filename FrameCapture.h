@@ -0,0 +1,480 @@
+/**************************************************************
+	Frame Capture
+
+	A compact binary encoding of the commands a frame records, so
+	a frame can be replayed later as a fixed workload: same draws,
+	same constants, no input, no timing dependence.
+
+	Every command is a one byte opcode followed by its arguments.
+	Objects (root signatures, PSOs, buffers, descriptor heaps) are
+	never stored as pointers. They're registered in a
+	CaptureObjectTable up front and referenced as an id plus a byte
+	offset into them, so the same stream works in another process
+	as long as the objects are registered in the same order.
+	Constant buffer and root SRV contents are stored inline, the
+	memory they came from is long gone by replay time.
+
+	Nothing in here is D3D specific. ReplayFrame() decodes into any
+	backend that has a method per opcode (see CaptureD3D12.h for
+	the one that drives a real command list).
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+enum CaptureOp : uint8_t
+{
+	CAPTURE_BEGIN_LIST,
+	CAPTURE_SET_PIPELINE_STATE,
+	CAPTURE_SET_ROOT_SIGNATURE,
+	CAPTURE_SET_DESCRIPTOR_HEAP,
+	CAPTURE_SET_ROOT_DESCRIPTOR_TABLE,
+	CAPTURE_SET_ROOT_CONSTANT_BUFFER,
+	CAPTURE_SET_ROOT_SHADER_RESOURCE,
+	CAPTURE_SET_VERTEX_BUFFER,
+	CAPTURE_SET_INDEX_BUFFER,
+	CAPTURE_SET_TOPOLOGY,
+	CAPTURE_SET_VIEWPORT,
+	CAPTURE_SET_SCISSOR_RECT,
+	CAPTURE_SET_RENDER_TARGET,
+	CAPTURE_CLEAR_RENDER_TARGET,
+	CAPTURE_CLEAR_DEPTH_STENCIL,
+	CAPTURE_DRAW_INDEXED,
+	CAPTURE_BARRIER,
+	CAPTURE_ALIASING_BARRIER,
+	CAPTURE_DRAW,
+	CAPTURE_SET_ROOT_CONSTANTS,
+	CAPTURE_OP_COUNT
+};
+
+// An object and a byte offset into it, e.g. a buffer and where a view starts
+struct CaptureRef
+{
+	uint16_t Object;
+	uint32_t Offset;
+};
+
+// Maps objects, and address ranges inside them, to small ids. Registration happens
+// once at startup, lookups are read only so any number of threads can capture at once.
+class CaptureObjectTable
+{
+public:
+	static constexpr uint16_t InvalidId = 0xffff;
+
+	// 'start'/'size' describe the address range the object owns (gpu virtual
+	// addresses, descriptor handles), pass 0 for objects only referenced by pointer
+	uint16_t Register(void* object, uint64_t start = 0, uint64_t size = 0)
+	{
+		m_entries.push_back({ object, start, size });
+		return static_cast<uint16_t>(m_entries.size() - 1);
+	}
+
+	uint16_t Find(const void* object) const
+	{
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			if (m_entries[i].Object == object)
+				return static_cast<uint16_t>(i);
+		}
+		return InvalidId;
+	}
+
+	CaptureRef Find(uint64_t address) const
+	{
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			const Entry& entry = m_entries[i];
+			if (address >= entry.Start && address - entry.Start < entry.Size)
+				return { static_cast<uint16_t>(i), static_cast<uint32_t>(address - entry.Start) };
+		}
+		return { InvalidId, 0 };
+	}
+
+	// Puts another object in the id's place, a recreated resource or the pipeline that
+	// took over from a fallback. Streams captured from here on refer to it by that id.
+	void Set(uint16_t id, void* object) { m_entries[id].Object = object; }
+
+	void* GetObject(uint16_t id) const { return m_entries[id].Object; }
+	uint64_t GetAddress(const CaptureRef& ref) const { return m_entries[ref.Object].Start + ref.Offset; }
+
+private:
+	struct Entry
+	{
+		void* Object;
+		uint64_t Start;
+		uint64_t Size;
+	};
+
+	std::vector<Entry> m_entries;
+};
+
+// Appends commands to a byte stream. Clear() keeps the capacity, so once a frame
+// has been captured the next ones don't allocate.
+class CaptureWriter
+{
+public:
+	void Clear() { m_bytes.clear(); }
+	void Reserve(size_t size) { m_bytes.reserve(size); }
+
+	const std::vector<uint8_t>& GetBytes() const { return m_bytes; }
+
+	void BeginList() { Op(CAPTURE_BEGIN_LIST); }
+	void SetPipelineState(uint16_t pipelineState) { Op(CAPTURE_SET_PIPELINE_STATE); Put(pipelineState); }
+	void SetRootSignature(uint16_t rootSignature) { Op(CAPTURE_SET_ROOT_SIGNATURE); Put(rootSignature); }
+	void SetDescriptorHeap(uint16_t heap) { Op(CAPTURE_SET_DESCRIPTOR_HEAP); Put(heap); }
+
+	void SetRootDescriptorTable(uint8_t parameter, const CaptureRef& table)
+	{
+		Op(CAPTURE_SET_ROOT_DESCRIPTOR_TABLE); Put(parameter); Put(table);
+	}
+
+	void SetRootConstantBuffer(uint8_t parameter, const void* data, uint32_t size)
+	{
+		Op(CAPTURE_SET_ROOT_CONSTANT_BUFFER); Put(parameter); Put(size); PutBytes(data, size);
+	}
+
+	void SetRootShaderResource(uint8_t parameter, const void* data, uint32_t size)
+	{
+		Op(CAPTURE_SET_ROOT_SHADER_RESOURCE); Put(parameter); Put(size); PutBytes(data, size);
+	}
+
+	void SetRootConstants(uint8_t parameter, uint32_t offset, const void* data, uint32_t count)
+	{
+		Op(CAPTURE_SET_ROOT_CONSTANTS); Put(parameter); Put(offset); Put(count); PutBytes(data, count * sizeof(uint32_t));
+	}
+
+	void SetVertexBuffer(uint8_t slot, const CaptureRef& buffer, uint32_t size, uint32_t stride)
+	{
+		Op(CAPTURE_SET_VERTEX_BUFFER); Put(slot); Put(buffer); Put(size); Put(stride);
+	}
+
+	void SetIndexBuffer(const CaptureRef& buffer, uint32_t size, uint32_t format)
+	{
+		Op(CAPTURE_SET_INDEX_BUFFER); Put(buffer); Put(size); Put(format);
+	}
+
+	void SetTopology(uint32_t topology) { Op(CAPTURE_SET_TOPOLOGY); Put(topology); }
+
+	// x, y, width, height, min depth, max depth
+	void SetViewport(const float viewport[6]) { Op(CAPTURE_SET_VIEWPORT); PutBytes(viewport, 6 * sizeof(float)); }
+
+	// left, top, right, bottom
+	void SetScissorRect(const int32_t rect[4]) { Op(CAPTURE_SET_SCISSOR_RECT); PutBytes(rect, 4 * sizeof(int32_t)); }
+
+	// depthStencil.Object is InvalidId when there is none
+	void SetRenderTarget(const CaptureRef& renderTarget, const CaptureRef& depthStencil)
+	{
+		Op(CAPTURE_SET_RENDER_TARGET); Put(renderTarget); Put(depthStencil);
+	}
+
+	void ClearRenderTarget(const CaptureRef& renderTarget, const float color[4])
+	{
+		Op(CAPTURE_CLEAR_RENDER_TARGET); Put(renderTarget); PutBytes(color, 4 * sizeof(float));
+	}
+
+	void ClearDepthStencil(const CaptureRef& depthStencil, uint32_t flags, float depth, uint8_t stencil)
+	{
+		Op(CAPTURE_CLEAR_DEPTH_STENCIL); Put(depthStencil); Put(flags); Put(depth); Put(stencil);
+	}
+
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+	{
+		Op(CAPTURE_DRAW_INDEXED); Put(indexCount); Put(instanceCount); Put(firstIndex); Put(baseVertex); Put(firstInstance);
+	}
+
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		Op(CAPTURE_DRAW); Put(vertexCount); Put(instanceCount); Put(firstVertex); Put(firstInstance);
+	}
+
+	// 'flags' marks the begin and end halves of a split barrier
+	void Barrier(uint16_t resource, uint32_t subresource, uint32_t before, uint32_t after, uint8_t flags)
+	{
+		Op(CAPTURE_BARRIER); Put(resource); Put(subresource); Put(before); Put(after); Put(flags);
+	}
+
+	// 'before' is InvalidId for any resource sharing the memory
+	void AliasingBarrier(uint16_t before, uint16_t after)
+	{
+		Op(CAPTURE_ALIASING_BARRIER); Put(before); Put(after);
+	}
+
+private:
+	void Op(CaptureOp op) { m_bytes.push_back(op); }
+
+	template <typename T>
+	void Put(const T& value) { PutBytes(&value, sizeof(T)); }
+
+	void Put(const CaptureRef& ref) { Put(ref.Object); Put(ref.Offset); }
+
+	void PutBytes(const void* data, size_t size)
+	{
+		const size_t at = m_bytes.size();
+		m_bytes.resize(at + size);
+		memcpy(m_bytes.data() + at, data, size);
+	}
+
+	std::vector<uint8_t> m_bytes;
+};
+
+namespace FrameCaptureDetail
+{
+	// Bytes each op has after its opcode, not counting payloads. ReplayFrame() checks
+	// these are all there before decoding, a cut op is never half issued.
+	const uint8_t ArgumentSizes[CAPTURE_OP_COUNT] =
+	{
+		0,				// CAPTURE_BEGIN_LIST
+		2,				// CAPTURE_SET_PIPELINE_STATE
+		2,				// CAPTURE_SET_ROOT_SIGNATURE
+		2,				// CAPTURE_SET_DESCRIPTOR_HEAP
+		1 + 6,			// CAPTURE_SET_ROOT_DESCRIPTOR_TABLE
+		1 + 4,			// CAPTURE_SET_ROOT_CONSTANT_BUFFER
+		1 + 4,			// CAPTURE_SET_ROOT_SHADER_RESOURCE
+		1 + 6 + 4 + 4,	// CAPTURE_SET_VERTEX_BUFFER
+		6 + 4 + 4,		// CAPTURE_SET_INDEX_BUFFER
+		4,				// CAPTURE_SET_TOPOLOGY
+		6 * 4,			// CAPTURE_SET_VIEWPORT
+		4 * 4,			// CAPTURE_SET_SCISSOR_RECT
+		6 + 6,			// CAPTURE_SET_RENDER_TARGET
+		6 + 4 * 4,		// CAPTURE_CLEAR_RENDER_TARGET
+		6 + 4 + 4 + 1,	// CAPTURE_CLEAR_DEPTH_STENCIL
+		5 * 4,			// CAPTURE_DRAW_INDEXED
+		2 + 4 + 4 + 4 + 1,	// CAPTURE_BARRIER
+		2 + 2,			// CAPTURE_ALIASING_BARRIER
+		4 * 4,			// CAPTURE_DRAW
+		1 + 4 + 4,		// CAPTURE_SET_ROOT_CONSTANTS
+	};
+
+	class Reader
+	{
+	public:
+		Reader(const uint8_t* data, size_t size) : m_data(data), m_end(data + size), m_failed(false) { }
+
+		bool AtEnd() const { return m_data == m_end; }
+		size_t Remaining() const { return static_cast<size_t>(m_end - m_data); }
+		bool Failed() const { return m_failed; }
+
+		template <typename T>
+		T Get()
+		{
+			T value = T();
+			memcpy(&value, Skip(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		CaptureRef GetRef()
+		{
+			CaptureRef ref;
+			ref.Object = Get<uint16_t>();
+			ref.Offset = Get<uint32_t>();
+			return ref;
+		}
+
+		// Points into the stream, 'size' bytes long
+		const uint8_t* Skip(size_t size)
+		{
+			static const uint8_t zeros[64] = {};
+			if (m_failed || static_cast<size_t>(m_end - m_data) < size)
+			{
+				// Truncated stream, hand out zeros until the caller notices
+				m_failed = true;
+				return zeros;
+			}
+
+			const uint8_t* at = m_data;
+			m_data += size;
+			return at;
+		}
+
+	private:
+		const uint8_t* m_data;
+		const uint8_t* m_end;
+		bool m_failed;
+	};
+}
+
+// Decodes 'data' into calls on 'backend'. Returns false on a corrupt or truncated
+// stream, every op before that point has already been issued, the bad one isn't.
+template <typename Backend>
+bool ReplayFrame(const uint8_t* data, size_t size, Backend& backend)
+{
+	FrameCaptureDetail::Reader reader(data, size);
+
+	while (!reader.AtEnd())
+	{
+		const uint8_t op = reader.Get<uint8_t>();
+		if (op >= CAPTURE_OP_COUNT || reader.Remaining() < FrameCaptureDetail::ArgumentSizes[op])
+			return false;
+
+		switch (op)
+		{
+		case CAPTURE_BEGIN_LIST:
+			backend.BeginList();
+			break;
+		case CAPTURE_SET_PIPELINE_STATE:
+			backend.SetPipelineState(reader.Get<uint16_t>());
+			break;
+		case CAPTURE_SET_ROOT_SIGNATURE:
+			backend.SetRootSignature(reader.Get<uint16_t>());
+			break;
+		case CAPTURE_SET_DESCRIPTOR_HEAP:
+			backend.SetDescriptorHeap(reader.Get<uint16_t>());
+			break;
+		case CAPTURE_SET_ROOT_DESCRIPTOR_TABLE:
+		{
+			const uint8_t parameter = reader.Get<uint8_t>();
+			backend.SetRootDescriptorTable(parameter, reader.GetRef());
+			break;
+		}
+		case CAPTURE_SET_ROOT_CONSTANT_BUFFER:
+		case CAPTURE_SET_ROOT_SHADER_RESOURCE:
+		{
+			const uint8_t parameter = reader.Get<uint8_t>();
+			const uint32_t payloadSize = reader.Get<uint32_t>();
+			const uint8_t* payload = reader.Skip(payloadSize);
+			if (reader.Failed())
+				return false;
+
+			if (op == CAPTURE_SET_ROOT_CONSTANT_BUFFER)
+				backend.SetRootConstantBuffer(parameter, payload, payloadSize);
+			else
+				backend.SetRootShaderResource(parameter, payload, payloadSize);
+			break;
+		}
+		case CAPTURE_SET_VERTEX_BUFFER:
+		{
+			const uint8_t slot = reader.Get<uint8_t>();
+			const CaptureRef buffer = reader.GetRef();
+			const uint32_t bufferSize = reader.Get<uint32_t>();
+			backend.SetVertexBuffer(slot, buffer, bufferSize, reader.Get<uint32_t>());
+			break;
+		}
+		case CAPTURE_SET_INDEX_BUFFER:
+		{
+			const CaptureRef buffer = reader.GetRef();
+			const uint32_t bufferSize = reader.Get<uint32_t>();
+			backend.SetIndexBuffer(buffer, bufferSize, reader.Get<uint32_t>());
+			break;
+		}
+		case CAPTURE_SET_TOPOLOGY:
+			backend.SetTopology(reader.Get<uint32_t>());
+			break;
+		case CAPTURE_SET_VIEWPORT:
+		{
+			float viewport[6];
+			memcpy(viewport, reader.Skip(sizeof(viewport)), sizeof(viewport));
+			backend.SetViewport(viewport);
+			break;
+		}
+		case CAPTURE_SET_SCISSOR_RECT:
+		{
+			int32_t rect[4];
+			memcpy(rect, reader.Skip(sizeof(rect)), sizeof(rect));
+			backend.SetScissorRect(rect);
+			break;
+		}
+		case CAPTURE_SET_RENDER_TARGET:
+		{
+			const CaptureRef renderTarget = reader.GetRef();
+			backend.SetRenderTarget(renderTarget, reader.GetRef());
+			break;
+		}
+		case CAPTURE_CLEAR_RENDER_TARGET:
+		{
+			const CaptureRef renderTarget = reader.GetRef();
+			float color[4];
+			memcpy(color, reader.Skip(sizeof(color)), sizeof(color));
+			backend.ClearRenderTarget(renderTarget, color);
+			break;
+		}
+		case CAPTURE_CLEAR_DEPTH_STENCIL:
+		{
+			const CaptureRef depthStencil = reader.GetRef();
+			const uint32_t flags = reader.Get<uint32_t>();
+			const float depth = reader.Get<float>();
+			backend.ClearDepthStencil(depthStencil, flags, depth, reader.Get<uint8_t>());
+			break;
+		}
+		case CAPTURE_DRAW_INDEXED:
+		{
+			const uint32_t indexCount = reader.Get<uint32_t>();
+			const uint32_t instanceCount = reader.Get<uint32_t>();
+			const uint32_t firstIndex = reader.Get<uint32_t>();
+			const int32_t baseVertex = reader.Get<int32_t>();
+			backend.DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex, reader.Get<uint32_t>());
+			break;
+		}
+		case CAPTURE_DRAW:
+		{
+			const uint32_t vertexCount = reader.Get<uint32_t>();
+			const uint32_t instanceCount = reader.Get<uint32_t>();
+			const uint32_t firstVertex = reader.Get<uint32_t>();
+			backend.Draw(vertexCount, instanceCount, firstVertex, reader.Get<uint32_t>());
+			break;
+		}
+		case CAPTURE_BARRIER:
+		{
+			const uint16_t resource = reader.Get<uint16_t>();
+			const uint32_t subresource = reader.Get<uint32_t>();
+			const uint32_t before = reader.Get<uint32_t>();
+			const uint32_t after = reader.Get<uint32_t>();
+			backend.Barrier(resource, subresource, before, after, reader.Get<uint8_t>());
+			break;
+		}
+		case CAPTURE_ALIASING_BARRIER:
+		{
+			const uint16_t before = reader.Get<uint16_t>();
+			backend.AliasingBarrier(before, reader.Get<uint16_t>());
+			break;
+		}
+		case CAPTURE_SET_ROOT_CONSTANTS:
+		{
+			const uint8_t parameter = reader.Get<uint8_t>();
+			const uint32_t offset = reader.Get<uint32_t>();
+			const uint32_t count = reader.Get<uint32_t>();
+			const uint8_t* values = reader.Skip(count * sizeof(uint32_t));
+			if (reader.Failed())
+				return false;
+
+			backend.SetRootConstants(parameter, offset, values, count);
+			break;
+		}
+		default:
+			return false;
+		}
+
+		if (reader.Failed())
+			return false;
+	}
+
+	return true;
+}
+
+inline bool SaveFrameCapture(const char* fileName, const std::vector<uint8_t>& bytes)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+		return false;
+
+	const bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	return fclose(file) == 0 && written;
+}
+
+inline bool LoadFrameCapture(const char* fileName, std::vector<uint8_t>& bytes)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+		return false;
+
+	bytes.clear();
+	uint8_t buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		bytes.insert(bytes.end(), buffer, buffer + read);
+
+	const bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
@@ -0,0 +1,414 @@
+/**************************************************************
+	Frame Graph
+
+	A frame described as passes and the resources they read and
+	write, rebuilt every frame. Compile() works out:
+
+	- Which passes run. A pass only runs if something it writes
+	  ends up in an imported resource (the back buffer, say),
+	  directly or through later passes. The rest are culled.
+	  Passes run in the order they were added.
+	- The barriers in front of every pass, and the ones after the
+	  last pass that put imported resources in their final state.
+	- Where every transient resource lives in one block of memory.
+	  Transients only exist from the first pass that uses them to
+	  the last, so two whose lifetimes don't overlap can share the
+	  same bytes. Placement is greedy, biggest first, each at the
+	  lowest offset that doesn't collide with anything placed that
+	  is alive at the same time.
+
+	A transient that shares memory with another one gets an
+	aliasing barrier before its first use, and that use has to be
+	a write that covers all of it (a clear, or a full overwrite),
+	whatever was in those bytes before belongs to someone else.
+	Compile() fails if a transient is read before it's written.
+
+	Nothing D3D12 specific in here: states are plain numbers and
+	sizes come from the caller. See FrameGraphD3D12.h for the part
+	that creates the memory and the resources and sends barriers.
+**************************************************************/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct FrameGraphBarrier
+{
+	uint32_t Resource;
+	uint32_t StateBefore;	// FrameGraph::UnknownState at a transient's first use
+	uint32_t StateAfter;
+	bool Aliasing;			// 'Resource' takes over its memory, the states don't apply
+};
+
+class FrameGraph
+{
+public:
+	static constexpr uint32_t InvalidId = ~0u;
+	static constexpr uint32_t UnknownState = ~0u;
+
+	FrameGraph() : m_peakSize(0), m_unaliasedSize(0), m_culledCount(0) { }
+
+	// Forgets every pass and resource, keeps the memory for the next frame's graph
+	void Reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_accesses.clear();
+	}
+
+	// Lives outside the graph, comes in as 'state' and has to leave as 'finalState'
+	uint32_t Import(const char* name, uint32_t state, uint32_t finalState)
+	{
+		Resource resource = {};
+		resource.Name = name;
+		resource.InitialState = state;
+		resource.FinalState = finalState;
+		resource.Imported = true;
+		return AddResource(resource);
+	}
+
+	uint32_t CreateTransient(const char* name, uint64_t size, uint64_t alignment)
+	{
+		Resource resource = {};
+		resource.Name = name;
+		resource.Size = size;
+		resource.Alignment = alignment ? alignment : 1;
+		resource.InitialState = UnknownState;
+		return AddResource(resource);
+	}
+
+	// Reads and writes go to the pass added last
+	uint32_t AddPass(const char* name)
+	{
+		const uint32_t accessEnd = static_cast<uint32_t>(m_accesses.size());
+		m_passes.push_back({ name, accessEnd, accessEnd, false, 0, 0 });
+		return static_cast<uint32_t>(m_passes.size() - 1);
+	}
+
+	void Read(uint32_t resource, uint32_t state) { AddAccess(resource, state, false); }
+	void Write(uint32_t resource, uint32_t state) { AddAccess(resource, state, true); }
+
+	bool Compile()
+	{
+		m_order.clear();
+		m_barriers.clear();
+		m_finalBarriers.clear();
+		m_peakSize = 0;
+		m_unaliasedSize = 0;
+		m_culledCount = 0;
+
+		Cull();
+
+		for (Resource& resource : m_resources)
+		{
+			resource.FirstUse = InvalidId;
+			resource.LastUse = 0;
+			resource.Aliased = false;
+		}
+
+		// Lifetimes, in positions of the execution order
+		for (uint32_t position = 0; position < m_order.size(); position++)
+		{
+			const Pass& pass = m_passes[m_order[position]];
+			for (uint32_t access = pass.AccessBegin; access < pass.AccessEnd; access++)
+			{
+				Resource& resource = m_resources[m_accesses[access].Resource];
+				if (resource.FirstUse == InvalidId)
+				{
+					if (!resource.Imported && !Writes(pass, m_accesses[access].Resource))
+						return false;
+					resource.FirstUse = position;
+				}
+				resource.LastUse = position;
+			}
+		}
+
+		Place();
+		BuildBarriers();
+		return true;
+	}
+
+	// Passes that survived culling, in the order they run
+	const std::vector<uint32_t>& GetOrder() const { return m_order; }
+	bool IsCulled(uint32_t pass) const { return m_passes[pass].Culled; }
+	const char* GetPassName(uint32_t pass) const { return m_passes[pass].Name; }
+
+	// What goes in front of 'pass', empty for a culled one
+	const FrameGraphBarrier* GetBarriers(uint32_t pass, uint32_t* count) const
+	{
+		*count = m_passes[pass].BarrierCount;
+		return m_barriers.data() + m_passes[pass].BarrierBegin;
+	}
+
+	// Imported resources back to their final state, after the last pass
+	const std::vector<FrameGraphBarrier>& GetFinalBarriers() const { return m_finalBarriers; }
+
+	uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_resources.size()); }
+	const char* GetResourceName(uint32_t resource) const { return m_resources[resource].Name; }
+	bool IsImported(uint32_t resource) const { return m_resources[resource].Imported; }
+
+	// False for a transient only culled passes touched, it gets no memory
+	bool IsUsed(uint32_t resource) const { return m_resources[resource].FirstUse != InvalidId; }
+	uint64_t GetOffset(uint32_t resource) const { return m_resources[resource].Offset; }
+	uint64_t GetSize(uint32_t resource) const { return m_resources[resource].Size; }
+	uint32_t GetFirstState(uint32_t resource) const { return m_resources[resource].FirstState; }
+
+	// Bytes the transients need with aliasing, and what they'd take without it
+	uint64_t GetPeakSize() const { return m_peakSize; }
+	uint64_t GetUnaliasedSize() const { return m_unaliasedSize; }
+	uint32_t GetCulledCount() const { return m_culledCount; }
+	size_t GetBarrierCount() const { return m_barriers.size() + m_finalBarriers.size(); }
+
+private:
+	struct Resource
+	{
+		const char* Name;
+		uint64_t Size;
+		uint64_t Alignment;
+		uint32_t InitialState;	// Imported: the state it comes in with
+		uint32_t FinalState;
+		bool Imported;
+
+		// Filled in by Compile()
+		bool Needed;
+		bool Aliased;
+		uint32_t FirstUse;
+		uint32_t LastUse;
+		uint32_t FirstState;
+		uint64_t Offset;
+	};
+
+	struct Pass
+	{
+		const char* Name;
+		uint32_t AccessBegin;
+		uint32_t AccessEnd;
+		bool Culled;
+		uint32_t BarrierBegin;
+		uint32_t BarrierCount;
+	};
+
+	struct Access
+	{
+		uint32_t Resource;
+		uint32_t State;
+		bool Write;
+	};
+
+	uint32_t AddResource(const Resource& resource)
+	{
+		m_resources.push_back(resource);
+		return static_cast<uint32_t>(m_resources.size() - 1);
+	}
+
+	void AddAccess(uint32_t resource, uint32_t state, bool write)
+	{
+		m_accesses.push_back({ resource, state, write });
+		m_passes.back().AccessEnd++;
+	}
+
+	bool Writes(const Pass& pass, uint32_t resource) const
+	{
+		for (uint32_t access = pass.AccessBegin; access < pass.AccessEnd; access++)
+		{
+			if (m_accesses[access].Resource == resource && m_accesses[access].Write)
+				return true;
+		}
+		return false;
+	}
+
+	// Walks backwards from the imported resources. Whatever a pass that runs touches
+	// is needed, writes included since a write can be partial (depth testing, blending).
+	void Cull()
+	{
+		for (Resource& resource : m_resources)
+			resource.Needed = resource.Imported;
+
+		for (uint32_t passIndex = static_cast<uint32_t>(m_passes.size()); passIndex-- > 0;)
+		{
+			Pass& pass = m_passes[passIndex];
+			pass.Culled = true;
+			for (uint32_t access = pass.AccessBegin; access < pass.AccessEnd; access++)
+			{
+				if (m_accesses[access].Write && m_resources[m_accesses[access].Resource].Needed)
+					pass.Culled = false;
+			}
+
+			if (pass.Culled)
+			{
+				m_culledCount++;
+				continue;
+			}
+
+			for (uint32_t access = pass.AccessBegin; access < pass.AccessEnd; access++)
+				m_resources[m_accesses[access].Resource].Needed = true;
+		}
+
+		for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+		{
+			if (!m_passes[passIndex].Culled)
+				m_order.push_back(passIndex);
+		}
+	}
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	void Place()
+	{
+		m_placement.clear();
+		for (uint32_t resource = 0; resource < m_resources.size(); resource++)
+		{
+			if (!m_resources[resource].Imported && IsUsed(resource))
+				m_placement.push_back(resource);
+		}
+
+		std::sort(m_placement.begin(), m_placement.end(), [&](uint32_t a, uint32_t b)
+		{
+			if (m_resources[a].Size != m_resources[b].Size)
+				return m_resources[a].Size > m_resources[b].Size;
+			return m_resources[a].FirstUse < m_resources[b].FirstUse;
+		});
+
+		// What's been placed so far, by the positions it's alive at, so only the ones
+		// alive at the same time are looked at, not everything placed before
+		if (m_alive.size() < m_order.size())
+			m_alive.resize(m_order.size());
+		for (std::vector<uint32_t>& alive : m_alive)
+			alive.clear();
+
+		for (uint32_t resourceIndex : m_placement)
+		{
+			Resource& resource = m_resources[resourceIndex];
+
+			// Everything placed so far that's alive at the same time, by offset. One
+			// alive at several positions is taken at the first of them in range.
+			m_collisions.clear();
+			for (uint32_t position = resource.FirstUse; position <= resource.LastUse; position++)
+			{
+				for (uint32_t other : m_alive[position])
+				{
+					if (position == resource.FirstUse || m_resources[other].FirstUse == position)
+						m_collisions.push_back(other);
+				}
+			}
+			std::sort(m_collisions.begin(), m_collisions.end(), [&](uint32_t a, uint32_t b)
+			{
+				return m_resources[a].Offset < m_resources[b].Offset;
+			});
+
+			// Lowest gap it fits in
+			uint64_t offset = 0;
+			for (uint32_t collision : m_collisions)
+			{
+				const Resource& neighbour = m_resources[collision];
+				if (AlignUp(offset, resource.Alignment) + resource.Size <= neighbour.Offset)
+					break;
+				offset = std::max(offset, neighbour.Offset + neighbour.Size);
+			}
+			resource.Offset = AlignUp(offset, resource.Alignment);
+
+			for (uint32_t position = resource.FirstUse; position <= resource.LastUse; position++)
+				m_alive[position].push_back(resourceIndex);
+
+			m_peakSize = std::max(m_peakSize, resource.Offset + resource.Size);
+			m_unaliasedSize += resource.Size;
+		}
+
+		// Sharing bytes with anything, at any point in the frame, means aliasing. By
+		// offset, a resource can only share with the ones that start before it ends.
+		std::sort(m_placement.begin(), m_placement.end(), [&](uint32_t a, uint32_t b)
+		{
+			return m_resources[a].Offset < m_resources[b].Offset;
+		});
+		uint64_t reach = 0;
+		for (size_t placed = 0; placed < m_placement.size(); placed++)
+		{
+			Resource& resource = m_resources[m_placement[placed]];
+			if (placed && resource.Offset < reach)
+			{
+				resource.Aliased = true;
+				for (size_t other = placed; other-- > 0 && !m_resources[m_placement[other]].Aliased;)
+				{
+					Resource& neighbour = m_resources[m_placement[other]];
+					if (resource.Offset < neighbour.Offset + neighbour.Size)
+						neighbour.Aliased = true;
+				}
+			}
+			reach = std::max(reach, resource.Offset + resource.Size);
+		}
+	}
+
+	// Works on a copy of the initial states, so compiling again gives the same barriers
+	void BuildBarriers()
+	{
+		m_states.resize(m_resources.size());
+		for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); resourceIndex++)
+			m_states[resourceIndex] = m_resources[resourceIndex].InitialState;
+
+		for (uint32_t passIndex : m_order)
+		{
+			Pass& pass = m_passes[passIndex];
+			pass.BarrierBegin = static_cast<uint32_t>(m_barriers.size());
+
+			for (uint32_t access = pass.AccessBegin; access < pass.AccessEnd; access++)
+			{
+				const uint32_t resourceIndex = m_accesses[access].Resource;
+				Resource& resource = m_resources[resourceIndex];
+
+				// A pass that uses a resource more than once needs all of those states at once
+				uint32_t state = m_accesses[access].State;
+				bool seen = false;
+				for (uint32_t other = pass.AccessBegin; other < pass.AccessEnd; other++)
+				{
+					if (m_accesses[other].Resource != resourceIndex)
+						continue;
+					if (other < access)
+						seen = true;
+					state |= m_accesses[other].State;
+				}
+				if (seen)
+					continue;
+
+				uint32_t& current = m_states[resourceIndex];
+				if (current == UnknownState)
+				{
+					resource.FirstState = state;
+					if (resource.Aliased)
+						m_barriers.push_back({ resourceIndex, UnknownState, UnknownState, true });
+				}
+				if (current != state)
+					m_barriers.push_back({ resourceIndex, current, state, false });
+				current = state;
+			}
+
+			pass.BarrierCount = static_cast<uint32_t>(m_barriers.size()) - pass.BarrierBegin;
+		}
+
+		for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); resourceIndex++)
+		{
+			const Resource& resource = m_resources[resourceIndex];
+			if (resource.Imported && m_states[resourceIndex] != resource.FinalState)
+				m_finalBarriers.push_back({ resourceIndex, m_states[resourceIndex], resource.FinalState, false });
+		}
+	}
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::vector<Access> m_accesses;
+	std::vector<uint32_t> m_order;
+	std::vector<FrameGraphBarrier> m_barriers;
+	std::vector<FrameGraphBarrier> m_finalBarriers;
+
+	// Scratch for Place(), kept around so compiling doesn't allocate once warmed up
+	std::vector<uint32_t> m_placement;
+	std::vector<uint32_t> m_collisions;
+	std::vector<std::vector<uint32_t>> m_alive;
+	std::vector<uint32_t> m_states;			// BuildBarriers(), where each resource is up to
+
+	uint64_t m_peakSize;
+	uint64_t m_unaliasedSize;
+	uint32_t m_culledCount;
+};
@@ -0,0 +1,301 @@
+/**************************************************************
+	Frame Graph D3D12
+
+	The D3D12 end of FrameGraph.h. Transient textures are placed
+	resources in one heap, at the offsets the graph worked out, so
+	attachments whose lifetimes don't overlap share memory. Only
+	render targets and depth buffers can be transient, the heap is
+	created with ALLOW_ONLY_RT_DS_TEXTURES so it works on resource
+	heap tier 1 too.
+
+	Placed resources are kept from one frame to the next and only
+	recreated when a transient's description or offset changes,
+	so a graph that has the same shape every frame creates nothing
+	after the first one. The heap grows to the peak the graph asks
+	for and never shrinks. Whatever is replaced goes away once the
+	frames that used it have completed, the same way the upload
+	rings recycle their memory.
+
+	Barriers go through a ResourceStateTracker: the graph says
+	what state a pass needs, the tracker knows what state the
+	resource is really in, imported ones included, and batches
+	everything in front of a pass into one call.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "FrameGraph.h"
+#include "ResourceStateTracker.h"
+
+class FrameGraphD3D12
+{
+public:
+	FrameGraphD3D12() : m_device(nullptr), m_states(nullptr), m_heap(nullptr), m_heapSize(0), m_heapAlignment(0), m_createdCount(0) { }
+
+	~FrameGraphD3D12()
+	{
+		for (Placed& placed : m_placed)
+			placed.Resource->Release();
+		for (RetiredObject& retired : m_retired)
+			retired.Object->Release();
+		for (RetiredObject& retired : m_inFlight)
+			retired.Object->Release();
+		if (m_heap)
+			m_heap->Release();
+	}
+
+	FrameGraphD3D12(const FrameGraphD3D12&) = delete;
+	FrameGraphD3D12& operator=(const FrameGraphD3D12&) = delete;
+
+	void Init(ID3D12Device* device, ResourceStateTracker* states)
+	{
+		m_device = device;
+		m_states = states;
+	}
+
+	// Starts the next frame's graph
+	void Reset()
+	{
+		m_graph.Reset();
+		m_resources.clear();
+		m_textures.clear();
+	}
+
+	// 'resource' has to be registered with the state tracker, it's taken from there
+	uint32_t Import(const char* name, ID3D12Resource* resource, D3D12_RESOURCE_STATES finalState)
+	{
+		m_resources.push_back(resource);
+		m_textures.push_back({});
+		return m_graph.Import(name, m_states->GetState(resource), finalState);
+	}
+
+	// 'clearValue' can be null. Render targets and depth buffers only.
+	uint32_t CreateTexture(const char* name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue)
+	{
+		const D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+		TransientTexture texture = {};
+		texture.Desc = desc;
+		texture.Alignment = info.Alignment;
+		texture.HasClearValue = clearValue != nullptr;
+		if (clearValue)
+			texture.ClearValue = *clearValue;
+
+		m_resources.push_back(nullptr);
+		m_textures.push_back(texture);
+		return m_graph.CreateTransient(name, info.SizeInBytes, info.Alignment);
+	}
+
+	uint32_t AddPass(const char* name) { return m_graph.AddPass(name); }
+	void Read(uint32_t resource, D3D12_RESOURCE_STATES state) { m_graph.Read(resource, state); }
+	void Write(uint32_t resource, D3D12_RESOURCE_STATES state) { m_graph.Write(resource, state); }
+
+	// Compiles the graph and makes sure every transient it uses has memory and a resource
+	HRESULT Compile()
+	{
+		if (!m_graph.Compile())
+			return E_INVALIDARG;
+
+		// Multisampled targets need 4 MB alignment, and then so does the heap
+		UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		for (const TransientTexture& texture : m_textures)
+			alignment = std::max(alignment, texture.Alignment);
+
+		if (m_graph.GetPeakSize() > m_heapSize || alignment > m_heapAlignment)
+		{
+			// Everything placed in the old heap goes with it
+			for (Placed& placed : m_placed)
+			{
+				m_states->Unregister(placed.Resource);
+				Retire(placed.Resource);
+			}
+			m_placed.clear();
+			if (m_heap)
+				Retire(m_heap);
+			m_heap = nullptr;
+
+			D3D12_HEAP_DESC heapDesc = {};
+			heapDesc.SizeInBytes = m_graph.GetPeakSize();
+			heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+			heapDesc.Alignment = alignment;
+			heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+			HRESULT hr = m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_heap));
+			if (FAILED(hr))
+			{
+				m_heapSize = 0;
+				return hr;
+			}
+			m_heapSize = heapDesc.SizeInBytes;
+			m_heapAlignment = alignment;
+		}
+
+		for (Placed& placed : m_placed)
+			placed.Used = false;
+
+		for (uint32_t resource = 0; resource < m_graph.GetResourceCount(); resource++)
+		{
+			if (m_graph.IsImported(resource) || !m_graph.IsUsed(resource))
+				continue;
+
+			HRESULT hr = Place(resource);
+			if (FAILED(hr))
+				return hr;
+		}
+
+		// Anything this graph doesn't have a use for anymore
+		for (size_t placed = m_placed.size(); placed-- > 0;)
+		{
+			if (m_placed[placed].Used)
+				continue;
+			m_states->Unregister(m_placed[placed].Resource);
+			Retire(m_placed[placed].Resource);
+			m_placed.erase(m_placed.begin() + placed);
+		}
+
+		return S_OK;
+	}
+
+	// Null for a transient no pass that runs uses
+	ID3D12Resource* GetResource(uint32_t resource) const { return m_resources[resource]; }
+	const FrameGraph& GetGraph() const { return m_graph; }
+
+	// Barriers for 'pass', in one call on 'commandList'. Transients that share memory
+	// are only valid after this, and the pass has to clear or overwrite all of them.
+	template <typename CommandList>
+	void BeginPass(uint32_t pass, CommandList& commandList)
+	{
+		uint32_t count = 0;
+		const FrameGraphBarrier* barriers = m_graph.GetBarriers(pass, &count);
+		for (uint32_t i = 0; i < count; i++)
+			QueueBarrier(barriers[i]);
+		m_states->Flush(commandList);
+	}
+
+	// Imported resources back to the state they leave the frame in
+	template <typename CommandList>
+	void EndFrame(CommandList& commandList)
+	{
+		for (const FrameGraphBarrier& barrier : m_graph.GetFinalBarriers())
+			QueueBarrier(barrier);
+		m_states->Flush(commandList);
+	}
+
+	// Everything replaced since the last call was last used by the frame signaling 'fenceValue'
+	void FinishFrame(UINT64 fenceValue)
+	{
+		for (RetiredObject& retired : m_retired)
+			m_inFlight.push_back({ retired.Object, fenceValue });
+		m_retired.clear();
+	}
+
+	void ReleaseCompleted(UINT64 completedFenceValue)
+	{
+		while (!m_inFlight.empty() && m_inFlight.front().FenceValue <= completedFenceValue)
+		{
+			m_inFlight.front().Object->Release();
+			m_inFlight.pop_front();
+		}
+	}
+
+	UINT64 GetHeapSize() const { return m_heapSize; }
+	UINT GetPlacedCount() const { return static_cast<UINT>(m_placed.size()); }
+	UINT64 GetCreatedCount() const { return m_createdCount; }
+
+private:
+	struct TransientTexture
+	{
+		D3D12_RESOURCE_DESC Desc;
+		D3D12_CLEAR_VALUE ClearValue;
+		bool HasClearValue;
+		UINT64 Alignment;
+	};
+
+	struct Placed
+	{
+		D3D12_RESOURCE_DESC Desc;
+		UINT64 Offset;
+		ID3D12Resource* Resource;
+		bool Used;
+	};
+
+	struct RetiredObject
+	{
+		ID3D12Pageable* Object;
+		UINT64 FenceValue;
+	};
+
+	static bool SameDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b)
+	{
+		return a.Dimension == b.Dimension && a.Alignment == b.Alignment && a.Width == b.Width && a.Height == b.Height
+			&& a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels && a.Format == b.Format
+			&& a.SampleDesc.Count == b.SampleDesc.Count && a.SampleDesc.Quality == b.SampleDesc.Quality
+			&& a.Layout == b.Layout && a.Flags == b.Flags;
+	}
+
+	HRESULT Place(uint32_t resource)
+	{
+		const TransientTexture& texture = m_textures[resource];
+		const UINT64 offset = m_graph.GetOffset(resource);
+
+		for (Placed& placed : m_placed)
+		{
+			if (placed.Used || placed.Offset != offset || !SameDesc(placed.Desc, texture.Desc))
+				continue;
+
+			placed.Used = true;
+			m_resources[resource] = placed.Resource;
+			return S_OK;
+		}
+
+		// Created in the state it's first used in, that first barrier is then a no-op
+		const D3D12_RESOURCE_STATES state = static_cast<D3D12_RESOURCE_STATES>(m_graph.GetFirstState(resource));
+
+		Placed placed = {};
+		placed.Desc = texture.Desc;
+		placed.Offset = offset;
+		placed.Used = true;
+		HRESULT hr = m_device->CreatePlacedResource(m_heap, offset, &texture.Desc, state,
+			texture.HasClearValue ? &texture.ClearValue : nullptr, IID_PPV_ARGS(&placed.Resource));
+		if (FAILED(hr))
+			return hr;
+
+		m_states->Register(placed.Resource, state);
+		m_placed.push_back(placed);
+		m_resources[resource] = placed.Resource;
+		m_createdCount++;
+		return S_OK;
+	}
+
+	void QueueBarrier(const FrameGraphBarrier& barrier)
+	{
+		ID3D12Resource* resource = m_resources[barrier.Resource];
+		if (barrier.Aliasing)
+			m_states->Aliasing(nullptr, resource);
+		else
+			m_states->Transition(resource, static_cast<D3D12_RESOURCE_STATES>(barrier.StateAfter));
+	}
+
+	void Retire(ID3D12Pageable* object)
+	{
+		m_retired.push_back({ object, 0 });
+	}
+
+	ID3D12Device* m_device;
+	ResourceStateTracker* m_states;
+	FrameGraph m_graph;
+
+	// Per graph resource, rebuilt every frame
+	std::vector<ID3D12Resource*> m_resources;
+	std::vector<TransientTexture> m_textures;
+
+	ID3D12Heap* m_heap;
+	UINT64 m_heapSize;
+	UINT64 m_heapAlignment;
+	std::vector<Placed> m_placed;
+	std::vector<RetiredObject> m_retired;
+	std::deque<RetiredObject> m_inFlight;
+	UINT64 m_createdCount;
+};
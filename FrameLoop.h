@@ -0,0 +1,202 @@
+/**************************************************************
+	Frame Loop
+
+	The part of a frame that is the same whatever gets drawn:
+	wait until the frame slot is free again, let the app update
+	and record, execute its lists in order, present, and signal
+	the frame's fence value. The cpu time of each phase is added
+	up over the run.
+
+	What it runs on comes from a Platform, anything with
+
+		bool PumpMessages();	// false once the app should quit
+		void Present();			// right after the lists are executed
+
+	WinMain has one for the window and swap chain (or offscreen
+	targets when headless), the tests one on the null device.
+
+	Each slot's Context needs an ID3D12CommandAllocator* named
+	CommandAllocator, Init() creates them and Begin() resets the
+	one it hands out, which is only safe because the slot's last
+	frame is done by then.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <chrono>
+#include <vector>
+#include "FrameRing.h"
+
+template <typename Platform, typename Context, uint32_t Count>
+class FrameLoop
+{
+public:
+	enum Phase { PHASE_WAIT, PHASE_UPDATE, PHASE_RECORD, PHASE_SUBMIT, PHASE_COUNT };
+
+	static const char* GetPhaseName(Phase phase)
+	{
+		static const char* names[PHASE_COUNT] = { "Fence wait", "Update", "Record", "Submit" };
+		return names[phase];
+	}
+
+	FrameLoop()
+		: m_platform(nullptr), m_queue(nullptr), m_fence(nullptr), m_fenceEvent(nullptr), m_fenceValue(0),
+		m_frameCount(0), m_waitCount(0), m_waitSeconds(0.0), m_phaseSeconds() { }
+
+	~FrameLoop()
+	{
+		if (m_fence)
+		{
+			Flush();
+			m_fence->Release();
+		}
+		for (uint32_t slot = 0; slot < Count; slot++)
+		{
+			if (m_ring[slot].CommandAllocator)
+				m_ring[slot].CommandAllocator->Release();
+		}
+		if (m_fenceEvent) CloseHandle(m_fenceEvent);
+	}
+
+	FrameLoop(const FrameLoop&) = delete;
+	FrameLoop& operator=(const FrameLoop&) = delete;
+
+	// 'queue' has to be a direct queue, it isn't AddRef'd
+	HRESULT Init(ID3D12Device* device, ID3D12CommandQueue* queue, Platform* platform)
+	{
+		m_platform = platform;
+		m_queue = queue;
+
+		HRESULT hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+		if (FAILED(hr))
+			return hr;
+
+		m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		if (!m_fenceEvent)
+			return HRESULT_FROM_WIN32(GetLastError());
+
+		for (uint32_t slot = 0; slot < Count; slot++)
+		{
+			m_ring[slot].CommandAllocator = nullptr;
+			hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_ring[slot].CommandAllocator));
+			if (FAILED(hr))
+				return hr;
+		}
+		return S_OK;
+	}
+
+	// One whole frame. 'update(context, completedFenceValue)' runs once the slot is
+	// free, 'record(context, lists)' appends closed lists to execute in order, and
+	// 'finish(fenceValue)' gets the value the frame is signaled with, for anything
+	// that tags its allocations with it. Returns false, without starting a frame,
+	// once the platform wants to quit.
+	template <typename Update, typename Record, typename Finish>
+	bool RunFrame(Update update, Record record, Finish finish)
+	{
+		if (!m_platform->PumpMessages())
+			return false;
+
+		Clock::time_point phaseStart = Clock::now();
+		auto EndPhase = [&](Phase phase)
+		{
+			const Clock::time_point phaseEnd = Clock::now();
+			m_phaseSeconds[phase] += std::chrono::duration<double>(phaseEnd - phaseStart).count();
+			phaseStart = phaseEnd;
+		};
+
+		Context& context = Begin();
+		EndPhase(PHASE_WAIT);
+
+		update(context, m_fence->GetCompletedValue());
+		EndPhase(PHASE_UPDATE);
+
+		m_lists.clear();
+		record(context, m_lists);
+		EndPhase(PHASE_RECORD);
+
+		finish(Submit(UINT(m_lists.size()), m_lists.data(), true));
+		EndPhase(PHASE_SUBMIT);
+		return true;
+	}
+
+	// Moves on to the next slot, blocking until the frame that last used it is done,
+	// which is Count frames ago rather than the one just submitted. Resets its allocator.
+	Context& Begin()
+	{
+		m_ring.Begin(m_fence->GetCompletedValue(), [&](uint64_t fenceValue)
+		{
+			const Clock::time_point waitStart = Clock::now();
+			WaitFor(fenceValue);
+			m_waitSeconds += std::chrono::duration<double>(Clock::now() - waitStart).count();
+			m_waitCount++;
+		});
+
+		Context& context = m_ring.GetCurrent();
+		context.CommandAllocator->Reset();
+		return context;
+	}
+
+	// Executes 'lists' for the current slot, presents if asked to, and signals the
+	// fence value it returns. Doesn't wait, the slot is checked when it comes around again.
+	UINT64 Submit(UINT count, ID3D12CommandList* const* lists, bool present)
+	{
+		if (count)
+			m_queue->ExecuteCommandLists(count, lists);
+		if (present)
+			m_platform->Present();
+
+		m_ring.End(Signal());
+		m_frameCount++;
+		return m_fenceValue;
+	}
+
+	// Signals the next fence value on the queue, for work submitted outside a frame
+	UINT64 Signal()
+	{
+		m_queue->Signal(m_fence, ++m_fenceValue);
+		return m_fenceValue;
+	}
+
+	// Blocks the cpu until everything signaled so far is done
+	void Flush() { WaitFor(m_fenceValue); }
+
+	uint32_t GetIndex() const { return m_ring.GetIndex(); }
+	Context& operator[](uint32_t index) { return m_ring[index]; }
+
+	ID3D12Fence* GetFence() const { return m_fence; }
+	UINT64 GetFenceValue() const { return m_fenceValue; }
+	UINT64 GetCompletedFenceValue() const { return m_fence->GetCompletedValue(); }
+	UINT64 GetFrameCount() const { return m_frameCount; }
+
+	// Frames that had to wait for their slot, and for how long altogether. Flush()
+	// isn't counted.
+	UINT64 GetWaitCount() const { return m_waitCount; }
+	double GetWaitSeconds() const { return m_waitSeconds; }
+
+	// Over every RunFrame so far. The message pump isn't in any of them.
+	double GetPhaseSeconds(Phase phase) const { return m_phaseSeconds[phase]; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	void WaitFor(UINT64 fenceValue)
+	{
+		if (m_fence->GetCompletedValue() >= fenceValue)
+			return;
+
+		m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent);
+		WaitForSingleObject(m_fenceEvent, INFINITE);
+	}
+
+	Platform* m_platform;
+	ID3D12CommandQueue* m_queue;
+	ID3D12Fence* m_fence;
+	HANDLE m_fenceEvent;
+	UINT64 m_fenceValue;
+	FrameRing<Context, Count> m_ring;
+	std::vector<ID3D12CommandList*> m_lists;
+
+	UINT64 m_frameCount;
+	UINT64 m_waitCount;
+	double m_waitSeconds;
+	double m_phaseSeconds[PHASE_COUNT];
+};
@@ -0,0 +1,52 @@
+/**************************************************************
+	Frame Ring
+
+	One context per frame in flight, so the cpu can record frame
+	N+1 while the gpu is still working on frame N. A slot is only
+	handed out again once the fence value it was submitted with
+	has completed, which is Count frames ago rather than the frame
+	just submitted.
+
+	Only deals with fence values, waiting is up to the caller, so
+	the same ring runs against a D3D12 fence or a mock one.
+**************************************************************/
+#pragma once
+#include <cstdint>
+
+template <typename Context, uint32_t Count>
+class FrameRing
+{
+public:
+	FrameRing() : m_index(Count - 1), m_contexts(), m_fenceValues() { }
+
+	static constexpr uint32_t GetCount() { return Count; }
+
+	// Moves on to the next slot. 'completed' is the fence's value now, if it hasn't
+	// reached the one the slot was last submitted with 'wait(fenceValue)' has to
+	// block until it has. Returns true if it had to wait.
+	template <typename Wait>
+	bool Begin(uint64_t completed, Wait wait)
+	{
+		m_index = (m_index + 1) % Count;
+		if (completed >= m_fenceValues[m_index])
+			return false;
+
+		wait(m_fenceValues[m_index]);
+		return true;
+	}
+
+	// The fence value the current slot's frame was submitted with
+	void End(uint64_t fenceValue) { m_fenceValues[m_index] = fenceValue; }
+
+	uint32_t GetIndex() const { return m_index; }
+	Context& GetCurrent() { return m_contexts[m_index]; }
+	Context& operator[](uint32_t index) { return m_contexts[index]; }
+
+	// What a slot waits for before it can be reused, 0 if it never was submitted
+	uint64_t GetFenceValue(uint32_t index) const { return m_fenceValues[index]; }
+
+private:
+	uint32_t m_index;
+	Context m_contexts[Count];
+	uint64_t m_fenceValues[Count];
+};
@@ -0,0 +1,59 @@
+/**************************************************************
+	Instancing
+
+	Per-instance data for the instanced cube path. The layout has
+	to match InstanceData in Shaders.hlsl, which reads it through
+	a StructuredBuffer indexed by SV_InstanceID.
+**************************************************************/
+#pragma once
+#include <DirectXMath.h>
+#include "BatchTransform.h"
+
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 Model;	// Transposed, HLSL expects column major
+	DirectX::XMFLOAT4 Color;	// Color of the light hitting this instance
+	uint32_t Material;			// Bindless texture slot
+};
+
+#define INSTANCESPERRING 16
+
+// Lays 'count' cubes out on rings around the light and writes their data straight
+// into 'out' (normally mapped upload memory). The first ring matches the two
+// cubes of the non instanced path: evenly spaced and orbiting 'angle' degrees.
+// 'objects' is scratch space so we don't reallocate the SoA arrays every frame.
+inline void PackOrbitInstances(
+	InstanceData* out,
+	unsigned int count,
+	float angle,
+	const DirectX::XMVECTOR* palette,
+	unsigned int paletteSize,
+	unsigned int paletteOffset,
+	const uint32_t* materials,
+	unsigned int materialCount,
+	TransformSoA& objects)
+{
+	const unsigned int perRing = count < INSTANCESPERRING ? count : INSTANCESPERRING;
+
+	objects.Resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const unsigned int ring = i / INSTANCESPERRING;
+		const float radius = 2.0f + 1.5f * ring;
+		const float theta = DirectX::XMConvertToRadians(angle + 180.0f + (360.0f * (i % INSTANCESPERRING)) / perRing);
+
+		objects.PositionX[i] = radius * cosf(theta);
+		objects.PositionY[i] = 0.0f;
+		objects.PositionZ[i] = radius * sinf(theta);
+		objects.RotationY[i] = 0.0f;
+	}
+
+	// Only the model matrix is needed, the vertex shader applies ViewProj itself
+	BatchTransform(objects, DirectX::XMMatrixIdentity(), { nullptr, 0, &out[0].Model, sizeof(InstanceData) });
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		DirectX::XMStoreFloat4(&out[i].Color, palette[(paletteOffset + i * 9) % paletteSize]);
+		out[i].Material = materials[i % materialCount];
+	}
+}
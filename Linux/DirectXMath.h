@@ -0,0 +1,299 @@
+/**************************************************************
+	DirectXMath (Linux stand-in)
+
+	The part of DirectXMath the device independent code uses, so
+	it builds with GCC and Clang without the Windows SDK. Types,
+	names and conventions are the real ones: row vectors, row
+	major XMMATRIX, left handed camera helpers. On x86 XMVECTOR is
+	an __m128 and _XM_SSE_INTRINSICS_ is defined, like the real
+	header does, so the SSE paths built on it are the ones tested.
+
+	The math is plain scalar code. Results agree with DirectXMath
+	to float rounding, except XMScalarSinCos, which calls
+	sinf/cosf instead of its polynomial.
+**************************************************************/
+#pragma once
+#include <cmath>
+#include <cstdint>
+#if defined(__SSE2__) || defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#ifndef _XM_SSE_INTRINSICS_
+#define _XM_SSE_INTRINSICS_
+#endif
+#endif
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+
+	constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+#if defined(_XM_SSE_INTRINSICS_)
+	typedef __m128 XMVECTOR;
+#else
+	struct XMVECTOR { float v[4]; };
+#endif
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	namespace Detail
+	{
+		inline float Get(FXMVECTOR v, int i)
+		{
+#if defined(_XM_SSE_INTRINSICS_)
+			alignas(16) float f[4];
+			_mm_store_ps(f, v);
+			return f[i];
+#else
+			return v.v[i];
+#endif
+		}
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVectorSet(float x, float y, float z, float w)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		return _mm_set_ps(w, z, y, x);
+#else
+		return { { x, y, z, w } };
+#endif
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVectorZero() { return XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f); }
+	inline float XM_CALLCONV XMVectorGetX(FXMVECTOR v) { return Detail::Get(v, 0); }
+	inline float XM_CALLCONV XMVectorGetY(FXMVECTOR v) { return Detail::Get(v, 1); }
+	inline float XM_CALLCONV XMVectorGetZ(FXMVECTOR v) { return Detail::Get(v, 2); }
+	inline float XM_CALLCONV XMVectorGetW(FXMVECTOR v) { return Detail::Get(v, 3); }
+
+	struct XMVECTORF32
+	{
+		union
+		{
+			float f[4];
+			XMVECTOR v;
+		};
+
+		inline operator XMVECTOR() const { return v; }
+		inline operator const float*() const { return f; }
+	};
+
+	struct XMFLOAT2
+	{
+		float x, y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) { }
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) { }
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) { }
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03),
+			_21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23),
+			_41(m30), _42(m31), _43(m32), _44(m33) { }
+
+		float operator()(size_t row, size_t column) const { return m[row][column]; }
+		float& operator()(size_t row, size_t column) { return m[row][column]; }
+	};
+
+	inline XMVECTOR XM_CALLCONV XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+	inline XMVECTOR XM_CALLCONV XMLoadFloat3(const XMFLOAT3* source) { return XMVectorSet(source->x, source->y, source->z, 0.0f); }
+
+	inline void XM_CALLCONV XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v)
+	{
+		*destination = XMFLOAT4(Detail::Get(v, 0), Detail::Get(v, 1), Detail::Get(v, 2), Detail::Get(v, 3));
+	}
+
+	inline void XM_CALLCONV XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v)
+	{
+		*destination = XMFLOAT3(Detail::Get(v, 0), Detail::Get(v, 1), Detail::Get(v, 2));
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVectorSubtract(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(Detail::Get(a, 0) - Detail::Get(b, 0), Detail::Get(a, 1) - Detail::Get(b, 1),
+			Detail::Get(a, 2) - Detail::Get(b, 2), Detail::Get(a, 3) - Detail::Get(b, 3));
+	}
+
+	inline float XM_CALLCONV XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		return Detail::Get(a, 0) * Detail::Get(b, 0) + Detail::Get(a, 1) * Detail::Get(b, 1) + Detail::Get(a, 2) * Detail::Get(b, 2);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		const float ax = Detail::Get(a, 0), ay = Detail::Get(a, 1), az = Detail::Get(a, 2);
+		const float bx = Detail::Get(b, 0), by = Detail::Get(b, 1), bz = Detail::Get(b, 2);
+		return XMVectorSet(ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx, 0.0f);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector3Normalize(FXMVECTOR v)
+	{
+		const float length = sqrtf(XMVector3Dot(v, v));
+		const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+		return XMVectorSet(Detail::Get(v, 0) * scale, Detail::Get(v, 1) * scale, Detail::Get(v, 2) * scale, Detail::Get(v, 3) * scale);
+	}
+
+	inline void XMScalarSinCos(float* sin, float* cos, float value)
+	{
+		*sin = sinf(value);
+		*cos = cosf(value);
+	}
+
+	struct XMMATRIX;
+	typedef const XMMATRIX FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) : r{ r0, r1, r2, r3 } { }
+		XMMATRIX(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: r{ XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13),
+			XMVectorSet(m20, m21, m22, m23), XMVectorSet(m30, m31, m32, m33) } { }
+
+		float Get(int row, int column) const { return Detail::Get(r[row], column); }
+
+		XMMATRIX operator*(CXMMATRIX other) const
+		{
+			float result[4][4];
+			for (int row = 0; row < 4; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					result[row][column] = Get(row, 0) * other.Get(0, column) + Get(row, 1) * other.Get(1, column)
+						+ Get(row, 2) * other.Get(2, column) + Get(row, 3) * other.Get(3, column);
+				}
+			}
+			return XMMATRIX(result[0][0], result[0][1], result[0][2], result[0][3],
+				result[1][0], result[1][1], result[1][2], result[1][3],
+				result[2][0], result[2][1], result[2][2], result[2][3],
+				result[3][0], result[3][1], result[3][2], result[3][3]);
+		}
+
+		XMMATRIX& operator*=(CXMMATRIX other)
+		{
+			*this = *this * other;
+			return *this;
+		}
+	};
+
+	inline XMMATRIX XM_CALLCONV XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) { return a * b; }
+
+	inline XMMATRIX XM_CALLCONV XMMatrixIdentity()
+	{
+		return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixTranspose(FXMMATRIX m)
+	{
+		return XMMATRIX(m.Get(0, 0), m.Get(1, 0), m.Get(2, 0), m.Get(3, 0),
+			m.Get(0, 1), m.Get(1, 1), m.Get(2, 1), m.Get(3, 1),
+			m.Get(0, 2), m.Get(1, 2), m.Get(2, 2), m.Get(3, 2),
+			m.Get(0, 3), m.Get(1, 3), m.Get(2, 3), m.Get(3, 3));
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixTranslation(float x, float y, float z)
+	{
+		return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixScaling(float x, float y, float z)
+	{
+		return XMMATRIX(x, 0.0f, 0.0f, 0.0f, 0.0f, y, 0.0f, 0.0f, 0.0f, 0.0f, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixRotationY(float angle)
+	{
+		float s, c;
+		XMScalarSinCos(&s, &c, angle);
+		return XMMATRIX(c, 0.0f, -s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, s, 0.0f, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR direction, FXMVECTOR up)
+	{
+		const XMVECTOR r2 = XMVector3Normalize(direction);
+		const XMVECTOR r0 = XMVector3Normalize(XMVector3Cross(up, r2));
+		const XMVECTOR r1 = XMVector3Cross(r2, r0);
+		return XMMATRIX(XMVectorGetX(r0), XMVectorGetX(r1), XMVectorGetX(r2), 0.0f,
+			XMVectorGetY(r0), XMVectorGetY(r1), XMVectorGetY(r2), 0.0f,
+			XMVectorGetZ(r0), XMVectorGetZ(r1), XMVectorGetZ(r2), 0.0f,
+			-XMVector3Dot(r0, eye), -XMVector3Dot(r1, eye), -XMVector3Dot(r2, eye), 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up)
+	{
+		return XMMatrixLookToLH(eye, XMVectorSubtract(focus, eye), up);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float s, c;
+		XMScalarSinCos(&s, &c, 0.5f * fovAngleY);
+		const float height = c / s;
+		const float width = height / aspectRatio;
+		const float range = farZ / (farZ - nearZ);
+		return XMMATRIX(width, 0.0f, 0.0f, 0.0f, 0.0f, height, 0.0f, 0.0f, 0.0f, 0.0f, range, 1.0f, 0.0f, 0.0f, -range * nearZ, 0.0f);
+	}
+
+	inline void XM_CALLCONV XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				destination->m[row][column] = m.Get(row, column);
+		}
+	}
+
+	inline XMMATRIX XM_CALLCONV XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		return XMMATRIX(source->_11, source->_12, source->_13, source->_14, source->_21, source->_22, source->_23, source->_24,
+			source->_31, source->_32, source->_33, source->_34, source->_41, source->_42, source->_43, source->_44);
+	}
+}
@@ -0,0 +1,1060 @@
+/**************************************************************
+	Null D3D12
+
+	An in-process D3D12 device with nothing behind it, for running
+	the device dependent modules on Linux. Resources get a virtual
+	address and, once mapped or written, CPU memory. Heaps, fences
+	and events behave like the real ones, and footprints and
+	allocation sizes follow the D3D12 rules closely enough for the
+	allocators built on top of them.
+
+	Each command queue has a thread of its own playing the gpu: it
+	runs the copies recorded in the lists it executes, in order, and
+	signals and waits on fences. Queues can be paused, to look at
+	the cpu side while the gpu is "busy", or given a latency per
+	ExecuteCommandLists.
+
+	Descriptor heaps are real memory: a CPU handle points at the
+	Descriptor a view wrote, so views and descriptor copies can be
+	checked. Render target clears fill RGBA8 targets.
+
+	Everything the device doesn't implement (root signatures and
+	pipeline states) returns E_NOTIMPL, so a test that wanders off
+	the covered path fails loudly.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DDSParser.h"
+
+namespace NullD3D12
+{
+	inline UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	inline bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM)
+			|| (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+
+	inline UINT SubresourceCount(const D3D12_RESOURCE_DESC& desc)
+	{
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			return 1;
+		const UINT arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+		return arraySize * desc.MipLevels;
+	}
+
+	// Same layout rules as the runtime: rows padded to 256 bytes, subresources
+	// placed at 512 byte boundaries, block compressed footprints in whole blocks
+	inline void GetCopyableFootprints(const D3D12_RESOURCE_DESC* desc, UINT firstSubresource, UINT numSubresources,
+		UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows, UINT64* rowSizeInBytes, UINT64* totalBytes)
+	{
+		if (firstSubresource + numSubresources > SubresourceCount(*desc))
+		{
+			if (totalBytes)
+				*totalBytes = ~UINT64(0);
+			return;
+		}
+
+		UINT64 offset = baseOffset;
+		UINT64 total = 0;
+		for (UINT i = 0; i < numSubresources; i++)
+		{
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = {};
+			UINT rows;
+			UINT64 rowSize;
+
+			if (desc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			{
+				layout.Footprint = { DXGI_FORMAT_UNKNOWN, UINT(desc->Width), 1, 1, UINT(AlignUp(desc->Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)) };
+				rows = 1;
+				rowSize = desc->Width;
+			}
+			else
+			{
+				const UINT mip = (firstSubresource + i) % desc->MipLevels;
+				UINT width = std::max(UINT(desc->Width >> mip), 1u);
+				UINT height = desc->Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ? 1 : std::max(desc->Height >> mip, 1u);
+				const UINT depth = desc->Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? std::max(UINT(desc->DepthOrArraySize) >> mip, 1u) : 1;
+
+				size_t bytes, rowBytes, rowCount;
+				DirectX::GetSurfaceInfo(width, height, desc->Format, &bytes, &rowBytes, &rowCount);
+				if (IsBlockCompressed(desc->Format))
+				{
+					width = UINT(AlignUp(width, 4));
+					height = UINT(AlignUp(height, 4));
+				}
+
+				offset = AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+				layout.Footprint = { desc->Format, width, height, depth, UINT(AlignUp(rowBytes, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)) };
+				rows = UINT(rowCount);
+				rowSize = rowBytes;
+			}
+			layout.Offset = offset;
+
+			// The last row of the last slice isn't padded
+			const UINT64 size = UINT64(layout.Footprint.RowPitch) * (UINT64(rows) * layout.Footprint.Depth - 1) + rowSize;
+			total = layout.Offset + size - baseOffset;
+			offset = layout.Offset + UINT64(layout.Footprint.RowPitch) * rows * layout.Footprint.Depth;
+
+			if (layouts)
+				layouts[i] = layout;
+			if (numRows)
+				numRows[i] = rows;
+			if (rowSizeInBytes)
+				rowSizeInBytes[i] = rowSize;
+		}
+		if (totalBytes)
+			*totalBytes = total;
+	}
+
+	// Resources alive right now, over every device
+	inline std::atomic<int>& LiveResourceCount()
+	{
+		static std::atomic<int> count { 0 };
+		return count;
+	}
+
+	// Reference counting and QueryInterface for one interface (and IUnknown)
+	template <typename Interface>
+	class Object : public Interface
+	{
+	public:
+		HRESULT QueryInterface(REFIID riid, void** object) override
+		{
+			if (riid == UuidOf<IUnknown>() || riid == UuidOf<Interface>())
+			{
+				AddRef();
+				*object = static_cast<Interface*>(this);
+				return S_OK;
+			}
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG AddRef() override { return ++m_refCount; }
+
+		ULONG Release() override
+		{
+			const ULONG count = --m_refCount;
+			if (count == 0)
+				delete this;
+			return count;
+		}
+
+		ULONG GetRefCount() const { return m_refCount; }
+
+		// Hands out 'object' as 'riid', dropping the creator's reference
+		static HRESULT Return(Object* object, REFIID riid, void** out)
+		{
+			const HRESULT hr = object->QueryInterface(riid, out);
+			object->Release();
+			return hr;
+		}
+
+	protected:
+		Object() : m_refCount(1) { }
+
+	private:
+		std::atomic<ULONG> m_refCount;
+	};
+
+	// ID3D12Object's methods, names are kept so a debugger can show them
+	template <typename Interface>
+	class DeviceChild : public Object<Interface>
+	{
+	public:
+		HRESULT GetPrivateData(REFGUID, UINT*, void*) override { return E_NOTIMPL; }
+		HRESULT SetPrivateData(REFGUID, UINT, const void*) override { return E_NOTIMPL; }
+		HRESULT SetPrivateDataInterface(REFGUID, const IUnknown*) override { return E_NOTIMPL; }
+		HRESULT SetName(LPCWSTR name) override { m_name = name ? name : L""; return S_OK; }
+
+		const std::wstring& GetName() const { return m_name; }
+
+	private:
+		std::wstring m_name;
+	};
+
+	template <typename Interface>
+	class Child : public DeviceChild<Interface>
+	{
+	public:
+		HRESULT GetDevice(REFIID riid, void** device) override
+		{
+			return m_device->QueryInterface(riid, device);
+		}
+
+	protected:
+		explicit Child(ID3D12Device* device) : m_device(device) { }
+
+		ID3D12Device* m_device;		// Not a reference, the device outlives everything it made
+	};
+
+	class Heap : public Child<ID3D12Heap>
+	{
+	public:
+		Heap(ID3D12Device* device, const D3D12_HEAP_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS address)
+			: Child(device), m_desc(desc), m_address(address) { }
+
+		D3D12_HEAP_DESC GetDesc() override { return m_desc; }
+		D3D12_GPU_VIRTUAL_ADDRESS GetAddress() const { return m_address; }
+
+	private:
+		D3D12_HEAP_DESC m_desc;
+		D3D12_GPU_VIRTUAL_ADDRESS m_address;
+	};
+
+	class Resource : public Child<ID3D12Resource>
+	{
+	public:
+		Resource(ID3D12Device* device, const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES state,
+			D3D12_GPU_VIRTUAL_ADDRESS address, Heap* heap)
+			: Child(device), m_desc(desc), m_heapType(heapType), m_initialState(state), m_address(address), m_heap(heap)
+		{
+			if (m_heap)
+				m_heap->AddRef();
+			LiveResourceCount()++;
+		}
+
+		~Resource() override
+		{
+			LiveResourceCount()--;
+			if (m_heap)
+				m_heap->Release();
+		}
+
+		// Only upload and readback heaps can be mapped. The memory is allocated
+		// on the first Map and lives as long as the resource.
+		HRESULT Map(UINT subresource, const D3D12_RANGE*, void** data) override
+		{
+			if (m_heapType != D3D12_HEAP_TYPE_UPLOAD && m_heapType != D3D12_HEAP_TYPE_READBACK)
+				return E_INVALIDARG;
+			if (subresource >= SubresourceCount(m_desc))
+				return E_INVALIDARG;
+
+			UINT8* memory = GetMemory();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_mapCount++;
+			if (data)
+				*data = memory;
+			return S_OK;
+		}
+
+		void Unmap(UINT, const D3D12_RANGE*) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_mapCount)
+				m_mapCount--;
+		}
+
+		D3D12_RESOURCE_DESC GetDesc() override { return m_desc; }
+		D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() override
+		{
+			return m_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? m_address : 0;
+		}
+
+		D3D12_HEAP_TYPE GetHeapType() const { return m_heapType; }
+		D3D12_RESOURCE_STATES GetInitialState() const { return m_initialState; }
+		Heap* GetHeap() const { return m_heap; }
+		D3D12_GPU_VIRTUAL_ADDRESS GetAddress() const { return m_address; }
+		UINT GetMapCount() const { return m_mapCount; }
+
+		// Buffers are laid out as is, textures subresource after subresource with
+		// the footprints GetCopyableFootprints gives for them
+		UINT8* GetMemory()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_memory.empty())
+			{
+				UINT64 size = m_desc.Width;
+				if (m_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+					GetCopyableFootprints(&m_desc, 0, SubresourceCount(m_desc), 0, nullptr, nullptr, nullptr, &size);
+				m_memory.resize(size_t(size));
+			}
+			return m_memory.data();
+		}
+
+	private:
+		D3D12_RESOURCE_DESC m_desc;
+		D3D12_HEAP_TYPE m_heapType;
+		D3D12_RESOURCE_STATES m_initialState;
+		D3D12_GPU_VIRTUAL_ADDRESS m_address;
+		Heap* m_heap;
+
+		std::mutex m_mutex;
+		std::vector<UINT8> m_memory;
+		UINT m_mapCount = 0;
+	};
+
+	class Fence : public Child<ID3D12Fence>
+	{
+	public:
+		Fence(ID3D12Device* device, UINT64 initialValue) : Child(device), m_value(initialValue) { }
+
+		UINT64 GetCompletedValue() override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_value;
+		}
+
+		HRESULT SetEventOnCompletion(UINT64 value, HANDLE event) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_value >= value)
+				SetEvent(event);
+			else
+				m_waits.push_back({ value, event });
+			return S_OK;
+		}
+
+		// Same as the gpu reaching the value
+		HRESULT Signal(UINT64 value) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_value = value;
+			for (size_t i = 0; i < m_waits.size();)
+			{
+				if (m_waits[i].Value <= value)
+				{
+					SetEvent(m_waits[i].Event);
+					m_waits.erase(m_waits.begin() + i);
+				}
+				else
+				{
+					i++;
+				}
+			}
+			return S_OK;
+		}
+
+	private:
+		struct Wait
+		{
+			UINT64 Value;
+			HANDLE Event;
+		};
+
+		std::mutex m_mutex;
+		UINT64 m_value;
+		std::vector<Wait> m_waits;
+	};
+
+	// What a view leaves in its descriptor. CPU handles point right at these, so
+	// views can be written, copied and read back like on a real heap.
+	struct Descriptor
+	{
+		ID3D12Resource* Resource;		// Not a reference, like a real descriptor
+		D3D12_DESCRIPTOR_HEAP_TYPE HeapType;
+		UINT ViewDimension;				// The view desc's, 0 without one
+		DXGI_FORMAT Format;
+		bool Written;
+	};
+
+	inline Descriptor& GetDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE handle)
+	{
+		return *reinterpret_cast<Descriptor*>(handle.ptr);
+	}
+
+	class DescriptorHeap : public Child<ID3D12DescriptorHeap>
+	{
+	public:
+		DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC& desc, UINT64 gpuStart)
+			: Child(device), m_desc(desc), m_descriptors(desc.NumDescriptors), m_gpuStart(gpuStart) { }
+
+		D3D12_DESCRIPTOR_HEAP_DESC GetDesc() override { return m_desc; }
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() override
+		{
+			return { SIZE_T(m_descriptors.data()) };
+		}
+
+		// Only shader visible heaps have a gpu side
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() override
+		{
+			return { m_desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE ? m_gpuStart : 0 };
+		}
+
+		bool Contains(D3D12_CPU_DESCRIPTOR_HANDLE handle) const
+		{
+			return handle.ptr >= SIZE_T(m_descriptors.data()) && handle.ptr < SIZE_T(m_descriptors.data() + m_descriptors.size());
+		}
+
+	private:
+		D3D12_DESCRIPTOR_HEAP_DESC m_desc;
+		std::vector<Descriptor> m_descriptors;
+		UINT64 m_gpuStart;
+	};
+
+	// Timestamps are never written, only the calls are checked
+	class QueryHeap : public Child<ID3D12QueryHeap>
+	{
+	public:
+		QueryHeap(ID3D12Device* device, const D3D12_QUERY_HEAP_DESC& desc) : Child(device), m_desc(desc) { }
+
+		const D3D12_QUERY_HEAP_DESC& GetDesc() const { return m_desc; }
+
+	private:
+		D3D12_QUERY_HEAP_DESC m_desc;
+	};
+
+	class CommandAllocator : public Child<ID3D12CommandAllocator>
+	{
+	public:
+		CommandAllocator(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) : Child(device), m_type(type) { }
+
+		HRESULT Reset() override { m_resetCount++; return S_OK; }
+
+		D3D12_COMMAND_LIST_TYPE GetType() const { return m_type; }
+		UINT GetResetCount() const { return m_resetCount; }
+
+	private:
+		D3D12_COMMAND_LIST_TYPE m_type;
+		UINT m_resetCount = 0;
+	};
+
+	// Copies are recorded as work for the queue's gpu thread, everything else
+	// is only counted. Draws also log their StartInstanceLocation, so a test can
+	// tag each draw and check which list it ended up in and in what order.
+	class GraphicsCommandList : public Child<ID3D12GraphicsCommandList>
+	{
+	public:
+		typedef std::function<void()> Work;
+
+		struct Counts
+		{
+			UINT Copies;
+			UINT Barriers;
+			UINT Draws;
+			UINT StateChanges;		// Pipelines, root signatures, root arguments, views, targets
+			UINT Clears;
+		};
+
+		GraphicsCommandList(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) : Child(device), m_type(type), m_counts() { }
+
+		D3D12_COMMAND_LIST_TYPE GetType() override { return m_type; }
+
+		HRESULT Close() override
+		{
+			if (m_closed)
+				return E_FAIL;
+			m_closed = true;
+			return S_OK;
+		}
+
+		HRESULT Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) override
+		{
+			if (!m_closed)
+				return E_FAIL;
+			m_closed = false;
+			m_work.clear();
+			m_draws.clear();
+			m_counts = {};
+			return S_OK;
+		}
+
+		void DrawInstanced(UINT, UINT, UINT, UINT startInstance) override
+		{
+			m_counts.Draws++;
+			m_draws.push_back(startInstance);
+		}
+
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT startInstance) override
+		{
+			m_counts.Draws++;
+			m_draws.push_back(startInstance);
+		}
+
+		void CopyBufferRegion(ID3D12Resource* dstBuffer, UINT64 dstOffset, ID3D12Resource* srcBuffer, UINT64 srcOffset, UINT64 numBytes) override
+		{
+			Resource* dst = static_cast<Resource*>(dstBuffer);
+			Resource* src = static_cast<Resource*>(srcBuffer);
+			if (dstOffset + numBytes > dst->GetDesc().Width || srcOffset + numBytes > src->GetDesc().Width)
+			{
+				m_errors++;
+				return;
+			}
+
+			m_counts.Copies++;
+			m_work.push_back([=] { memcpy(dst->GetMemory() + dstOffset, src->GetMemory() + srcOffset, size_t(numBytes)); });
+		}
+
+		// Only whole subresources from a placed footprint into a texture, which is
+		// all UpdateSubresources records
+		void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst, UINT dstX, UINT dstY, UINT dstZ,
+			const D3D12_TEXTURE_COPY_LOCATION* src, const D3D12_BOX* srcBox) override
+		{
+			if (dst->Type != D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX || src->Type != D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT
+				|| dstX || dstY || dstZ || srcBox)
+			{
+				m_errors++;
+				return;
+			}
+
+			Resource* texture = static_cast<Resource*>(dst->pResource);
+			Resource* buffer = static_cast<Resource*>(src->pResource);
+			const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT target = {};
+			UINT rows = 0;
+			UINT64 rowSize = 0;
+			UINT64 textureSize = 0;
+			GetCopyableFootprints(&desc, dst->SubresourceIndex, 1, 0, nullptr, nullptr, nullptr, &textureSize);
+			if (textureSize == ~UINT64(0))
+			{
+				m_errors++;
+				return;
+			}
+
+			// Where the subresource sits in the texture's own memory
+			UINT64 offset = 0;
+			if (dst->SubresourceIndex)
+				GetCopyableFootprints(&desc, 0, dst->SubresourceIndex, 0, nullptr, nullptr, nullptr, &offset);
+			GetCopyableFootprints(&desc, dst->SubresourceIndex, 1, offset, &target, &rows, &rowSize, nullptr);
+
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT source = src->PlacedFootprint;
+			if (source.Footprint.Format != desc.Format || source.Footprint.Width != target.Footprint.Width
+				|| source.Footprint.Height != target.Footprint.Height || source.Footprint.Depth != target.Footprint.Depth
+				|| source.Footprint.RowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT || source.Offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+				|| source.Offset + UINT64(source.Footprint.RowPitch) * (UINT64(rows) * source.Footprint.Depth - 1) + rowSize > buffer->GetDesc().Width)
+			{
+				m_errors++;
+				return;
+			}
+
+			m_counts.Copies++;
+			m_work.push_back([=]
+			{
+				UINT8* to = texture->GetMemory() + target.Offset;
+				const UINT8* from = buffer->GetMemory() + source.Offset;
+				for (UINT row = 0; row < rows * target.Footprint.Depth; row++)
+					memcpy(to + UINT64(row) * target.Footprint.RowPitch, from + UINT64(row) * source.Footprint.RowPitch, size_t(rowSize));
+			});
+		}
+
+		void CopyResource(ID3D12Resource* dstResource, ID3D12Resource* srcResource) override
+		{
+			Resource* dst = static_cast<Resource*>(dstResource);
+			Resource* src = static_cast<Resource*>(srcResource);
+			m_counts.Copies++;
+			m_work.push_back([=]
+			{
+				UINT64 size = dst->GetDesc().Width;
+				const D3D12_RESOURCE_DESC desc = dst->GetDesc();
+				if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+					GetCopyableFootprints(&desc, 0, SubresourceCount(desc), 0, nullptr, nullptr, nullptr, &size);
+				memcpy(dst->GetMemory(), src->GetMemory(), size_t(size));
+			});
+		}
+
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) override { m_counts.StateChanges++; }
+		void RSSetViewports(UINT, const D3D12_VIEWPORT*) override { m_counts.StateChanges++; }
+		void RSSetScissorRects(UINT, const D3D12_RECT*) override { m_counts.StateChanges++; }
+		void SetPipelineState(ID3D12PipelineState*) override { m_counts.StateChanges++; }
+		void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER*) override { m_counts.Barriers += numBarriers; }
+		void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) override { m_counts.StateChanges++; }
+		void SetGraphicsRootSignature(ID3D12RootSignature*) override { m_counts.StateChanges++; }
+		void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) override { m_counts.StateChanges++; }
+		void SetGraphicsRoot32BitConstant(UINT, UINT, UINT) override { m_counts.StateChanges++; }
+		void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) override { m_counts.StateChanges++; }
+		void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { m_counts.StateChanges++; }
+		void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { m_counts.StateChanges++; }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) override { m_counts.StateChanges++; }
+		void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) override { m_counts.StateChanges++; }
+		void OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) override { m_counts.StateChanges++; }
+		void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT, const D3D12_RECT*) override { }
+		// Whole RGBA8 targets get the color written to their first mip, anything
+		// else is only counted
+		void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4], UINT numRects, const D3D12_RECT*) override
+		{
+			const Descriptor descriptor = GetDescriptor(renderTargetView);
+			if (!descriptor.Written || descriptor.HeapType != D3D12_DESCRIPTOR_HEAP_TYPE_RTV || !descriptor.Resource)
+			{
+				m_errors++;
+				return;
+			}
+
+			m_counts.Clears++;
+			Resource* target = static_cast<Resource*>(descriptor.Resource);
+			const D3D12_RESOURCE_DESC desc = target->GetDesc();
+			if (numRects || desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D
+				|| (desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM && desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB))
+				return;
+
+			UINT8 texel[4];
+			for (int i = 0; i < 4; i++)
+				texel[i] = UINT8(std::min(std::max(colorRGBA[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = {};
+			UINT rows = 0;
+			GetCopyableFootprints(&desc, 0, 1, 0, &layout, &rows, nullptr, nullptr);
+			m_work.push_back([=]
+			{
+				UINT8* memory = target->GetMemory() + layout.Offset;
+				for (UINT row = 0; row < rows; row++)
+				{
+					for (UINT x = 0; x < layout.Footprint.Width; x++)
+						memcpy(memory + UINT64(row) * layout.Footprint.RowPitch + 4 * x, texel, 4);
+				}
+			});
+		}
+
+		void EndQuery(ID3D12QueryHeap* queryHeap, D3D12_QUERY_TYPE, UINT index) override
+		{
+			if (index >= static_cast<QueryHeap*>(queryHeap)->GetDesc().Count)
+				m_errors++;
+		}
+
+		void ResolveQueryData(ID3D12QueryHeap* queryHeap, D3D12_QUERY_TYPE, UINT startIndex, UINT numQueries, ID3D12Resource* destination,
+			UINT64 alignedDestinationBufferOffset) override
+		{
+			if (startIndex + numQueries > static_cast<QueryHeap*>(queryHeap)->GetDesc().Count
+				|| alignedDestinationBufferOffset % 8 || alignedDestinationBufferOffset + 8 * numQueries > destination->GetDesc().Width)
+				m_errors++;
+		}
+
+		bool IsClosed() const { return m_closed; }
+		const Counts& GetCounts() const { return m_counts; }
+		UINT GetErrorCount() const { return m_errors; }			// Calls the real runtime would have rejected
+		const std::vector<Work>& GetWork() const { return m_work; }
+		const std::vector<UINT>& GetDraws() const { return m_draws; }	// StartInstanceLocation of each draw since Reset
+
+	private:
+		D3D12_COMMAND_LIST_TYPE m_type;
+		bool m_closed = false;
+		std::vector<Work> m_work;
+		std::vector<UINT> m_draws;
+		Counts m_counts;
+		UINT m_errors = 0;
+	};
+
+	class CommandQueue : public Child<ID3D12CommandQueue>
+	{
+	public:
+		CommandQueue(ID3D12Device* device, const D3D12_COMMAND_QUEUE_DESC& desc, std::chrono::microseconds latency)
+			: Child(device), m_desc(desc), m_latency(latency)
+		{
+			m_gpu = std::thread([this] { GpuLoop(); });
+		}
+
+		~CommandQueue() override
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_quit = true;
+				m_paused = false;
+			}
+			m_changed.notify_all();
+			m_gpu.join();
+		}
+
+		void ExecuteCommandLists(UINT numCommandLists, ID3D12CommandList* const* commandLists) override
+		{
+			std::vector<GraphicsCommandList::Work> work;
+			for (UINT i = 0; i < numCommandLists; i++)
+			{
+				GraphicsCommandList* list = static_cast<GraphicsCommandList*>(commandLists[i]);
+				if (!list->IsClosed() || list->GetType() != m_desc.Type)
+					m_errors++;
+				work.insert(work.end(), list->GetWork().begin(), list->GetWork().end());
+			}
+
+			m_executeCount++;
+			const std::chrono::microseconds latency = m_latency;
+			Push([work, latency]
+			{
+				if (latency.count())
+					std::this_thread::sleep_for(latency);
+				for (const GraphicsCommandList::Work& item : work)
+					item();
+			});
+		}
+
+		HRESULT Signal(ID3D12Fence* fence, UINT64 value) override
+		{
+			fence->AddRef();
+			Push([fence, value]
+			{
+				fence->Signal(value);
+				fence->Release();
+			});
+			return S_OK;
+		}
+
+		HRESULT Wait(ID3D12Fence* fence, UINT64 value) override
+		{
+			fence->AddRef();
+			Push([fence, value]
+			{
+				HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+				fence->SetEventOnCompletion(value, event);
+				WaitForSingleObject(event, INFINITE);
+				CloseHandle(event);
+				fence->Release();
+			});
+			return S_OK;
+		}
+
+		HRESULT GetTimestampFrequency(UINT64* frequency) override
+		{
+			*frequency = 1000000000;
+			return S_OK;
+		}
+
+		D3D12_COMMAND_QUEUE_DESC GetDesc() override { return m_desc; }
+
+		// A paused gpu takes work but doesn't run any of it
+		void Pause()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_paused = true;
+		}
+
+		void Resume()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_paused = false;
+			}
+			m_changed.notify_all();
+		}
+
+		// Blocks until everything pushed so far has run, the queue mustn't be paused
+		void WaitIdle()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this] { return m_work.empty() && !m_running; });
+		}
+
+		UINT GetExecuteCount() const { return m_executeCount; }
+		UINT GetErrorCount() const { return m_errors; }
+
+	private:
+		void Push(std::function<void()> work)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_work.push_back(std::move(work));
+			}
+			m_changed.notify_all();
+		}
+
+		void GpuLoop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (;;)
+			{
+				m_changed.wait(lock, [this] { return m_quit || (!m_paused && !m_work.empty()); });
+				if (m_work.empty())
+					return;		// Quitting, and everything already pushed has run
+
+				std::function<void()> work = std::move(m_work.front());
+				m_work.pop_front();
+				m_running = true;
+				lock.unlock();
+				work();
+				lock.lock();
+				m_running = false;
+				m_changed.notify_all();
+			}
+		}
+
+		D3D12_COMMAND_QUEUE_DESC m_desc;
+		std::chrono::microseconds m_latency;
+		std::atomic<UINT> m_executeCount { 0 };
+		std::atomic<UINT> m_errors { 0 };
+
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+		std::deque<std::function<void()>> m_work;
+		bool m_paused = false;
+		bool m_running = false;
+		bool m_quit = false;
+		std::thread m_gpu;		// Last, it uses everything above
+	};
+
+	class Device : public DeviceChild<ID3D12Device2>
+	{
+	public:
+		Device() { }
+
+		// Tier 2 unless a test wants to see the split heaps
+		D3D12_RESOURCE_HEAP_TIER ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+
+		// How long each ExecuteCommandLists keeps the gpu of queues created from now on busy
+		std::chrono::microseconds QueueLatency { 0 };
+
+		// CreateDescriptorHeap runs out of memory once this many have been created
+		UINT DescriptorHeapLimit = ~0u;
+
+		HRESULT QueryInterface(REFIID riid, void** object) override
+		{
+			if (riid == UuidOf<ID3D12Device>() || riid == UuidOf<ID3D12Device1>())
+			{
+				AddRef();
+				*object = static_cast<ID3D12Device2*>(this);
+				return S_OK;
+			}
+			return DeviceChild::QueryInterface(riid, object);
+		}
+
+		UINT GetNodeCount() override { return 1; }
+
+		HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** commandQueue) override
+		{
+			return CommandQueue::Return(new CommandQueue(this, *desc, QueueLatency), riid, commandQueue);
+		}
+
+		HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** commandAllocator) override
+		{
+			m_allocatorCount++;
+			return CommandAllocator::Return(new CommandAllocator(this, type), riid, commandAllocator);
+		}
+
+		HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+		HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+		HRESULT CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* allocator, ID3D12PipelineState*,
+			REFIID riid, void** commandList) override
+		{
+			if (static_cast<CommandAllocator*>(allocator)->GetType() != type)
+				return E_INVALIDARG;
+
+			m_commandListCount++;
+			return GraphicsCommandList::Return(new GraphicsCommandList(this, type), riid, commandList);
+		}
+
+		HRESULT CheckFeatureSupport(D3D12_FEATURE feature, void* data, UINT dataSize) override
+		{
+			switch (feature)
+			{
+			case D3D12_FEATURE_D3D12_OPTIONS:
+			{
+				if (dataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+					return E_INVALIDARG;
+				D3D12_FEATURE_DATA_D3D12_OPTIONS* options = static_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS*>(data);
+				*options = {};
+				options->ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+				options->ResourceHeapTier = ResourceHeapTier;
+				return S_OK;
+			}
+			case D3D12_FEATURE_FORMAT_INFO:
+			{
+				if (dataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_INFO))
+					return E_INVALIDARG;
+				D3D12_FEATURE_DATA_FORMAT_INFO* info = static_cast<D3D12_FEATURE_DATA_FORMAT_INFO*>(data);
+				const bool depthStencil = info->Format == DXGI_FORMAT_D24_UNORM_S8_UINT || info->Format == DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
+				info->PlaneCount = depthStencil ? 2 : 1;
+				return S_OK;
+			}
+			default:
+				return E_INVALIDARG;
+			}
+		}
+
+		HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* desc, REFIID riid, void** heap) override
+		{
+			if (desc->NumDescriptors == 0 || ((desc->Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+				&& (desc->Type == D3D12_DESCRIPTOR_HEAP_TYPE_RTV || desc->Type == D3D12_DESCRIPTOR_HEAP_TYPE_DSV)))
+				return E_INVALIDARG;
+			if (m_descriptorHeapCount >= DescriptorHeapLimit)
+				return E_OUTOFMEMORY;
+
+			m_descriptorHeapCount++;
+			return DescriptorHeap::Return(new DescriptorHeap(this, *desc, Reserve(UINT64(desc->NumDescriptors) * sizeof(Descriptor))), riid, heap);
+		}
+
+		UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override { return sizeof(Descriptor); }
+		HRESULT CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void**) override { return E_NOTIMPL; }
+
+		void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) override
+		{
+			GetDescriptor(destDescriptor) = { nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 0, DXGI_FORMAT_UNKNOWN, true };
+		}
+
+		void CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) override
+		{
+			WriteView(destDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, resource, desc ? UINT(desc->ViewDimension) : 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN);
+		}
+
+		void CreateRenderTargetView(ID3D12Resource* resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) override
+		{
+			WriteView(destDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, resource, desc ? UINT(desc->ViewDimension) : 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN);
+		}
+
+		void CreateDepthStencilView(ID3D12Resource* resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) override
+		{
+			WriteView(destDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, resource, desc ? UINT(desc->ViewDimension) : 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN);
+		}
+
+		void CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) override
+		{
+			GetDescriptor(destDescriptor) = { nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 0, DXGI_FORMAT_UNKNOWN, true };
+		}
+
+		// A null size array means ranges of one, same as the runtime
+		void CopyDescriptors(UINT numDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* destDescriptorRangeStarts, const UINT* destDescriptorRangeSizes,
+			UINT numSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* srcDescriptorRangeStarts, const UINT* srcDescriptorRangeSizes,
+			D3D12_DESCRIPTOR_HEAP_TYPE) override
+		{
+			UINT dstRange = 0, dstIndex = 0, copied = 0;
+			for (UINT srcRange = 0; srcRange < numSrcDescriptorRanges; srcRange++)
+			{
+				const UINT srcSize = srcDescriptorRangeSizes ? srcDescriptorRangeSizes[srcRange] : 1;
+				for (UINT srcIndex = 0; srcIndex < srcSize; srcIndex++)
+				{
+					while (dstRange < numDestDescriptorRanges && dstIndex == (destDescriptorRangeSizes ? destDescriptorRangeSizes[dstRange] : 1))
+					{
+						dstRange++;
+						dstIndex = 0;
+					}
+					if (dstRange == numDestDescriptorRanges)
+					{
+						m_copiedDescriptorCount += copied;
+						return;
+					}
+
+					const Descriptor* source = reinterpret_cast<const Descriptor*>(srcDescriptorRangeStarts[srcRange].ptr) + srcIndex;
+					reinterpret_cast<Descriptor*>(destDescriptorRangeStarts[dstRange].ptr)[dstIndex++] = *source;
+					copied++;
+				}
+			}
+			m_copiedDescriptorCount += copied;
+		}
+
+		void CopyDescriptorsSimple(UINT numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptorRangeStart, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptorRangeStart,
+			D3D12_DESCRIPTOR_HEAP_TYPE) override
+		{
+			memmove(reinterpret_cast<void*>(destDescriptorRangeStart.ptr), reinterpret_cast<const void*>(srcDescriptorRangeStart.ptr),
+				numDescriptors * sizeof(Descriptor));
+			m_copiedDescriptorCount += numDescriptors;
+		}
+
+		// Buffers and big textures align to 64 KB, small textures that ask for
+		// it to 4 KB, multisampled ones to 4 MB
+		D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT, UINT numResourceDescs, const D3D12_RESOURCE_DESC* descs) override
+		{
+			D3D12_RESOURCE_ALLOCATION_INFO info = { 0, 0 };
+			for (UINT i = 0; i < numResourceDescs; i++)
+			{
+				const D3D12_RESOURCE_DESC& desc = descs[i];
+				UINT64 size = desc.Width;
+				if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+					GetCopyableFootprints(&desc, 0, SubresourceCount(desc), 0, nullptr, nullptr, nullptr, &size);
+				if (size == ~UINT64(0))
+					return { ~UINT64(0), 0 };
+
+				UINT64 alignment = desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+				if (desc.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT && desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER
+					&& size <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+					alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+
+				info.SizeInBytes = AlignUp(info.SizeInBytes, alignment) + AlignUp(size, alignment);
+				info.Alignment = std::max(info.Alignment, alignment);
+			}
+			return info;
+		}
+
+		HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* desc,
+			D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE*, REFIID riid, void** resource) override
+		{
+			const D3D12_RESOURCE_ALLOCATION_INFO info = GetResourceAllocationInfo(0, 1, desc);
+			if (info.Alignment == 0)
+				return E_INVALIDARG;
+
+			m_committedCount++;
+			Resource* created = new Resource(this, *desc, heapProperties->Type, initialState, Reserve(info.SizeInBytes), nullptr);
+			return Resource::Return(created, riid, resource);
+		}
+
+		HRESULT CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** heap) override
+		{
+			if (desc->SizeInBytes == 0)
+				return E_INVALIDARG;
+
+			m_heapCount++;
+			return Heap::Return(new Heap(this, *desc, Reserve(desc->SizeInBytes)), riid, heap);
+		}
+
+		HRESULT CreatePlacedResource(ID3D12Heap* heap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE*, REFIID riid, void** resource) override
+		{
+			Heap* nullHeap = static_cast<Heap*>(heap);
+			const D3D12_HEAP_DESC heapDesc = nullHeap->GetDesc();
+			const D3D12_RESOURCE_ALLOCATION_INFO info = GetResourceAllocationInfo(0, 1, desc);
+			if (info.Alignment == 0 || heapOffset % info.Alignment || heapOffset + info.SizeInBytes > heapDesc.SizeInBytes)
+				return E_INVALIDARG;
+
+			m_placedCount++;
+			Resource* created = new Resource(this, *desc, heapDesc.Properties.Type, initialState, nullHeap->GetAddress() + heapOffset, nullHeap);
+			return Resource::Return(created, riid, resource);
+		}
+
+		HRESULT CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS, REFIID riid, void** fence) override
+		{
+			return Fence::Return(new Fence(this, initialValue), riid, fence);
+		}
+
+		HRESULT GetDeviceRemovedReason() override { return S_OK; }
+
+		void GetCopyableFootprints(const D3D12_RESOURCE_DESC* desc, UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows, UINT64* rowSizeInBytes, UINT64* totalBytes) override
+		{
+			NullD3D12::GetCopyableFootprints(desc, firstSubresource, numSubresources, baseOffset, layouts, numRows, rowSizeInBytes, totalBytes);
+		}
+
+		HRESULT CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* desc, REFIID riid, void** heap) override
+		{
+			if (desc->Count == 0)
+				return E_INVALIDARG;
+			return QueryHeap::Return(new QueryHeap(this, *desc), riid, heap);
+		}
+
+		LUID GetAdapterLuid() override { return { 0, 0 }; }
+
+		HRESULT CreatePipelineLibrary(const void*, SIZE_T, REFIID, void**) override { return E_NOTIMPL; }
+		HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+
+		UINT GetCommittedCount() const { return m_committedCount; }
+		UINT GetPlacedCount() const { return m_placedCount; }
+		UINT GetHeapCount() const { return m_heapCount; }
+		UINT GetAllocatorCount() const { return m_allocatorCount; }
+		UINT GetCommandListCount() const { return m_commandListCount; }
+		UINT GetDescriptorHeapCount() const { return m_descriptorHeapCount; }
+		UINT GetCopiedDescriptorCount() const { return m_copiedDescriptorCount; }
+
+	private:
+		void WriteView(D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE heapType, ID3D12Resource* resource, UINT viewDimension, DXGI_FORMAT format)
+		{
+			if (resource && format == DXGI_FORMAT_UNKNOWN)
+				format = resource->GetDesc().Format;
+			GetDescriptor(destDescriptor) = { resource, heapType, viewDimension, format, true };
+		}
+
+		// Address space only, never freed
+		D3D12_GPU_VIRTUAL_ADDRESS Reserve(UINT64 size)
+		{
+			return m_nextAddress.fetch_add(AlignUp(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+		}
+
+		std::atomic<UINT64> m_nextAddress { 0x100000000ull };
+		std::atomic<UINT> m_committedCount { 0 };
+		std::atomic<UINT> m_placedCount { 0 };
+		std::atomic<UINT> m_heapCount { 0 };
+		std::atomic<UINT> m_allocatorCount { 0 };
+		std::atomic<UINT> m_commandListCount { 0 };
+		std::atomic<UINT> m_descriptorHeapCount { 0 };
+		std::atomic<UINT> m_copiedDescriptorCount { 0 };
+	};
+}
@@ -0,0 +1,1503 @@
+/**************************************************************
+	d3d12.h (Linux stand-in)
+
+	The part of the D3D12 API this repo and d3dx12.h (without its
+	state object helpers) use, so the device independent modules
+	and the tests that drive them build with GCC and Clang. Enum
+	values, structure layouts and method signatures are the real
+	ones. Interfaces only carry the methods something here calls,
+	and they're plain abstract classes: there is no runtime behind
+	them, Linux/NullD3D12.h is the implementation to test with.
+**************************************************************/
+#pragma once
+#include "winadapter.h"
+#include "dxgiformat.h"
+#include "d3dcommon.h"
+
+#define D3DX12_NO_STATE_OBJECT_HELPERS
+
+// dxgicommon.h
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+// Constants
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT 256
+#define D3D12_DEFAULT_DEPTH_BIAS 0
+#define D3D12_DEFAULT_DEPTH_BIAS_CLAMP 0.0f
+#define D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS 0.0f
+#define D3D12_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK 0xff
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT 4194304
+#define D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT 4096
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND 0xffffffff
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+#define D3D12_FLOAT32_MAX 3.402823466e+38f
+#define D3D12_MAX_DEPTH 1.0f
+#define D3D12_MIN_DEPTH 0.0f
+#define D3D12_REQ_SUBRESOURCES 30720
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D12_APPEND_ALIGNED_ELEMENT 0xffffffff
+
+#define D3D12_SHADER_COMPONENT_MAPPING_MASK 0x7
+#define D3D12_SHADER_COMPONENT_MAPPING_SHIFT 3
+#define D3D12_SHADER_COMPONENT_MAPPING_ALWAYS_SET_BIT_AVOIDING_ZEROMEM_MISTAKES (1 << (D3D12_SHADER_COMPONENT_MAPPING_SHIFT * 4))
+#define D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(Src0, Src1, Src2, Src3) \
+	((((Src0) & D3D12_SHADER_COMPONENT_MAPPING_MASK) | \
+	(((Src1) & D3D12_SHADER_COMPONENT_MAPPING_MASK) << D3D12_SHADER_COMPONENT_MAPPING_SHIFT) | \
+	(((Src2) & D3D12_SHADER_COMPONENT_MAPPING_MASK) << (D3D12_SHADER_COMPONENT_MAPPING_SHIFT * 2)) | \
+	(((Src3) & D3D12_SHADER_COMPONENT_MAPPING_MASK) << (D3D12_SHADER_COMPONENT_MAPPING_SHIFT * 3)) | \
+	D3D12_SHADER_COMPONENT_MAPPING_ALWAYS_SET_BIT_AVOIDING_ZEROMEM_MISTAKES))
+#define D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 1, 2, 3)
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+typedef RECT D3D12_RECT;
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+
+enum D3D_ROOT_SIGNATURE_VERSION
+{
+	D3D_ROOT_SIGNATURE_VERSION_1 = 0x1,
+	D3D_ROOT_SIGNATURE_VERSION_1_0 = 0x1,
+	D3D_ROOT_SIGNATURE_VERSION_1_1 = 0x2,
+};
+
+// Enums
+enum D3D12_COMMAND_LIST_TYPE
+{
+	D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+	D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+	D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+	D3D12_COMMAND_LIST_TYPE_COPY = 3,
+};
+
+enum D3D12_COMMAND_QUEUE_FLAGS
+{
+	D3D12_COMMAND_QUEUE_FLAG_NONE = 0,
+	D3D12_COMMAND_QUEUE_FLAG_DISABLE_GPU_TIMEOUT = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_COMMAND_QUEUE_FLAGS)
+
+enum D3D12_COMMAND_QUEUE_PRIORITY
+{
+	D3D12_COMMAND_QUEUE_PRIORITY_NORMAL = 0,
+	D3D12_COMMAND_QUEUE_PRIORITY_HIGH = 100,
+};
+
+enum D3D12_FENCE_FLAGS
+{
+	D3D12_FENCE_FLAG_NONE = 0,
+	D3D12_FENCE_FLAG_SHARED = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_FENCE_FLAGS)
+
+enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3,
+	D3D12_HEAP_TYPE_CUSTOM = 4,
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+	D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE = 1,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE = 2,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_BACK = 3,
+};
+
+enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+	D3D12_MEMORY_POOL_L0 = 1,
+	D3D12_MEMORY_POOL_L1 = 2,
+};
+
+enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_SHARED = 0x1,
+	D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+	D3D12_HEAP_FLAG_ALLOW_DISPLAY = 0x8,
+	D3D12_HEAP_FLAG_SHARED_CROSS_ADAPTER = 0x20,
+	D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+	D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+	D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES = 0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4,
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+	D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE = 2,
+	D3D12_TEXTURE_LAYOUT_64KB_STANDARD_SWIZZLE = 3,
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+	D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE = 0x8,
+	D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER = 0x10,
+	D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS = 0x20,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	D3D12_RESOURCE_STATE_STREAM_OUT = 0x100,
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+	D3D12_RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+	D3D12_RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+	D3D12_RESOURCE_STATE_PRESENT = 0,
+	D3D12_RESOURCE_STATE_PREDICATION = 0x200,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+	D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+	D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+	D3D12_RESOURCE_BARRIER_TYPE_UAV = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+	D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+	D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+	D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_BARRIER_FLAGS)
+
+enum D3D12_TEXTURE_COPY_TYPE
+{
+	D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0,
+	D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE
+{
+	D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+	D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER = 1,
+	D3D12_DESCRIPTOR_HEAP_TYPE_RTV = 2,
+	D3D12_DESCRIPTOR_HEAP_TYPE_DSV = 3,
+	D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES = 4,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_FLAGS
+{
+	D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0,
+	D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_DESCRIPTOR_HEAP_FLAGS)
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+	D3D12_DESCRIPTOR_RANGE_TYPE_UAV = 1,
+	D3D12_DESCRIPTOR_RANGE_TYPE_CBV = 2,
+	D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER = 3,
+};
+
+enum D3D12_DESCRIPTOR_RANGE_FLAGS
+{
+	D3D12_DESCRIPTOR_RANGE_FLAG_NONE = 0,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE = 0x1,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE = 0x2,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE = 0x4,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC = 0x8,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_DESCRIPTOR_RANGE_FLAGS)
+
+enum D3D12_ROOT_DESCRIPTOR_FLAGS
+{
+	D3D12_ROOT_DESCRIPTOR_FLAG_NONE = 0,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE = 0x2,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE = 0x4,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC = 0x8,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_ROOT_DESCRIPTOR_FLAGS)
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+	D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS = 1,
+	D3D12_ROOT_PARAMETER_TYPE_CBV = 2,
+	D3D12_ROOT_PARAMETER_TYPE_SRV = 3,
+	D3D12_ROOT_PARAMETER_TYPE_UAV = 4,
+};
+
+enum D3D12_SHADER_VISIBILITY
+{
+	D3D12_SHADER_VISIBILITY_ALL = 0,
+	D3D12_SHADER_VISIBILITY_VERTEX = 1,
+	D3D12_SHADER_VISIBILITY_HULL = 2,
+	D3D12_SHADER_VISIBILITY_DOMAIN = 3,
+	D3D12_SHADER_VISIBILITY_GEOMETRY = 4,
+	D3D12_SHADER_VISIBILITY_PIXEL = 5,
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+	D3D12_ROOT_SIGNATURE_FLAG_NONE = 0,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS = 0x2,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS = 0x4,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS = 0x8,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS = 0x10,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS = 0x20,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_STREAM_OUTPUT = 0x40,
+	D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE = 0x80,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_ROOT_SIGNATURE_FLAGS)
+
+enum D3D12_FILTER
+{
+	D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D12_FILTER_MIN_MAG_POINT_MIP_LINEAR = 0x1,
+	D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT = 0x14,
+	D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D12_FILTER_ANISOTROPIC = 0x55,
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+	D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR = 2,
+	D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3,
+	D3D12_TEXTURE_ADDRESS_MODE_BORDER = 4,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR_ONCE = 5,
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8,
+};
+
+enum D3D12_STATIC_BORDER_COLOR
+{
+	D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK = 0,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK = 1,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE = 2,
+};
+
+enum D3D12_BLEND
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_COLOR = 3,
+	D3D12_BLEND_INV_SRC_COLOR = 4,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6,
+};
+
+enum D3D12_BLEND_OP
+{
+	D3D12_BLEND_OP_ADD = 1,
+	D3D12_BLEND_OP_SUBTRACT = 2,
+	D3D12_BLEND_OP_REV_SUBTRACT = 3,
+	D3D12_BLEND_OP_MIN = 4,
+	D3D12_BLEND_OP_MAX = 5,
+};
+
+enum D3D12_LOGIC_OP
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_SET = 1,
+	D3D12_LOGIC_OP_COPY = 2,
+	D3D12_LOGIC_OP_COPY_INVERTED = 3,
+	D3D12_LOGIC_OP_NOOP = 4,
+};
+
+enum D3D12_COLOR_WRITE_ENABLE
+{
+	D3D12_COLOR_WRITE_ENABLE_RED = 1,
+	D3D12_COLOR_WRITE_ENABLE_GREEN = 2,
+	D3D12_COLOR_WRITE_ENABLE_BLUE = 4,
+	D3D12_COLOR_WRITE_ENABLE_ALPHA = 8,
+	D3D12_COLOR_WRITE_ENABLE_ALL = 15,
+};
+
+enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3,
+};
+
+enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3,
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1,
+};
+
+enum D3D12_DEPTH_WRITE_MASK
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1,
+};
+
+enum D3D12_STENCIL_OP
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+	D3D12_STENCIL_OP_ZERO = 2,
+	D3D12_STENCIL_OP_REPLACE = 3,
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1,
+};
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE
+{
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF = 1,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF = 2,
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH = 4,
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS
+{
+	D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+	D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_PIPELINE_STATE_FLAGS)
+
+enum D3D12_PIPELINE_STATE_SUBOBJECT_TYPE
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE = 0,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS = 1,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS = 2,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS = 3,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS = 4,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS = 5,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS = 6,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT = 7,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND = 8,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK = 9,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER = 10,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL = 11,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT = 12,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE = 13,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY = 14,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS = 15,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT = 16,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC = 17,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK = 18,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO = 19,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS = 20,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1 = 21,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING = 22,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID = 23,
+};
+
+enum D3D12_VIEW_INSTANCING_FLAGS
+{
+	D3D12_VIEW_INSTANCING_FLAG_NONE = 0,
+	D3D12_VIEW_INSTANCING_FLAG_ENABLE_VIEW_INSTANCE_MASKING = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_VIEW_INSTANCING_FLAGS)
+
+enum D3D12_SRV_DIMENSION
+{
+	D3D12_SRV_DIMENSION_UNKNOWN = 0,
+	D3D12_SRV_DIMENSION_BUFFER = 1,
+	D3D12_SRV_DIMENSION_TEXTURE1D = 2,
+	D3D12_SRV_DIMENSION_TEXTURE1DARRAY = 3,
+	D3D12_SRV_DIMENSION_TEXTURE2D = 4,
+	D3D12_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+	D3D12_SRV_DIMENSION_TEXTURE2DMS = 6,
+	D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY = 7,
+	D3D12_SRV_DIMENSION_TEXTURE3D = 8,
+	D3D12_SRV_DIMENSION_TEXTURECUBE = 9,
+	D3D12_SRV_DIMENSION_TEXTURECUBEARRAY = 10,
+};
+
+enum D3D12_BUFFER_SRV_FLAGS
+{
+	D3D12_BUFFER_SRV_FLAG_NONE = 0,
+	D3D12_BUFFER_SRV_FLAG_RAW = 0x1,
+};
+
+enum D3D12_RTV_DIMENSION
+{
+	D3D12_RTV_DIMENSION_UNKNOWN = 0,
+	D3D12_RTV_DIMENSION_BUFFER = 1,
+	D3D12_RTV_DIMENSION_TEXTURE1D = 2,
+	D3D12_RTV_DIMENSION_TEXTURE1DARRAY = 3,
+	D3D12_RTV_DIMENSION_TEXTURE2D = 4,
+	D3D12_RTV_DIMENSION_TEXTURE2DARRAY = 5,
+};
+
+enum D3D12_DSV_DIMENSION
+{
+	D3D12_DSV_DIMENSION_UNKNOWN = 0,
+	D3D12_DSV_DIMENSION_TEXTURE1D = 1,
+	D3D12_DSV_DIMENSION_TEXTURE1DARRAY = 2,
+	D3D12_DSV_DIMENSION_TEXTURE2D = 3,
+	D3D12_DSV_DIMENSION_TEXTURE2DARRAY = 4,
+};
+
+enum D3D12_DSV_FLAGS
+{
+	D3D12_DSV_FLAG_NONE = 0,
+	D3D12_DSV_FLAG_READ_ONLY_DEPTH = 0x1,
+	D3D12_DSV_FLAG_READ_ONLY_STENCIL = 0x2,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_DSV_FLAGS)
+
+enum D3D12_CLEAR_FLAGS
+{
+	D3D12_CLEAR_FLAG_DEPTH = 0x1,
+	D3D12_CLEAR_FLAG_STENCIL = 0x2,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_CLEAR_FLAGS)
+
+enum D3D12_QUERY_HEAP_TYPE
+{
+	D3D12_QUERY_HEAP_TYPE_OCCLUSION = 0,
+	D3D12_QUERY_HEAP_TYPE_TIMESTAMP = 1,
+	D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS = 2,
+	D3D12_QUERY_HEAP_TYPE_SO_STATISTICS = 3,
+};
+
+enum D3D12_QUERY_TYPE
+{
+	D3D12_QUERY_TYPE_OCCLUSION = 0,
+	D3D12_QUERY_TYPE_BINARY_OCCLUSION = 1,
+	D3D12_QUERY_TYPE_TIMESTAMP = 2,
+	D3D12_QUERY_TYPE_PIPELINE_STATISTICS = 3,
+};
+
+enum D3D12_FEATURE
+{
+	D3D12_FEATURE_D3D12_OPTIONS = 0,
+	D3D12_FEATURE_ARCHITECTURE = 1,
+	D3D12_FEATURE_FEATURE_LEVELS = 2,
+	D3D12_FEATURE_FORMAT_SUPPORT = 3,
+	D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS = 4,
+	D3D12_FEATURE_FORMAT_INFO = 5,
+	D3D12_FEATURE_GPU_VIRTUAL_ADDRESS_SUPPORT = 6,
+	D3D12_FEATURE_SHADER_MODEL = 7,
+	D3D12_FEATURE_D3D12_OPTIONS1 = 8,
+	D3D12_FEATURE_ROOT_SIGNATURE = 12,
+};
+
+enum D3D12_RESOURCE_HEAP_TIER
+{
+	D3D12_RESOURCE_HEAP_TIER_1 = 1,
+	D3D12_RESOURCE_HEAP_TIER_2 = 2,
+};
+
+enum D3D12_RESOURCE_BINDING_TIER
+{
+	D3D12_RESOURCE_BINDING_TIER_1 = 1,
+	D3D12_RESOURCE_BINDING_TIER_2 = 2,
+	D3D12_RESOURCE_BINDING_TIER_3 = 3,
+};
+
+enum D3D12_TILED_RESOURCES_TIER
+{
+	D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED = 0,
+	D3D12_TILED_RESOURCES_TIER_1 = 1,
+	D3D12_TILED_RESOURCES_TIER_2 = 2,
+	D3D12_TILED_RESOURCES_TIER_3 = 3,
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_TIER
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_TIER_NOT_SUPPORTED = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_TIER_1 = 1,
+	D3D12_CONSERVATIVE_RASTERIZATION_TIER_2 = 2,
+	D3D12_CONSERVATIVE_RASTERIZATION_TIER_3 = 3,
+};
+
+enum D3D12_CROSS_NODE_SHARING_TIER
+{
+	D3D12_CROSS_NODE_SHARING_TIER_NOT_SUPPORTED = 0,
+};
+
+enum D3D12_SHADER_MIN_PRECISION_SUPPORT
+{
+	D3D12_SHADER_MIN_PRECISION_SUPPORT_NONE = 0,
+};
+
+enum D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE
+{
+	D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_DISCARD = 0,
+	D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_PRESERVE = 1,
+	D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_CLEAR = 2,
+	D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE_NO_ACCESS = 3,
+};
+
+enum D3D12_RENDER_PASS_ENDING_ACCESS_TYPE
+{
+	D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_DISCARD = 0,
+	D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_PRESERVE = 1,
+	D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_RESOLVE = 2,
+	D3D12_RENDER_PASS_ENDING_ACCESS_TYPE_NO_ACCESS = 3,
+};
+
+enum D3D12_RESOLVE_MODE
+{
+	D3D12_RESOLVE_MODE_DECOMPRESS = 0,
+	D3D12_RESOLVE_MODE_MIN = 1,
+	D3D12_RESOLVE_MODE_MAX = 2,
+	D3D12_RESOLVE_MODE_AVERAGE = 3,
+};
+
+// Structures
+struct D3D12_COMMAND_QUEUE_DESC
+{
+	D3D12_COMMAND_LIST_TYPE Type;
+	INT Priority;
+	D3D12_COMMAND_QUEUE_FLAGS Flags;
+	UINT NodeMask;
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+struct D3D12_HEAP_DESC
+{
+	UINT64 SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	UINT64 Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	UINT64 Alignment;
+	UINT64 Width;
+	UINT Height;
+	UINT16 DepthOrArraySize;
+	UINT16 MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+	UINT64 SizeInBytes;
+	UINT64 Alignment;
+};
+
+struct D3D12_DEPTH_STENCIL_VALUE
+{
+	FLOAT Depth;
+	UINT8 Stencil;
+};
+
+struct D3D12_CLEAR_VALUE
+{
+	DXGI_FORMAT Format;
+	union
+	{
+		FLOAT Color[4];
+		D3D12_DEPTH_STENCIL_VALUE DepthStencil;
+	};
+};
+
+struct D3D12_RANGE
+{
+	SIZE_T Begin;
+	SIZE_T End;
+};
+
+struct D3D12_RANGE_UINT64
+{
+	UINT64 Begin;
+	UINT64 End;
+};
+
+struct D3D12_SUBRESOURCE_RANGE_UINT64
+{
+	UINT Subresource;
+	D3D12_RANGE_UINT64 Range;
+};
+
+struct D3D12_BOX
+{
+	UINT left;
+	UINT top;
+	UINT front;
+	UINT right;
+	UINT bottom;
+	UINT back;
+};
+
+struct D3D12_VIEWPORT
+{
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+struct D3D12_SUBRESOURCE_DATA
+{
+	const void* pData;
+	LONG_PTR RowPitch;
+	LONG_PTR SlicePitch;
+};
+
+struct D3D12_MEMCPY_DEST
+{
+	void* pData;
+	SIZE_T RowPitch;
+	SIZE_T SlicePitch;
+};
+
+struct D3D12_SUBRESOURCE_FOOTPRINT
+{
+	DXGI_FORMAT Format;
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT
+{
+	UINT64 Offset;
+	D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+struct D3D12_TILED_RESOURCE_COORDINATE
+{
+	UINT X;
+	UINT Y;
+	UINT Z;
+	UINT Subresource;
+};
+
+struct D3D12_TILE_REGION_SIZE
+{
+	UINT NumTiles;
+	BOOL UseBox;
+	UINT Width;
+	UINT16 Height;
+	UINT16 Depth;
+};
+
+struct D3D12_SUBRESOURCE_TILING
+{
+	UINT WidthInTiles;
+	UINT16 HeightInTiles;
+	UINT16 DepthInTiles;
+	UINT StartTileIndexInOverallResource;
+};
+
+struct D3D12_TILE_SHAPE
+{
+	UINT WidthInTexels;
+	UINT HeightInTexels;
+	UINT DepthInTexels;
+};
+
+struct D3D12_PACKED_MIP_INFO
+{
+	UINT8 NumStandardMips;
+	UINT8 NumPackedMips;
+	UINT NumTilesForPackedMips;
+	UINT StartTileIndexInOverallResource;
+};
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+	SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+struct D3D12_DESCRIPTOR_HEAP_DESC
+{
+	D3D12_DESCRIPTOR_HEAP_TYPE Type;
+	UINT NumDescriptors;
+	D3D12_DESCRIPTOR_HEAP_FLAGS Flags;
+	UINT NodeMask;
+};
+
+struct D3D12_QUERY_HEAP_DESC
+{
+	D3D12_QUERY_HEAP_TYPE Type;
+	UINT Count;
+	UINT NodeMask;
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+struct D3D12_CONSTANT_BUFFER_VIEW_DESC
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+};
+
+struct D3D12_BUFFER_SRV
+{
+	UINT64 FirstElement;
+	UINT NumElements;
+	UINT StructureByteStride;
+	D3D12_BUFFER_SRV_FLAGS Flags;
+};
+
+struct D3D12_TEX1D_SRV { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEX1D_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEX2D_SRV { UINT MostDetailedMip; UINT MipLevels; UINT PlaneSlice; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEX2D_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; UINT PlaneSlice; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEX3D_SRV { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEXCUBE_SRV { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; };
+struct D3D12_TEXCUBE_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT First2DArrayFace; UINT NumCubes; FLOAT ResourceMinLODClamp; };
+
+struct D3D12_SHADER_RESOURCE_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_SRV_DIMENSION ViewDimension;
+	UINT Shader4ComponentMapping;
+	union
+	{
+		D3D12_BUFFER_SRV Buffer;
+		D3D12_TEX1D_SRV Texture1D;
+		D3D12_TEX1D_ARRAY_SRV Texture1DArray;
+		D3D12_TEX2D_SRV Texture2D;
+		D3D12_TEX2D_ARRAY_SRV Texture2DArray;
+		D3D12_TEX3D_SRV Texture3D;
+		D3D12_TEXCUBE_SRV TextureCube;
+		D3D12_TEXCUBE_ARRAY_SRV TextureCubeArray;
+	};
+};
+
+struct D3D12_TEX2D_RTV { UINT MipSlice; UINT PlaneSlice; };
+
+struct D3D12_RENDER_TARGET_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_RTV_DIMENSION ViewDimension;
+	union
+	{
+		D3D12_TEX2D_RTV Texture2D;
+	};
+};
+
+struct D3D12_TEX2D_DSV { UINT MipSlice; };
+
+struct D3D12_DEPTH_STENCIL_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_DSV_DIMENSION ViewDimension;
+	D3D12_DSV_FLAGS Flags;
+	union
+	{
+		D3D12_TEX2D_DSV Texture2D;
+	};
+};
+
+struct D3D12_SAMPLER_DESC
+{
+	D3D12_FILTER Filter;
+	D3D12_TEXTURE_ADDRESS_MODE AddressU;
+	D3D12_TEXTURE_ADDRESS_MODE AddressV;
+	D3D12_TEXTURE_ADDRESS_MODE AddressW;
+	FLOAT MipLODBias;
+	UINT MaxAnisotropy;
+	D3D12_COMPARISON_FUNC ComparisonFunc;
+	FLOAT BorderColor[4];
+	FLOAT MinLOD;
+	FLOAT MaxLOD;
+};
+
+struct D3D12_FEATURE_DATA_D3D12_OPTIONS
+{
+	BOOL DoublePrecisionFloatShaderOps;
+	BOOL OutputMergerLogicOp;
+	D3D12_SHADER_MIN_PRECISION_SUPPORT MinPrecisionSupport;
+	D3D12_TILED_RESOURCES_TIER TiledResourcesTier;
+	D3D12_RESOURCE_BINDING_TIER ResourceBindingTier;
+	BOOL PSSpecifiedStencilRefSupported;
+	BOOL TypedUAVLoadAdditionalFormats;
+	BOOL ROVsSupported;
+	D3D12_CONSERVATIVE_RASTERIZATION_TIER ConservativeRasterizationTier;
+	UINT MaxGPUVirtualAddressBitsPerResource;
+	BOOL StandardSwizzle64KBSupported;
+	D3D12_CROSS_NODE_SHARING_TIER CrossNodeSharingTier;
+	BOOL CrossAdapterRowMajorTextureSupported;
+	BOOL VPAndRTArrayIndexFromAnyShaderFeedingRasterizerSupportedWithoutGSEmulation;
+	D3D12_RESOURCE_HEAP_TIER ResourceHeapTier;
+};
+
+struct D3D12_FEATURE_DATA_FORMAT_INFO
+{
+	DXGI_FORMAT Format;
+	UINT8 PlaneCount;
+};
+
+// Barriers
+struct ID3D12Resource;
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+	ID3D12Resource* pResource;
+	UINT Subresource;
+	D3D12_RESOURCE_STATES StateBefore;
+	D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+	ID3D12Resource* pResourceBefore;
+	ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+	ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+	D3D12_RESOURCE_BARRIER_TYPE Type;
+	D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	union
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+		D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+		D3D12_RESOURCE_UAV_BARRIER UAV;
+	};
+};
+
+struct D3D12_TEXTURE_COPY_LOCATION
+{
+	ID3D12Resource* pResource;
+	D3D12_TEXTURE_COPY_TYPE Type;
+	union
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint;
+		UINT SubresourceIndex;
+	};
+};
+
+// Root signatures
+struct D3D12_DESCRIPTOR_RANGE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_DESCRIPTOR_RANGE1
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	D3D12_DESCRIPTOR_RANGE_FLAGS Flags;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE1
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE1* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	UINT Num32BitValues;
+};
+
+struct D3D12_ROOT_DESCRIPTOR
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+};
+
+struct D3D12_ROOT_DESCRIPTOR1
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_ROOT_DESCRIPTOR_FLAGS Flags;
+};
+
+struct D3D12_ROOT_PARAMETER
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_ROOT_PARAMETER1
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE1 DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR1 Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+	D3D12_FILTER Filter;
+	D3D12_TEXTURE_ADDRESS_MODE AddressU;
+	D3D12_TEXTURE_ADDRESS_MODE AddressV;
+	D3D12_TEXTURE_ADDRESS_MODE AddressW;
+	FLOAT MipLODBias;
+	UINT MaxAnisotropy;
+	D3D12_COMPARISON_FUNC ComparisonFunc;
+	D3D12_STATIC_BORDER_COLOR BorderColor;
+	FLOAT MinLOD;
+	FLOAT MaxLOD;
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC1
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER1* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+struct D3D12_VERSIONED_ROOT_SIGNATURE_DESC
+{
+	D3D_ROOT_SIGNATURE_VERSION Version;
+	union
+	{
+		D3D12_ROOT_SIGNATURE_DESC Desc_1_0;
+		D3D12_ROOT_SIGNATURE_DESC1 Desc_1_1;
+	};
+};
+
+// Pipeline state
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	SIZE_T BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY
+{
+	UINT Stream;
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	BYTE StartComponent;
+	BYTE ComponentCount;
+	BYTE OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY* pSODeclaration;
+	UINT NumEntries;
+	const UINT* pBufferStrides;
+	UINT NumStrides;
+	UINT RasterizedStream;
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	UINT ForcedSampleCount;
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC1
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+	BOOL DepthBoundsTestEnable;
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+	UINT NumElements;
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void* pCachedBlob;
+	SIZE_T CachedBlobSizeInBytes;
+};
+
+struct D3D12_RT_FORMAT_ARRAY
+{
+	DXGI_FORMAT RTFormats[8];
+	UINT NumRenderTargets;
+};
+
+struct D3D12_VIEW_INSTANCE_LOCATION
+{
+	UINT ViewportArrayIndex;
+	UINT RenderTargetArrayIndex;
+};
+
+struct D3D12_VIEW_INSTANCING_DESC
+{
+	UINT ViewInstanceCount;
+	const D3D12_VIEW_INSTANCE_LOCATION* pViewInstanceLocations;
+	D3D12_VIEW_INSTANCING_FLAGS Flags;
+};
+
+struct ID3D12RootSignature;
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE VS;
+	D3D12_SHADER_BYTECODE PS;
+	D3D12_SHADER_BYTECODE DS;
+	D3D12_SHADER_BYTECODE HS;
+	D3D12_SHADER_BYTECODE GS;
+	D3D12_STREAM_OUTPUT_DESC StreamOutput;
+	D3D12_BLEND_DESC BlendState;
+	UINT SampleMask;
+	D3D12_RASTERIZER_DESC RasterizerState;
+	D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+	D3D12_INPUT_LAYOUT_DESC InputLayout;
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+	UINT NumRenderTargets;
+	DXGI_FORMAT RTVFormats[8];
+	DXGI_FORMAT DSVFormat;
+	DXGI_SAMPLE_DESC SampleDesc;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE CS;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_PIPELINE_STATE_STREAM_DESC
+{
+	SIZE_T SizeInBytes;
+	void* pPipelineStateSubobjectStream;
+};
+
+// Render passes, only for d3dx12's comparison operators
+struct D3D12_RENDER_PASS_BEGINNING_ACCESS_CLEAR_PARAMETERS
+{
+	D3D12_CLEAR_VALUE ClearValue;
+};
+
+struct D3D12_RENDER_PASS_BEGINNING_ACCESS
+{
+	D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE Type;
+	union
+	{
+		D3D12_RENDER_PASS_BEGINNING_ACCESS_CLEAR_PARAMETERS Clear;
+	};
+};
+
+struct D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_SUBRESOURCE_PARAMETERS
+{
+	UINT SrcSubresource;
+	UINT DstSubresource;
+	UINT DstX;
+	UINT DstY;
+	D3D12_RECT SrcRect;
+};
+
+struct D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_PARAMETERS
+{
+	ID3D12Resource* pSrcResource;
+	ID3D12Resource* pDstResource;
+	UINT SubresourceCount;
+	const D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_SUBRESOURCE_PARAMETERS* pSubresourceParameters;
+	DXGI_FORMAT Format;
+	D3D12_RESOLVE_MODE ResolveMode;
+	BOOL PreserveResolveSource;
+};
+
+struct D3D12_RENDER_PASS_ENDING_ACCESS
+{
+	D3D12_RENDER_PASS_ENDING_ACCESS_TYPE Type;
+	union
+	{
+		D3D12_RENDER_PASS_ENDING_ACCESS_RESOLVE_PARAMETERS Resolve;
+	};
+};
+
+struct D3D12_RENDER_PASS_RENDER_TARGET_DESC
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor;
+	D3D12_RENDER_PASS_BEGINNING_ACCESS BeginningAccess;
+	D3D12_RENDER_PASS_ENDING_ACCESS EndingAccess;
+};
+
+struct D3D12_RENDER_PASS_DEPTH_STENCIL_DESC
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor;
+	D3D12_RENDER_PASS_BEGINNING_ACCESS DepthBeginningAccess;
+	D3D12_RENDER_PASS_BEGINNING_ACCESS StencilBeginningAccess;
+	D3D12_RENDER_PASS_ENDING_ACCESS DepthEndingAccess;
+	D3D12_RENDER_PASS_ENDING_ACCESS StencilEndingAccess;
+};
+
+// Interfaces
+struct ID3D12Device;
+
+struct ID3D12Object : public IUnknown
+{
+	virtual HRESULT GetPrivateData(REFGUID guid, UINT* dataSize, void* data) = 0;
+	virtual HRESULT SetPrivateData(REFGUID guid, UINT dataSize, const void* data) = 0;
+	virtual HRESULT SetPrivateDataInterface(REFGUID guid, const IUnknown* data) = 0;
+	virtual HRESULT SetName(LPCWSTR name) = 0;
+};
+
+struct ID3D12DeviceChild : public ID3D12Object
+{
+	virtual HRESULT GetDevice(REFIID riid, void** device) = 0;
+};
+
+struct ID3D12Pageable : public ID3D12DeviceChild { };
+
+struct ID3D12RootSignature : public ID3D12DeviceChild { };
+
+struct ID3D12Heap : public ID3D12Pageable
+{
+	virtual D3D12_HEAP_DESC GetDesc() = 0;
+};
+
+struct ID3D12Resource : public ID3D12Pageable
+{
+	virtual HRESULT Map(UINT subresource, const D3D12_RANGE* readRange, void** data) = 0;
+	virtual void Unmap(UINT subresource, const D3D12_RANGE* writtenRange) = 0;
+	virtual D3D12_RESOURCE_DESC GetDesc() = 0;
+	virtual D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() = 0;
+};
+
+struct ID3D12CommandAllocator : public ID3D12Pageable
+{
+	virtual HRESULT Reset() = 0;
+};
+
+struct ID3D12Fence : public ID3D12Pageable
+{
+	virtual UINT64 GetCompletedValue() = 0;
+	virtual HRESULT SetEventOnCompletion(UINT64 value, HANDLE event) = 0;
+	virtual HRESULT Signal(UINT64 value) = 0;
+};
+
+struct ID3D12PipelineState : public ID3D12Pageable
+{
+	virtual HRESULT GetCachedBlob(ID3DBlob** blob) = 0;
+};
+
+struct ID3D12DescriptorHeap : public ID3D12Pageable
+{
+	virtual D3D12_DESCRIPTOR_HEAP_DESC GetDesc() = 0;
+	virtual D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() = 0;
+	virtual D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() = 0;
+};
+
+struct ID3D12QueryHeap : public ID3D12Pageable { };
+
+struct ID3D12CommandList : public ID3D12DeviceChild
+{
+	virtual D3D12_COMMAND_LIST_TYPE GetType() = 0;
+};
+
+struct ID3D12GraphicsCommandList : public ID3D12CommandList
+{
+	virtual HRESULT Close() = 0;
+	virtual HRESULT Reset(ID3D12CommandAllocator* allocator, ID3D12PipelineState* initialState) = 0;
+	virtual void DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation) = 0;
+	virtual void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation, INT baseVertexLocation,
+		UINT startInstanceLocation) = 0;
+	virtual void CopyBufferRegion(ID3D12Resource* dstBuffer, UINT64 dstOffset, ID3D12Resource* srcBuffer, UINT64 srcOffset, UINT64 numBytes) = 0;
+	virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst, UINT dstX, UINT dstY, UINT dstZ,
+		const D3D12_TEXTURE_COPY_LOCATION* src, const D3D12_BOX* srcBox) = 0;
+	virtual void CopyResource(ID3D12Resource* dstResource, ID3D12Resource* srcResource) = 0;
+	virtual void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology) = 0;
+	virtual void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports) = 0;
+	virtual void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects) = 0;
+	virtual void SetPipelineState(ID3D12PipelineState* pipelineState) = 0;
+	virtual void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers) = 0;
+	virtual void SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* descriptorHeaps) = 0;
+	virtual void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature) = 0;
+	virtual void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor) = 0;
+	virtual void SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT srcData, UINT destOffsetIn32BitValues) = 0;
+	virtual void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValuesToSet, const void* srcData,
+		UINT destOffsetIn32BitValues) = 0;
+	virtual void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) = 0;
+	virtual void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) = 0;
+	virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) = 0;
+	virtual void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) = 0;
+	virtual void OMSetRenderTargets(UINT numRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetDescriptors,
+		BOOL rtsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilDescriptor) = 0;
+	virtual void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags, FLOAT depth,
+		UINT8 stencil, UINT numRects, const D3D12_RECT* rects) = 0;
+	virtual void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4], UINT numRects,
+		const D3D12_RECT* rects) = 0;
+	virtual void EndQuery(ID3D12QueryHeap* queryHeap, D3D12_QUERY_TYPE type, UINT index) = 0;
+	virtual void ResolveQueryData(ID3D12QueryHeap* queryHeap, D3D12_QUERY_TYPE type, UINT startIndex, UINT numQueries,
+		ID3D12Resource* destinationBuffer, UINT64 alignedDestinationBufferOffset) = 0;
+};
+
+struct ID3D12CommandQueue : public ID3D12Pageable
+{
+	virtual void ExecuteCommandLists(UINT numCommandLists, ID3D12CommandList* const* commandLists) = 0;
+	virtual HRESULT Signal(ID3D12Fence* fence, UINT64 value) = 0;
+	virtual HRESULT Wait(ID3D12Fence* fence, UINT64 value) = 0;
+	virtual HRESULT GetTimestampFrequency(UINT64* frequency) = 0;
+	virtual D3D12_COMMAND_QUEUE_DESC GetDesc() = 0;
+};
+
+struct ID3D12PipelineLibrary : public ID3D12DeviceChild
+{
+	virtual HRESULT StorePipeline(LPCWSTR name, ID3D12PipelineState* pipeline) = 0;
+	virtual HRESULT LoadGraphicsPipeline(LPCWSTR name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState) = 0;
+	virtual HRESULT LoadComputePipeline(LPCWSTR name, const D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState) = 0;
+	virtual SIZE_T GetSerializedSize() = 0;
+	virtual HRESULT Serialize(void* data, SIZE_T dataSizeInBytes) = 0;
+};
+
+struct ID3D12PipelineLibrary1 : public ID3D12PipelineLibrary
+{
+	virtual HRESULT LoadPipeline(LPCWSTR name, const D3D12_PIPELINE_STATE_STREAM_DESC* desc, REFIID riid, void** pipelineState) = 0;
+};
+
+struct ID3D12Device : public ID3D12Object
+{
+	virtual UINT GetNodeCount() = 0;
+	virtual HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** commandQueue) = 0;
+	virtual HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** commandAllocator) = 0;
+	virtual HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState) = 0;
+	virtual HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState) = 0;
+	virtual HRESULT CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* commandAllocator,
+		ID3D12PipelineState* initialState, REFIID riid, void** commandList) = 0;
+	virtual HRESULT CheckFeatureSupport(D3D12_FEATURE feature, void* featureSupportData, UINT featureSupportDataSize) = 0;
+	virtual HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* descriptorHeapDesc, REFIID riid, void** heap) = 0;
+	virtual UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) = 0;
+	virtual HRESULT CreateRootSignature(UINT nodeMask, const void* blobWithRootSignature, SIZE_T blobLengthInBytes, REFIID riid,
+		void** rootSignature) = 0;
+	virtual void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) = 0;
+	virtual void CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc,
+		D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) = 0;
+	virtual void CreateRenderTargetView(ID3D12Resource* resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc,
+		D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) = 0;
+	virtual void CreateDepthStencilView(ID3D12Resource* resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc,
+		D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) = 0;
+	virtual void CreateSampler(const D3D12_SAMPLER_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor) = 0;
+	virtual void CopyDescriptors(UINT numDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* destDescriptorRangeStarts,
+		const UINT* destDescriptorRangeSizes, UINT numSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* srcDescriptorRangeStarts,
+		const UINT* srcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapsType) = 0;
+	virtual void CopyDescriptorsSimple(UINT numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptorRangeStart,
+		D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapsType) = 0;
+	virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs,
+		const D3D12_RESOURCE_DESC* resourceDescs) = 0;
+	virtual HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags,
+		const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialResourceState, const D3D12_CLEAR_VALUE* optimizedClearValue,
+		REFIID riidResource, void** resource) = 0;
+	virtual HRESULT CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** heap) = 0;
+	virtual HRESULT CreatePlacedResource(ID3D12Heap* heap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* desc,
+		D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue, REFIID riid, void** resource) = 0;
+	virtual HRESULT CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** fence) = 0;
+	virtual HRESULT GetDeviceRemovedReason() = 0;
+	virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC* resourceDesc, UINT firstSubresource, UINT numSubresources,
+		UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows, UINT64* rowSizeInBytes,
+		UINT64* totalBytes) = 0;
+	virtual HRESULT CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* desc, REFIID riid, void** heap) = 0;
+	virtual LUID GetAdapterLuid() = 0;
+};
+
+struct ID3D12Device1 : public ID3D12Device
+{
+	virtual HRESULT CreatePipelineLibrary(const void* libraryBlob, SIZE_T blobLength, REFIID riid, void** pipelineLibrary) = 0;
+};
+
+struct ID3D12Device2 : public ID3D12Device1
+{
+	virtual HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* desc, REFIID riid, void** pipelineState) = 0;
+};
+
+// Only declared, d3dx12.h refers to them from helpers nothing here calls
+HRESULT WINAPI D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* rootSignature, D3D_ROOT_SIGNATURE_VERSION version,
+	ID3DBlob** blob, ID3DBlob** errorBlob);
+HRESULT WINAPI D3D12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* rootSignature, ID3DBlob** blob,
+	ID3DBlob** errorBlob);
@@ -0,0 +1,39 @@
+/**************************************************************
+	d3dcommon.h (Linux stand-in)
+
+	ID3DBlob, primitive topologies, feature levels and shader
+	macros, with the real values.
+**************************************************************/
+#pragma once
+#include "winadapter.h"
+
+enum D3D_FEATURE_LEVEL
+{
+	D3D_FEATURE_LEVEL_11_0 = 0xb000,
+	D3D_FEATURE_LEVEL_11_1 = 0xb100,
+	D3D_FEATURE_LEVEL_12_0 = 0xc000,
+	D3D_FEATURE_LEVEL_12_1 = 0xc100,
+};
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+};
+
+struct D3D_SHADER_MACRO
+{
+	LPCSTR Name;
+	LPCSTR Definition;
+};
+
+struct ID3D10Blob : public IUnknown
+{
+	virtual LPVOID GetBufferPointer() = 0;
+	virtual SIZE_T GetBufferSize() = 0;
+};
+typedef ID3D10Blob ID3DBlob;
@@ -0,0 +1,29 @@
+/**************************************************************
+	dxgi1_4.h (Linux stand-in)
+
+	Only IDXGIAdapter3::QueryVideoMemoryInfo, for the budget check
+	in ResourceHeapAllocator. There is no swap chain on Linux.
+**************************************************************/
+#pragma once
+#include "winadapter.h"
+#include "dxgiformat.h"
+
+enum DXGI_MEMORY_SEGMENT_GROUP
+{
+	DXGI_MEMORY_SEGMENT_GROUP_LOCAL = 0,
+	DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL = 1,
+};
+
+struct DXGI_QUERY_VIDEO_MEMORY_INFO
+{
+	UINT64 Budget;
+	UINT64 CurrentUsage;
+	UINT64 AvailableForReservation;
+	UINT64 CurrentReservation;
+};
+
+struct IDXGIAdapter3 : public IUnknown
+{
+	virtual HRESULT QueryVideoMemoryInfo(UINT nodeIndex, DXGI_MEMORY_SEGMENT_GROUP memorySegmentGroup,
+		DXGI_QUERY_VIDEO_MEMORY_INFO* videoMemoryInfo) = 0;
+};
@@ -0,0 +1,265 @@
+/**************************************************************
+	winadapter.h (Linux stand-in)
+
+	The Win32 and COM basics the D3D12 headers lean on, the same
+	job as the header of this name in the DirectX-Headers package:
+	integer typedefs, HRESULT and its macros, GUIDs, IUnknown, SAL
+	annotations as nothing. Events are real ones, built on a mutex
+	and a condition variable, so code that waits on a fence with
+	SetEventOnCompletion/WaitForSingleObject runs unchanged.
+**************************************************************/
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+// Integers and friends
+typedef int32_t INT;
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef int64_t INT64;
+typedef uint32_t UINT;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef uint32_t DWORD;
+typedef uint16_t WORD;
+typedef uint8_t BYTE;
+typedef int BOOL;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef void* HANDLE;
+typedef void* HWND;
+typedef void* HMODULE;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define INFINITE 0xffffffff
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+
+#define DECLSPEC_SELECTANY
+#define DECLSPEC_NOVTABLE
+#define STDMETHODCALLTYPE
+#define WINAPI
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+
+// Bitwise operators for the flag enums, like winnt.h
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE) \
+	inline constexpr ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((std::underlying_type<ENUMTYPE>::type)a) | ((std::underlying_type<ENUMTYPE>::type)b)); } \
+	inline ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b) { return a = a | b; } \
+	inline constexpr ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((std::underlying_type<ENUMTYPE>::type)a) & ((std::underlying_type<ENUMTYPE>::type)b)); } \
+	inline ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b) { return a = a & b; } \
+	inline constexpr ENUMTYPE operator~(ENUMTYPE a) { return ENUMTYPE(~((std::underlying_type<ENUMTYPE>::type)a)); } \
+	inline constexpr ENUMTYPE operator^(ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((std::underlying_type<ENUMTYPE>::type)a) ^ ((std::underlying_type<ENUMTYPE>::type)b)); } \
+	inline ENUMTYPE& operator^=(ENUMTYPE& a, ENUMTYPE b) { return a = a ^ b; }
+
+#ifndef _countof
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+#endif
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+union LARGE_INTEGER
+{
+	struct
+	{
+		DWORD LowPart;
+		LONG HighPart;
+	};
+	LONGLONG QuadPart;
+};
+
+struct LUID
+{
+	DWORD LowPart;
+	LONG HighPart;
+};
+
+// HRESULT
+typedef int32_t HRESULT;
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_HANDLE_EOF 38L
+#define ERROR_NOT_SUPPORTED 50L
+#define ERROR_FILE_INVALID 1006L
+#define ERROR_INVALID_DATA 13L
+
+inline HRESULT HRESULT_FROM_WIN32(unsigned long x)
+{
+	return (HRESULT)(x) <= 0 ? (HRESULT)(x) : (HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000);
+}
+
+// errno stands in for the thread's last error
+inline DWORD GetLastError() { return (DWORD)errno; }
+inline void SetLastError(DWORD error) { errno = (int)error; }
+
+// GUIDs. __uuidof gives every interface an IID of its own, the values don't
+// match Windows, nothing here talks to a real runtime.
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& a, const GUID& b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& a, const GUID& b) { return !(a == b); }
+
+template <typename T>
+inline const GUID& UuidOf()
+{
+	static const GUID guid = { (uint32_t)(uintptr_t)&guid, 0, 0, { 0 } };
+	return guid;
+}
+#define __uuidof(x) UuidOf<typename std::remove_cv<typename std::remove_pointer<typename std::remove_reference<decltype(x)>::type>::type>::type>()
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** object) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+	virtual ~IUnknown() { }
+};
+
+template <typename T>
+void** IID_PPV_ARGS_Helper(T** pp)
+{
+	static_assert(std::is_base_of<IUnknown, T>::value, "IID_PPV_ARGS needs a COM interface");
+	return reinterpret_cast<void**>(pp);
+}
+#define IID_PPV_ARGS(ppType) __uuidof(**(ppType)), IID_PPV_ARGS_Helper(ppType)
+
+// The process heap is malloc
+inline HANDLE GetProcessHeap() { return reinterpret_cast<HANDLE>(1); }
+inline void* HeapAlloc(HANDLE, DWORD, SIZE_T bytes) { return malloc(bytes); }
+inline BOOL HeapFree(HANDLE, DWORD, void* memory) { free(memory); return TRUE; }
+
+// Events
+struct WinAdapterEvent
+{
+	std::mutex Mutex;
+	std::condition_variable Signaled;
+	bool ManualReset;
+	bool State;
+};
+
+inline HANDLE CreateEvent(void*, BOOL manualReset, BOOL initialState, LPCSTR)
+{
+	WinAdapterEvent* event = new WinAdapterEvent();
+	event->ManualReset = manualReset != FALSE;
+	event->State = initialState != FALSE;
+	return event;
+}
+
+inline BOOL SetEvent(HANDLE handle)
+{
+	WinAdapterEvent* event = static_cast<WinAdapterEvent*>(handle);
+	{
+		std::lock_guard<std::mutex> lock(event->Mutex);
+		event->State = true;
+	}
+	event->Signaled.notify_all();
+	return TRUE;
+}
+
+inline BOOL ResetEvent(HANDLE handle)
+{
+	WinAdapterEvent* event = static_cast<WinAdapterEvent*>(handle);
+	std::lock_guard<std::mutex> lock(event->Mutex);
+	event->State = false;
+	return TRUE;
+}
+
+inline DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+	WinAdapterEvent* event = static_cast<WinAdapterEvent*>(handle);
+	std::unique_lock<std::mutex> lock(event->Mutex);
+	if (milliseconds == INFINITE)
+		event->Signaled.wait(lock, [event] { return event->State; });
+	else if (!event->Signaled.wait_for(lock, std::chrono::milliseconds(milliseconds), [event] { return event->State; }))
+		return WAIT_TIMEOUT;
+
+	if (!event->ManualReset)
+		event->State = false;
+	return WAIT_OBJECT_0;
+}
+
+inline BOOL CloseHandle(HANDLE handle)
+{
+	delete static_cast<WinAdapterEvent*>(handle);
+	return TRUE;
+}
+
+// SAL
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_range_(low, high)
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _In_reads_bytes_opt_(size)
+#define _Inout_
+#define _Inout_opt_
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_opt_(size)
+#define _Out_writes_bytes_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Outptr_opt_result_maybenull_
+#define _COM_Outptr_
+#define _COM_Outptr_opt_
+#define _Always_(annotation)
+#define _Use_decl_annotations_
+#define _Check_return_
+#define __analysis_assume(expr)
@@ -0,0 +1,5 @@
+/**************************************************************
+	wrl.h (Linux stand-in)
+**************************************************************/
+#pragma once
+#include "wrl/client.h"
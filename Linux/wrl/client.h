@@ -0,0 +1,82 @@
+/**************************************************************
+	wrl/client.h (Linux stand-in)
+
+	Microsoft::WRL::ComPtr, the parts of it this repo uses.
+**************************************************************/
+#pragma once
+#include "../winadapter.h"
+
+namespace Microsoft
+{
+namespace WRL
+{
+	template <typename T>
+	class ComPtr
+	{
+	public:
+		typedef T InterfaceType;
+
+		ComPtr() : m_ptr(nullptr) { }
+		ComPtr(std::nullptr_t) : m_ptr(nullptr) { }
+		ComPtr(T* other) : m_ptr(other) { InternalAddRef(); }
+		ComPtr(const ComPtr& other) : m_ptr(other.m_ptr) { InternalAddRef(); }
+		ComPtr(ComPtr&& other) : m_ptr(other.m_ptr) { other.m_ptr = nullptr; }
+		template <typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+		ComPtr(const ComPtr<U>& other) : m_ptr(other.Get()) { InternalAddRef(); }
+		~ComPtr() { InternalRelease(); }
+
+		ComPtr& operator=(std::nullptr_t) { InternalRelease(); return *this; }
+		ComPtr& operator=(T* other) { ComPtr(other).Swap(*this); return *this; }
+		ComPtr& operator=(const ComPtr& other) { ComPtr(other).Swap(*this); return *this; }
+		ComPtr& operator=(ComPtr&& other) { ComPtr(static_cast<ComPtr&&>(other)).Swap(*this); return *this; }
+
+		void Swap(ComPtr& other) { T* ptr = m_ptr; m_ptr = other.m_ptr; other.m_ptr = ptr; }
+
+		explicit operator bool() const { return m_ptr != nullptr; }
+		T* operator->() const { return m_ptr; }
+		T* Get() const { return m_ptr; }
+
+		T* const* GetAddressOf() const { return &m_ptr; }
+		T** GetAddressOf() { return &m_ptr; }
+		T** ReleaseAndGetAddressOf() { InternalRelease(); return &m_ptr; }
+		T** operator&() { return ReleaseAndGetAddressOf(); }
+
+		T* Detach() { T* ptr = m_ptr; m_ptr = nullptr; return ptr; }
+		void Attach(T* other) { InternalRelease(); m_ptr = other; }
+		unsigned long Reset() { return InternalRelease(); }
+
+		template <typename U>
+		HRESULT As(ComPtr<U>* other) const
+		{
+			return m_ptr->QueryInterface(UuidOf<U>(), reinterpret_cast<void**>(other->ReleaseAndGetAddressOf()));
+		}
+
+		HRESULT CopyTo(T** other) const { InternalAddRef(); *other = m_ptr; return S_OK; }
+
+	private:
+		void InternalAddRef() const { if (m_ptr) m_ptr->AddRef(); }
+		unsigned long InternalRelease()
+		{
+			unsigned long count = 0;
+			T* ptr = m_ptr;
+			if (ptr)
+			{
+				m_ptr = nullptr;
+				count = ptr->Release();
+			}
+			return count;
+		}
+
+		T* m_ptr;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() == b.Get(); }
+	template <typename T, typename U>
+	bool operator!=(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() != b.Get(); }
+	template <typename T>
+	bool operator==(const ComPtr<T>& a, std::nullptr_t) { return a.Get() == nullptr; }
+	template <typename T>
+	bool operator!=(const ComPtr<T>& a, std::nullptr_t) { return a.Get() != nullptr; }
+}
+}
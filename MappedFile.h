@@ -0,0 +1,141 @@
+//--------------------------------------------------------------------------------------
+// File: MappedFile.h
+//
+// Read-only memory mapping of a whole file. The DDS loader uses it to point
+// D3D12_SUBRESOURCE_DATA straight at the file contents instead of reading the
+// file into a heap buffer first.
+//
+// Win32 uses CreateFileMapping/MapViewOfFile, everything else uses mmap.
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+#if defined(_WIN32)
+    typedef wchar_t PathChar;
+#else
+    typedef char PathChar;
+#endif
+
+    MappedFile() : m_data(nullptr), m_size(0) {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // On failure returns false, GetLastError()/errno say why
+    bool Open(const PathChar* fileName)
+    {
+        Close();
+
+#if defined(_WIN32)
+        HANDLE hFile = CreateFileW(fileName,
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                   nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize = { 0 };
+        if (!GetFileSizeEx(hFile, &fileSize))
+        {
+            CloseHandle(hFile);
+            return false;
+        }
+
+        // Empty files can't be mapped, and a 32-bit process can't map more than 4 GB
+        if (fileSize.QuadPart == 0 || static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX)
+        {
+            CloseHandle(hFile);
+            SetLastError(ERROR_FILE_INVALID);
+            return false;
+        }
+
+        // The view keeps its own reference to the mapping, and the mapping to the
+        // file, so both handles can be closed as soon as the view exists.
+        HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (!hMapping)
+            return false;
+
+        void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hMapping);
+        if (!view)
+            return false;
+
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(fileName, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        if (st.st_size <= 0 || static_cast<unsigned long long>(st.st_size) > SIZE_MAX)
+        {
+            close(fd);
+            errno = EINVAL;
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+            return false;
+
+        // The texture data is read front to back exactly once
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_data)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(m_data);
+#else
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+};
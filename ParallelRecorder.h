@@ -0,0 +1,66 @@
+/**************************************************************
+	Parallel Recorder
+
+	Splits a frame's draws into contiguous chunks and records each
+	chunk on its own thread. Chunk i always covers the same range
+	for a given draw count, so the caller can hand chunk i its own
+	command list up front and submit them in chunk order.
+
+	The calling thread records the first chunk itself instead of
+	sitting idle in WaitIdle(). Nothing in here knows about D3D,
+	'record' can write into anything.
+**************************************************************/
+#pragma once
+#include <algorithm>
+#include "WorkerPool.h"
+
+class ParallelRecorder
+{
+public:
+	// 'threadCount' includes the calling thread, 0 means one per core.
+	// 'minDrawsPerChunk' keeps small frames from paying for a thread handoff per draw.
+	ParallelRecorder(unsigned int threadCount, unsigned int minDrawsPerChunk)
+		: m_workers(threadCount > 1 ? threadCount - 1 : threadCount == 1 ? 1 : 0),
+		m_threadCount(threadCount ? threadCount : m_workers.GetThreadCount() + 1),
+		m_minDrawsPerChunk(minDrawsPerChunk ? minDrawsPerChunk : 1) { }
+
+	ParallelRecorder(const ParallelRecorder&) = delete;
+	ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+	unsigned int GetThreadCount() const { return m_threadCount; }
+
+	unsigned int GetChunkCount(unsigned int drawCount) const
+	{
+		const unsigned int chunks = (drawCount + m_minDrawsPerChunk - 1) / m_minDrawsPerChunk;
+		return std::max(1u, std::min(chunks, GetThreadCount()));
+	}
+
+	// Calls record(chunk, firstDraw, endDraw) once per chunk and returns when all of
+	// them are done. 'record' runs on several threads at once.
+	template <typename RecordFunc>
+	void Record(unsigned int drawCount, const RecordFunc& record)
+	{
+		const unsigned int chunks = GetChunkCount(drawCount);
+
+		for (unsigned int chunk = 1; chunk < chunks; chunk++)
+		{
+			m_workers.Submit([&record, chunk, chunks, drawCount]
+			{
+				record(chunk, ChunkBegin(chunk, chunks, drawCount), ChunkBegin(chunk + 1, chunks, drawCount));
+			});
+		}
+
+		record(0u, 0u, ChunkBegin(1, chunks, drawCount));
+		m_workers.WaitIdle();
+	}
+
+private:
+	static unsigned int ChunkBegin(unsigned int chunk, unsigned int chunks, unsigned int drawCount)
+	{
+		return static_cast<unsigned int>((static_cast<unsigned long long>(drawCount) * chunk) / chunks);
+	}
+
+	WorkerPool m_workers;			// Idle when 'threadCount' is 1
+	unsigned int m_threadCount;
+	unsigned int m_minDrawsPerChunk;
+};
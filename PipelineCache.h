@@ -0,0 +1,220 @@
+/**************************************************************
+	Pipeline Cache
+
+	Pipeline states by content. Every request is a pipeline state
+	stream (a D3D12_GRAPHICS_PIPELINE_STATE_DESC is turned into
+	one with CD3DX12_PIPELINE_STATE_STREAM), and the stream is
+	walked with D3DX12ParsePipelineStream and hashed subobject by
+	subobject: shader bytecode by its bytes, input layouts by
+	their semantic names, never by pointer. Root signatures are
+	hashed by their serialized blob if they were registered, so
+	the hash is the same from one run to the next.
+
+	A request whose hash was seen before gets the same PSO back
+	without touching the driver. A new one is looked up in an
+	ID3D12PipelineLibrary loaded from disk, and only compiled if
+	it isn't there either. Save() writes the library back out if
+	anything was added. Where the driver has no pipeline library,
+	or the file came from another driver or adapter, everything
+	is compiled and the library starts out empty.
+
+	Create() can be called from any thread. Two threads asking
+	for the same new PSO may both compile it, the first one in
+	keeps it and the other one's copy is dropped.
+**************************************************************/
+#pragma once
+#include <Windows.h>
+#include <d3d12.h>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "d3dx12.h"
+#include "ContentHash.h"
+#include "PipelineStreamHasher.h"
+
+class PipelineCache
+{
+public:
+	PipelineCache() : m_device(nullptr), m_library(nullptr), m_libraryChanged(false),
+		m_requestCount(0), m_dedupedCount(0), m_loadedCount(0), m_compiledCount(0) { }
+
+	~PipelineCache()
+	{
+		for (auto& pipeline : m_pipelines)
+			pipeline.second->Release();
+		if (m_library) m_library->Release();
+		if (m_device) m_device->Release();
+	}
+
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache& operator=(const PipelineCache&) = delete;
+
+	// Loads the library in 'fileName' if there is one
+	HRESULT Init(ID3D12Device* device, const wchar_t* fileName)
+	{
+		HRESULT hr = device->QueryInterface(IID_PPV_ARGS(&m_device));
+		if (FAILED(hr))
+			return hr;
+		m_fileName = fileName;
+
+		if (FILE* file = _wfopen(fileName, L"rb"))
+		{
+			fseek(file, 0, SEEK_END);
+			const long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			m_libraryData.resize(size > 0 ? size : 0);
+			if (fread(m_libraryData.data(), 1, m_libraryData.size(), file) != m_libraryData.size())
+				m_libraryData.clear();
+			fclose(file);
+		}
+
+		// The library reads from m_libraryData for as long as it lives. Data from
+		// another driver or adapter is refused, then we start over with an empty one.
+		if (!m_libraryData.empty())
+		{
+			hr = m_device->CreatePipelineLibrary(m_libraryData.data(), m_libraryData.size(), IID_PPV_ARGS(&m_library));
+			if (FAILED(hr))
+				m_libraryData.clear();
+		}
+		if (!m_library && FAILED(m_device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library))))
+			m_library = nullptr;		// No library support, everything gets compiled
+		return S_OK;
+	}
+
+	// Lets pipelines using 'rootSignature' be found again in the next run
+	void RegisterRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* serialized)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_rootSignatures[rootSignature] = HashBytes(serialized->GetBufferPointer(), serialized->GetBufferSize());
+	}
+
+	HRESULT Create(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3D12PipelineState** pipelineState)
+	{
+		CD3DX12_PIPELINE_STATE_STREAM stream(desc);
+		const D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(stream), &stream };
+		return Create(streamDesc, pipelineState);
+	}
+
+	// The PSO comes back with a reference of its own for the caller
+	HRESULT Create(const D3D12_PIPELINE_STATE_STREAM_DESC& stream, ID3D12PipelineState** pipelineState)
+	{
+		*pipelineState = nullptr;
+		m_requestCount++;
+
+		uint64_t hash;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			PipelineStreamHasher hasher(&m_rootSignatures);
+			if (FAILED(D3DX12ParsePipelineStream(stream, &hasher)) || hasher.Failed())
+				return E_INVALIDARG;
+			hash = hasher.GetHash();
+
+			auto found = m_pipelines.find(hash);
+			if (found != m_pipelines.end())
+			{
+				m_dedupedCount++;
+				*pipelineState = found->second;
+				(*pipelineState)->AddRef();
+				return S_OK;
+			}
+		}
+
+		wchar_t name[17];
+		swprintf(name, _countof(name), L"%016llx", static_cast<unsigned long long>(hash));
+
+		HRESULT hr = E_FAIL;
+		if (m_library)
+		{
+			std::lock_guard<std::mutex> lock(m_libraryMutex);
+			hr = m_library->LoadPipeline(name, &stream, IID_PPV_ARGS(pipelineState));
+		}
+		if (SUCCEEDED(hr))
+		{
+			m_loadedCount++;
+		}
+		else
+		{
+			hr = m_device->CreatePipelineState(&stream, IID_PPV_ARGS(pipelineState));
+			if (FAILED(hr))
+				return hr;
+			m_compiledCount++;
+
+			if (m_library)
+			{
+				std::lock_guard<std::mutex> lock(m_libraryMutex);
+				if (SUCCEEDED(m_library->StorePipeline(name, *pipelineState)))
+					m_libraryChanged = true;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto inserted = m_pipelines.insert({ hash, *pipelineState });
+		if (inserted.second)
+		{
+			(*pipelineState)->AddRef();
+		}
+		else
+		{
+			// Someone else got there first, theirs is the one everybody shares
+			(*pipelineState)->Release();
+			*pipelineState = inserted.first->second;
+			(*pipelineState)->AddRef();
+		}
+		return S_OK;
+	}
+
+	// Writes the library out if any pipeline was added to it
+	HRESULT Save()
+	{
+		std::lock_guard<std::mutex> lock(m_libraryMutex);
+		if (!m_library || !m_libraryChanged)
+			return S_OK;
+
+		std::vector<uint8_t> data(m_library->GetSerializedSize());
+		HRESULT hr = m_library->Serialize(data.data(), data.size());
+		if (FAILED(hr))
+			return hr;
+
+		// Written next to the old one and moved over it, so a crash never leaves half a library
+		const std::wstring tempPath = m_fileName + L".tmp";
+		FILE* file = _wfopen(tempPath.c_str(), L"wb");
+		if (!file)
+			return E_FAIL;
+		bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+		written = fclose(file) == 0 && written;
+		if (!written || !MoveFileExW(tempPath.c_str(), m_fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			DeleteFileW(tempPath.c_str());
+			return E_FAIL;
+		}
+
+		m_libraryChanged = false;
+		return S_OK;
+	}
+
+	bool HasLibrary() const { return m_library != nullptr; }
+	UINT GetRequestCount() const { return m_requestCount; }
+	UINT GetDedupedCount() const { return m_dedupedCount; }	// Same state asked for again
+	UINT GetLoadedCount() const { return m_loadedCount; }		// Found in the library
+	UINT GetCompiledCount() const { return m_compiledCount; }
+
+private:
+	ID3D12Device2* m_device;
+	ID3D12PipelineLibrary1* m_library;
+	std::wstring m_fileName;
+	std::vector<uint8_t> m_libraryData;
+	bool m_libraryChanged;
+
+	std::mutex m_mutex;				// m_pipelines and m_rootSignatures
+	std::mutex m_libraryMutex;
+	std::unordered_map<uint64_t, ID3D12PipelineState*> m_pipelines;
+	std::unordered_map<ID3D12RootSignature*, uint64_t> m_rootSignatures;
+
+	std::atomic<UINT> m_requestCount;
+	std::atomic<UINT> m_dedupedCount;
+	std::atomic<UINT> m_loadedCount;
+	std::atomic<UINT> m_compiledCount;
+};
@@ -0,0 +1,164 @@
+/**************************************************************
+	Pipeline Compile Queue
+
+	Specialized pipelines compiled on worker threads while draws
+	keep using a generic fallback. Every request comes with the
+	fallback to use until it's done and a function that does the
+	compiling, and Get() hands out whichever of the two is
+	current.
+
+	Requests don't run in the order they came in. Every frame the
+	render thread says how many draws each one would have been
+	used for, and a worker that's free takes the waiting request
+	with the most, so what covers the most of the screen gets
+	fixed first. Equal ones go in request order.
+
+	Finished pipelines are only swapped in by Update(), called on
+	the render thread before anything is recorded. A frame sees
+	the same pipeline for a request on every recording thread,
+	and Get() needs no lock.
+
+	Nothing D3D12 specific, 'Pipeline' is whatever the compile
+	function returns, a null one meaning it failed and the
+	fallback stays. A function that sleeps stands in for a
+	device to try the scheduling without one.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "WorkerPool.h"
+
+template <typename Pipeline>
+class PipelineCompileQueue
+{
+public:
+	explicit PipelineCompileQueue(unsigned int threadCount = 0)
+		: m_readyCount(0), m_failedCount(0), m_workers(threadCount) { }
+
+	// Requests nobody has started on are dropped, the ones being compiled are waited for
+	~PipelineCompileQueue()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_waiting.clear();
+	}
+
+	PipelineCompileQueue(const PipelineCompileQueue&) = delete;
+	PipelineCompileQueue& operator=(const PipelineCompileQueue&) = delete;
+
+	// Render thread. 'compile' runs on a worker thread, so whatever it uses has to
+	// be safe to call from there.
+	uint32_t Request(Pipeline fallback, std::function<Pipeline()> compile, uint32_t priority = 0)
+	{
+		const uint32_t id = static_cast<uint32_t>(m_current.size());
+		m_current.push_back(fallback);
+		m_ready.push_back(false);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requests.push_back({ std::move(compile), priority });
+			m_waiting.push_back(id);
+		}
+
+		// The job takes whichever request is most wanted by the time it runs, not this one
+		m_workers.Submit([this] { CompileNext(); });
+		return id;
+	}
+
+	// Render thread, normally once a frame with the number of draws that used the request
+	void SetPriority(uint32_t id, uint32_t priority)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests[id].Priority = priority;
+	}
+
+	// Render thread, before recording. Swaps in what finished since the last call and
+	// calls 'onReady' for each first. Returns how many were swapped in.
+	uint32_t Update(const std::function<void(uint32_t, Pipeline)>& onReady = nullptr)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished.swap(m_swapping);
+		}
+
+		uint32_t swapped = 0;
+		for (const std::pair<uint32_t, Pipeline>& finished : m_swapping)
+		{
+			if (!finished.second)
+			{
+				m_failedCount++;
+				continue;
+			}
+			if (onReady)
+				onReady(finished.first, finished.second);
+			m_current[finished.first] = finished.second;
+			m_ready[finished.first] = true;
+			swapped++;
+		}
+		m_swapping.clear();
+		m_readyCount += swapped;
+		return swapped;
+	}
+
+	// Any thread, as long as the render thread isn't in Request() or Update()
+	Pipeline Get(uint32_t id) const { return m_current[id]; }
+	bool IsReady(uint32_t id) const { return m_ready[id]; }
+
+	// Blocks until every request so far has been compiled, Update() still has to swap them in
+	void WaitIdle() { m_workers.WaitIdle(); }
+
+	uint32_t GetRequestCount() const { return static_cast<uint32_t>(m_current.size()); }
+	uint32_t GetReadyCount() const { return m_readyCount; }
+	uint32_t GetFailedCount() const { return m_failedCount; }
+	uint32_t GetWaitingCount() const { return GetRequestCount() - m_readyCount - m_failedCount; }
+
+private:
+	struct Entry
+	{
+		std::function<Pipeline()> Compile;
+		uint32_t Priority;
+	};
+
+	void CompileNext()
+	{
+		uint32_t id;
+		std::function<Pipeline()> compile;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_waiting.empty())
+				return;
+
+			size_t best = 0;
+			for (size_t i = 1; i < m_waiting.size(); i++)
+			{
+				if (m_requests[m_waiting[i]].Priority > m_requests[m_waiting[best]].Priority)
+					best = i;
+			}
+			id = m_waiting[best];
+			m_waiting.erase(m_waiting.begin() + best);
+			compile = std::move(m_requests[id].Compile);
+		}
+
+		const Pipeline pipeline = compile();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finished.push_back({ id, pipeline });
+	}
+
+	// Render thread only
+	std::vector<Pipeline> m_current;
+	std::vector<bool> m_ready;
+	std::vector<std::pair<uint32_t, Pipeline>> m_swapping;
+	uint32_t m_readyCount;
+	uint32_t m_failedCount;
+
+	// Shared with the workers
+	std::mutex m_mutex;
+	std::vector<Entry> m_requests;
+	std::vector<uint32_t> m_waiting;		// In request order
+	std::vector<std::pair<uint32_t, Pipeline>> m_finished;
+
+	// Last, so the workers are stopped before anything they use goes away
+	WorkerPool m_workers;
+};
@@ -0,0 +1,215 @@
+/**************************************************************
+	Pipeline Stream Hasher
+
+	Walks a pipeline state stream with D3DX12ParsePipelineStream
+	and hashes what the pipeline state is made of, subobject by
+	subobject: shader bytecode by its bytes, input layouts and
+	stream output by their semantic names, never by pointer, so
+	two requests built separately for the same state hash the
+	same. Root signatures can only be told apart by pointer,
+	unless they're mapped to the hash of their serialized blob.
+
+	Needs no device, PipelineCache.h is the part that keeps and
+	creates the pipeline states.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <unordered_map>
+#include "d3dx12.h"
+#include "ContentHash.h"
+
+// Walks a stream and hashes what the pipeline state is made of. Needs no device.
+class PipelineStreamHasher : public ID3DX12PipelineParserCallbacks
+{
+public:
+	// 'rootSignatures' maps a root signature to the hash of its serialized blob, can be null
+	explicit PipelineStreamHasher(const std::unordered_map<ID3D12RootSignature*, uint64_t>* rootSignatures = nullptr)
+		: m_rootSignatures(rootSignatures), m_hash(ContentHashSeed), m_failed(false) { }
+
+	uint64_t GetHash() const { return m_hash; }
+	bool Failed() const { return m_failed; }
+
+	void FlagsCb(D3D12_PIPELINE_STATE_FLAGS flags) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS); Add(flags); }
+	void NodeMaskCb(UINT nodeMask) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK); Add(nodeMask); }
+
+	void RootSignatureCb(ID3D12RootSignature* rootSignature) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE);
+		if (m_rootSignatures)
+		{
+			auto found = m_rootSignatures->find(rootSignature);
+			if (found != m_rootSignatures->end())
+			{
+				Add(found->second);
+				return;
+			}
+		}
+		// Still tells root signatures apart, just not from one run to the next
+		Add(reinterpret_cast<uintptr_t>(rootSignature));
+	}
+
+	void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& inputLayout) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT);
+		Add(inputLayout.NumElements);
+		for (UINT i = 0; i < inputLayout.NumElements; i++)
+		{
+			const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[i];
+			m_hash = HashString(element.SemanticName, m_hash);
+			Add(element.SemanticIndex);
+			Add(element.Format);
+			Add(element.InputSlot);
+			Add(element.AlignedByteOffset);
+			Add(element.InputSlotClass);
+			Add(element.InstanceDataStepRate);
+		}
+	}
+
+	void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE); Add(value); }
+	void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE type) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY); Add(type); }
+
+	void VSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, shader); }
+	void GSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, shader); }
+	void HSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, shader); }
+	void DSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, shader); }
+	void PSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, shader); }
+	void CSCb(const D3D12_SHADER_BYTECODE& shader) override { Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, shader); }
+
+	void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& streamOutput) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT);
+		Add(streamOutput.NumEntries);
+		for (UINT i = 0; i < streamOutput.NumEntries; i++)
+		{
+			const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+			Add(entry.Stream);
+			m_hash = HashString(entry.SemanticName, m_hash);
+			Add(entry.SemanticIndex);
+			Add(entry.StartComponent);
+			Add(entry.ComponentCount);
+			Add(entry.OutputSlot);
+		}
+		Add(streamOutput.NumStrides);
+		m_hash = HashBytes(streamOutput.pBufferStrides, streamOutput.NumStrides * sizeof(UINT), m_hash);
+		Add(streamOutput.RasterizedStream);
+	}
+
+	void BlendStateCb(const D3D12_BLEND_DESC& blend) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND);
+		Add(blend.AlphaToCoverageEnable);
+		Add(blend.IndependentBlendEnable);
+		for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+		{
+			Add(target.BlendEnable);
+			Add(target.LogicOpEnable);
+			Add(target.SrcBlend);
+			Add(target.DestBlend);
+			Add(target.BlendOp);
+			Add(target.SrcBlendAlpha);
+			Add(target.DestBlendAlpha);
+			Add(target.BlendOpAlpha);
+			Add(target.LogicOp);
+			Add(target.RenderTargetWriteMask);
+		}
+	}
+
+	// Both depth stencil subobjects hash the same for the same state
+	void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& depthStencil) override
+	{
+		DepthStencilState1Cb(CD3DX12_DEPTH_STENCIL_DESC1(depthStencil));
+	}
+
+	void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& depthStencil) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL);
+		Add(depthStencil.DepthEnable);
+		Add(depthStencil.DepthWriteMask);
+		Add(depthStencil.DepthFunc);
+		Add(depthStencil.StencilEnable);
+		Add(depthStencil.StencilReadMask);
+		Add(depthStencil.StencilWriteMask);
+		for (const D3D12_DEPTH_STENCILOP_DESC* face : { &depthStencil.FrontFace, &depthStencil.BackFace })
+		{
+			Add(face->StencilFailOp);
+			Add(face->StencilDepthFailOp);
+			Add(face->StencilPassOp);
+			Add(face->StencilFunc);
+		}
+		Add(depthStencil.DepthBoundsTestEnable);
+	}
+
+	void DSVFormatCb(DXGI_FORMAT format) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT); Add(format); }
+
+	void RasterizerStateCb(const D3D12_RASTERIZER_DESC& rasterizer) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER);
+		Add(rasterizer.FillMode);
+		Add(rasterizer.CullMode);
+		Add(rasterizer.FrontCounterClockwise);
+		Add(rasterizer.DepthBias);
+		Add(rasterizer.DepthBiasClamp);
+		Add(rasterizer.SlopeScaledDepthBias);
+		Add(rasterizer.DepthClipEnable);
+		Add(rasterizer.MultisampleEnable);
+		Add(rasterizer.AntialiasedLineEnable);
+		Add(rasterizer.ForcedSampleCount);
+		Add(rasterizer.ConservativeRaster);
+	}
+
+	void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& formats) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS);
+		Add(formats.NumRenderTargets);
+		for (UINT i = 0; i < formats.NumRenderTargets && i < 8; i++)
+			Add(formats.RTFormats[i]);
+	}
+
+	void SampleDescCb(const DXGI_SAMPLE_DESC& sampleDesc) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC);
+		Add(sampleDesc.Count);
+		Add(sampleDesc.Quality);
+	}
+
+	void SampleMaskCb(UINT sampleMask) override { Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK); Add(sampleMask); }
+
+	void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& viewInstancing) override
+	{
+		Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING);
+		Add(viewInstancing.ViewInstanceCount);
+		for (UINT i = 0; i < viewInstancing.ViewInstanceCount; i++)
+		{
+			Add(viewInstancing.pViewInstanceLocations[i].ViewportArrayIndex);
+			Add(viewInstancing.pViewInstanceLocations[i].RenderTargetArrayIndex);
+		}
+		Add(viewInstancing.Flags);
+	}
+
+	// A cached blob is a hint for the driver, not part of the state
+	void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE&) override { }
+
+	void ErrorBadInputParameter(UINT) override { m_failed = true; }
+	void ErrorDuplicateSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE) override { m_failed = true; }
+	void ErrorUnknownSubobject(UINT) override { m_failed = true; }
+
+private:
+	template <typename T>
+	void Add(const T& value) { m_hash = HashValue(value, m_hash); }
+
+	void Tag(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type) { Add(static_cast<uint32_t>(type)); }
+
+	// Empty shaders are left out, a stream with a null CS hashes like one without it
+	void Shader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const D3D12_SHADER_BYTECODE& shader)
+	{
+		if (!shader.BytecodeLength)
+			return;
+		Tag(type);
+		Add(static_cast<uint64_t>(shader.BytecodeLength));
+		m_hash = HashBytes(shader.pShaderBytecode, shader.BytecodeLength, m_hash);
+	}
+
+	const std::unordered_map<ID3D12RootSignature*, uint64_t>* m_rootSignatures;
+	uint64_t m_hash;
+	bool m_failed;
+};
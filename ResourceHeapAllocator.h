@@ -0,0 +1,330 @@
+/**************************************************************
+	Resource Heap Allocator
+
+	DEFAULT heap buffers and textures placed in big ID3D12Heap
+	blocks instead of a committed allocation each. Every block is
+	split up by a BuddyAllocator.
+
+	Resource heap tier 1 hardware can't mix buffers, render target
+	and depth textures, and other textures in one heap, so there
+	is a pool of blocks for each of those. On tier 2 everything
+	shares one pool.
+
+	Buffers and most textures need 64 KB alignment. Textures that
+	aren't render targets or depth buffers and are small enough
+	can go down to 4 KB, which is asked for first and only dropped
+	if the device says no. Anything that needs more than 64 KB
+	(multisampled textures) or is bigger than half a block gets a
+	committed resource after all.
+
+	A new block is only created when none has room. It's the full
+	block size unless the adapter's local memory budget doesn't
+	leave room for it, then it's just big enough for what's being
+	placed. Blocks that end up empty are released, except one per
+	pool to keep allocating from.
+
+	Free() instead of Release(): the resource goes away and its
+	range is handed back once the frame that last used it has
+	completed, the same way the rings recycle their memory.
+
+	Every placed allocation and free can be recorded as an
+	AllocationTraceEntry, to replay against BuddyAllocators
+	elsewhere. Render thread only.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "d3dx12.h"
+#include "BuddyAllocator.h"
+
+class ResourceHeapAllocator
+{
+public:
+	enum Pool : uint8_t
+	{
+		POOL_BUFFERS,
+		POOL_TEXTURES,
+		POOL_TARGETS,		// Render target and depth stencil textures
+		POOL_COUNT
+	};
+
+	ResourceHeapAllocator()
+		: m_device(nullptr), m_adapter(nullptr), m_blockSize(0), m_mixedHeaps(false), m_recording(false), m_nextId(0),
+		m_placedCount(0), m_committedCount(0), m_overBudgetCount(0) { }
+
+	~ResourceHeapAllocator()
+	{
+		for (PendingFree& pending : m_freed)
+			pending.Resource->Release();
+		for (PendingFree& pending : m_inFlight)
+			pending.Resource->Release();
+		for (std::vector<Block>& pool : m_pools)
+		{
+			for (Block& block : pool)
+				block.Heap->Release();
+		}
+		if (m_adapter) m_adapter->Release();
+	}
+
+	ResourceHeapAllocator(const ResourceHeapAllocator&) = delete;
+	ResourceHeapAllocator& operator=(const ResourceHeapAllocator&) = delete;
+
+	// 'adapter' is for the memory budget and can be null, 'blockSize' a power of two
+	HRESULT Init(ID3D12Device* device, IDXGIAdapter3* adapter, UINT64 blockSize)
+	{
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+		HRESULT hr = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options));
+		if (FAILED(hr))
+			return hr;
+
+		m_device = device;
+		m_adapter = adapter;
+		if (m_adapter)
+			m_adapter->AddRef();
+		m_blockSize = blockSize;
+		m_mixedHeaps = options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+		return S_OK;
+	}
+
+	void RecordTrace(bool record) { m_recording = record; }
+	const std::vector<AllocationTraceEntry>& GetTrace() const { return m_trace; }
+
+	HRESULT CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES state, const D3D12_CLEAR_VALUE* clearValue,
+		ID3D12Resource** resource)
+	{
+		const Pool pool = PoolFor(desc);
+
+		// Small textures try the 4 KB alignment first, everything else (and a small
+		// texture the driver won't give 4 KB) is asked about with the desc as it is
+		D3D12_RESOURCE_DESC placedDesc = desc;
+		D3D12_RESOURCE_ALLOCATION_INFO info = {};
+		bool queried = false;
+		const bool smallTexture = desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && desc.SampleDesc.Count <= 1
+			&& !(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL));
+		if (smallTexture)
+		{
+			placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+			info = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+			queried = info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+			if (!queried)
+				placedDesc.Alignment = 0;
+		}
+		if (!queried)
+			info = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+
+		if (info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT || info.SizeInBytes > m_blockSize / 2)
+		{
+			const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+			const HRESULT hr = m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
+				&desc, state, clearValue, IID_PPV_ARGS(resource));
+			if (SUCCEEDED(hr))
+				m_committedCount++;
+			return hr;
+		}
+
+		Placement placement = {};
+		placement.HeapPool = pool;
+		placement.Id = m_nextId++;
+		HRESULT hr = Allocate(pool, info.SizeInBytes, info.Alignment, &placement);
+		if (FAILED(hr))
+			return hr;
+
+		Block& block = m_pools[pool][placement.Block];
+		hr = m_device->CreatePlacedResource(block.Heap, placement.Offset, &placedDesc, state, clearValue, IID_PPV_ARGS(resource));
+		if (FAILED(hr))
+		{
+			block.Ranges.Free(placement.Offset);
+			return hr;
+		}
+
+		if (m_recording)
+			m_trace.push_back({ AllocationTraceEntry::ALLOCATE, static_cast<uint8_t>(pool), placement.Id, info.SizeInBytes, info.Alignment });
+
+		m_placements[*resource] = placement;
+		m_placedCount++;
+		return S_OK;
+	}
+
+	// Takes over the caller's reference, see above
+	void Free(ID3D12Resource* resource)
+	{
+		m_freed.push_back({ resource, 0 });
+	}
+
+	// Everything freed since the last call may still be used by the frame signaling 'fenceValue'
+	void FinishFrame(UINT64 fenceValue)
+	{
+		for (PendingFree& pending : m_freed)
+			m_inFlight.push_back({ pending.Resource, fenceValue });
+		m_freed.clear();
+	}
+
+	void ReleaseCompleted(UINT64 completedFenceValue)
+	{
+		while (!m_inFlight.empty() && m_inFlight.front().FenceValue <= completedFenceValue)
+		{
+			ID3D12Resource* resource = m_inFlight.front().Resource;
+			m_inFlight.pop_front();
+
+			auto found = m_placements.find(resource);
+			resource->Release();
+			if (found == m_placements.end())
+				continue;		// Committed
+
+			const Placement placement = found->second;
+			m_placements.erase(found);
+			if (m_recording)
+				m_trace.push_back({ AllocationTraceEntry::FREE, placement.HeapPool, placement.Id, 0, 0 });
+
+			m_pools[placement.HeapPool][placement.Block].Ranges.Free(placement.Offset);
+			ReleaseEmptyBlocks(placement.HeapPool);
+		}
+	}
+
+	UINT GetBlockCount() const
+	{
+		UINT count = 0;
+		for (const std::vector<Block>& pool : m_pools)
+			count += static_cast<UINT>(pool.size());
+		return count;
+	}
+
+	// Bytes in heaps, and how much of that is handed out
+	UINT64 GetHeapSize() const { return SumBlocks(&BuddyAllocator::GetSize); }
+	UINT64 GetAllocatedSize() const { return SumBlocks(&BuddyAllocator::GetAllocatedSize); }
+
+	UINT64 GetPlacedCount() const { return m_placedCount; }
+	UINT64 GetCommittedCount() const { return m_committedCount; }
+	UINT GetOverBudgetCount() const { return m_overBudgetCount; }
+
+private:
+	struct Block
+	{
+		ID3D12Heap* Heap;
+		BuddyAllocator Ranges;
+	};
+
+	struct Placement
+	{
+		Pool HeapPool;
+		UINT32 Id;
+		UINT Block;
+		UINT64 Offset;
+	};
+
+	struct PendingFree
+	{
+		ID3D12Resource* Resource;
+		UINT64 FenceValue;
+	};
+
+	Pool PoolFor(const D3D12_RESOURCE_DESC& desc) const
+	{
+		if (m_mixedHeaps || desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			return POOL_BUFFERS;
+		if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+			return POOL_TARGETS;
+		return POOL_TEXTURES;
+	}
+
+	HRESULT Allocate(Pool pool, UINT64 size, UINT64 alignment, Placement* placement)
+	{
+		std::vector<Block>& blocks = m_pools[pool];
+		for (UINT block = 0; block < blocks.size(); block++)
+		{
+			const UINT64 offset = blocks[block].Ranges.Allocate(size, alignment);
+			if (offset != BuddyAllocator::InvalidOffset)
+			{
+				placement->Block = block;
+				placement->Offset = offset;
+				return S_OK;
+			}
+		}
+
+		// A whole block if the budget has room for it, otherwise only as much as needed
+		UINT64 heapSize = m_blockSize;
+		if (m_adapter)
+		{
+			DXGI_QUERY_VIDEO_MEMORY_INFO memory = {};
+			if (SUCCEEDED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memory)))
+			{
+				const UINT64 available = memory.Budget > memory.CurrentUsage ? memory.Budget - memory.CurrentUsage : 0;
+				if (heapSize > available)
+				{
+					heapSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+					while (heapSize < size || heapSize < alignment)
+						heapSize *= 2;
+					m_overBudgetCount++;
+				}
+			}
+		}
+
+		static const D3D12_HEAP_FLAGS poolFlags[POOL_COUNT] =
+		{
+			D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+		};
+
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = heapSize;
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = m_mixedHeaps ? D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES : poolFlags[pool];
+
+		Block block = {};
+		HRESULT hr = m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&block.Heap));
+		if (FAILED(hr))
+			return hr;
+
+		block.Ranges.Reset(heapSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+		placement->Block = static_cast<UINT>(blocks.size());
+		placement->Offset = block.Ranges.Allocate(size, alignment);
+		blocks.push_back(std::move(block));
+		return S_OK;
+	}
+
+	// Placements index blocks, so only empty blocks at the end of the pool can go
+	// without renumbering. One of them stays to allocate from next time.
+	void ReleaseEmptyBlocks(Pool pool)
+	{
+		std::vector<Block>& blocks = m_pools[pool];
+		while (blocks.size() > 1 && blocks.back().Ranges.IsEmpty() && blocks[blocks.size() - 2].Ranges.IsEmpty())
+		{
+			blocks.back().Heap->Release();
+			blocks.pop_back();
+		}
+	}
+
+	UINT64 SumBlocks(UINT64 (BuddyAllocator::*get)() const) const
+	{
+		UINT64 sum = 0;
+		for (const std::vector<Block>& pool : m_pools)
+		{
+			for (const Block& block : pool)
+				sum += (block.Ranges.*get)();
+		}
+		return sum;
+	}
+
+	ID3D12Device* m_device;
+	IDXGIAdapter3* m_adapter;
+	UINT64 m_blockSize;
+	bool m_mixedHeaps;
+
+	std::vector<Block> m_pools[POOL_COUNT];
+	std::unordered_map<ID3D12Resource*, Placement> m_placements;
+	std::vector<PendingFree> m_freed;
+	std::deque<PendingFree> m_inFlight;
+
+	bool m_recording;
+	std::vector<AllocationTraceEntry> m_trace;
+	UINT32 m_nextId;
+
+	UINT64 m_placedCount;
+	UINT m_committedCount;
+	UINT m_overBudgetCount;
+};
@@ -0,0 +1,279 @@
+/**************************************************************
+	Resource State Tracker
+
+	Knows what state every registered resource is in, down to the
+	subresource, so code asks for the state it needs instead of
+	writing out the before state by hand. Transition() works out
+	the barriers and queues them, Flush() sends everything queued
+	in one ResourceBarrier call.
+
+	While they sit in the queue barriers are cheap to fix up:
+	asking for a state the resource is already in, or a read state
+	it already includes, queues nothing, and a second transition
+	of the same subresource before the flush is folded into the
+	first (A->B then B->C is sent as A->C, A->B then B->A is
+	dropped). That's only sound because nothing gets recorded
+	between queueing and flushing, so flush into the list that's
+	about to use the resources before recording anything else.
+
+	BeginTransition() starts a split barrier, the matching
+	Transition() later ends it. Use it when there's work to put
+	in between, the gpu can then overlap the transition with it.
+
+	Uniform resources are one state for all subresources until a
+	single subresource is transitioned on its own. They fold back
+	once their subresources are all in the same state again.
+
+	The state is global, not per list, so every list that has
+	transitions has to be recorded on the render thread in the
+	order it's submitted. Lists recorded on other threads can use
+	resources but must not need a transition.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+class ResourceStateTracker
+{
+public:
+	ResourceStateTracker() : m_requestedCount(0), m_issuedCount(0), m_skippedCount(0), m_mergedCount(0), m_batchCount(0) { }
+
+	ResourceStateTracker(const ResourceStateTracker&) = delete;
+	ResourceStateTracker& operator=(const ResourceStateTracker&) = delete;
+
+	// 'state' is what the resource was created in, or is in right now
+	void Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresourceCount = 1)
+	{
+		TrackedResource& tracked = m_resources[resource];
+		tracked.SubresourceCount = subresourceCount;
+		tracked.Subresources.assign(1, { state, state, false });
+	}
+
+	void Unregister(ID3D12Resource* resource) { m_resources.erase(resource); }
+
+	void Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		TrackedResource& tracked = Find(resource);
+		if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+		{
+			for (UINT i = 0; i < tracked.Subresources.size(); i++)
+				TransitionSubresource(resource, tracked.Subresources[i], tracked.IsUniform() ? subresource : i, state);
+		}
+		else
+		{
+			Expand(resource, tracked);
+			TransitionSubresource(resource, tracked.Subresources[subresource], subresource, state);
+		}
+		Fold(tracked);
+	}
+
+	// The resource can't be used until the Transition() to the same state
+	void BeginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		TrackedResource& tracked = Find(resource);
+		if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+		{
+			for (UINT i = 0; i < tracked.Subresources.size(); i++)
+				BeginSubresource(resource, tracked.Subresources[i], tracked.IsUniform() ? subresource : i, state);
+		}
+		else
+		{
+			Expand(resource, tracked);
+			BeginSubresource(resource, tracked.Subresources[subresource], subresource, state);
+		}
+	}
+
+	// 'after' takes over memory it shares with other placed resources, a null
+	// 'before' stands for any of them. Queued in order with the transitions.
+	void Aliasing(ID3D12Resource* before, ID3D12Resource* after)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+		barrier.Aliasing.pResourceBefore = before;
+		barrier.Aliasing.pResourceAfter = after;
+		m_barriers.push_back(barrier);
+	}
+
+	// 'commandList' is anything with ResourceBarrier(count, barriers), a
+	// CapturedCommandList for instance, so the barriers get captured too
+	template <typename CommandList>
+	void Flush(CommandList& commandList)
+	{
+		if (m_barriers.empty())
+			return;
+
+		commandList.ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+		m_issuedCount += m_barriers.size();
+		m_batchCount++;
+		m_barriers.clear();
+	}
+
+	// The state after everything queued so far, mid split it's still the old one
+	D3D12_RESOURCE_STATES GetState(ID3D12Resource* resource, UINT subresource = 0)
+	{
+		const TrackedResource& tracked = Find(resource);
+		return tracked.Subresources[tracked.IsUniform() ? 0 : subresource].State;
+	}
+
+	UINT GetQueuedCount() const { return static_cast<UINT>(m_barriers.size()); }
+
+	// Counters since startup: transitions asked for, barriers actually sent, in how
+	// many ResourceBarrier calls, and how many were redundant or folded into another
+	UINT64 GetRequestedCount() const { return m_requestedCount; }
+	UINT64 GetIssuedCount() const { return m_issuedCount; }
+	UINT64 GetBatchCount() const { return m_batchCount; }
+	UINT64 GetSkippedCount() const { return m_skippedCount; }
+	UINT64 GetMergedCount() const { return m_mergedCount; }
+
+private:
+	struct SubresourceState
+	{
+		D3D12_RESOURCE_STATES State;
+		D3D12_RESOURCE_STATES SplitState;	// Where the split barrier is going
+		bool Splitting;
+	};
+
+	struct TrackedResource
+	{
+		UINT SubresourceCount;
+		std::vector<SubresourceState> Subresources;	// One entry while uniform
+
+		bool IsUniform() const { return Subresources.size() == 1; }
+	};
+
+	static constexpr D3D12_RESOURCE_STATES ReadStates = D3D12_RESOURCE_STATES(D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ);
+
+	// COMMON is 0, so it's never 'already included' in anything
+	static bool Includes(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES state)
+	{
+		if (current == state)
+			return true;
+		return state && !(current & ~ReadStates) && (current & state) == state;
+	}
+
+	TrackedResource& Find(ID3D12Resource* resource)
+	{
+		auto found = m_resources.find(resource);
+		assert(found != m_resources.end());
+		return found->second;
+	}
+
+	// A split that covers the whole resource has to end as one too
+	void Expand(ID3D12Resource* resource, TrackedResource& tracked)
+	{
+		if (!tracked.IsUniform())
+			return;
+
+		SubresourceState& uniform = tracked.Subresources[0];
+		if (uniform.Splitting)
+			TransitionSubresource(resource, uniform, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, uniform.SplitState);
+		tracked.Subresources.assign(tracked.SubresourceCount, uniform);
+	}
+
+	void Fold(TrackedResource& tracked)
+	{
+		for (const SubresourceState& subresource : tracked.Subresources)
+		{
+			if (subresource.Splitting || subresource.State != tracked.Subresources[0].State)
+				return;
+		}
+		tracked.Subresources.resize(1);
+	}
+
+	void TransitionSubresource(ID3D12Resource* resource, SubresourceState& current, UINT subresource, D3D12_RESOURCE_STATES state)
+	{
+		m_requestedCount++;
+
+		if (current.Splitting)
+		{
+			current.Splitting = false;
+			Queue(resource, subresource, current.State, current.SplitState, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+			current.State = current.SplitState;
+		}
+
+		if (Includes(current.State, state))
+		{
+			m_skippedCount++;
+			return;
+		}
+
+		// An earlier full barrier for this subresource still in the queue can just go further
+		for (size_t i = m_barriers.size(); i-- > 0;)
+		{
+			D3D12_RESOURCE_BARRIER& queued = m_barriers[i];
+			if (queued.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING)
+			{
+				if (!queued.Aliasing.pResourceBefore || queued.Aliasing.pResourceBefore == resource || queued.Aliasing.pResourceAfter == resource)
+					break;
+				continue;
+			}
+			if (queued.Transition.pResource != resource)
+				continue;
+
+			// A whole resource barrier and one for a subresource overlap, neither can move past the other
+			if (queued.Transition.Subresource != subresource)
+			{
+				if (queued.Transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES || subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+					break;
+				continue;
+			}
+			if (queued.Flags != D3D12_RESOURCE_BARRIER_FLAG_NONE)
+				break;
+
+			m_mergedCount++;
+			if (queued.Transition.StateBefore == state)
+				m_barriers.erase(m_barriers.begin() + i);
+			else
+				queued.Transition.StateAfter = state;
+			current.State = state;
+			return;
+		}
+
+		Queue(resource, subresource, current.State, state, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+		current.State = state;
+	}
+
+	void BeginSubresource(ID3D12Resource* resource, SubresourceState& current, UINT subresource, D3D12_RESOURCE_STATES state)
+	{
+		if (current.Splitting)
+		{
+			if (current.SplitState == state)
+				return;
+			TransitionSubresource(resource, current, subresource, current.SplitState);
+		}
+
+		m_requestedCount++;
+		if (Includes(current.State, state))
+		{
+			m_skippedCount++;
+			return;
+		}
+
+		Queue(resource, subresource, current.State, state, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+		current.SplitState = state;
+		current.Splitting = true;
+	}
+
+	void Queue(ID3D12Resource* resource, UINT subresource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Flags = flags;
+		barrier.Transition.pResource = resource;
+		barrier.Transition.Subresource = subresource;
+		barrier.Transition.StateBefore = before;
+		barrier.Transition.StateAfter = after;
+		m_barriers.push_back(barrier);
+	}
+
+	std::unordered_map<ID3D12Resource*, TrackedResource> m_resources;
+	std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
+
+	UINT64 m_requestedCount;
+	UINT64 m_issuedCount;
+	UINT64 m_skippedCount;
+	UINT64 m_mergedCount;
+	UINT64 m_batchCount;
+};
@@ -0,0 +1,130 @@
+/**************************************************************
+	Ring Allocator
+
+	Hands out linear, aligned slices of one big buffer and takes
+	them back in the order they were given out, once the fence
+	value they were tagged with has completed on the gpu.
+
+	There is nothing D3D12 specific in here, the allocator only
+	deals with offsets so it can sit on top of any mapped buffer.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <deque>
+
+class RingAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = ~0ull;
+
+	explicit RingAllocator(uint64_t size = 0) { Reset(size); }
+
+	void Reset(uint64_t size)
+	{
+		m_size = size;
+		m_head = 0;
+		m_tail = 0;
+		m_used = 0;
+		m_frameStartUsed = 0;
+		m_frames.clear();
+	}
+
+	// Returns the offset of an aligned block of 'size' bytes, or InvalidOffset if
+	// the ring is full. Alignment must be a power of two.
+	uint64_t Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0 || size > m_size)
+			return InvalidOffset;
+
+		const uint64_t alignedHead = AlignUp(m_head, alignment);
+		const uint64_t padding = alignedHead - m_head;
+
+		if (m_head > m_tail || m_used == 0)
+		{
+			// [tail ... head) is in use, free space is [head, size) and [0, tail)
+			if (alignedHead + size <= m_size)
+			{
+				m_head = alignedHead + size;
+				m_used += padding + size;
+				return alignedHead;
+			}
+
+			// Nothing is in use, so just restart from the beginning. Any frames still
+			// waiting on their fence are empty and need to point there as well.
+			if (m_used == 0)
+			{
+				for (FrameMarker& frame : m_frames)
+					frame.Tail = 0;
+				m_tail = 0;
+				m_head = size;
+				m_used = size;
+				return 0;
+			}
+
+			// Not enough room at the end, waste it and wrap around to the start
+			if (size <= m_tail)
+			{
+				const uint64_t wasted = m_size - m_head;
+				m_head = size;
+				m_used += wasted + size;
+				return 0;
+			}
+		}
+		else if (alignedHead + size <= m_tail)
+		{
+			// Already wrapped, free space is [head, tail)
+			m_head = alignedHead + size;
+			m_used += padding + size;
+			return alignedHead;
+		}
+
+		return InvalidOffset;
+	}
+
+	// Tags everything allocated since the last call with the fence value
+	// the frame was signaled with.
+	void FinishFrame(uint64_t fenceValue)
+	{
+		const uint64_t frameSize = m_used - m_frameStartUsed;
+		m_frames.push_back({ fenceValue, m_head, frameSize });
+		m_frameStartUsed = m_used;
+	}
+
+	// Gives back the memory of every frame whose fence value has completed.
+	void ReleaseCompletedFrames(uint64_t completedFenceValue)
+	{
+		while (!m_frames.empty() && m_frames.front().FenceValue <= completedFenceValue)
+		{
+			const FrameMarker& frame = m_frames.front();
+			m_used -= frame.Size;
+			m_frameStartUsed -= frame.Size;
+			m_tail = frame.Tail;
+			m_frames.pop_front();
+		}
+	}
+
+	uint64_t GetSize() const { return m_size; }
+	uint64_t GetUsedSize() const { return m_used; }
+	bool IsEmpty() const { return m_used == 0; }
+	bool IsFull() const { return m_used == m_size; }
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+private:
+	struct FrameMarker
+	{
+		uint64_t FenceValue;
+		uint64_t Tail;
+		uint64_t Size;
+	};
+
+	uint64_t m_size;
+	uint64_t m_head;
+	uint64_t m_tail;
+	uint64_t m_used;
+	uint64_t m_frameStartUsed;
+	std::deque<FrameMarker> m_frames;
+};
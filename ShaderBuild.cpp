@@ -0,0 +1,243 @@
+/**************************************************************
+	The build's shader step: every shader WinMain compiles, run
+	through dxc ahead of time into the directory ShaderCache
+	looks in first (PREBUILT_SHADER_DIR). The list is WinMain's,
+	and the PSMain permutations come from the same
+	AddPixelShaderOptions(), so the keys line up.
+
+	For each shader dxc writes the DXIL (-Fo), its reflection
+	blob (-Fre) and a listing (-Fc). The listing is only read for
+	the instruction count, counted the way the permutation report
+	does. The three go into one ShaderCacheFile.h file, with the
+	includes the source names (#include "...", next to it).
+
+	Afterwards every file is loaded back the way ShaderCache does
+	on a hit, and both times are printed: what startup costs
+	compiling everything against what it costs with the build's
+	output.
+
+	ShaderBuild <dxc> <Shaders.hlsl> <output directory>
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "DrawBinding.h"
+#include "ShaderCacheFile.h"
+#include "ShaderPermutationKeys.h"
+
+namespace
+{
+	struct Shader
+	{
+		const char* EntryPoint;
+		const char* Target;
+		std::vector<std::pair<std::string, std::string>> Defines;
+	};
+
+	// The order and spelling of the defines is part of the key, so they're the ones WinMain passes
+	std::vector<Shader> AppShaders()
+	{
+		std::vector<Shader> shaders =
+		{
+			{ "VSMainInstanced", "vs_5_1", {} },
+			{ "PSMain", "ps_5_1", {} },
+			{ "VSUpscale", "vs_5_1", {} },
+			{ "PSUpscale", "ps_5_1", {} },
+		};
+		for (uint32_t binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+			shaders.push_back({ "VSMain", "vs_5_1", { { "BINDING", std::to_string(binding) } } });
+
+		ShaderPermutationKeys pixelShaders;
+		AddPixelShaderOptions(pixelShaders);
+		for (uint32_t key = 0; key < pixelShaders.GetPermutationCount(); key++)
+		{
+			Shader shader = { "PSMain", "ps_5_1", {} };
+			for (uint32_t option = 0; option < pixelShaders.GetOptionCount(); option++)
+				shader.Defines.push_back({ pixelShaders.GetDefine(option), std::to_string(pixelShaders.GetValue(key, option)) });
+			shaders.push_back(shader);
+		}
+		return shaders;
+	}
+
+	bool ReadFile(const std::string& fileName, std::vector<uint8_t>& bytes)
+	{
+		FILE* file = std::fopen(fileName.c_str(), "rb");
+		if (!file)
+			return false;
+
+		std::fseek(file, 0, SEEK_END);
+		const long size = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+		bytes.resize(size > 0 ? size : 0);
+		const bool read = size >= 0 && std::fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		std::fclose(file);
+		return read;
+	}
+
+	bool WriteFile(const std::string& fileName, const std::vector<uint8_t>& bytes)
+	{
+		FILE* file = std::fopen(fileName.c_str(), "wb");
+		if (!file)
+			return false;
+		const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		return std::fclose(file) == 0 && written;
+	}
+
+	// The quoted includes of 'source', hashed. False if one of them can't be read.
+	bool FindIncludes(const std::vector<uint8_t>& source, const std::string& directory, std::vector<ShaderCacheInclude>& includes)
+	{
+		const std::string text(source.begin(), source.end());
+		for (size_t line = 0; line < text.size(); line = text.find('\n', line) + 1)
+		{
+			const size_t start = text.find_first_not_of(" \t", line);
+			if (start == std::string::npos || text.compare(start, 8, "#include") != 0)
+			{
+				if (text.find('\n', line) == std::string::npos)
+					break;
+				continue;
+			}
+
+			const size_t open = text.find('"', start);
+			const size_t close = open == std::string::npos ? open : text.find('"', open + 1);
+			if (close == std::string::npos || text.find('\n', start) < close)
+				return false;
+
+			const std::string name = text.substr(open + 1, close - open - 1);
+			std::vector<uint8_t> include;
+			if (!ReadFile(directory + name, include))
+				return false;
+			includes.push_back({ name, HashBytes(include.data(), include.size()) });
+			if (text.find('\n', line) == std::string::npos)
+				break;
+		}
+		return true;
+	}
+
+	// Every line of the entry point's body but labels and comments, 0 if it isn't in the listing
+	uint32_t CountInstructions(const std::string& listingName, const char* entryPoint)
+	{
+		FILE* listing = std::fopen(listingName.c_str(), "r");
+		if (!listing)
+			return 0;
+
+		const std::string signature = std::string("@") + entryPoint + "(";
+		uint32_t count = 0;
+		bool inFunction = false;
+		char line[4096];
+		while (std::fgets(line, sizeof(line), listing))
+		{
+			if (!inFunction)
+			{
+				inFunction = std::strncmp(line, "define ", 7) == 0 && std::strstr(line, signature.c_str());
+				continue;
+			}
+			if (line[0] == '}')
+				break;
+
+			const char* text = line + std::strspn(line, " \t");
+			const size_t length = std::strcspn(text, ";\r\n");
+			if (length && text[length - 1] != ':')
+				count++;
+		}
+		std::fclose(listing);
+		return count;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 4)
+	{
+		std::printf("ShaderBuild <dxc> <source> <output directory>\n");
+		return 1;
+	}
+	const std::string dxc = argv[1];
+	const std::filesystem::path sourcePath = argv[2];
+	const std::filesystem::path outputPath = argv[3];
+
+	std::vector<uint8_t> source;
+	std::vector<ShaderCacheInclude> includes;
+	const std::string sourceDirectory = sourcePath.has_parent_path() ? sourcePath.parent_path().string() + "/" : std::string();
+	if (!ReadFile(sourcePath.string(), source) || !FindIncludes(source, sourceDirectory, includes))
+	{
+		std::printf("Couldn't read %s or one of its includes\n", sourcePath.string().c_str());
+		return 1;
+	}
+
+	// Output of an older source would never be loaded again, so it goes
+	std::error_code error;
+	std::filesystem::create_directories(outputPath, error);
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(outputPath, error))
+	{
+		if (entry.path().extension() == ".cso")
+			std::filesystem::remove(entry.path(), error);
+	}
+
+	const std::vector<Shader> shaders = AppShaders();
+	std::vector<std::string> written;
+	const auto compileStart = std::chrono::steady_clock::now();
+	for (const Shader& shader : shaders)
+	{
+		std::vector<D3D_SHADER_MACRO> defines;
+		for (const std::pair<std::string, std::string>& define : shader.Defines)
+			defines.push_back({ define.first.c_str(), define.second.c_str() });
+		defines.push_back({ nullptr, nullptr });
+
+		const uint64_t key = PrebuiltShaderKey(source.data(), source.size(), defines.data(), shader.EntryPoint, shader.Target);
+		const std::string base = (outputPath / ShaderCacheName(key)).string();
+		std::string command = "\"" + dxc + "\" -T " + DxilTarget(shader.Target) + " -E " + shader.EntryPoint;
+		for (const std::pair<std::string, std::string>& define : shader.Defines)
+			command += " -D " + define.first + "=" + define.second;
+		command += " -Fo \"" + base + ".dxil\" -Fre \"" + base + ".refl\" -Fc \"" + base + ".lst\" \"" + sourcePath.string() + "\"";
+
+		std::vector<uint8_t> code, reflection;
+		const bool compiled = std::system(command.c_str()) == 0 && ReadFile(base + ".dxil", code) && !code.empty();
+		ReadFile(base + ".refl", reflection);		// Optional, an older dxc may not write it
+		const uint32_t instructionCount = compiled ? CountInstructions(base + ".lst", shader.EntryPoint) : 0;
+		for (const char* extension : { ".dxil", ".refl", ".lst" })
+			std::filesystem::remove(base + extension, error);
+
+		if (!compiled || !WriteFile(base + ".cso", MakeShaderCacheFile(includes, code.data(), code.size(), reflection.data(),
+			reflection.size(), instructionCount)))
+		{
+			std::printf("%s %s failed: %s\n", shader.EntryPoint, shader.Target, command.c_str());
+			return 1;
+		}
+		written.push_back(base + ".cso");
+	}
+	const double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+
+	// What ShaderCache does on a hit: read, parse, check the includes, copy the code out
+	const auto loadStart = std::chrono::steady_clock::now();
+	size_t loadedBytes = 0;
+	for (const std::string& fileName : written)
+	{
+		std::vector<uint8_t> file, include;
+		ShaderCacheHeader header;
+		std::vector<ShaderCacheInclude> fileIncludes;
+		const uint8_t* code = nullptr;
+		const uint8_t* reflection = nullptr;
+		if (!ReadFile(fileName, file) || !ParseShaderCacheFile(file.data(), file.size(), header, fileIncludes, &code, &reflection))
+		{
+			std::printf("Couldn't load %s back\n", fileName.c_str());
+			return 1;
+		}
+		for (const ShaderCacheInclude& fileInclude : fileIncludes)
+		{
+			if (!ReadFile(sourceDirectory + fileInclude.Name, include) || HashBytes(include.data(), include.size()) != fileInclude.Hash)
+				return 1;
+		}
+		const std::vector<uint8_t> copy(code, code + header.CodeSize);
+		loadedBytes += copy.size();
+	}
+	const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+	std::printf("%s: %zu shaders, %zu KB of DXIL. Compiled with dxc %.1f ms, loaded from %s %.3f ms (%.1f us each)\n",
+		sourcePath.filename().string().c_str(), written.size(), loadedBytes / 1024, compileMs, outputPath.string().c_str(), loadMs,
+		1000.0 * loadMs / written.size());
+	return 0;
+}
@@ -0,0 +1,260 @@
+/**************************************************************
+	Shader Cache
+
+	Compiled shaders on disk, so startup only compiles what
+	changed. Two places are looked in before compiling anything:
+
+	The build's output. When cmake finds dxc, the Shaders target
+	runs ShaderBuild.cpp, which compiles every shader WinMain asks
+	for to DXIL (the 5.x profile taken to 6.0) along with dxc's
+	reflection blob and an instruction count from its listing,
+	into PREBUILT_SHADER_DIR. Only shaders without compile flags
+	are looked up there. It's every shader or none: they share
+	the source, and a pipeline state can't mix DXIL with DXBC.
+
+	The cache directory, filled in by earlier runs. A miss in
+	both compiles with D3DCompile and writes the result out for
+	next time. Writes go to a temporary file first and are moved
+	into place, so two threads or processes compiling the same
+	shader never leave half a file behind.
+
+	Either way a shader is one file named after a hash of
+	everything that goes into compiling it, and lists the
+	includes it was built from with a hash of each. A hit only
+	counts if all of them still hash the same. See
+	ShaderCacheFile.h. Compile() can be called from any thread.
+**************************************************************/
+#pragma once
+#include <Windows.h>
+#include <d3dcompiler.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "ShaderCacheFile.h"
+
+// Where the build's dxc step put its output, see CMakeLists.txt
+#ifdef PREBUILT_SHADER_DIR
+static constexpr const wchar_t* PrebuiltShaderDirectory = PREBUILT_SHADER_DIR;
+#else
+static constexpr const wchar_t* PrebuiltShaderDirectory = nullptr;
+#endif
+
+namespace ShaderCacheDetail
+{
+	inline std::wstring Widen(const char* text)
+	{
+		const int length = MultiByteToWideChar(CP_UTF8, 0, text, -1, nullptr, 0);
+		std::wstring wide(length > 0 ? length - 1 : 0, L'\0');
+		if (length > 1)
+			MultiByteToWideChar(CP_UTF8, 0, text, -1, &wide[0], length);
+		return wide;
+	}
+
+	// Resolves includes next to the source file and remembers what it handed out
+	class IncludeHandler : public ID3DInclude
+	{
+	public:
+		explicit IncludeHandler(const std::wstring& directory) : m_directory(directory) { }
+
+		HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID, LPCVOID* data, UINT* size) override
+		{
+			MappedFile* file = new MappedFile();
+			if (!file->Open((m_directory + Widen(fileName)).c_str()))
+			{
+				delete file;
+				return E_FAIL;
+			}
+
+			m_includes.push_back({ fileName, HashBytes(file->Data(), file->Size()) });
+			m_open.push_back(file);
+			*data = file->Data();
+			*size = static_cast<UINT>(file->Size());
+			return S_OK;
+		}
+
+		HRESULT __stdcall Close(LPCVOID data) override
+		{
+			for (size_t i = 0; i < m_open.size(); i++)
+			{
+				if (m_open[i]->Data() != data)
+					continue;
+				delete m_open[i];
+				m_open.erase(m_open.begin() + i);
+				break;
+			}
+			return S_OK;
+		}
+
+		~IncludeHandler()
+		{
+			for (MappedFile* file : m_open)
+				delete file;
+		}
+
+		const std::vector<ShaderCacheInclude>& GetIncludes() const { return m_includes; }
+
+	private:
+		std::wstring m_directory;
+		std::vector<MappedFile*> m_open;
+		std::vector<ShaderCacheInclude> m_includes;
+	};
+}
+
+// What came with a shader besides its code
+struct ShaderCacheInfo
+{
+	bool Prebuilt;				// DXIL from the build's dxc step, not DXBC compiled here
+	UINT InstructionCount;		// Counted by the build step, 0 for DXBC (D3DReflect that instead)
+	ID3DBlob* Reflection;		// dxc's reflection blob, null for DXBC. The caller releases it.
+};
+
+class ShaderCache
+{
+public:
+	explicit ShaderCache(const wchar_t* directory = L"ShaderCache", const wchar_t* prebuiltDirectory = PrebuiltShaderDirectory)
+		: m_directory(directory), m_prebuiltDirectory(prebuiltDirectory ? prebuiltDirectory : L""), m_prebuiltCount(0), m_hitCount(0),
+		m_missCount(0)
+	{
+		CreateDirectoryW(directory, nullptr);
+	}
+
+	ShaderCache(const ShaderCache&) = delete;
+	ShaderCache& operator=(const ShaderCache&) = delete;
+
+	// Same as D3DCompileFromFile with the standard include handler, except that
+	// includes are only looked for in the source file's directory
+	HRESULT Compile(const wchar_t* fileName, const D3D_SHADER_MACRO* defines, const char* entryPoint, const char* target, UINT flags,
+		ID3DBlob** code, ShaderCacheInfo* info = nullptr)
+	{
+		*code = nullptr;
+		if (info)
+			*info = {};
+
+		MappedFile source;
+		if (!source.Open(fileName))
+			return HRESULT_FROM_WIN32(GetLastError());
+
+		const std::wstring sourceDirectory = DirectoryOf(fileName);
+		if (!m_prebuiltDirectory.empty() && !flags && !DxilTarget(target).empty())
+		{
+			const uint64_t prebuiltKey = PrebuiltShaderKey(source.Data(), source.Size(), defines, entryPoint, target);
+			if (Load(m_prebuiltDirectory + L"\\" + Widen(ShaderCacheName(prebuiltKey)) + L".cso", sourceDirectory, code, info))
+			{
+				if (info)
+					info->Prebuilt = true;
+				m_prebuiltCount++;
+				return S_OK;
+			}
+		}
+
+		const uint64_t key = ShaderCacheKey(source.Data(), source.Size(), defines, entryPoint, target, flags, D3D_COMPILER_VERSION);
+		const std::wstring cachePath = m_directory + L"\\" + Widen(ShaderCacheName(key)) + L".cso";
+		if (Load(cachePath, sourceDirectory, code, nullptr))
+		{
+			m_hitCount++;
+			return S_OK;
+		}
+		m_missCount++;
+
+		ShaderCacheDetail::IncludeHandler includes(sourceDirectory);
+		const std::string sourceName(fileName, fileName + wcslen(fileName));		// Only for error messages
+		ID3DBlob* errors = nullptr;
+		HRESULT hr = D3DCompile(source.Data(), source.Size(), sourceName.c_str(), defines, &includes, entryPoint, target, flags, 0, code, &errors);
+		if (errors)
+		{
+			OutputDebugString(static_cast<const char*>(errors->GetBufferPointer()));
+			errors->Release();
+		}
+		if (FAILED(hr))
+			return hr;
+
+		// Not being able to write the cache only costs the next run some time
+		Save(cachePath, includes.GetIncludes(), *code);
+		return S_OK;
+	}
+
+	UINT GetPrebuiltCount() const { return m_prebuiltCount; }
+	UINT GetHitCount() const { return m_hitCount; }
+	UINT GetMissCount() const { return m_missCount; }
+
+private:
+	static std::wstring Widen(const std::string& text) { return ShaderCacheDetail::Widen(text.c_str()); }
+
+	static std::wstring DirectoryOf(const wchar_t* fileName)
+	{
+		const wchar_t* slash = wcsrchr(fileName, L'\\');
+		const wchar_t* forwardSlash = wcsrchr(fileName, L'/');
+		if (!slash || (forwardSlash && forwardSlash > slash))
+			slash = forwardSlash;
+		return slash ? std::wstring(fileName, slash + 1) : std::wstring();
+	}
+
+	// 'info' is only filled in if it's given, the reflection blob with it
+	static bool Load(const std::wstring& cachePath, const std::wstring& sourceDirectory, ID3DBlob** code, ShaderCacheInfo* info)
+	{
+		MappedFile file;
+		if (!file.Open(cachePath.c_str()))
+			return false;
+
+		ShaderCacheHeader header;
+		std::vector<ShaderCacheInclude> includes;
+		const uint8_t* codeData = nullptr;
+		const uint8_t* reflectionData = nullptr;
+		if (!ParseShaderCacheFile(file.Data(), file.Size(), header, includes, &codeData, &reflectionData))
+			return false;
+
+		for (const ShaderCacheInclude& include : includes)
+		{
+			MappedFile includeFile;
+			if (!includeFile.Open((sourceDirectory + Widen(include.Name)).c_str())
+				|| HashBytes(includeFile.Data(), includeFile.Size()) != include.Hash)
+				return false;
+		}
+
+		ID3DBlob* reflection = nullptr;
+		if (info && reflectionData && FAILED(D3DCreateBlob(header.ReflectionSize, &reflection)))
+			return false;
+		if (FAILED(D3DCreateBlob(header.CodeSize, code)))
+		{
+			if (reflection)
+				reflection->Release();
+			return false;
+		}
+		memcpy((*code)->GetBufferPointer(), codeData, header.CodeSize);
+
+		if (info)
+		{
+			if (reflection)
+				memcpy(reflection->GetBufferPointer(), reflectionData, header.ReflectionSize);
+			info->InstructionCount = header.InstructionCount;
+			info->Reflection = reflection;
+		}
+		return true;
+	}
+
+	static void Save(const std::wstring& cachePath, const std::vector<ShaderCacheInclude>& includes, ID3DBlob* code)
+	{
+		const std::wstring tempPath = cachePath + L"." + std::to_wstring(GetCurrentThreadId()) + L".tmp";
+		FILE* file = _wfopen(tempPath.c_str(), L"wb");
+		if (!file)
+			return;
+
+		const std::vector<uint8_t> bytes = MakeShaderCacheFile(includes, code->GetBufferPointer(), code->GetBufferSize());
+		bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		written = fclose(file) == 0 && written;
+
+		if (!written || !MoveFileExW(tempPath.c_str(), cachePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+			DeleteFileW(tempPath.c_str());
+	}
+
+	std::wstring m_directory;
+	std::wstring m_prebuiltDirectory;		// Empty without a dxc step
+	std::atomic<UINT> m_prebuiltCount;
+	std::atomic<UINT> m_hitCount;
+	std::atomic<UINT> m_missCount;
+};
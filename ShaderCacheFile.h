@@ -0,0 +1,140 @@
+/**************************************************************
+	Shader Cache File
+
+	What ShaderCache and the build's dxc step (ShaderBuild.cpp)
+	agree on, without a compiler or Windows: the key a shader is
+	cached under, the file it's cached in, and the shader model 6
+	profile a prebuilt shader is compiled to.
+
+	A key is a hash of everything that goes into compiling the
+	shader except its includes. Those are listed in the file with
+	a hash of each, and checked when it's loaded.
+
+	The file is a header, the includes (hash, name length, name),
+	the code, then the reflection blob if the build step wrote
+	one. Everything little endian, as written.
+**************************************************************/
+#pragma once
+#include <d3dcommon.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ContentHash.h"
+
+struct ShaderCacheHeader
+{
+	uint32_t Magic;
+	uint32_t IncludeCount;
+	uint32_t CodeSize;
+	uint32_t ReflectionSize;		// 0 for DXBC, its reflection is part of the code
+	uint32_t InstructionCount;		// Counted by the build step from dxc's listing, 0 for DXBC
+};
+
+static constexpr uint32_t ShaderCacheMagic = 0x32434853;	// "SHC2"
+
+// Stands in for D3D_COMPILER_VERSION in the keys of prebuilt shaders. Bump it when
+// ShaderBuild.cpp changes how it calls dxc, so old output stops matching.
+static constexpr uint32_t ShaderBuildVersion = 1;
+
+struct ShaderCacheInclude
+{
+	std::string Name;
+	uint64_t Hash;
+};
+
+inline uint64_t ShaderCacheKey(const void* source, size_t sourceSize, const D3D_SHADER_MACRO* defines, const char* entryPoint,
+	const char* target, uint32_t flags, uint32_t compilerVersion)
+{
+	uint64_t key = HashBytes(source, sourceSize);
+	for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++)
+	{
+		key = HashString(define->Name, key);
+		key = HashString(define->Definition ? define->Definition : "", key);
+	}
+	key = HashString(entryPoint, key);
+	key = HashString(target, key);
+	key = HashValue(flags, key);
+	return HashValue(compilerVersion, key);
+}
+
+// The file name, without the extension
+inline std::string ShaderCacheName(uint64_t key)
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	return name;
+}
+
+// The shader model 6 profile the build step compiles a 5.x one to, "vs_5_1" to
+// "vs_6_0". Empty for anything else, those are never prebuilt.
+inline std::string DxilTarget(const char* target)
+{
+	if (std::strlen(target) != 6 || target[2] != '_' || target[3] != '5' || target[4] != '_')
+		return std::string();
+	return std::string(target, 2) + "_6_0";
+}
+
+// The key the build step writes a shader under, and the one ShaderCache looks for
+// when it's asked for the same source, defines, entry point and 5.x profile
+inline uint64_t PrebuiltShaderKey(const void* source, size_t sourceSize, const D3D_SHADER_MACRO* defines, const char* entryPoint,
+	const char* target)
+{
+	return ShaderCacheKey(source, sourceSize, defines, entryPoint, DxilTarget(target).c_str(), 0, ShaderBuildVersion);
+}
+
+inline std::vector<uint8_t> MakeShaderCacheFile(const std::vector<ShaderCacheInclude>& includes, const void* code, size_t codeSize,
+	const void* reflection = nullptr, size_t reflectionSize = 0, uint32_t instructionCount = 0)
+{
+	const ShaderCacheHeader header = { ShaderCacheMagic, static_cast<uint32_t>(includes.size()), static_cast<uint32_t>(codeSize),
+		static_cast<uint32_t>(reflectionSize), instructionCount };
+	std::vector<uint8_t> file(reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header + 1));
+	for (const ShaderCacheInclude& include : includes)
+	{
+		const uint32_t nameLength = static_cast<uint32_t>(include.Name.size());
+		file.insert(file.end(), reinterpret_cast<const uint8_t*>(&include.Hash), reinterpret_cast<const uint8_t*>(&include.Hash + 1));
+		file.insert(file.end(), reinterpret_cast<const uint8_t*>(&nameLength), reinterpret_cast<const uint8_t*>(&nameLength + 1));
+		file.insert(file.end(), include.Name.begin(), include.Name.end());
+	}
+	file.insert(file.end(), static_cast<const uint8_t*>(code), static_cast<const uint8_t*>(code) + codeSize);
+	if (reflectionSize)
+		file.insert(file.end(), static_cast<const uint8_t*>(reflection), static_cast<const uint8_t*>(reflection) + reflectionSize);
+	return file;
+}
+
+// False unless the sizes add up to exactly 'size'. 'code' and 'reflection' point into 'data'.
+inline bool ParseShaderCacheFile(const uint8_t* data, size_t size, ShaderCacheHeader& header, std::vector<ShaderCacheInclude>& includes,
+	const uint8_t** code, const uint8_t** reflection)
+{
+	includes.clear();
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.Magic != ShaderCacheMagic)
+		return false;
+
+	const uint8_t* at = data + sizeof(header);
+	const uint8_t* end = data + size;
+	for (uint32_t include = 0; include < header.IncludeCount; include++)
+	{
+		uint64_t hash;
+		uint32_t nameLength;
+		if (static_cast<size_t>(end - at) < sizeof(hash) + sizeof(nameLength))
+			return false;
+		memcpy(&hash, at, sizeof(hash));
+		memcpy(&nameLength, at + sizeof(hash), sizeof(nameLength));
+		at += sizeof(hash) + sizeof(nameLength);
+		if (static_cast<size_t>(end - at) < nameLength)
+			return false;
+
+		includes.push_back({ std::string(reinterpret_cast<const char*>(at), nameLength), hash });
+		at += nameLength;
+	}
+
+	if (static_cast<uint64_t>(end - at) != uint64_t(header.CodeSize) + header.ReflectionSize)
+		return false;
+	*code = at;
+	*reflection = header.ReflectionSize ? at + header.CodeSize : nullptr;
+	return true;
+}
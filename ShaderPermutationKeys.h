@@ -0,0 +1,106 @@
+/**************************************************************
+	Shader Permutation Keys
+
+	The options of a shader compiled once per combination of a
+	few defines, and the keys naming each combination. Each
+	define is an option with a small range of values, and a
+	permutation's key is its values packed mixed radix, option 0
+	the least significant. Keys run from 0 to
+	GetPermutationCount() - 1 with no gaps.
+
+	No compiler in here, ShaderPermutations compiles the keys
+	with FXC and the permutation report runs them through dxc.
+	PSMain's options are listed once at the bottom, for both.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ShaderPermutationKeys
+{
+public:
+	// 'define' takes the values 'firstValue' to 'firstValue + valueCount - 1'.
+	// Returns the option's index, for GetValue() and WithValue().
+	uint32_t AddOption(const char* define, uint32_t valueCount, uint32_t firstValue = 0)
+	{
+		m_options.push_back({ define, valueCount, firstValue });
+		return static_cast<uint32_t>(m_options.size() - 1);
+	}
+
+	uint32_t GetOptionCount() const { return static_cast<uint32_t>(m_options.size()); }
+	const char* GetDefine(uint32_t option) const { return m_options[option].Define; }
+
+	uint32_t GetPermutationCount() const
+	{
+		uint32_t count = 1;
+		for (const Option& option : m_options)
+			count *= option.ValueCount;
+		return count;
+	}
+
+	// 'values' has one value per option, in the order they were added
+	uint32_t GetKey(const uint32_t* values) const
+	{
+		uint32_t key = 0;
+		for (size_t option = m_options.size(); option-- > 0;)
+			key = key * m_options[option].ValueCount + (values[option] - m_options[option].FirstValue);
+		return key;
+	}
+
+	uint32_t GetValue(uint32_t key, uint32_t option) const
+	{
+		for (uint32_t i = 0; i < option; i++)
+			key /= m_options[i].ValueCount;
+		return key % m_options[option].ValueCount + m_options[option].FirstValue;
+	}
+
+	// 'key' with one option changed
+	uint32_t WithValue(uint32_t key, uint32_t option, uint32_t value) const
+	{
+		uint32_t stride = 1;
+		for (uint32_t i = 0; i < option; i++)
+			stride *= m_options[i].ValueCount;
+		return key - (GetValue(key, option) - value) * stride;
+	}
+
+	// "TEXTURE=1 SPECULAR=0", for the log
+	std::string GetName(uint32_t key) const
+	{
+		std::string name;
+		for (uint32_t option = 0; option < m_options.size(); option++)
+			name += (option ? " " : "") + std::string(m_options[option].Define) + "=" + std::to_string(GetValue(key, option));
+		return name;
+	}
+
+private:
+	struct Option
+	{
+		const char* Define;
+		uint32_t ValueCount;
+		uint32_t FirstValue;
+	};
+
+	std::vector<Option> m_options;
+};
+
+// PSMain's options in Shaders.hlsl, in the order their keys are packed
+enum PixelShaderOption : uint32_t
+{
+	PIXEL_SHADER_HALF_PRECISION,
+	PIXEL_SHADER_TEXTURE,
+	PIXEL_SHADER_SPECULAR,
+	PIXEL_SHADER_LIGHT_COUNT,
+	PIXEL_SHADER_OPTION_COUNT
+};
+
+// Lights besides the one the cubes orbit, PSMain variants use up to all of them
+static constexpr uint32_t PixelShaderFillLightCount = 3;
+
+inline void AddPixelShaderOptions(ShaderPermutationKeys& keys)
+{
+	keys.AddOption("HALF_PRECISION", 2);
+	keys.AddOption("TEXTURE", 2);
+	keys.AddOption("SPECULAR", 2);
+	keys.AddOption("LIGHT_COUNT", 1 + PixelShaderFillLightCount, 1);
+}
@@ -0,0 +1,121 @@
+/**************************************************************
+	Shader Permutations
+
+	One shader source compiled for every combination of a few
+	defines. The options and keys are ShaderPermutationKeys',
+	keys run from 0 to GetPermutationCount() - 1 with no gaps, so
+	the index from key to bytecode is a plain array.
+
+	Every variant is reflected after it's compiled for its
+	instruction and temp register counts, so code choosing
+	between variants that all look good enough can take the
+	cheapest. The counts are for the DXBC, the driver compiles
+	it again, but they rank variants of one shader well enough.
+	Prebuilt DXIL comes with the count the build step took from
+	dxc's listing instead, and no temp register count.
+
+	Compiling goes through the ShaderCache, after the first run
+	only the variants whose source changed are compiled again.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <d3d12shader.h>
+#include <d3dcompiler.h>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+#include "ShaderPermutationKeys.h"
+
+class ShaderPermutations : public ShaderPermutationKeys
+{
+public:
+	struct Variant
+	{
+		ID3DBlob* Code;
+		ID3DBlob* Reflection;		// dxc's, for prebuilt DXIL only
+		UINT InstructionCount;
+		UINT TempRegisterCount;
+	};
+
+	ShaderPermutations() = default;
+	ShaderPermutations(const ShaderPermutations&) = delete;
+	ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+	~ShaderPermutations()
+	{
+		for (Variant& variant : m_variants)
+		{
+			if (variant.Code)
+				variant.Code->Release();
+			if (variant.Reflection)
+				variant.Reflection->Release();
+		}
+	}
+
+	// Compiles 'entryPoint' once per permutation. Stops at the first one that fails.
+	HRESULT Compile(ShaderCache& cache, const wchar_t* fileName, const char* entryPoint, const char* target, UINT flags)
+	{
+		m_variants.assign(GetPermutationCount(), Variant());
+
+		std::vector<std::string> values(GetOptionCount());
+		std::vector<D3D_SHADER_MACRO> defines(GetOptionCount() + 1);
+		for (uint32_t key = 0; key < m_variants.size(); key++)
+		{
+			for (uint32_t option = 0; option < GetOptionCount(); option++)
+			{
+				values[option] = std::to_string(GetValue(key, option));
+				defines[option] = { GetDefine(option), values[option].c_str() };
+			}
+			defines.back() = { nullptr, nullptr };
+
+			Variant& variant = m_variants[key];
+			ShaderCacheInfo info;
+			HRESULT hr = cache.Compile(fileName, defines.data(), entryPoint, target, flags, &variant.Code, &info);
+			if (FAILED(hr))
+				return hr;
+
+			variant.Reflection = info.Reflection;
+			if (info.Prebuilt)
+			{
+				variant.InstructionCount = info.InstructionCount;
+				variant.TempRegisterCount = 0;
+				continue;
+			}
+
+			// Counts are only for choosing, a shader that can't be reflected still works
+			ID3D12ShaderReflection* reflection = nullptr;
+			D3D12_SHADER_DESC desc = {};
+			if (SUCCEEDED(D3DReflect(variant.Code->GetBufferPointer(), variant.Code->GetBufferSize(), IID_ID3D12ShaderReflection,
+				reinterpret_cast<void**>(&reflection))))
+			{
+				reflection->GetDesc(&desc);
+				reflection->Release();
+			}
+			variant.InstructionCount = desc.InstructionCount;
+			variant.TempRegisterCount = desc.TempRegisterCount;
+		}
+		return S_OK;
+	}
+
+	const Variant& GetVariant(uint32_t key) const { return m_variants[key]; }
+
+	D3D12_SHADER_BYTECODE GetBytecode(uint32_t key) const
+	{
+		return { m_variants[key].Code->GetBufferPointer(), m_variants[key].Code->GetBufferSize() };
+	}
+
+	// The one of 'keys' with the fewest instructions, the earliest of them on a tie
+	uint32_t GetCheapest(const uint32_t* keys, uint32_t count) const
+	{
+		uint32_t cheapest = keys[0];
+		for (uint32_t i = 1; i < count; i++)
+		{
+			if (m_variants[keys[i]].InstructionCount < m_variants[cheapest].InstructionCount)
+				cheapest = keys[i];
+		}
+		return cheapest;
+	}
+
+private:
+	std::vector<Variant> m_variants;
+};
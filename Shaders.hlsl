@@ -8,61 +8,173 @@ cbuffer PSConstantBuffer : register(b0)
 {
     matrix World;
     matrix Model;
+    matrix ViewProj;
     
     Light light;
+    Light fillLights[3];    // Lights after the first for PSMain's LIGHT_COUNT, must match PixelShaderFillLightCount in ShaderPermutationKeys.h
     
     float4 Eye;
+    
+    float4 Upscale;     // PSUpscale only. xy: part of the scene target drawn to, zw: its texel size
+    
+    uint Material;      // Slot of the material's texture in the bindless heap
 }
+
+// Per instance data for VSMainInstanced, and per draw for VSMain. Must match InstanceData in Instancing.h
+struct InstanceData
+{
+    matrix Model;
+    float4 Color;
+    uint Material;
+};
+
 struct Layout
 {
     float4 position : SV_POSITION;
     float2 texCoord : TEXCOORD;
     float3 normal : NORMAL;
     float3 fragPos : FRAG;
+    nointerpolation float4 lightColor : COLOR;
+    nointerpolation uint material : MATERIAL;
 };
 
 SamplerState sample : register(s0);
-Texture2D tex : register(t0);
+SamplerState upscaleSampler : register(s1);      // Linear, clamped
+Texture2D textures[] : register(t0, space1);     // The whole bindless heap
+StructuredBuffer<InstanceData> instances : register(t1);
 
-Layout VSMain(float3 pos : POSITION, float2 texCoord : TEXCOORD, float3 normal : NORMAL)
+// The cube at 'pos' placed by 'instance', ViewProj is the same for every draw
+Layout PlaceInstance(float3 pos, float2 texCoord, float3 normal, InstanceData instance)
 {
     Layout layout;
-    layout.position = mul(float4(pos, 1.0f), World);
+    float4 worldPos = mul(float4(pos, 1.0f), instance.Model);
+    layout.position = mul(worldPos, ViewProj);
     layout.texCoord = texCoord;
-    layout.normal = mul(normal, (float3x3)Model);
-    layout.fragPos = mul(float4(pos, 1.0f), Model).xyz;
-        
+    layout.normal = mul(normal, (float3x3)instance.Model);
+    layout.fragPos = worldPos.xyz;
+    layout.lightColor = instance.Color;
+    layout.material = instance.Material;
+    
     return layout;
 }
 
-float4 PSMain(Layout layout) : SV_TARGET
+// How VSMain gets its draw's InstanceData, must match DrawBinding in DrawBinding.h
+#define BINDING_ROOT_CONSTANTS 0
+#define BINDING_ROOT_CBV 1
+#define BINDING_STRUCTURED_BUFFER 2
+#ifndef BINDING
+#define BINDING BINDING_ROOT_CBV
+#endif
+
+#if BINDING == BINDING_STRUCTURED_BUFFER
+cbuffer DrawIndex : register(b1)
 {
-    float4 diffuseAlbedo = float4(0.2f, 0.2f, 0.2f, 1.0f);
-    
-    float3 totalLight = float3(0.0f, 0.0f, 0.0f);
-    
-    float4 pixelColor = tex.Sample(sample, layout.texCoord);
-    
-    float3 attenuation = length(light.Position.xyz - layout.fragPos);
-    
-    // Diffuse
-    float3 diffuse = float3(0.0f, 0.0f, 0.0f), specular = float3(0.0f, 0.0f, 0.0f);
-    float3 norm = normalize(layout.normal);
-    float3 lightDir = normalize(light.Position.xyz - layout.fragPos);
-    float3 diff = max(dot(norm, lightDir), 0.0f) / (attenuation);
+    uint drawIndex;     // Into this command list's part of 'instances'
+}
+#else
+ConstantBuffer<InstanceData> draw : register(b1);     // Root constants or a root CBV, the shader can't tell
+#endif
+
+// One cube per draw, the per frame data stays in PSConstantBuffer
+Layout VSMain(float3 pos : POSITION, float2 texCoord : TEXCOORD, float3 normal : NORMAL)
+{
+#if BINDING == BINDING_STRUCTURED_BUFFER
+    return PlaceInstance(pos, texCoord, normal, instances[drawIndex]);
+#else
+    return PlaceInstance(pos, texCoord, normal, draw);
+#endif
+}
+
+// Same as VSMain, but every cube is drawn with one DrawIndexedInstanced call
+Layout VSMainInstanced(float3 pos : POSITION, float2 texCoord : TEXCOORD, float3 normal : NORMAL, uint instanceID : SV_InstanceID)
+{
+    return PlaceInstance(pos, texCoord, normal, instances[instanceID]);
+}
+
+// PSMain is compiled once per combination of these, see the permutations in
+// WinMain.cpp. Without any defines it's the full precision, textured, specular,
+// one light version.
+#ifndef TEXTURE
+#define TEXTURE 1
+#endif
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+#ifndef HALF_PRECISION
+#define HALF_PRECISION 0
+#endif
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 1
+#endif
+
+// Positions stay 32 bit either way, only the lighting math drops to 16
+#if HALF_PRECISION
+typedef min16float real;
+typedef min16float3 real3;
+typedef min16float4 real4;
+#else
+typedef float real;
+typedef float3 real3;
+typedef float4 real4;
+#endif
+
+// Diffuse and specular from one light, both falling off with distance
+real3 Shade(float3 lightPos, real3 lightColor, float3 fragPos, real3 norm, real3 viewDir)
+{
+    float3 toLight = lightPos - fragPos;
+    real attenuation = (real)length(toLight);
+    real3 lightDir = (real3)normalize(toLight);
     
-    diffuse = (diff * light.Color.xyz);
+    real3 result = max(dot(norm, lightDir), (real)0.0f) * lightColor;
+#if SPECULAR
+    real3 reflectDir = reflect(-lightDir, norm);
+    result += pow(max(dot(viewDir, reflectDir), (real)0.0f), 32) * lightColor;
+#endif
+    return result / attenuation;
+}
+
+float4 PSMain(Layout layout) : SV_TARGET
+{
+    real3 norm = (real3)normalize(layout.normal);
+    real3 viewDir = (real3)normalize(Eye.xyz - layout.fragPos);
     
-    // Specular
-    float3 viewDir = normalize(Eye.xyz - layout.fragPos);
-    float3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0f), 32) / (attenuation);
-    specular = (1.0f * spec * light.Color.xyz);
+    // Ambient, then the light the cube orbits, then the fill lights
+    real3 totalLight = 0.2f;
+    totalLight += Shade(light.Position.xyz, (real3)layout.lightColor.xyz, layout.fragPos, norm, viewDir);
+    [unroll]
+    for (uint i = 1; i < LIGHT_COUNT; i++)
+        totalLight += Shade(fillLights[i - 1].Position.xyz, (real3)fillLights[i - 1].Color.xyz, layout.fragPos, norm, viewDir);
     
+#if TEXTURE
+    // Instances of one draw can use different materials
+    real4 pixelColor = (real4)textures[NonUniformResourceIndex(layout.material)].Sample(sample, layout.texCoord);
+#else
+    real4 pixelColor = 1.0f;
+#endif
+    return pixelColor * real4(totalLight, 1.0f);
+}
 
+struct UpscaleLayout
+{
+    float4 position : SV_POSITION;
+    float2 texCoord : TEXCOORD;
+};
+
+// One triangle that covers the whole back buffer, no vertex buffer needed
+UpscaleLayout VSUpscale(uint vertexID : SV_VertexID)
+{
+    float2 corner = float2((vertexID << 1) & 2, vertexID & 2);
     
-    totalLight = diffuseAlbedo.xyz + diffuse + specular;
-    
-   
-    return pixelColor * float4(totalLight, 1.0f);
-}
\ No newline at end of file
+    UpscaleLayout layout;
+    layout.position = float4(corner * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    layout.texCoord = corner * Upscale.xy;
+    return layout;
+}
+
+// Stretches the part of the scene target this frame drew to over the back buffer
+float4 PSUpscale(UpscaleLayout layout) : SV_TARGET
+{
+    // Half a texel in from the edge, or the bilinear filter pulls in what's outside it
+    float2 texCoord = min(layout.texCoord, Upscale.xy - 0.5f * Upscale.zw);
+    return textures[Material].Sample(upscaleSampler, texCoord);
+}
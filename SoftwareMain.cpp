@@ -0,0 +1,205 @@
+/**************************************************************
+	Software renderer
+
+	Draws the app's cube scene on the cpu rasterizer, no window and
+	no device, and reports its throughput as the cube count grows:
+
+		SoftwareMain [frames per size, 100 by default]
+
+	Same cube, light and checkboard.dds as WinMain. The cubes are
+	laid out in a square grid around the light, and the camera
+	looks from WinMain's direction but backs off until the whole
+	grid is in the frustum, so every cube is drawn at every size.
+	The 2 cube scene is saved to software.bmp to compare against a
+	gpu capture. Builds anywhere the rasterizer does.
+**************************************************************/
+#include <DirectXMath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "BatchTransform.h"
+#include "DDSParser.h"
+#include "MappedFile.h"
+#include "SoftwareRasterizer.h"
+
+namespace
+{
+	const float CubeSpacing = 1.5f;				// Center to center, the cubes are 1 across
+	const float FieldOfView = 45.0f;			// Vertical, the narrower one at 4:3
+
+	// WinMain's RandomColors
+	const DirectX::XMFLOAT4 LightColors[20] =
+	{
+		{ 0.000000f, 0.000000f, 1.000000f, 1.0f },	// Blue
+		{ 0.000000f, 0.392157f, 0.000000f, 1.0f },	// DarkGreen
+		{ 0.000000f, 1.000000f, 1.000000f, 1.0f },	// Aqua
+		{ 1.000000f, 0.843137f, 0.000000f, 1.0f },	// Gold
+		{ 0.576471f, 0.439216f, 0.858824f, 1.0f },	// MediumPurple
+
+		{ 0.901961f, 0.901961f, 0.980392f, 1.0f },	// Lavender
+		{ 0.901961f, 0.901961f, 0.980392f, 1.0f },	// Lavender
+		{ 0.000000f, 0.807843f, 0.819608f, 1.0f },	// DarkTurquoise
+		{ 0.000000f, 0.807843f, 0.819608f, 1.0f },	// DarkTurquoise
+		{ 0.000000f, 1.000000f, 1.000000f, 1.0f },	// Cyan
+
+		{ 0.133333f, 0.545098f, 0.133333f, 1.0f },	// ForestGreen
+		{ 0.960784f, 0.870588f, 0.701961f, 1.0f },	// Wheat
+		{ 0.866667f, 0.627451f, 0.866667f, 1.0f },	// Plum
+		{ 1.000000f, 0.388235f, 0.278431f, 1.0f },	// Tomato
+		{ 0.752941f, 0.752941f, 0.752941f, 1.0f },	// Silver
+
+		{ 1.000000f, 0.270588f, 0.000000f, 1.0f },	// OrangeRed
+		{ 0.933333f, 0.509804f, 0.933333f, 1.0f },	// Violet
+		{ 0.254902f, 0.411765f, 0.882353f, 1.0f },	// RoyalBlue
+		{ 0.196078f, 0.803922f, 0.196078f, 1.0f },	// LimeGreen
+		{ 1.000000f, 0.894118f, 0.768627f, 1.0f },	// Bisque
+	};
+
+	SoftwareVertex MakeVertex(float px, float py, float pz, float u, float v, float nx, float ny, float nz)
+	{
+		SoftwareVertex vertex;
+		vertex.Position = DirectX::XMFLOAT3(px, py, pz);
+		vertex.TexCoord = DirectX::XMFLOAT2(u, v);
+		vertex.Normal = DirectX::XMFLOAT3(nx, ny, nz);
+		return vertex;
+	}
+
+	// The cube in WinMain's vertex and index buffers
+	const SoftwareVertex CubeVertices[24] =
+	{
+		MakeVertex(-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f),
+		MakeVertex(-0.5f, +0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f),
+		MakeVertex(+0.5f, +0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f),
+		MakeVertex(+0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, 0.0f, -1.0f),
+
+		MakeVertex(-0.5f, -0.5f, +0.5f, 1.0f, 1.0f, 0.0f, 0.0f, +1.0f),
+		MakeVertex(+0.5f, -0.5f, +0.5f, 0.0f, 1.0f, 0.0f, 0.0f, +1.0f),
+		MakeVertex(+0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, 0.0f, +1.0f),
+		MakeVertex(-0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, 0.0f, +1.0f),
+
+		MakeVertex(-0.5f, +0.5f, -0.5f, 0.0f, 1.0f, 0.0f, +1.0f, 0.0f),
+		MakeVertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, +1.0f, 0.0f),
+		MakeVertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, +1.0f, 0.0f),
+		MakeVertex(+0.5f, +0.5f, -0.5f, 1.0f, 1.0f, 0.0f, +1.0f, 0.0f),
+
+		MakeVertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, -1.0f, 0.0f),
+		MakeVertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f),
+		MakeVertex(+0.5f, -0.5f, +0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f),
+		MakeVertex(-0.5f, -0.5f, +0.5f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f),
+
+		MakeVertex(-0.5f, -0.5f, +0.5f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f),
+		MakeVertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f),
+		MakeVertex(-0.5f, +0.5f, -0.5f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f),
+		MakeVertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f),
+
+		MakeVertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, +1.0f, 0.0f, 0.0f),
+		MakeVertex(+0.5f, +0.5f, -0.5f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f),
+		MakeVertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, +1.0f, 0.0f, 0.0f),
+		MakeVertex(+0.5f, -0.5f, +0.5f, 1.0f, 1.0f, +1.0f, 0.0f, 0.0f),
+	};
+
+	const uint16_t CubeIndices[36] =
+	{
+		0, 1, 2, 0, 2, 3,			// Front
+		4, 5, 6, 4, 6, 7,			// Back
+		8, 9, 10, 8, 10, 11,		// Top
+		12, 13, 14, 12, 14, 15,		// Bottom
+		16, 17, 18, 16, 18, 19,		// Left
+		20, 21, 22, 20, 22, 23,		// Right
+	};
+
+#if defined(_WIN32)
+	const MappedFile::PathChar* TextureFileName = L"checkboard.dds";
+#else
+	const MappedFile::PathChar* TextureFileName = "checkboard.dds";
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int frames = argc > 1 ? (unsigned int)atoi(argv[1]) : 0;
+	if (frames == 0)
+		frames = 100;
+
+	SoftwareTexture texture;
+	MappedFile textureFile;
+	DirectX::DDSTextureDesc textureDesc;
+	std::vector<DirectX::DDSSubresource> textureSubresources;
+	const bool textured = textureFile.Open(TextureFileName)
+		&& DirectX::ParseDDSTexture(textureFile.Data(), textureFile.Size(), 0, textureDesc, textureSubresources) == DirectX::DDS_PARSE_OK
+		&& LoadSoftwareTexture(textureDesc, textureSubresources[0], texture);
+	if (!textured)
+		std::printf("Couldn't load checkboard.dds, drawing untextured\n");
+
+	// The direction of the outer camera WinMain starts with, yaw -90 and pitch 30 degrees
+	const float yaw = DirectX::XMConvertToRadians(-90.0f), pitch = DirectX::XMConvertToRadians(30.0f);
+	const DirectX::XMFLOAT4 focus(0.0f, 0.0f, 0.0f, 1.0f);
+	const DirectX::XMFLOAT4 up(0.0f, 1.0f, 0.0f, 1.0f);
+	const DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(FieldOfView), 4.0f / 3.0f, 0.1f, 300.0f);
+
+	WorkerPool workers;
+	SoftwareRasterizer software(800, 600, workers);
+	const float clearColor[] = { 0.0f, 0.0f, 0.2f, 1.0f };
+
+	TransformSoA cubes;
+	const unsigned int sceneSizes[] = { 2, 16, 128, 1024 };
+	for (unsigned int cubeCount : sceneSizes)
+	{
+		// An even number of columns, so no cube sits on the light in the middle
+		unsigned int columns = (unsigned int)ceilf(sqrtf(float(cubeCount)));
+		columns += columns & 1;
+		const unsigned int rows = (cubeCount + columns - 1) / columns;
+
+		std::vector<DirectX::XMFLOAT4X4> world(cubeCount), model(cubeCount);
+		cubes.Resize(cubeCount);
+		for (unsigned int cube = 0; cube < cubeCount; cube++)
+		{
+			cubes.PositionX[cube] = CubeSpacing * ((cube % columns) - 0.5f * (columns - 1));
+			cubes.PositionY[cube] = 0.0f;
+			cubes.PositionZ[cube] = CubeSpacing * ((cube / columns) - 0.5f * (rows - 1));
+			cubes.RotationY[cube] = 0.0f;
+		}
+
+		// Far enough that a sphere around the grid and the cubes' corners fits the vertical field of view,
+		// never closer than WinMain's 5 units
+		const float gridRadius = 0.5f * CubeSpacing * sqrtf(float((columns - 1) * (columns - 1) + (rows - 1) * (rows - 1))) + 0.87f;
+		const float distance = std::max(5.0f, gridRadius / sinf(DirectX::XMConvertToRadians(0.5f * FieldOfView)));
+		const DirectX::XMFLOAT4 eye(distance * cosf(yaw) * cosf(pitch), distance * sinf(pitch), distance * sinf(yaw) * cosf(pitch), 1.0f);
+		const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat4(&eye), DirectX::XMLoadFloat4(&focus), DirectX::XMLoadFloat4(&up));
+		BatchTransform(cubes, view * proj, { world.data(), sizeof(DirectX::XMFLOAT4X4), model.data(), sizeof(DirectX::XMFLOAT4X4) });
+
+		std::vector<SoftwareConstants> constants(cubeCount);
+		for (unsigned int cube = 0; cube < cubeCount; cube++)
+		{
+			constants[cube].World = world[cube];
+			constants[cube].Model = model[cube];
+			DirectX::XMStoreFloat4x4(&constants[cube].ViewProj, DirectX::XMMatrixTranspose(view * proj));
+			constants[cube].LightPosition = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+			constants[cube].LightColor = LightColors[(cube * 9) % 20];
+			constants[cube].Eye = eye;
+		}
+
+		software.ResetStats();
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			software.Clear(clearColor);
+			for (unsigned int cube = 0; cube < cubeCount; cube++)
+				software.DrawIndexed(CubeVertices, CubeIndices, 36, constants[cube], textured ? &texture : nullptr);
+			software.Flush();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const SoftwareStats& stats = software.GetStats();
+		std::printf("Software, %u cubes: %.3f ms/frame, %.1f Mpixels/s, %.0f triangles/s (%llu of %llu rasterized)\n", cubeCount,
+			1000.0 * seconds / frames, stats.PixelsShaded / seconds / 1e6, stats.Triangles / seconds,
+			(unsigned long long)(stats.Rasterized / frames), (unsigned long long)(stats.Triangles / frames));
+
+		if (cubeCount == sceneSizes[0] && !software.SaveBMP("software.bmp"))
+			std::printf("Couldn't write software.bmp\n");
+	}
+	return 0;
+}
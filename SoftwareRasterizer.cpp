@@ -0,0 +1,595 @@
+/**************************************************************
+	Software Rasterizer
+**************************************************************/
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if defined(_XM_SSE_INTRINSICS_)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// BC1 endpoints are 5:6:5, replicate the top bits into the bottom ones
+	uint32_t Expand565(uint16_t color, uint32_t* r, uint32_t* g, uint32_t* b)
+	{
+		const uint32_t r5 = (color >> 11) & 31, g6 = (color >> 5) & 63, b5 = color & 31;
+		*r = (r5 << 3) | (r5 >> 2);
+		*g = (g6 << 2) | (g6 >> 4);
+		*b = (b5 << 3) | (b5 >> 2);
+		return *r | (*g << 8) | (*b << 16) | 0xFF000000;
+	}
+
+	uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	void DecodeBC1(const DirectX::DDSSubresource& top, uint32_t width, uint32_t height, uint32_t* texels)
+	{
+		const uint8_t* rows = static_cast<const uint8_t*>(top.data);
+
+		for (uint32_t by = 0; by < (height + 3) / 4; by++)
+		{
+			for (uint32_t bx = 0; bx < (width + 3) / 4; bx++)
+			{
+				const uint8_t* block = rows + by * top.rowPitch + bx * 8;
+				const uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+				const uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+				const uint32_t bits = uint32_t(block[4]) | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+
+				uint32_t r0, g0, b0, r1, g1, b1;
+				uint32_t palette[4];
+				palette[0] = Expand565(c0, &r0, &g0, &b0);
+				palette[1] = Expand565(c1, &r1, &g1, &b1);
+				if (c0 > c1)
+				{
+					palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+					palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+				}
+				else
+				{
+					// Three colors and transparent black
+					palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+					palette[3] = 0;
+				}
+
+				for (uint32_t py = 0; py < 4; py++)
+				{
+					for (uint32_t px = 0; px < 4; px++)
+					{
+						const uint32_t x = bx * 4 + px, y = by * 4 + py;
+						if (x < width && y < height)
+							texels[y * width + x] = palette[(bits >> (2 * (py * 4 + px))) & 3];
+					}
+				}
+			}
+		}
+	}
+
+	// Point sampling with wrap addressing, like the static sampler in the root signature
+	uint32_t Sample(const SoftwareTexture& texture, float u, float v)
+	{
+		int x = int(floorf(u * texture.Width)) % int(texture.Width);
+		int y = int(floorf(v * texture.Height)) % int(texture.Height);
+		if (x < 0) x += texture.Width;
+		if (y < 0) y += texture.Height;
+		return texture.Texels[y * texture.Width + x];
+	}
+
+	float Dot3(const float* a, const float* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+}
+
+bool LoadSoftwareTexture(const DirectX::DDSTextureDesc& desc, const DirectX::DDSSubresource& top, SoftwareTexture& texture)
+{
+	if (desc.dimension != DirectX::DDS_DIMENSION_TEXTURE2D)
+		return false;
+
+	texture.Width = desc.width;
+	texture.Height = desc.height;
+	texture.Texels.resize(size_t(desc.width) * desc.height);
+
+	switch (desc.format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		DecodeBC1(top, desc.width, desc.height, texture.Texels.data());
+		return true;
+
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		for (uint32_t y = 0; y < desc.height; y++)
+			memcpy(&texture.Texels[y * desc.width], static_cast<const uint8_t*>(top.data) + y * top.rowPitch, desc.width * 4);
+		return true;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		for (uint32_t y = 0; y < desc.height; y++)
+		{
+			const uint32_t* row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(top.data) + y * top.rowPitch);
+			for (uint32_t x = 0; x < desc.width; x++)
+			{
+				const uint32_t bgra = row[x];
+				texture.Texels[y * desc.width + x] = (bgra & 0xFF00FF00) | ((bgra >> 16) & 0xFF) | ((bgra & 0xFF) << 16);
+			}
+		}
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, WorkerPool& workers)
+	: m_width(width), m_height(height), m_workers(workers), m_stats(), m_scalarShading(false)
+{
+	m_tilesX = (width + SOFTWARETILESIZE - 1) / SOFTWARETILESIZE;
+	m_tilesY = (height + SOFTWARETILESIZE - 1) / SOFTWARETILESIZE;
+
+	// Rows are padded to 4 pixels so the last quad of a row never reads past the end
+	m_stride = (width + 3) & ~3u;
+	m_color.resize(size_t(m_stride) * height);
+	m_depth.resize(size_t(m_stride) * height);
+
+	m_bins.resize(m_tilesX * m_tilesY);
+	m_tilePixels.resize(m_tilesX * m_tilesY);
+}
+
+void SoftwareRasterizer::Clear(const float color[4])
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < 4; i++)
+		packed |= uint32_t(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f) << (8 * i);
+
+	std::fill(m_color.begin(), m_color.end(), packed);
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+void SoftwareRasterizer::DrawIndexed(const SoftwareVertex* vertices, const uint16_t* indices, uint32_t indexCount,
+	const SoftwareConstants& constants, const SoftwareTexture* texture)
+{
+	const uint32_t draw = static_cast<uint32_t>(m_draws.size());
+	m_draws.push_back({ constants, texture });
+
+	// The matrices are transposed, so mul(v, M) is a dot product with each row
+	const DirectX::XMFLOAT4X4& world = constants.World;
+	const DirectX::XMFLOAT4X4& model = constants.Model;
+
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		ClipVertex triangle[3];
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const SoftwareVertex& in = vertices[indices[i + corner]];
+			const float pos[4] = { in.Position.x, in.Position.y, in.Position.z, 1.0f };
+			const float normal[3] = { in.Normal.x, in.Normal.y, in.Normal.z };
+			ClipVertex& out = triangle[corner];
+
+			// VSMain
+			for (int row = 0; row < 4; row++)
+				out.Position[row] = Dot3(world.m[row], pos) + world.m[row][3];
+
+			out.Attributes[0] = in.TexCoord.x;
+			out.Attributes[1] = in.TexCoord.y;
+			for (int row = 0; row < 3; row++)
+			{
+				out.Attributes[2 + row] = Dot3(model.m[row], normal);
+				out.Attributes[5 + row] = Dot3(model.m[row], pos) + model.m[row][3];
+			}
+		}
+
+		m_stats.Triangles++;
+		ClipAndSetup(triangle, draw);
+	}
+}
+
+// Only the near plane (z >= 0) needs real clipping, x and y are handled by clamping
+// the bounding box to the screen and far depths fail the depth test anyway.
+void SoftwareRasterizer::ClipAndSetup(const ClipVertex* triangle, uint32_t draw)
+{
+	const bool inside[3] = { triangle[0].Position[2] >= 0.0f, triangle[1].Position[2] >= 0.0f, triangle[2].Position[2] >= 0.0f };
+	if (inside[0] && inside[1] && inside[2])
+	{
+		SetupTriangle(triangle[0], triangle[1], triangle[2], draw);
+		return;
+	}
+
+	// Sutherland-Hodgman against one plane turns a triangle into at most a quad
+	ClipVertex polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const ClipVertex& a = triangle[i];
+		const ClipVertex& b = triangle[(i + 1) % 3];
+
+		if (inside[i])
+			polygon[count++] = a;
+
+		if (inside[i] != inside[(i + 1) % 3])
+		{
+			const float t = a.Position[2] / (a.Position[2] - b.Position[2]);
+			ClipVertex& v = polygon[count++];
+			for (int k = 0; k < 4; k++)
+				v.Position[k] = a.Position[k] + t * (b.Position[k] - a.Position[k]);
+			for (int k = 0; k < 8; k++)
+				v.Attributes[k] = a.Attributes[k] + t * (b.Attributes[k] - a.Attributes[k]);
+		}
+	}
+
+	for (int i = 1; i + 1 < count; i++)
+		SetupTriangle(polygon[0], polygon[i], polygon[i + 1], draw);
+}
+
+void SoftwareRasterizer::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t draw)
+{
+	const ClipVertex* v[3] = { &v0, &v1, &v2 };
+	float sx[3], sy[3], sz[3], invW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		invW[i] = 1.0f / v[i]->Position[3];
+		sx[i] = (v[i]->Position[0] * invW[i] * 0.5f + 0.5f) * m_width;
+		sy[i] = (0.5f - v[i]->Position[1] * invW[i] * 0.5f) * m_height;
+		sz[i] = v[i]->Position[2] * invW[i];
+	}
+
+	// With y pointing down, clockwise (front facing) triangles have a positive area
+	const float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+	if (!(area > 0.0f))
+		return;
+
+	Triangle t;
+	t.MinX = std::max(0, int(floorf(std::min({ sx[0], sx[1], sx[2] }))));
+	t.MinY = std::max(0, int(floorf(std::min({ sy[0], sy[1], sy[2] }))));
+	t.MaxX = std::min(int(m_width) - 1, int(ceilf(std::max({ sx[0], sx[1], sx[2] }))));
+	t.MaxY = std::min(int(m_height) - 1, int(ceilf(std::max({ sy[0], sy[1], sy[2] }))));
+	if (t.MinX > t.MaxX || t.MinY > t.MaxY)
+		return;
+
+	// Edge i is opposite vertex i, so it's also that vertex's barycentric weight
+	for (int i = 0; i < 3; i++)
+	{
+		const int a = (i + 1) % 3, b = (i + 2) % 3;
+		const float dx = sx[b] - sx[a], dy = sy[b] - sy[a];
+		t.Edges[i] = { -dy, dx, dy * sx[a] - dx * sy[a] };
+		t.TopLeft[i] = (dy == 0.0f && dx > 0.0f) || dy < 0.0f;
+	}
+
+	const float invArea = 1.0f / area;
+	auto MakePlane = [&](float a0, float a1, float a2) -> Plane
+	{
+		return {
+			(t.Edges[0].A * a0 + t.Edges[1].A * a1 + t.Edges[2].A * a2) * invArea,
+			(t.Edges[0].B * a0 + t.Edges[1].B * a1 + t.Edges[2].B * a2) * invArea,
+			(t.Edges[0].C * a0 + t.Edges[1].C * a1 + t.Edges[2].C * a2) * invArea };
+	};
+
+	t.Depth = MakePlane(sz[0], sz[1], sz[2]);
+	t.InvW = MakePlane(invW[0], invW[1], invW[2]);
+	for (int k = 0; k < 8; k++)
+		t.Attributes[k] = MakePlane(v0.Attributes[k] * invW[0], v1.Attributes[k] * invW[1], v2.Attributes[k] * invW[2]);
+	t.Draw = draw;
+
+	const uint32_t index = static_cast<uint32_t>(m_triangles.size());
+	m_triangles.push_back(t);
+	m_stats.Rasterized++;
+
+	for (int ty = t.MinY / SOFTWARETILESIZE; ty <= t.MaxY / SOFTWARETILESIZE; ty++)
+		for (int tx = t.MinX / SOFTWARETILESIZE; tx <= t.MaxX / SOFTWARETILESIZE; tx++)
+			m_bins[ty * m_tilesX + tx].push_back(index);
+}
+
+void SoftwareRasterizer::Flush()
+{
+	for (uint32_t tile = 0; tile < m_bins.size(); tile++)
+	{
+		m_tilePixels[tile] = 0;
+		if (!m_bins[tile].empty())
+			m_workers.Submit([this, tile] { ShadeTile(tile); });
+	}
+	m_workers.WaitIdle();
+
+	for (uint32_t tile = 0; tile < m_bins.size(); tile++)
+	{
+		m_stats.PixelsShaded += m_tilePixels[tile];
+		m_bins[tile].clear();
+	}
+	m_triangles.clear();
+	m_draws.clear();
+}
+
+void SoftwareRasterizer::ShadeTile(uint32_t tile)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	if (!m_scalarShading)
+	{
+		ShadeTileSSE(tile);
+		return;
+	}
+#endif
+	ShadeTileScalar(tile);
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+namespace
+{
+	inline __m128 EvaluatePlane(float a, float b, float c, __m128 x, float y)
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a), x), _mm_set1_ps(b * y + c));
+	}
+
+	inline __m128 Dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	inline __m128 Saturate(__m128 v)
+	{
+		return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
+}
+
+void SoftwareRasterizer::ShadeTileSSE(uint32_t tile)
+{
+	const int tileX0 = int(tile % m_tilesX) * SOFTWARETILESIZE;
+	const int tileY0 = int(tile / m_tilesX) * SOFTWARETILESIZE;
+	const int tileX1 = std::min(tileX0 + SOFTWARETILESIZE, int(m_width)) - 1;
+	const int tileY1 = std::min(tileY0 + SOFTWARETILESIZE, int(m_height)) - 1;
+
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 screenWidth = _mm_set1_ps(float(m_width));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	uint64_t pixels = 0;
+
+	for (uint32_t index : m_bins[tile])
+	{
+		const Triangle& t = m_triangles[index];
+		const DrawState& draw = m_draws[t.Draw];
+		const SoftwareConstants& constants = draw.Constants;
+
+		// Quads start on a multiple of 4, tiles do too so a quad never straddles two
+		const int x0 = std::max(t.MinX, tileX0) & ~3;
+		const int x1 = std::min(t.MaxX, tileX1);
+		const int y0 = std::max(t.MinY, tileY0);
+		const int y1 = std::min(t.MaxY, tileY1);
+
+		const __m128 lightX = _mm_set1_ps(constants.LightPosition.x);
+		const __m128 lightY = _mm_set1_ps(constants.LightPosition.y);
+		const __m128 lightZ = _mm_set1_ps(constants.LightPosition.z);
+		const __m128 eyeX = _mm_set1_ps(constants.Eye.x);
+		const __m128 eyeY = _mm_set1_ps(constants.Eye.y);
+		const __m128 eyeZ = _mm_set1_ps(constants.Eye.z);
+
+		for (int y = y0; y <= y1; y++)
+		{
+			const float py = y + 0.5f;
+			for (int x = x0; x <= x1; x += 4)
+			{
+				const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), laneOffsets);
+
+				// Inside every edge, with ties going to top and left edges
+				__m128 mask = _mm_cmplt_ps(px, screenWidth);
+				for (int e = 0; e < 3; e++)
+				{
+					const __m128 edge = EvaluatePlane(t.Edges[e].A, t.Edges[e].B, t.Edges[e].C, px, py);
+					mask = _mm_and_ps(mask, t.TopLeft[e] ? _mm_cmpge_ps(edge, zero) : _mm_cmpgt_ps(edge, zero));
+				}
+				if (_mm_movemask_ps(mask) == 0)
+					continue;
+
+				float* depthRow = &m_depth[y * m_stride + x];
+				const __m128 z = EvaluatePlane(t.Depth.A, t.Depth.B, t.Depth.C, px, py);
+				mask = _mm_and_ps(mask, _mm_cmplt_ps(z, _mm_loadu_ps(depthRow)));
+				const int covered = _mm_movemask_ps(mask);
+				if (covered == 0)
+					continue;
+
+				_mm_storeu_ps(depthRow, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, _mm_loadu_ps(depthRow))));
+
+				// Perspective correct attributes: interpolate a/w and 1/w, then divide
+				const __m128 w = _mm_div_ps(one, EvaluatePlane(t.InvW.A, t.InvW.B, t.InvW.C, px, py));
+				__m128 attributes[8];
+				for (int k = 0; k < 8; k++)
+					attributes[k] = _mm_mul_ps(EvaluatePlane(t.Attributes[k].A, t.Attributes[k].B, t.Attributes[k].C, px, py), w);
+
+				// Texture fetches are the only part done lane by lane
+				alignas(16) float u[4], v[4], texR[4], texG[4], texB[4], texA[4];
+				_mm_store_ps(u, attributes[0]);
+				_mm_store_ps(v, attributes[1]);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					const uint32_t texel = draw.Texture ? Sample(*draw.Texture, u[lane], v[lane]) : 0xFFFFFFFF;
+					texR[lane] = (texel & 0xFF) * (1.0f / 255.0f);
+					texG[lane] = ((texel >> 8) & 0xFF) * (1.0f / 255.0f);
+					texB[lane] = ((texel >> 16) & 0xFF) * (1.0f / 255.0f);
+					texA[lane] = (texel >> 24) * (1.0f / 255.0f);
+				}
+
+				// PSMain
+				const __m128 toLightX = _mm_sub_ps(lightX, attributes[5]);
+				const __m128 toLightY = _mm_sub_ps(lightY, attributes[6]);
+				const __m128 toLightZ = _mm_sub_ps(lightZ, attributes[7]);
+				const __m128 attenuation = _mm_sqrt_ps(Dot3(toLightX, toLightY, toLightZ, toLightX, toLightY, toLightZ));
+				const __m128 invAttenuation = _mm_div_ps(one, attenuation);
+				const __m128 lightDirX = _mm_mul_ps(toLightX, invAttenuation);
+				const __m128 lightDirY = _mm_mul_ps(toLightY, invAttenuation);
+				const __m128 lightDirZ = _mm_mul_ps(toLightZ, invAttenuation);
+
+				const __m128 invNormalLength = _mm_div_ps(one, _mm_sqrt_ps(Dot3(attributes[2], attributes[3], attributes[4], attributes[2], attributes[3], attributes[4])));
+				const __m128 normX = _mm_mul_ps(attributes[2], invNormalLength);
+				const __m128 normY = _mm_mul_ps(attributes[3], invNormalLength);
+				const __m128 normZ = _mm_mul_ps(attributes[4], invNormalLength);
+
+				const __m128 normDotLight = Dot3(normX, normY, normZ, lightDirX, lightDirY, lightDirZ);
+				const __m128 diff = _mm_mul_ps(_mm_max_ps(normDotLight, zero), invAttenuation);
+
+				const __m128 toEyeX = _mm_sub_ps(eyeX, attributes[5]);
+				const __m128 toEyeY = _mm_sub_ps(eyeY, attributes[6]);
+				const __m128 toEyeZ = _mm_sub_ps(eyeZ, attributes[7]);
+				const __m128 invEyeDistance = _mm_div_ps(one, _mm_sqrt_ps(Dot3(toEyeX, toEyeY, toEyeZ, toEyeX, toEyeY, toEyeZ)));
+
+				// reflect(-lightDir, norm) = 2 * dot(norm, lightDir) * norm - lightDir
+				const __m128 twoNdotL = _mm_add_ps(normDotLight, normDotLight);
+				const __m128 reflectX = _mm_sub_ps(_mm_mul_ps(twoNdotL, normX), lightDirX);
+				const __m128 reflectY = _mm_sub_ps(_mm_mul_ps(twoNdotL, normY), lightDirY);
+				const __m128 reflectZ = _mm_sub_ps(_mm_mul_ps(twoNdotL, normZ), lightDirZ);
+
+				__m128 spec = _mm_max_ps(_mm_mul_ps(Dot3(toEyeX, toEyeY, toEyeZ, reflectX, reflectY, reflectZ), invEyeDistance), zero);
+				for (int i = 0; i < 5; i++)
+					spec = _mm_mul_ps(spec, spec);	// pow(x, 32)
+				spec = _mm_mul_ps(spec, invAttenuation);
+
+				// totalLight = albedo + (diff + spec) * lightColor
+				const __m128 lit = _mm_add_ps(diff, spec);
+				const __m128 albedo = _mm_set1_ps(0.2f);
+				const __m128 r = Saturate(_mm_mul_ps(_mm_load_ps(texR), _mm_add_ps(albedo, _mm_mul_ps(lit, _mm_set1_ps(constants.LightColor.x)))));
+				const __m128 g = Saturate(_mm_mul_ps(_mm_load_ps(texG), _mm_add_ps(albedo, _mm_mul_ps(lit, _mm_set1_ps(constants.LightColor.y)))));
+				const __m128 b = Saturate(_mm_mul_ps(_mm_load_ps(texB), _mm_add_ps(albedo, _mm_mul_ps(lit, _mm_set1_ps(constants.LightColor.z)))));
+				const __m128 a = _mm_load_ps(texA);
+
+				const __m128 scale = _mm_set1_ps(255.0f);
+				const __m128i packed = _mm_or_si128(
+					_mm_or_si128(_mm_cvtps_epi32(_mm_mul_ps(r, scale)), _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(g, scale)), 8)),
+					_mm_or_si128(_mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(b, scale)), 16), _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)), 24)));
+
+				uint32_t* colorRow = &m_color[y * m_stride + x];
+				const __m128i oldColor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorRow));
+				const __m128i colorMask = _mm_castps_si128(mask);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(colorRow),
+					_mm_or_si128(_mm_and_si128(colorMask, packed), _mm_andnot_si128(colorMask, oldColor)));
+
+				pixels += (covered & 1) + ((covered >> 1) & 1) + ((covered >> 2) & 1) + ((covered >> 3) & 1);
+			}
+		}
+	}
+
+	m_tilePixels[tile] = pixels;
+}
+
+#endif
+
+// Always compiled, it's what the SSE path is tested against
+void SoftwareRasterizer::ShadeTileScalar(uint32_t tile)
+{
+	const int tileX0 = int(tile % m_tilesX) * SOFTWARETILESIZE;
+	const int tileY0 = int(tile / m_tilesX) * SOFTWARETILESIZE;
+	const int tileX1 = std::min(tileX0 + SOFTWARETILESIZE, int(m_width)) - 1;
+	const int tileY1 = std::min(tileY0 + SOFTWARETILESIZE, int(m_height)) - 1;
+	uint64_t pixels = 0;
+
+	// Summed in the same order as EvaluatePlane() so both cover the same pixels
+	auto Evaluate = [](const Plane& p, float x, float y) { return p.A * x + (p.B * y + p.C); };
+
+	for (uint32_t index : m_bins[tile])
+	{
+		const Triangle& t = m_triangles[index];
+		const DrawState& draw = m_draws[t.Draw];
+		const SoftwareConstants& constants = draw.Constants;
+
+		for (int y = std::max(t.MinY, tileY0); y <= std::min(t.MaxY, tileY1); y++)
+		{
+			for (int x = std::max(t.MinX, tileX0); x <= std::min(t.MaxX, tileX1); x++)
+			{
+				const float px = x + 0.5f, py = y + 0.5f;
+
+				bool inside = true;
+				for (int e = 0; e < 3; e++)
+				{
+					const float edge = Evaluate(t.Edges[e], px, py);
+					inside = inside && (t.TopLeft[e] ? edge >= 0.0f : edge > 0.0f);
+				}
+
+				const float z = Evaluate(t.Depth, px, py);
+				float& depth = m_depth[y * m_stride + x];
+				if (!inside || !(z < depth))
+					continue;
+				depth = z;
+
+				const float w = 1.0f / Evaluate(t.InvW, px, py);
+				float attributes[8];
+				for (int k = 0; k < 8; k++)
+					attributes[k] = Evaluate(t.Attributes[k], px, py) * w;
+
+				const uint32_t texel = draw.Texture ? Sample(*draw.Texture, attributes[0], attributes[1]) : 0xFFFFFFFF;
+
+				// PSMain
+				const float* fragPos = &attributes[5];
+				float lightDir[3] = { constants.LightPosition.x - fragPos[0], constants.LightPosition.y - fragPos[1], constants.LightPosition.z - fragPos[2] };
+				const float attenuation = sqrtf(::Dot3(lightDir, lightDir));
+				for (float& c : lightDir) c /= attenuation;
+
+				float norm[3] = { attributes[2], attributes[3], attributes[4] };
+				const float normalLength = sqrtf(::Dot3(norm, norm));
+				for (float& c : norm) c /= normalLength;
+
+				const float normDotLight = ::Dot3(norm, lightDir);
+				const float diff = std::max(normDotLight, 0.0f) / attenuation;
+
+				float viewDir[3] = { constants.Eye.x - fragPos[0], constants.Eye.y - fragPos[1], constants.Eye.z - fragPos[2] };
+				const float eyeDistance = sqrtf(::Dot3(viewDir, viewDir));
+				const float reflectDir[3] = { 2.0f * normDotLight * norm[0] - lightDir[0], 2.0f * normDotLight * norm[1] - lightDir[1], 2.0f * normDotLight * norm[2] - lightDir[2] };
+				const float spec = powf(std::max(::Dot3(viewDir, reflectDir) / eyeDistance, 0.0f), 32.0f) / attenuation;
+
+				const float lightColor[3] = { constants.LightColor.x, constants.LightColor.y, constants.LightColor.z };
+				uint32_t packed = texel & 0xFF000000;
+				for (int c = 0; c < 3; c++)
+				{
+					const float value = ((texel >> (8 * c)) & 0xFF) * (1.0f / 255.0f) * (0.2f + (diff + spec) * lightColor[c]);
+					packed |= uint32_t(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f) << (8 * c);
+				}
+				m_color[y * m_stride + x] = packed;
+				pixels++;
+			}
+		}
+	}
+
+	m_tilePixels[tile] = pixels;
+}
+
+bool SoftwareRasterizer::SaveBMP(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+		return false;
+
+	const uint32_t rowSize = (m_width * 3 + 3) & ~3u;
+	const uint32_t imageSize = rowSize * m_height;
+
+	uint8_t header[54] = { 'B', 'M' };
+	auto Write32 = [&](int offset, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			header[offset + i] = uint8_t(value >> (8 * i));
+	};
+	Write32(2, sizeof(header) + imageSize);	// File size
+	Write32(10, sizeof(header));				// Pixel data offset
+	Write32(14, 40);							// BITMAPINFOHEADER
+	Write32(18, m_width);
+	Write32(22, m_height);						// Positive height, rows go bottom up
+	header[26] = 1;								// Planes
+	header[28] = 24;							// Bits per pixel
+	Write32(34, imageSize);
+
+	bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+	std::vector<uint8_t> row(rowSize, 0);
+	for (uint32_t y = m_height; ok && y-- > 0;)
+	{
+		for (uint32_t x = 0; x < m_width; x++)
+		{
+			const uint32_t rgba = m_color[y * m_stride + x];
+			row[x * 3 + 0] = uint8_t(rgba >> 16);
+			row[x * 3 + 1] = uint8_t(rgba >> 8);
+			row[x * 3 + 2] = uint8_t(rgba);
+		}
+		ok = fwrite(row.data(), rowSize, 1, file) == 1;
+	}
+
+	return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,147 @@
+/**************************************************************
+	Software Rasterizer
+
+	Runs the Shaders.hlsl pipeline (VSMain + PSMain) on the cpu so
+	the cube scene can be rendered without a gpu. Draws are only
+	transformed, clipped and binned into screen tiles when they're
+	submitted, Flush() then shades every tile in parallel on the
+	WorkerPool. Edge functions, depth test and shading work on 4
+	pixels of a row at once with SSE. Without it a plain C++ loop
+	does one pixel at a time, and SoftwareRasterizerTest checks
+	the two render the same image.
+
+	Matches the gpu pipeline state the app uses: clockwise front
+	faces, back face culling, depth LESS, point sampling with wrap.
+	Nothing in here is Windows or D3D specific.
+**************************************************************/
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "DDSParser.h"
+#include "WorkerPool.h"
+
+#define SOFTWARETILESIZE 64		// Pixels, must be a multiple of 4
+
+// Same layout as the Vertex struct the gpu vertex buffer is built from
+struct SoftwareVertex
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT2 TexCoord;
+	DirectX::XMFLOAT3 Normal;
+};
+
+// Same layout as the cbuffer in Shaders.hlsl up to Eye, matrices transposed just like
+// the ones uploaded to the gpu. The texture is passed to DrawIndexed() instead of Material.
+struct SoftwareConstants
+{
+	DirectX::XMFLOAT4X4 World;		// Model * View * Proj
+	DirectX::XMFLOAT4X4 Model;
+	DirectX::XMFLOAT4X4 ViewProj;	// Unused, VSMain only needs World
+	DirectX::XMFLOAT4 LightPosition;
+	DirectX::XMFLOAT4 LightColor;
+	DirectX::XMFLOAT4 Eye;
+};
+
+// RGBA8 texels, red in the low byte
+struct SoftwareTexture
+{
+	uint32_t Width;
+	uint32_t Height;
+	std::vector<uint32_t> Texels;
+};
+
+// Decodes the top mip of a parsed DDS. Handles BC1 and the 8-bit RGBA/BGRA formats.
+bool LoadSoftwareTexture(const DirectX::DDSTextureDesc& desc, const DirectX::DDSSubresource& top, SoftwareTexture& texture);
+
+struct SoftwareStats
+{
+	uint64_t Triangles;			// Submitted
+	uint64_t Rasterized;		// Left after clipping and culling
+	uint64_t PixelsShaded;		// Passed the depth test
+};
+
+class SoftwareRasterizer
+{
+public:
+	SoftwareRasterizer(uint32_t width, uint32_t height, WorkerPool& workers);
+
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+	void Clear(const float color[4]);
+
+	// Runs VSMain on every vertex and bins the triangles, nothing is shaded until Flush().
+	// 'texture' has to stay alive until then.
+	void DrawIndexed(const SoftwareVertex* vertices, const uint16_t* indices, uint32_t indexCount,
+		const SoftwareConstants& constants, const SoftwareTexture* texture);
+
+	// Shades every tile on the worker pool and waits for them
+	void Flush();
+
+	// 24-bit bottom-up BMP
+	bool SaveBMP(const char* fileName) const;
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	const uint32_t* GetPixels() const { return m_color.data(); }
+
+	const SoftwareStats& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = SoftwareStats(); }
+
+	// Shades with the plain C++ loop even where there's SSE, it's the reference the SSE one is tested against
+	void SetScalarShading(bool scalar) { m_scalarShading = scalar; }
+
+private:
+	// a*x + b*y + c, evaluated at pixel centers
+	struct Plane
+	{
+		float A, B, C;
+	};
+
+	// What VSMain outputs, before the perspective divide
+	struct ClipVertex
+	{
+		float Position[4];
+		float Attributes[8];	// texCoord.xy, normal.xyz, fragPos.xyz
+	};
+
+	struct Triangle
+	{
+		Plane Edges[3];
+		bool TopLeft[3];		// Pixels exactly on a top or left edge belong to this triangle
+		Plane Depth;
+		Plane InvW;
+		Plane Attributes[8];	// Attribute / w, so they interpolate perspective correct
+		int32_t MinX, MinY, MaxX, MaxY;
+		uint32_t Draw;
+	};
+
+	struct DrawState
+	{
+		SoftwareConstants Constants;
+		const SoftwareTexture* Texture;
+	};
+
+	void ClipAndSetup(const ClipVertex* triangle, uint32_t draw);
+	void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t draw);
+	void ShadeTile(uint32_t tile);
+	void ShadeTileSSE(uint32_t tile);
+	void ShadeTileScalar(uint32_t tile);
+
+	uint32_t m_width, m_height;
+	uint32_t m_stride;
+	uint32_t m_tilesX, m_tilesY;
+	WorkerPool& m_workers;
+
+	std::vector<uint32_t> m_color;
+	std::vector<float> m_depth;
+
+	std::vector<DrawState> m_draws;
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32_t>> m_bins;		// Triangle indices per tile, in submission order
+	std::vector<uint64_t> m_tilePixels;				// Written by one worker each, summed in Flush()
+
+	SoftwareStats m_stats;
+	bool m_scalarShading;
+};
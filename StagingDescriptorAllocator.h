@@ -0,0 +1,214 @@
+/**************************************************************
+	Staging Descriptor Allocator
+
+	Cpu only (non shader visible) descriptors of one heap type,
+	handed out from fixed size pages instead of a heap per view.
+	RTVs and DSVs live here for good, SRVs are written here once
+	and copied into the BindlessHeap, which is much cheaper than
+	creating them there directly.
+
+	Allocate and Free are O(1): every page keeps a stack of its
+	free slots, and the allocator keeps a stack of pages that
+	still have one. A new page is only created when every page
+	is full, pages are never released.
+
+	The shared allocator takes a lock. Threads that create a lot
+	of views should go through a Cache of their own, which moves
+	descriptors to and from the allocator in batches so the lock
+	is taken once per batch rather than once per view.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <mutex>
+#include <vector>
+
+struct StagingDescriptor
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+	UINT32 Page;
+	UINT32 Slot;
+
+	bool IsValid() const { return Handle.ptr != 0; }
+};
+
+class StagingDescriptorAllocator
+{
+public:
+	// One per thread, not thread safe itself. Hands everything it still holds back
+	// to the allocator when it goes away.
+	class Cache
+	{
+	public:
+		explicit Cache(StagingDescriptorAllocator& allocator, UINT batchSize = 32)
+			: m_allocator(allocator), m_batchSize(batchSize) { }
+
+		~Cache() { m_allocator.FreeBatch(m_free.data(), m_free.size()); }
+
+		Cache(const Cache&) = delete;
+		Cache& operator=(const Cache&) = delete;
+
+		StagingDescriptor Allocate()
+		{
+			if (m_free.empty() && !m_allocator.AllocateBatch(m_batchSize, m_free))
+				return StagingDescriptor();
+
+			const StagingDescriptor descriptor = m_free.back();
+			m_free.pop_back();
+			return descriptor;
+		}
+
+		void Free(const StagingDescriptor& descriptor)
+		{
+			m_free.push_back(descriptor);
+
+			// Keep one batch around for the next allocations, give the rest back
+			if (m_free.size() >= 2 * m_batchSize)
+			{
+				m_allocator.FreeBatch(m_free.data() + m_batchSize, m_free.size() - m_batchSize);
+				m_free.resize(m_batchSize);
+			}
+		}
+
+	private:
+		StagingDescriptorAllocator& m_allocator;
+		UINT m_batchSize;
+		std::vector<StagingDescriptor> m_free;
+	};
+
+	StagingDescriptorAllocator() : m_device(nullptr), m_type(D3D12_DESCRIPTOR_HEAP_TYPE_RTV), m_pageSize(0), m_descriptorSize(0), m_allocated(0) { }
+
+	~StagingDescriptorAllocator()
+	{
+		for (Page& page : m_pages)
+			page.Heap->Release();
+	}
+
+	StagingDescriptorAllocator(const StagingDescriptorAllocator&) = delete;
+	StagingDescriptorAllocator& operator=(const StagingDescriptorAllocator&) = delete;
+
+	void Init(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT pageSize)
+	{
+		m_device = device;
+		m_type = type;
+		m_pageSize = pageSize;
+		m_descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+	}
+
+	// Returns an invalid descriptor if a new page couldn't be created
+	StagingDescriptor Allocate()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return AllocateLocked();
+	}
+
+	void Free(const StagingDescriptor& descriptor)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		FreeLocked(descriptor);
+	}
+
+	// Appends 'count' descriptors to 'out', all or nothing
+	bool AllocateBatch(UINT count, std::vector<StagingDescriptor>& out)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const size_t start = out.size();
+		for (UINT i = 0; i < count; i++)
+		{
+			const StagingDescriptor descriptor = AllocateLocked();
+			if (!descriptor.IsValid())
+			{
+				for (size_t j = start; j < out.size(); j++)
+					FreeLocked(out[j]);
+				out.resize(start);
+				return false;
+			}
+			out.push_back(descriptor);
+		}
+		return true;
+	}
+
+	void FreeBatch(const StagingDescriptor* descriptors, size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < count; i++)
+			FreeLocked(descriptors[i]);
+	}
+
+	D3D12_DESCRIPTOR_HEAP_TYPE GetType() const { return m_type; }
+	UINT GetPageCount() const { return static_cast<UINT>(m_pages.size()); }
+	ID3D12DescriptorHeap* GetPageHeap(UINT page) const { return m_pages[page].Heap; }
+	UINT GetAllocatedCount() const { return m_allocated; }
+
+private:
+	struct Page
+	{
+		ID3D12DescriptorHeap* Heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE Start;
+		std::vector<UINT32> FreeSlots;
+	};
+
+	StagingDescriptor AllocateLocked()
+	{
+		if (m_pagesWithSpace.empty() && !AddPage())
+			return StagingDescriptor();
+
+		const UINT32 pageIndex = m_pagesWithSpace.back();
+		Page& page = m_pages[pageIndex];
+
+		StagingDescriptor descriptor;
+		descriptor.Page = pageIndex;
+		descriptor.Slot = page.FreeSlots.back();
+		descriptor.Handle.ptr = page.Start.ptr + SIZE_T(descriptor.Slot) * m_descriptorSize;
+
+		page.FreeSlots.pop_back();
+		if (page.FreeSlots.empty())
+			m_pagesWithSpace.pop_back();
+
+		m_allocated++;
+		return descriptor;
+	}
+
+	void FreeLocked(const StagingDescriptor& descriptor)
+	{
+		Page& page = m_pages[descriptor.Page];
+		if (page.FreeSlots.empty())
+			m_pagesWithSpace.push_back(descriptor.Page);
+
+		page.FreeSlots.push_back(descriptor.Slot);
+		m_allocated--;
+	}
+
+	bool AddPage()
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = m_pageSize;
+		heapDesc.Type = m_type;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+		Page page;
+		if (FAILED(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&page.Heap))))
+			return false;
+
+		page.Start = page.Heap->GetCPUDescriptorHandleForHeapStart();
+
+		// Reversed, so slots go out in address order
+		page.FreeSlots.resize(m_pageSize);
+		for (UINT slot = 0; slot < m_pageSize; slot++)
+			page.FreeSlots[slot] = m_pageSize - 1 - slot;
+
+		m_pages.push_back(std::move(page));
+		m_pagesWithSpace.push_back(static_cast<UINT32>(m_pages.size() - 1));
+		return true;
+	}
+
+	ID3D12Device* m_device;
+	D3D12_DESCRIPTOR_HEAP_TYPE m_type;
+	UINT m_pageSize;
+	UINT m_descriptorSize;
+
+	std::mutex m_mutex;
+	std::vector<Page> m_pages;
+	std::vector<UINT32> m_pagesWithSpace;
+	UINT m_allocated;
+};
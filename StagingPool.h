@@ -0,0 +1,150 @@
+/**************************************************************
+	Staging Pool
+
+	A handful of big upload buffers, mapped once, that texture and
+	buffer uploads borrow space from instead of each creating its
+	own committed upload heap. Every block is a RingAllocator, so
+	space comes back on its own once the copy fence it was tagged
+	with has completed.
+
+	Blocks are created on demand up to 'maxBlocks'. Anything bigger
+	than a block has to be split by the caller (see UploadManager).
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <vector>
+#include "d3dx12.h"
+#include "RingAllocator.h"
+
+struct StagingAllocation
+{
+	ID3D12Resource* Buffer;
+	UINT64 Offset;
+	UINT8* CpuAddress;
+};
+
+class StagingPool
+{
+public:
+	StagingPool() : m_device(nullptr), m_blockSize(0), m_maxBlocks(0), m_used(0), m_peakUsed(0), m_allocationCount(0) { }
+
+	~StagingPool()
+	{
+		for (Block& block : m_blocks)
+			block.Buffer->Release();
+	}
+
+	StagingPool(const StagingPool&) = delete;
+	StagingPool& operator=(const StagingPool&) = delete;
+
+	void Init(ID3D12Device* device, UINT64 blockSize, UINT maxBlocks)
+	{
+		m_device = device;
+		m_blockSize = blockSize;
+		m_maxBlocks = maxBlocks;
+	}
+
+	// Returns false if every block is busy (or 'size' is bigger than a block),
+	// the caller has to wait on the copy fence and try again.
+	bool Allocate(UINT64 size, UINT64 alignment, StagingAllocation* allocation)
+	{
+		if (size > m_blockSize)
+			return false;
+
+		for (Block& block : m_blocks)
+		{
+			if (AllocateFrom(block, size, alignment, allocation))
+				return true;
+		}
+
+		if (m_blocks.size() < m_maxBlocks && AddBlock())
+			return AllocateFrom(m_blocks.back(), size, alignment, allocation);
+
+		return false;
+	}
+
+	// Everything allocated since the last call is used by the batch signaling 'fenceValue'
+	void FinishBatch(UINT64 fenceValue)
+	{
+		for (Block& block : m_blocks)
+			block.Ring.FinishFrame(fenceValue);
+	}
+
+	void ReleaseCompleted(UINT64 completedFenceValue)
+	{
+		m_used = 0;
+		for (Block& block : m_blocks)
+		{
+			block.Ring.ReleaseCompletedFrames(completedFenceValue);
+			m_used += block.Ring.GetUsedSize();
+		}
+	}
+
+	UINT64 GetBlockSize() const { return m_blockSize; }
+	UINT64 GetCommittedSize() const { return m_blockSize * m_blocks.size(); }
+	UINT64 GetPeakUsedSize() const { return m_peakUsed; }
+	UINT64 GetAllocationCount() const { return m_allocationCount; }
+
+private:
+	struct Block
+	{
+		ID3D12Resource* Buffer;
+		UINT8* MappedData;
+		RingAllocator Ring;
+	};
+
+	bool AddBlock()
+	{
+		Block block = { nullptr, nullptr, RingAllocator() };
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_blockSize);
+		HRESULT hr = m_device->CreateCommittedResource(
+			&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&block.Buffer));
+		if (FAILED(hr))
+			return false;
+
+		CD3DX12_RANGE readRange(0, 0);
+		if (FAILED(block.Buffer->Map(0, &readRange, reinterpret_cast<void**>(&block.MappedData))))
+		{
+			block.Buffer->Release();
+			return false;
+		}
+
+		block.Ring.Reset(m_blockSize);
+		m_blocks.push_back(block);
+		return true;
+	}
+
+	bool AllocateFrom(Block& block, UINT64 size, UINT64 alignment, StagingAllocation* allocation)
+	{
+		const UINT64 usedBefore = block.Ring.GetUsedSize();
+		const UINT64 offset = block.Ring.Allocate(size, alignment);
+		if (offset == RingAllocator::InvalidOffset)
+			return false;
+
+		allocation->Buffer = block.Buffer;
+		allocation->Offset = offset;
+		allocation->CpuAddress = block.MappedData + offset;
+
+		// Count padding and wrap waste too, that's memory nobody else can use either
+		m_used += block.Ring.GetUsedSize() - usedBefore;
+		if (m_used > m_peakUsed)
+			m_peakUsed = m_used;
+		m_allocationCount++;
+		return true;
+	}
+
+	ID3D12Device* m_device;
+	UINT64 m_blockSize;
+	UINT m_maxBlocks;
+	std::vector<Block> m_blocks;
+
+	UINT64 m_used;
+	UINT64 m_peakUsed;
+	UINT64 m_allocationCount;
+};
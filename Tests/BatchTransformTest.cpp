@@ -0,0 +1,146 @@
+/**************************************************************
+	Batch transform: the scalar, SSE and (built with -mavx2) AVX2
+	paths each on their own, then BatchTransform as the frame
+	loop calls it, against one DirectXMath chain per object.
+	Counts that leave tails for every path, strided output into
+	a bigger struct, and World or Model left out.
+**************************************************************/
+#include <cstdlib>
+#include <vector>
+#include "BatchTransform.h"
+#include "Test.h"
+
+static const float Tolerance = 1e-4f;
+
+struct Outputs
+{
+	std::vector<DirectX::XMFLOAT4X4> World;
+	std::vector<DirectX::XMFLOAT4X4> Model;
+
+	explicit Outputs(size_t count) : World(count), Model(count) { }
+	TransformOutput Get() { return { World.data(), sizeof(DirectX::XMFLOAT4X4), Model.data(), sizeof(DirectX::XMFLOAT4X4) }; }
+};
+
+static float MatrixError(const DirectX::XMFLOAT4X4& a, const DirectX::XMFLOAT4X4& b)
+{
+	float error = 0.0f;
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+			error = (std::max)(error, fabsf(a.m[r][c] - b.m[r][c]));
+	}
+	return error;
+}
+
+// Largest difference from DirectXMath over every matrix in 'out'
+static float CompareToDirectXMath(const TransformSoA& in, DirectX::FXMMATRIX viewProj, const Outputs& out)
+{
+	float error = 0.0f;
+	for (size_t i = 0; i < in.Size(); i++)
+	{
+		const DirectX::XMMATRIX m = DirectX::XMMatrixRotationY(in.RotationY[i]) *
+			DirectX::XMMatrixTranslation(in.PositionX[i], in.PositionY[i], in.PositionZ[i]);
+
+		DirectX::XMFLOAT4X4 world, model;
+		DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranspose(m * viewProj));
+		DirectX::XMStoreFloat4x4(&model, DirectX::XMMatrixTranspose(m));
+		error = (std::max)(error, (std::max)(MatrixError(out.World[i], world), MatrixError(out.Model[i], model)));
+	}
+	return error;
+}
+
+static TransformSoA RandomObjects(size_t count)
+{
+	TransformSoA in;
+	in.Resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		in.PositionX[i] = 20.0f * rand() / RAND_MAX - 10.0f;
+		in.PositionY[i] = 20.0f * rand() / RAND_MAX - 10.0f;
+		in.PositionZ[i] = 20.0f * rand() / RAND_MAX - 10.0f;
+		in.RotationY[i] = 12.0f * rand() / RAND_MAX - 6.0f;
+	}
+	return in;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		std::printf("No AVX2 on this cpu, skipped\n");
+		return 77;
+	}
+#endif
+
+	// The camera the frame loop starts with
+	const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(0.0f, 2.5f, -4.33f, 1.0f),
+		DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f));
+	const DirectX::XMMATRIX viewProj = view * DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(45.0f), 4.0f / 3.0f, 0.1f, 300.0f);
+	DirectX::XMFLOAT4X4 vp;
+	DirectX::XMStoreFloat4x4(&vp, viewProj);
+
+	srand(1);
+	for (size_t count : { 1, 3, 4, 7, 8, 19, 1003 })
+	{
+		const TransformSoA in = RandomObjects(count);
+
+		Outputs scalar(count);
+		BatchTransformDetail::TransformScalar(in, 0, count, vp, scalar.Get());
+		CHECK(CompareToDirectXMath(in, viewProj, scalar) < Tolerance);
+
+#if defined(_XM_SSE_INTRINSICS_)
+		Outputs sse(count);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+			BatchTransformDetail::TransformSSE(in, i, vp, sse.Get());
+		BatchTransformDetail::TransformScalar(in, i, count, vp, sse.Get());
+		CHECK(CompareToDirectXMath(in, viewProj, sse) < Tolerance);
+#endif
+
+#if defined(__AVX2__)
+		Outputs avx2(count);
+		size_t j = 0;
+		for (; j + 8 <= count; j += 8)
+			BatchTransformDetail::TransformAVX2(in, j, vp, avx2.Get());
+		BatchTransformDetail::TransformScalar(in, j, count, vp, avx2.Get());
+		CHECK(CompareToDirectXMath(in, viewProj, avx2) < Tolerance);
+#endif
+
+		Outputs batch(count);
+		BatchTransform(in, viewProj, batch.Get());
+		CHECK(CompareToDirectXMath(in, viewProj, batch) < Tolerance);
+
+		// Model only, straight into a bigger struct the way the instanced path writes it,
+		// nothing else in the struct touched
+		struct Instance
+		{
+			DirectX::XMFLOAT4X4 Model;
+			uint32_t Guard;
+		};
+		std::vector<Instance> instances(count, Instance{ DirectX::XMFLOAT4X4(), 0xabcdef01 });
+		BatchTransform(in, viewProj, { nullptr, 0, &instances[0].Model, sizeof(Instance) });
+		for (size_t k = 0; k < count; k++)
+		{
+			CHECK(MatrixError(instances[k].Model, batch.Model[k]) == 0.0f);
+			CHECK(instances[k].Guard == 0xabcdef01);
+		}
+
+		// World only
+		Outputs worldOnly(count);
+		BatchTransform(in, viewProj, { worldOnly.World.data(), sizeof(DirectX::XMFLOAT4X4), nullptr, 0 });
+		for (size_t k = 0; k < count; k++)
+			CHECK(MatrixError(worldOnly.World[k], batch.World[k]) == 0.0f);
+	}
+
+	CHECK(VerifyBatchTransform(viewProj) < Tolerance);
+
+#if defined(__AVX2__)
+	std::printf("Checked the scalar, SSE and AVX2 paths\n");
+#elif defined(_XM_SSE_INTRINSICS_)
+	std::printf("Checked the scalar and SSE paths\n");
+#else
+	std::printf("Checked the scalar path\n");
+#endif
+	return TestResult();
+}
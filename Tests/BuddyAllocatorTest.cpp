@@ -0,0 +1,178 @@
+/**************************************************************
+	Buddy allocator: ranges rounded up to a power of two and
+	aligned to their size, an alignment bigger than the size
+	taking a bigger range, buddies merging back into the whole
+	block when they're freed, and nothing handed out once it's
+	full.
+
+	Then a random trace replayed against one block: no two live
+	ranges overlap, the allocated size always adds up, and it's
+	empty again at the end. The same trace goes through
+	SaveAllocationTrace and LoadAllocationTrace and has to come
+	back unchanged.
+**************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include "BuddyAllocator.h"
+#include "Test.h"
+
+namespace
+{
+	const uint64_t BlockSize = 8 << 20;
+	const uint64_t MinBlockSize = 4096;
+
+	void TestRanges()
+	{
+		BuddyAllocator block;
+		block.Reset(BlockSize, MinBlockSize);
+		CHECK(block.GetSize() == BlockSize && block.IsEmpty());
+		CHECK(block.GetLargestFreeRange() == BlockSize);
+
+		// 5000 bytes take an 8 KB range, the 4 KB one next to it stays free
+		const uint64_t a = block.Allocate(5000);
+		CHECK(a % 8192 == 0);
+		CHECK(block.GetAllocatedSize() == 8192);
+		const uint64_t b = block.Allocate(100);
+		CHECK(b % 4096 == 0 && (b + 4096 <= a || a + 8192 <= b));
+
+		// Alignment only makes the range bigger
+		CHECK(block.GetRangeSize(4096, 65536) == 65536);
+		const uint64_t c = block.Allocate(4096, 65536);
+		CHECK(c % 65536 == 0);
+		CHECK(block.GetAllocatedSize() == 8192 + 4096 + 65536);
+		CHECK(block.GetAllocationCount() == 3);
+
+		CHECK(block.GetRangeSize(BlockSize + 1, 1) == 0);
+		CHECK(block.Allocate(BlockSize + 1) == BuddyAllocator::InvalidOffset);
+
+		// Everything merges back
+		block.Free(b);
+		block.Free(c);
+		block.Free(a);
+		CHECK(block.IsEmpty() && block.GetAllocatedSize() == 0);
+		CHECK(block.GetLargestFreeRange() == BlockSize);
+
+		// Full
+		std::vector<uint64_t> quarters;
+		for (int i = 0; i < 4; i++)
+			quarters.push_back(block.Allocate(BlockSize / 4));
+		CHECK(block.Allocate(1) == BuddyAllocator::InvalidOffset);
+		CHECK(block.GetFreeSize() == 0 && block.GetLargestFreeRange() == 0);
+		block.Free(quarters[1]);
+		CHECK(block.Allocate(BlockSize / 2) == BuddyAllocator::InvalidOffset);
+		CHECK(block.Allocate(BlockSize / 4) == quarters[1]);
+	}
+
+	struct Range
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	std::vector<AllocationTraceEntry> MakeTrace()
+	{
+		std::vector<AllocationTraceEntry> trace;
+		std::vector<uint32_t> live;
+		std::srand(5);
+		for (uint32_t id = 0; id < 20000; id++)
+		{
+			if (live.size() >= 32 || (!live.empty() && std::rand() % 3 == 0))
+			{
+				const size_t freed = std::rand() % live.size();
+				trace.push_back({ AllocationTraceEntry::FREE, 0, live[freed], 0, 0 });
+				live[freed] = live.back();
+				live.pop_back();
+			}
+
+			const uint64_t alignment = std::rand() % 4 ? MinBlockSize : 65536;
+			trace.push_back({ AllocationTraceEntry::ALLOCATE, 0, id, 1 + uint64_t(std::rand()) % (64 * 1024), alignment });
+			live.push_back(id);
+		}
+		for (uint32_t id : live)
+			trace.push_back({ AllocationTraceEntry::FREE, 0, id, 0, 0 });
+		return trace;
+	}
+
+	void TestReplay(const std::vector<AllocationTraceEntry>& trace)
+	{
+		BuddyAllocator block;
+		block.Reset(BlockSize, MinBlockSize);
+
+		std::unordered_map<uint32_t, Range> live;
+		std::vector<int> owner(BlockSize / MinBlockSize, -1);
+		bool disjoint = true, aligned = true, counted = true;
+		uint32_t failed = 0;
+		uint64_t allocated = 0;
+		for (const AllocationTraceEntry& entry : trace)
+		{
+			if (entry.Operation == AllocationTraceEntry::ALLOCATE)
+			{
+				const uint64_t offset = block.Allocate(entry.Size, entry.Alignment);
+				if (offset == BuddyAllocator::InvalidOffset)
+				{
+					failed++;
+					continue;
+				}
+
+				const Range range = { offset, block.GetRangeSize(entry.Size, entry.Alignment) };
+				aligned &= offset % entry.Alignment == 0 && offset % range.Size == 0 && range.Size >= entry.Size;
+				for (uint64_t unit = offset / MinBlockSize; unit < (offset + range.Size) / MinBlockSize; unit++)
+				{
+					disjoint &= owner[unit] == -1;
+					owner[unit] = int(entry.Id);
+				}
+				live[entry.Id] = range;
+				allocated += range.Size;
+			}
+			else
+			{
+				auto found = live.find(entry.Id);
+				if (found == live.end())
+					continue;
+				for (uint64_t unit = found->second.Offset / MinBlockSize; unit < (found->second.Offset + found->second.Size) / MinBlockSize; unit++)
+					owner[unit] = -1;
+				block.Free(found->second.Offset);
+				allocated -= found->second.Size;
+				live.erase(found);
+			}
+			counted &= block.GetAllocatedSize() == allocated && block.GetAllocationCount() == live.size();
+		}
+
+		CHECK(disjoint);
+		CHECK(aligned);
+		CHECK(counted);
+		CHECK(failed == 0);		// 32 live ranges of at most 64 KB can't touch all 128 of the block's 64 KB ranges
+		CHECK(block.IsEmpty() && block.GetLargestFreeRange() == BlockSize);
+	}
+
+	void TestSaveLoad(const std::vector<AllocationTraceEntry>& trace)
+	{
+		const char* fileName = "BuddyAllocatorTest.trace";
+		CHECK(SaveAllocationTrace(fileName, trace));
+
+		std::vector<AllocationTraceEntry> loaded;
+		CHECK(LoadAllocationTrace(fileName, loaded));
+		CHECK(loaded.size() == trace.size());
+		bool same = loaded.size() == trace.size();
+		for (size_t i = 0; same && i < trace.size(); i++)
+		{
+			same = loaded[i].Operation == trace[i].Operation && loaded[i].Pool == trace[i].Pool && loaded[i].Id == trace[i].Id
+				&& loaded[i].Size == trace[i].Size && loaded[i].Alignment == trace[i].Alignment;
+		}
+		CHECK(same);
+		std::remove(fileName);
+
+		CHECK(!LoadAllocationTrace("BuddyAllocatorTest.missing", loaded));
+	}
+}
+
+int main()
+{
+	TestRanges();
+	const std::vector<AllocationTraceEntry> trace = MakeTrace();
+	TestReplay(trace);
+	TestSaveLoad(trace);
+	return TestResult();
+}
@@ -0,0 +1,55 @@
+/**************************************************************
+	libFuzzer target for the DDS parser. Anything ParseDDSHeader
+	or ParseDDSTexture accepts has to describe subresources that
+	lie inside the input, an accepted header can't hand out bits
+	outside it, and nothing may read past the end while deciding.
+
+	With clang: -fsanitize=fuzzer,address. Without libFuzzer it
+	links against DDSParserFuzzerMain.cpp instead, which feeds it
+	the repo's .dds files, synthetic ones and mutations of both.
+**************************************************************/
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "DDSParser.h"
+
+using namespace DirectX;
+
+static bool Inside(const void* begin, size_t size, const uint8_t* data, size_t dataSize)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(begin);
+	return p >= data && p <= data + dataSize && size <= (size_t)(data + dataSize - p);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
+	size_t bitSize = 0;
+	if (ParseDDSHeader(data, size, &header, &bitData, &bitSize) == DDS_PARSE_OK)
+	{
+		if (!Inside(header, sizeof(DDS_HEADER), data, size) || !Inside(bitData, bitSize, data, size))
+			__builtin_trap();
+	}
+
+	// Once with the full chain and once dropping mips, which takes the skip path
+	for (size_t maxsize : { size_t(0), size_t(64) })
+	{
+		DDSTextureDesc desc;
+		std::vector<DDSSubresource> subresources;
+		if (ParseDDSTexture(data, size, maxsize, desc, subresources) != DDS_PARSE_OK)
+			continue;
+
+		if (subresources.size() != (size_t)desc.mipCount * desc.arraySize)
+			__builtin_trap();
+		for (size_t i = 0; i < subresources.size(); i++)
+		{
+			// A volume's mip is slicePitch times its depth
+			const uint32_t mip = (uint32_t)(i % desc.mipCount);
+			const size_t depth = desc.dimension == DDS_DIMENSION_TEXTURE3D && (desc.depth >> mip) > 1 ? desc.depth >> mip : 1;
+			if (!Inside(subresources[i].data, subresources[i].slicePitch * depth, data, size))
+				__builtin_trap();
+		}
+	}
+	return 0;
+}
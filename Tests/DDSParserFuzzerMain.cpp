@@ -0,0 +1,108 @@
+/**************************************************************
+	Stand-in for libFuzzer where it isn't available (GCC), so the
+	fuzz target still runs under ctest. Every input is the repo's
+	.dds files, a set of synthetic ones, files named on the command
+	line, and for each of them: every truncation of the headers,
+	every single bit flip in the headers, and a fixed number of
+	header words overwritten with values near the limits. Inputs
+	are copied into a buffer of exactly their size so the address
+	sanitizer sees any read past the end.
+**************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include "SyntheticDDS.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static size_t s_inputCount = 0;
+
+static void Run(const std::vector<uint8_t>& input, size_t size)
+{
+	std::vector<uint8_t> exact(input.begin(), input.begin() + size);
+	LLVMFuzzerTestOneInput(exact.data(), exact.size());
+	s_inputCount++;
+}
+
+static bool ReadFile(const char* fileName, std::vector<uint8_t>& buffer)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	buffer.resize(size > 0 ? size : 0);
+	const bool read = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	fclose(file);
+	return read;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::vector<uint8_t>> seeds;
+	std::vector<const char*> fileNames = { "bricks.dds", "checkboard.dds" };
+	for (int i = 1; i < argc; i++)
+		fileNames.push_back(argv[i]);
+	for (const char* fileName : fileNames)
+	{
+		std::vector<uint8_t> file;
+		if (!ReadFile(fileName, file))
+		{
+			std::printf("Couldn't read %s\n", fileName);
+			return 1;
+		}
+		seeds.push_back(file);
+	}
+
+	SyntheticDDSDesc desc;
+	desc.Width = 16; desc.Height = 8; desc.MipCount = 5;
+	seeds.push_back(MakeSyntheticDDS(desc));
+	desc.DX10Header = false;
+	seeds.push_back(MakeSyntheticDDS(desc));
+	desc.Format = DXGI_FORMAT_BC1_UNORM;
+	seeds.push_back(MakeSyntheticDDS(desc));
+	desc.DX10Header = true; desc.Format = DXGI_FORMAT_BC7_UNORM; desc.CubeMap = true; desc.ArraySize = 2;
+	seeds.push_back(MakeSyntheticDDS(desc));
+	desc = SyntheticDDSDesc();
+	desc.Dimension = DirectX::DDS_DIMENSION_TEXTURE3D; desc.Width = 8; desc.Height = 8; desc.Depth = 8; desc.MipCount = 4;
+	seeds.push_back(MakeSyntheticDDS(desc));
+	desc = SyntheticDDSDesc();
+	desc.Dimension = DirectX::DDS_DIMENSION_TEXTURE1D; desc.Width = 64; desc.ArraySize = 3; desc.MipCount = 7;
+	seeds.push_back(MakeSyntheticDDS(desc));
+
+	const uint32_t limits[] = { 0, 1, 2, 6, 15, 16, 2047, 2048, 2049, 16384, 16385, 0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff };
+	std::mt19937 random(1);
+	for (const std::vector<uint8_t>& seed : seeds)
+	{
+		const size_t headerSize = std::min<size_t>(seed.size(), sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10));
+
+		Run(seed, seed.size());
+		for (size_t size = 0; size <= headerSize; size++)
+			Run(seed, size);
+		for (size_t size = headerSize; size < seed.size(); size += std::max<size_t>(1, seed.size() / 64))
+			Run(seed, size);
+
+		std::vector<uint8_t> mutated = seed;
+		for (size_t bit = 0; bit < headerSize * 8; bit++)
+		{
+			mutated[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+			Run(mutated, mutated.size());
+			mutated[bit / 8] = seed[bit / 8];
+		}
+
+		for (int round = 0; round < 5000; round++)
+		{
+			mutated = seed;
+			for (int word = random() % 3; word >= 0; word--)
+			{
+				const uint32_t value = random() % 4 ? limits[random() % (sizeof(limits) / sizeof(limits[0]))] : (uint32_t)random();
+				memcpy(&mutated[(random() % (headerSize / 4)) * 4], &value, sizeof(value));
+			}
+			Run(mutated, mutated.size());
+		}
+	}
+
+	std::printf("%zu inputs from %zu seeds\n", s_inputCount, seeds.size());
+	return 0;
+}
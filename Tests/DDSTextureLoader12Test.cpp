@@ -0,0 +1,200 @@
+/**************************************************************
+	D3D12 side of the DDS loader on the null device, for every
+	dimension a DDS can have: 1D, 1D array, 2D, 2D array, 3D,
+	cube and cube array. The resource desc matches the file (and
+	GetDDSResourceDesc12), the upload heap is as big as the
+	footprints say, every subresource lands where its footprint
+	puts it, the SRV covers all of it, and only the plain 2D one
+	may go in the bindless table.
+**************************************************************/
+#include <cstdio>
+#include <vector>
+#include <wrl.h>
+#include "BindlessHeap.h"
+#include "DDSTextureLoader12.h"
+#include "NullD3D12.h"
+#include "SyntheticDDS.h"
+#include "Test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	struct Case
+	{
+		const char* Name;
+		SyntheticDDSDesc File;
+		D3D12_RESOURCE_DIMENSION Dimension;
+		UINT16 DepthOrArraySize;
+		D3D12_SRV_DIMENSION ViewDimension;
+	};
+
+	SyntheticDDSDesc File(DirectX::DDS_DIMENSION dimension, uint32_t width, uint32_t height, uint32_t depth, uint32_t arraySize,
+		uint32_t mipCount, DXGI_FORMAT format, bool cubeMap = false)
+	{
+		SyntheticDDSDesc desc;
+		desc.Dimension = dimension;
+		desc.Width = width;
+		desc.Height = height;
+		desc.Depth = depth;
+		desc.ArraySize = arraySize;
+		desc.MipCount = mipCount;
+		desc.Format = format;
+		desc.CubeMap = cubeMap;
+		return desc;
+	}
+
+	// Compares every subresource of 'texture' with the rows the parser found
+	bool Matches(ID3D12Resource* texture, const std::vector<DirectX::DDSSubresource>& subresources)
+	{
+		const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+		const UINT count = UINT(subresources.size());
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(count);
+		std::vector<UINT> rows(count);
+		std::vector<UINT64> rowSizes(count);
+		NullD3D12::GetCopyableFootprints(&desc, 0, count, 0, layouts.data(), rows.data(), rowSizes.data(), nullptr);
+
+		const UINT8* memory = static_cast<NullD3D12::Resource*>(texture)->GetMemory();
+		for (UINT i = 0; i < count; i++)
+		{
+			for (UINT z = 0; z < layouts[i].Footprint.Depth; z++)
+			{
+				for (UINT row = 0; row < rows[i]; row++)
+				{
+					const UINT8* source = static_cast<const UINT8*>(subresources[i].data) + z * subresources[i].slicePitch + row * subresources[i].rowPitch;
+					const UINT8* copied = memory + layouts[i].Offset + (UINT64(z) * rows[i] + row) * layouts[i].Footprint.RowPitch;
+					if (memcmp(source, copied, size_t(rowSizes[i])) != 0)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	ComPtr<ID3D12CommandQueue> queue;
+	ComPtr<ID3D12CommandAllocator> allocator;
+	ComPtr<ID3D12GraphicsCommandList> commandList;
+	ComPtr<ID3D12Fence> fence;
+	CHECK(SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue))));
+	CHECK(SUCCEEDED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator))));
+	CHECK(SUCCEEDED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList))));
+	CHECK(SUCCEEDED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence))));
+	CHECK(SUCCEEDED(commandList->Close()));
+	HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+	using namespace DirectX;
+	const Case cases[] =
+	{
+		{ "1D", File(DDS_DIMENSION_TEXTURE1D, 64, 1, 1, 1, 7, DXGI_FORMAT_R8G8B8A8_UNORM),
+			D3D12_RESOURCE_DIMENSION_TEXTURE1D, 1, D3D12_SRV_DIMENSION_TEXTURE1D },
+		{ "1D array", File(DDS_DIMENSION_TEXTURE1D, 100, 1, 1, 4, 5, DXGI_FORMAT_R16G16B16A16_FLOAT),
+			D3D12_RESOURCE_DIMENSION_TEXTURE1D, 4, D3D12_SRV_DIMENSION_TEXTURE1DARRAY },
+		{ "2D", File(DDS_DIMENSION_TEXTURE2D, 64, 32, 1, 1, 7, DXGI_FORMAT_BC1_UNORM),
+			D3D12_RESOURCE_DIMENSION_TEXTURE2D, 1, D3D12_SRV_DIMENSION_TEXTURE2D },
+		{ "2D array", File(DDS_DIMENSION_TEXTURE2D, 40, 24, 1, 3, 4, DXGI_FORMAT_R8G8B8A8_UNORM),
+			D3D12_RESOURCE_DIMENSION_TEXTURE2D, 3, D3D12_SRV_DIMENSION_TEXTURE2DARRAY },
+		{ "3D", File(DDS_DIMENSION_TEXTURE3D, 32, 16, 8, 1, 6, DXGI_FORMAT_R8G8B8A8_UNORM),
+			D3D12_RESOURCE_DIMENSION_TEXTURE3D, 8, D3D12_SRV_DIMENSION_TEXTURE3D },
+		{ "3D, block compressed", File(DDS_DIMENSION_TEXTURE3D, 20, 12, 5, 1, 3, DXGI_FORMAT_BC3_UNORM),
+			D3D12_RESOURCE_DIMENSION_TEXTURE3D, 5, D3D12_SRV_DIMENSION_TEXTURE3D },
+		{ "Cube", File(DDS_DIMENSION_TEXTURE2D, 16, 16, 1, 1, 5, DXGI_FORMAT_R8G8B8A8_UNORM, true),
+			D3D12_RESOURCE_DIMENSION_TEXTURE2D, 6, D3D12_SRV_DIMENSION_TEXTURECUBE },
+		{ "Cube array", File(DDS_DIMENSION_TEXTURE2D, 32, 32, 1, 3, 6, DXGI_FORMAT_BC3_UNORM, true),
+			D3D12_RESOURCE_DIMENSION_TEXTURE2D, 18, D3D12_SRV_DIMENSION_TEXTURECUBEARRAY },
+	};
+
+	for (const Case& test : cases)
+	{
+		const int failuresBefore = TestFailureCount();
+		const std::vector<uint8_t> file = MakeSyntheticDDS(test.File);
+
+		DDSTextureDesc parsed;
+		std::vector<DDSSubresource> subresources;
+		CHECK(ParseDDSTexture(file.data(), file.size(), 0, parsed, subresources) == DDS_PARSE_OK);
+
+		CHECK(SUCCEEDED(allocator->Reset()));
+		CHECK(SUCCEEDED(commandList->Reset(allocator.Get(), nullptr)));
+		ComPtr<ID3D12Resource> texture, uploadHeap;
+		CHECK(SUCCEEDED(CreateDDSTextureFromMemory12(device.Get(), commandList.Get(), file.data(), file.size(), texture, uploadHeap)));
+		if (!texture)
+		{
+			std::printf("%s: not created\n", test.Name);
+			continue;
+		}
+
+		// The resource is what the file describes
+		const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+		CHECK(desc.Dimension == test.Dimension);
+		CHECK(desc.Width == test.File.Width);
+		CHECK(desc.Height == (test.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ? 1 : test.File.Height));
+		CHECK(desc.DepthOrArraySize == test.DepthOrArraySize);
+		CHECK(desc.MipLevels == test.File.MipCount);
+		CHECK(desc.Format == test.File.Format);
+
+		D3D12_RESOURCE_DESC placedDesc;
+		CHECK(SUCCEEDED(GetDDSResourceDesc12(parsed, &placedDesc)));
+		CHECK(placedDesc.Dimension == desc.Dimension && placedDesc.Width == desc.Width && placedDesc.Height == desc.Height
+			&& placedDesc.DepthOrArraySize == desc.DepthOrArraySize && placedDesc.MipLevels == desc.MipLevels
+			&& placedDesc.Format == desc.Format && placedDesc.Flags == desc.Flags);
+
+		// One subresource per mip and slice, a 3D mip keeps its depth slices inside
+		const UINT subresourceCount = NullD3D12::SubresourceCount(desc);
+		CHECK(subresources.size() == subresourceCount);
+		CHECK(uploadHeap->GetDesc().Width == GetRequiredIntermediateSize(texture.Get(), 0, subresourceCount));
+
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+		device->GetCopyableFootprints(&desc, 0, subresourceCount, 0, layouts.data(), nullptr, nullptr, nullptr);
+		const UINT expectedDepth = test.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? test.File.Depth : 1;
+		CHECK(layouts[0].Footprint.Depth == expectedDepth);
+		CHECK(layouts[0].Footprint.Height == (test.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ? 1u
+			: NullD3D12::IsBlockCompressed(desc.Format) ? UINT(NullD3D12::AlignUp(test.File.Height, 4)) : test.File.Height));
+
+		// And every byte of it lands where the footprints say
+		NullD3D12::GraphicsCommandList* nullList = static_cast<NullD3D12::GraphicsCommandList*>(commandList.Get());
+		CHECK(nullList->GetErrorCount() == 0);
+		CHECK(nullList->GetCounts().Copies == subresourceCount);
+		CHECK(SUCCEEDED(commandList->Close()));
+		ID3D12CommandList* lists[] = { commandList.Get() };
+		queue->ExecuteCommandLists(1, lists);
+		const UINT64 fenceValue = fence->GetCompletedValue() + 1;
+		queue->Signal(fence.Get(), fenceValue);
+		fence->SetEventOnCompletion(fenceValue, event);
+		CHECK(WaitForSingleObject(event, 5000) == WAIT_OBJECT_0);
+		CHECK(static_cast<NullD3D12::CommandQueue*>(queue.Get())->GetErrorCount() == 0);
+		CHECK(Matches(texture.Get(), subresources));
+
+		// The view sees all mips and slices, cubes as cubes
+		D3D12_SHADER_RESOURCE_VIEW_DESC view;
+		GetShaderResourceViewDesc12(texture.Get(), parsed.isCubeMap, &view);
+		CHECK(view.ViewDimension == test.ViewDimension);
+		CHECK(view.Format == desc.Format);
+		switch (view.ViewDimension)
+		{
+		case D3D12_SRV_DIMENSION_TEXTURE1D: CHECK(view.Texture1D.MipLevels == desc.MipLevels); break;
+		case D3D12_SRV_DIMENSION_TEXTURE1DARRAY: CHECK(view.Texture1DArray.MipLevels == desc.MipLevels && view.Texture1DArray.ArraySize == desc.DepthOrArraySize); break;
+		case D3D12_SRV_DIMENSION_TEXTURE2D: CHECK(view.Texture2D.MipLevels == desc.MipLevels); break;
+		case D3D12_SRV_DIMENSION_TEXTURE2DARRAY: CHECK(view.Texture2DArray.MipLevels == desc.MipLevels && view.Texture2DArray.ArraySize == desc.DepthOrArraySize); break;
+		case D3D12_SRV_DIMENSION_TEXTURE3D: CHECK(view.Texture3D.MipLevels == desc.MipLevels); break;
+		case D3D12_SRV_DIMENSION_TEXTURECUBE: CHECK(view.TextureCube.MipLevels == desc.MipLevels); break;
+		case D3D12_SRV_DIMENSION_TEXTURECUBEARRAY: CHECK(view.TextureCubeArray.MipLevels == desc.MipLevels && view.TextureCubeArray.NumCubes == desc.DepthOrArraySize / 6u); break;
+		default: CHECK(false); break;
+		}
+
+		// The bindless table is Texture2D textures[], nothing else goes in
+		CHECK(BindlessHeap::CanSample(view) == (test.ViewDimension == D3D12_SRV_DIMENSION_TEXTURE2D));
+
+		if (TestFailureCount() != failuresBefore)
+			std::printf("%s: failed\n", test.Name);
+	}
+
+	CloseHandle(event);
+	return TestResult();
+}
@@ -0,0 +1,146 @@
+/**************************************************************
+	Descriptor free list: indices in order from a fresh list, none
+	once it's full, the last freed coming back first, and Reset.
+
+	Then threads hammering one list at once, each holding a few
+	indices at a time. Every index has an owner slot the thread
+	claims when it gets the index and clears before freeing it,
+	so an index handed to two threads at once, or freed while
+	someone else holds it, shows up as a claim that finds the slot
+	taken. Run with capacity to spare and with too little, so
+	the empty list is hit under contention too. Afterwards every
+	index has to come back out exactly once.
+**************************************************************/
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "DescriptorFreeList.h"
+#include "Test.h"
+
+namespace
+{
+	// Everything that's free comes out once, then nothing
+	bool DrainsOnce(DescriptorFreeList& list)
+	{
+		std::vector<bool> seen(list.GetCapacity());
+		for (uint32_t i = 0; i < list.GetCapacity(); i++)
+		{
+			const uint32_t index = list.Allocate();
+			if (index >= list.GetCapacity() || seen[index])
+				return false;
+			seen[index] = true;
+		}
+		return list.Allocate() == DescriptorFreeList::InvalidIndex;
+	}
+
+	void TestSingleThread()
+	{
+		DescriptorFreeList empty;
+		CHECK(empty.GetCapacity() == 0);
+		CHECK(empty.Allocate() == DescriptorFreeList::InvalidIndex);
+
+		DescriptorFreeList list(4);
+		for (uint32_t i = 0; i < 4; i++)
+			CHECK(list.Allocate() == i);
+		CHECK(list.Allocate() == DescriptorFreeList::InvalidIndex);
+
+		// Last in, first out
+		list.Free(1);
+		list.Free(3);
+		CHECK(list.Allocate() == 3);
+		CHECK(list.Allocate() == 1);
+		CHECK(list.Allocate() == DescriptorFreeList::InvalidIndex);
+
+		list.Reset(6);
+		CHECK(list.GetCapacity() == 6);
+		CHECK(DrainsOnce(list));
+	}
+
+	void TestContention(uint32_t capacity, unsigned int threadCount, unsigned int held, unsigned int rounds)
+	{
+		DescriptorFreeList list(capacity);
+		std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[capacity]);
+		for (uint32_t index = 0; index < capacity; index++)
+			owners[index] = -1;
+
+		std::atomic<unsigned int> conflicts(0), outOfRange(0), misses(0);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> threads;
+		for (unsigned int thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&, thread]()
+			{
+				while (!go)
+					std::this_thread::yield();
+
+				std::vector<uint32_t> mine;
+				for (unsigned int round = 0; round < rounds; round++)
+				{
+					// A varying number held at once, so the list's length keeps changing
+					const unsigned int want = 1 + (round * 7 + thread) % held;
+					while (mine.size() < want)
+					{
+						const uint32_t index = list.Allocate();
+						if (index == DescriptorFreeList::InvalidIndex)
+						{
+							misses++;
+							break;
+						}
+						if (index >= capacity)
+						{
+							outOfRange++;
+							break;
+						}
+
+						int expected = -1;
+						if (!owners[index].compare_exchange_strong(expected, int(thread)))
+							conflicts++;
+						mine.push_back(index);
+					}
+
+					// Give back all but one, oldest first, so frees and allocations interleave
+					while (mine.size() > 1)
+					{
+						const uint32_t index = mine.front();
+						mine.erase(mine.begin());
+						int expected = int(thread);
+						if (!owners[index].compare_exchange_strong(expected, -1))
+							conflicts++;
+						list.Free(index);
+					}
+				}
+
+				for (uint32_t index : mine)
+				{
+					owners[index] = -1;
+					list.Free(index);
+				}
+			});
+		}
+		go = true;
+		for (std::thread& thread : threads)
+			thread.join();
+
+		CHECK(conflicts == 0);
+		CHECK(outOfRange == 0);
+		CHECK(DrainsOnce(list));
+
+		// Only a list too small for everyone runs dry
+		if (capacity >= threadCount * held)
+			CHECK(misses == 0);
+	}
+}
+
+int main()
+{
+	TestSingleThread();
+
+	// More threads than cores on purpose, a thread preempted between reading the
+	// head and swapping it is where ABA comes from
+	const unsigned int threadCount = 8;
+	TestContention(1024, threadCount, 16, 20000);
+	TestContention(threadCount * 4, threadCount, 16, 20000);
+	TestContention(1, threadCount, 2, 20000);
+	return TestResult();
+}
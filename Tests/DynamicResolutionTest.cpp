@@ -0,0 +1,140 @@
+/**************************************************************
+	Dynamic resolution against a made up gpu whose time is 1 ms
+	plus a load that grows with the pixel count, the times
+	arriving three frames late like the real ones. The load steps
+	every 300 frames. A step has settled once the area is within
+	10% of the one that would hit the target, and has to within
+	the first half of the step. Changes of direction over the
+	second half mean it's oscillating: none with 5% noise on the
+	times, which the dead band is there to swallow.
+
+	Also: a load too high or too low for any scale pins it at the
+	ends without winding up, and scaled sizes are multiples of 8.
+**************************************************************/
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include "DynamicResolution.h"
+#include "Test.h"
+
+namespace
+{
+	const float TargetMs = 14.0f;		// TARGETGPUMS in WinMain
+	const unsigned int Latency = 3;		// BUFFERCOUNT
+	const int StepFrames = 300;
+
+	struct Step
+	{
+		float Scale;
+		int SettledAt;
+		unsigned int DirectionChanges;
+	};
+
+	// 'noise' is the relative amount either way
+	class SyntheticGpu
+	{
+	public:
+		explicit SyntheticGpu(float noise) : m_noise(noise), m_random(1), m_frame(0), m_times() { }
+
+		Step Run(DynamicResolution& resolution, float load)
+		{
+			const float minScale = resolution.GetSettings().MinScale;
+			const float maxScale = resolution.GetSettings().MaxScale;
+			float idealArea = (TargetMs - 1.0f) / load;
+			idealArea = std::fmin(std::fmax(idealArea, minScale * minScale), maxScale * maxScale);
+
+			Step result = { resolution.GetScale(), -1, 0 };
+			int lastDirection = 0;
+			for (int step = 0; step < StepFrames; step++, m_frame++)
+			{
+				float& slot = m_times[m_frame % Latency];
+				const float measured = slot;
+				slot = (1.0f + load * result.Scale * result.Scale) * (1.0f + m_noise * Random());
+				if (m_frame < Latency)
+					continue;
+
+				const float scale = resolution.Update(measured);
+				const int direction = scale > result.Scale ? 1 : scale < result.Scale ? -1 : 0;
+				if (step >= StepFrames / 2 && direction && lastDirection && direction != lastDirection)
+					result.DirectionChanges++;
+				if (direction)
+					lastDirection = direction;
+				result.Scale = scale;
+
+				if (result.SettledAt < 0 && std::fabs(scale * scale - idealArea) < 0.1f * idealArea)
+					result.SettledAt = step;
+			}
+			return result;
+		}
+
+	private:
+		// -1 to 1
+		float Random()
+		{
+			m_random = m_random * 1664525u + 1013904223u;
+			return float(m_random >> 8) / float(1u << 23) - 1.0f;
+		}
+
+		float m_noise;
+		uint32_t m_random;
+		unsigned int m_frame;
+		float m_times[Latency];
+	};
+
+	void TestConvergence(float noise)
+	{
+		DynamicResolution resolution;
+		resolution.Reset(DynamicResolution::DefaultSettings(TargetMs));
+		SyntheticGpu gpu(noise);
+		for (float load : { 10.0f, 30.0f, 20.0f, 45.0f, 8.0f })
+		{
+			const Step step = gpu.Run(resolution, load);
+			std::printf("%2.0f%% noise, %4.1f ms load: scale %.3f, settled after %d frames, %u changes of direction once settled\n",
+				100.0f * noise, load, step.Scale, step.SettledAt, step.DirectionChanges);
+			CHECK(step.SettledAt >= 0 && step.SettledAt < StepFrames / 2);
+			CHECK(step.DirectionChanges == 0);
+		}
+	}
+
+	void TestLimits()
+	{
+		DynamicResolution resolution;
+		resolution.Reset(DynamicResolution::DefaultSettings(TargetMs));
+		const DynamicResolution::Settings& settings = resolution.GetSettings();
+
+		// Far too slow at any scale: pinned at the minimum
+		for (int frame = 0; frame < 200; frame++)
+			resolution.Update(4.0f * TargetMs);
+		CHECK(std::fabs(resolution.GetScale() - settings.MinScale) < 1e-4f);
+
+		// And straight back up once it's fast again, nothing built up while it was pinned
+		int framesToMax = 0;
+		while (resolution.GetScale() < settings.MaxScale - 1e-4f && framesToMax < 200)
+		{
+			resolution.Update(0.25f * TargetMs);
+			framesToMax++;
+		}
+		CHECK(framesToMax < 30);
+
+		// Fast enough at full size stays there
+		for (int frame = 0; frame < 200; frame++)
+			resolution.Update(0.25f * TargetMs);
+		CHECK(std::fabs(resolution.GetScale() - settings.MaxScale) < 1e-4f);
+		CHECK(resolution.GetScaledSize(800) == 800);
+
+		for (int frame = 0; frame < 200; frame++)
+			resolution.Update(1.5f * TargetMs);
+		const uint32_t size = resolution.GetScaledSize(803);
+		CHECK(size % 8 == 0 && size < 803 && size >= uint32_t(803 * settings.MinScale) - 8);
+		CHECK(resolution.GetScaledSize(5) == 5);
+	}
+}
+
+int main()
+{
+	TestConvergence(0.0f);
+	TestConvergence(0.05f);
+	TestLimits();
+	return TestResult();
+}
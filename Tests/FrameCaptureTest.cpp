@@ -0,0 +1,286 @@
+/**************************************************************
+	Frame capture round trip. Two lists are recorded through
+	CapturedCommandList on the null device, each with a writer of
+	its own like WinMain's recording threads, covering every op.
+	The streams are joined, saved with SaveFrameCapture, loaded
+	back and replayed into a RecordingReplayBackend, which has to
+	see exactly the calls the lists were given: same ops, same
+	arguments, same constant and root SRV bytes.
+
+	Also checks that a stream cut anywhere replays the calls
+	before the cut and fails unless the cut is between two ops,
+	and that an unknown opcode fails.
+**************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <wrl.h>
+#include "d3dx12.h"
+#include "CaptureD3D12.h"
+#include "NullD3D12.h"
+#include "RecordingReplayBackend.h"
+#include "Test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Root signatures and PSOs aren't implemented on the null device and the null
+	// lists never look at them, any distinct pointers will do
+	int FakeRootSignature, FakePipelineStates[2];
+
+	template <typename T>
+	T* Fake(int& object) { return reinterpret_cast<T*>(&object); }
+
+	std::vector<uint8_t> RandomBytes(size_t size)
+	{
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& byte : bytes)
+			byte = uint8_t(std::rand());
+		return bytes;
+	}
+
+	ComPtr<ID3D12Resource> CreateResource(ID3D12Device* device, const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType)
+	{
+		const CD3DX12_HEAP_PROPERTIES heapProperties(heapType);
+		ComPtr<ID3D12Resource> resource;
+		CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON,
+			nullptr, IID_PPV_ARGS(&resource))));
+		return resource;
+	}
+
+	ComPtr<ID3D12DescriptorHeap> CreateHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT count, bool shaderVisible)
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+		desc.Type = type;
+		desc.NumDescriptors = count;
+		desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+		ComPtr<ID3D12DescriptorHeap> heap;
+		CHECK(SUCCEEDED(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap))));
+		return heap;
+	}
+}
+
+int main()
+{
+	std::srand(5);
+
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+
+	// Everything the frame touches, registered like WinMain does at startup
+	const ComPtr<ID3D12Resource> vertexBuffer = CreateResource(device.Get(), CD3DX12_RESOURCE_DESC::Buffer(64 * 1024), D3D12_HEAP_TYPE_DEFAULT);
+	const ComPtr<ID3D12Resource> indexBuffer = CreateResource(device.Get(), CD3DX12_RESOURCE_DESC::Buffer(16 * 1024), D3D12_HEAP_TYPE_DEFAULT);
+	const ComPtr<ID3D12Resource> target = CreateResource(device.Get(), CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, 1, 1, 0,
+		D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), D3D12_HEAP_TYPE_DEFAULT);
+	const ComPtr<ID3D12Resource> aliased = CreateResource(device.Get(), CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, 4, 1, 0,
+		D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), D3D12_HEAP_TYPE_DEFAULT);
+	const ComPtr<ID3D12Resource> depth = CreateResource(device.Get(), CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, 64, 64, 1, 1, 1, 0,
+		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_HEAP_TYPE_DEFAULT);
+	const ComPtr<ID3D12DescriptorHeap> rtvHeap = CreateHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 4, false);
+	const ComPtr<ID3D12DescriptorHeap> dsvHeap = CreateHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 2, false);
+	const ComPtr<ID3D12DescriptorHeap> srvHeap = CreateHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64, true);
+
+	const UINT rtvSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	const D3D12_CPU_DESCRIPTOR_HANDLE rtv = { rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr + 2 * rtvSize };
+	const D3D12_CPU_DESCRIPTOR_HANDLE dsv = { dsvHeap->GetCPUDescriptorHandleForHeapStart().ptr + device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV) };
+	device->CreateRenderTargetView(target.Get(), nullptr, rtv);
+	device->CreateDepthStencilView(depth.Get(), nullptr, dsv);
+	const D3D12_GPU_DESCRIPTOR_HANDLE table = { srvHeap->GetGPUDescriptorHandleForHeapStart().ptr
+		+ 5 * device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) };
+
+	CaptureObjectTable objects;
+	const uint16_t rootSignatureId = objects.Register(&FakeRootSignature);
+	const uint16_t pipelineStateIds[2] = { objects.Register(&FakePipelineStates[0]), objects.Register(&FakePipelineStates[1]) };
+	RegisterCaptureBuffer(objects, vertexBuffer.Get());
+	RegisterCaptureBuffer(objects, indexBuffer.Get());
+	RegisterCaptureHeap(objects, device.Get(), rtvHeap.Get());
+	RegisterCaptureHeap(objects, device.Get(), dsvHeap.Get());
+	RegisterCaptureHeap(objects, device.Get(), srvHeap.Get());
+	const uint16_t targetId = objects.Register(target.Get());
+	const uint16_t aliasedId = objects.Register(aliased.Get());
+	const uint16_t depthId = objects.Register(depth.Get());
+
+	// What the captured references should resolve to
+	const CaptureRef vertexRef = objects.Find(vertexBuffer->GetGPUVirtualAddress() + 1024);
+	const CaptureRef indexRef = objects.Find(indexBuffer->GetGPUVirtualAddress());
+	const CaptureRef rtvRef = objects.Find(UINT64(rtv.ptr)), dsvRef = objects.Find(UINT64(dsv.ptr)), tableRef = objects.Find(table.ptr);
+	const uint16_t srvHeapId = objects.Find(srvHeap.Get());
+	const CaptureRef noDepth = { CaptureObjectTable::InvalidId, 0 };
+	CHECK(vertexRef.Offset == 1024 && indexRef.Offset == 0 && rtvRef.Offset == 2 * rtvSize && tableRef.Object != srvHeapId);
+
+	ComPtr<ID3D12CommandAllocator> allocator;
+	CHECK(SUCCEEDED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator))));
+	ComPtr<ID3D12GraphicsCommandList> lists[2];
+	for (ComPtr<ID3D12GraphicsCommandList>& list : lists)
+		CHECK(SUCCEEDED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&list))));
+
+	// Every call goes to the capturing list and, with the ids and offsets it should
+	// encode to, to 'expected'. After each call the stream is whole: Step() keeps
+	// its length and how many calls it decodes to.
+	struct Boundary
+	{
+		size_t Size, Calls;
+	};
+	CaptureWriter writers[2];
+	RecordingReplayBackend expected;
+	std::vector<Boundary> boundaries(1, Boundary{ 0, 0 });
+	auto Step = [&](size_t streamOffset, size_t writerIndex)
+	{
+		boundaries.push_back({ streamOffset + writers[writerIndex].GetBytes().size(), expected.GetCalls().size() });
+	};
+
+	const std::vector<uint8_t> frameConstants = RandomBytes(272), drawConstants = RandomBytes(96), drawBuffer = RandomBytes(1000);
+	const uint32_t rootConstants[4] = { 7, 0xdeadbeef, 0, 42 };
+	const D3D12_VERTEX_BUFFER_VIEW vertexView = { vertexBuffer->GetGPUVirtualAddress() + 1024, 24 * 32, 32 };
+	const D3D12_INDEX_BUFFER_VIEW indexView = { indexBuffer->GetGPUVirtualAddress(), 36 * 2, DXGI_FORMAT_R16_UINT };
+	const D3D12_VIEWPORT viewport = { 0.0f, 0.0f, 640.5f, 480.25f, 0.0f, 1.0f };
+	const D3D12_RECT scissor = { 1, 2, 640, 480 };
+	const float clearColor[4] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+	// The main list: clears, state, barriers (plain, split, aliasing) and a few draws
+	{
+		CapturedCommandList list(lists[0].Get(), objects, &writers[0]);
+		expected.BeginList(); Step(0, 0);
+
+		list.ResourceBarrier(target.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		expected.Barrier(targetId, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET, 0); Step(0, 0);
+
+		D3D12_RESOURCE_BARRIER barriers[3] = {};
+		barriers[0] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, aliased.Get());
+		barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(aliased.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 3,
+			D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+		barriers[2] = CD3DX12_RESOURCE_BARRIER::Aliasing(target.Get(), depth.Get());
+		list.ResourceBarrier(3, barriers);
+		expected.AliasingBarrier(CaptureObjectTable::InvalidId, aliasedId);
+		expected.Barrier(aliasedId, 3, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+		expected.AliasingBarrier(targetId, depthId); Step(0, 0);
+
+		list.OMSetRenderTarget(rtv, &dsv);
+		expected.SetRenderTarget(rtvRef, dsvRef); Step(0, 0);
+		list.ClearRenderTargetView(rtv, clearColor);
+		expected.ClearRenderTarget(rtvRef, clearColor); Step(0, 0);
+		list.ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0x80);
+		expected.ClearDepthStencil(dsvRef, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0x80); Step(0, 0);
+
+		list.SetGraphicsRootSignature(Fake<ID3D12RootSignature>(FakeRootSignature));
+		expected.SetRootSignature(rootSignatureId); Step(0, 0);
+		list.SetPipelineState(Fake<ID3D12PipelineState>(FakePipelineStates[1]));
+		expected.SetPipelineState(pipelineStateIds[1]); Step(0, 0);
+		list.SetDescriptorHeap(srvHeap.Get());
+		expected.SetDescriptorHeap(srvHeapId); Step(0, 0);
+		list.SetGraphicsRootDescriptorTable(1, table);
+		expected.SetRootDescriptorTable(1, tableRef); Step(0, 0);
+		list.SetGraphicsRootConstantBufferView(0, 0x1000, frameConstants.data(), UINT(frameConstants.size()));
+		expected.SetRootConstantBuffer(0, frameConstants.data(), uint32_t(frameConstants.size())); Step(0, 0);
+		list.IASetVertexBuffer(0, vertexView);
+		expected.SetVertexBuffer(0, vertexRef, vertexView.SizeInBytes, vertexView.StrideInBytes); Step(0, 0);
+		list.IASetIndexBuffer(indexView);
+		expected.SetIndexBuffer(indexRef, indexView.SizeInBytes, DXGI_FORMAT_R16_UINT); Step(0, 0);
+		list.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		expected.SetTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); Step(0, 0);
+		const float viewportValues[6] = { viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+		list.RSSetViewport(viewport);
+		expected.SetViewport(viewportValues); Step(0, 0);
+		const int32_t scissorValues[4] = { scissor.left, scissor.top, scissor.right, scissor.bottom };
+		list.RSSetScissorRect(scissor);
+		expected.SetScissorRect(scissorValues); Step(0, 0);
+		list.DrawIndexedInstanced(36, 2, 6, -3, 1);
+		expected.DrawIndexed(36, 2, 6, -3, 1); Step(0, 0);
+		list.OMSetRenderTarget(rtv, nullptr);
+		expected.SetRenderTarget(rtvRef, noDepth); Step(0, 0);
+		list.DrawInstanced(3, 1, 0, 0);
+		expected.Draw(3, 1, 0, 0); Step(0, 0);
+		lists[0]->Close();
+	}
+
+	// A chunk list: per draw data three ways, like the draw bindings
+	const size_t chunkOffset = writers[0].GetBytes().size();
+	{
+		CapturedCommandList list(lists[1].Get(), objects, &writers[1]);
+		expected.BeginList(); Step(chunkOffset, 1);
+		list.SetPipelineState(Fake<ID3D12PipelineState>(FakePipelineStates[0]));
+		expected.SetPipelineState(pipelineStateIds[0]); Step(chunkOffset, 1);
+		list.SetGraphicsRootShaderResourceView(2, 0x2000, drawBuffer.data(), UINT(drawBuffer.size()));
+		expected.SetRootShaderResource(2, drawBuffer.data(), uint32_t(drawBuffer.size())); Step(chunkOffset, 1);
+		for (uint32_t draw = 0; draw < 3; draw++)
+		{
+			list.SetGraphicsRoot32BitConstants(3, 4, rootConstants, draw);
+			expected.SetRootConstants(3, draw, rootConstants, 4); Step(chunkOffset, 1);
+			list.SetGraphicsRootConstantBufferView(4, 0x3000 + 256 * draw, drawConstants.data(), UINT(drawConstants.size()));
+			expected.SetRootConstantBuffer(4, drawConstants.data(), uint32_t(drawConstants.size())); Step(chunkOffset, 1);
+			list.DrawIndexedInstanced(36, 1, 0, 0, draw);
+			expected.DrawIndexed(36, 1, 0, 0, draw); Step(chunkOffset, 1);
+		}
+		lists[1]->Close();
+	}
+	for (ComPtr<ID3D12GraphicsCommandList>& list : lists)
+		CHECK(static_cast<NullD3D12::GraphicsCommandList*>(list.Get())->GetErrorCount() == 0);
+
+	// Joined in submit order, through a file and back
+	std::vector<uint8_t> frame(writers[0].GetBytes());
+	frame.insert(frame.end(), writers[1].GetBytes().begin(), writers[1].GetBytes().end());
+	CHECK(boundaries.back().Size == frame.size() && boundaries.back().Calls == expected.GetCalls().size());
+
+	const char* fileName = "FrameCaptureTest.cap";
+	std::vector<uint8_t> loaded;
+	CHECK(SaveFrameCapture(fileName, frame));
+	CHECK(LoadFrameCapture(fileName, loaded));
+	std::remove(fileName);
+	CHECK(loaded == frame);
+
+	RecordingReplayBackend replayed;
+	CHECK(ReplayFrame(loaded.data(), loaded.size(), replayed));
+	CHECK(replayed.GetCalls().size() == expected.GetCalls().size());
+	bool same = replayed.GetCalls().size() == expected.GetCalls().size();
+	for (size_t call = 0; same && call < expected.GetCalls().size(); call++)
+	{
+		if (replayed.GetCalls()[call] != expected.GetCalls()[call])
+		{
+			std::printf("Call %zu (op %d) doesn't round trip\n", call, int(expected.GetCalls()[call].Op));
+			same = false;
+		}
+	}
+	CHECK(same);
+
+	// Every op is covered
+	bool covered[CAPTURE_OP_COUNT] = {};
+	for (const ReplayedCall& call : replayed.GetCalls())
+		covered[call.Op] = true;
+	for (int op = 0; op < CAPTURE_OP_COUNT; op++)
+	{
+		if (!covered[op])
+			std::printf("Op %d isn't covered\n", op);
+		CHECK(covered[op]);
+	}
+
+	// Cut anywhere: whatever was whole before the cut replays, the rest fails. A cut
+	// inside the barrier batch can still land between two of its ops.
+	bool cutsBehave = true;
+	size_t next = 1;
+	for (size_t size = 0; size < frame.size(); size++)
+	{
+		while (boundaries[next].Size <= size)
+			next++;
+		const Boundary& before = boundaries[next - 1];
+		const Boundary& after = boundaries[next];
+
+		RecordingReplayBackend cut;
+		const bool ok = ReplayFrame(frame.data(), size, cut);
+		if (size == before.Size)
+			cutsBehave &= ok && cut.GetCalls().size() == before.Calls;
+		else
+			cutsBehave &= cut.GetCalls().size() >= before.Calls && cut.GetCalls().size() < after.Calls && (!ok || after.Calls - before.Calls > 1);
+		for (size_t call = 0; call < cut.GetCalls().size(); call++)
+			cutsBehave &= cut.GetCalls()[call] == expected.GetCalls()[call];
+	}
+	CHECK(cutsBehave);
+
+	std::vector<uint8_t> corrupt(frame);
+	corrupt.push_back(CAPTURE_OP_COUNT);
+	RecordingReplayBackend rejected;
+	CHECK(!ReplayFrame(corrupt.data(), corrupt.size(), rejected));
+	CHECK(rejected.GetCalls().size() == expected.GetCalls().size());
+
+	return TestResult();
+}
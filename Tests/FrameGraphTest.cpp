@@ -0,0 +1,178 @@
+/**************************************************************
+	Frame graph: a pass that only writes something nobody reads
+	is culled, a transient read before it's written fails to
+	compile, barriers go in front of the pass that needs them and
+	imported resources are put back in their final state.
+	Compiling the same graph again gives the same barriers.
+
+	Then synthetic graphs of 10 to 1000 passes, the benchmark's
+	shape, checked against lifetimes worked out here from the
+	accesses and the execution order: two transients alive at the
+	same time never share bytes, every one that shares bytes with
+	anything is marked for an aliasing barrier, and aliasing
+	actually saves memory.
+**************************************************************/
+#include <algorithm>
+#include <vector>
+#include <d3d12.h>
+#include "FrameGraph.h"
+#include "Test.h"
+
+namespace
+{
+	const uint32_t Present = D3D12_RESOURCE_STATE_PRESENT;
+	const uint32_t RenderTarget = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	const uint32_t ShaderResource = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	const uint64_t Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	bool HasBarrier(const FrameGraph& graph, uint32_t pass, uint32_t resource, uint32_t before, uint32_t after, bool aliasing)
+	{
+		uint32_t count = 0;
+		const FrameGraphBarrier* barriers = graph.GetBarriers(pass, &count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (barriers[i].Resource == resource && barriers[i].Aliasing == aliasing
+				&& (aliasing || (barriers[i].StateBefore == before && barriers[i].StateAfter == after)))
+				return true;
+		}
+		return false;
+	}
+
+	void TestSmallGraph()
+	{
+		FrameGraph graph;
+		const uint32_t backBuffer = graph.Import("Back buffer", Present, Present);
+		const uint32_t scene = graph.CreateTransient("Scene", 4 << 20, Alignment);
+		const uint32_t unused = graph.CreateTransient("Unused", 4 << 20, Alignment);
+
+		const uint32_t scenePass = graph.AddPass("Scene");
+		graph.Write(scene, RenderTarget);
+		const uint32_t culledPass = graph.AddPass("Culled");
+		graph.Write(unused, RenderTarget);
+		const uint32_t upscalePass = graph.AddPass("Upscale");
+		graph.Read(scene, ShaderResource);
+		graph.Write(backBuffer, RenderTarget);
+		CHECK(graph.Compile());
+
+		CHECK(graph.GetOrder().size() == 2 && graph.GetOrder()[0] == scenePass && graph.GetOrder()[1] == upscalePass);
+		CHECK(graph.IsCulled(culledPass) && graph.GetCulledCount() == 1);
+		CHECK(!graph.IsUsed(unused));
+		CHECK(graph.GetFirstState(scene) == RenderTarget);
+		CHECK(HasBarrier(graph, upscalePass, scene, RenderTarget, ShaderResource, false));
+		CHECK(HasBarrier(graph, upscalePass, backBuffer, Present, RenderTarget, false));
+		CHECK(graph.GetFinalBarriers().size() == 1 && graph.GetFinalBarriers()[0].StateAfter == Present);
+		CHECK(graph.GetPeakSize() == 4 << 20);
+
+		// Again without a Reset(), the back buffer still comes in as Present
+		const size_t barrierCount = graph.GetBarrierCount();
+		CHECK(graph.Compile());
+		CHECK(graph.GetBarrierCount() == barrierCount);
+		CHECK(HasBarrier(graph, upscalePass, backBuffer, Present, RenderTarget, false));
+		CHECK(graph.GetFinalBarriers().size() == 1 && graph.GetFinalBarriers()[0].StateBefore == RenderTarget);
+
+		// Reading a transient nothing wrote yet
+		graph.Reset();
+		const uint32_t output = graph.Import("Output", Present, Present);
+		const uint32_t garbage = graph.CreateTransient("Garbage", 1 << 20, Alignment);
+		graph.AddPass("Read");
+		graph.Read(garbage, ShaderResource);
+		graph.Write(output, RenderTarget);
+		CHECK(!graph.Compile());
+	}
+
+	struct Use
+	{
+		uint32_t Pass;
+		uint32_t Resource;
+	};
+
+	void TestSynthetic(uint32_t passCount)
+	{
+		FrameGraph graph;
+		std::vector<Use> uses;
+		const uint32_t output = graph.Import("Output", Present, Present);
+		const uint32_t unused = graph.CreateTransient("Unused", 8 << 20, Alignment);
+		const uint32_t firstTarget = graph.GetResourceCount();
+		for (uint32_t pass = 0; pass < passCount; pass++)
+			graph.CreateTransient("Target", (1 + pass % 4) * (2 << 20), Alignment);
+
+		// Every access also noted here, with the pass it belongs to
+		uint32_t passIndex = 0;
+		auto Access = [&](uint32_t resource, uint32_t state, bool write)
+		{
+			if (write)
+				graph.Write(resource, state);
+			else
+				graph.Read(resource, state);
+			uses.push_back({ passIndex, resource });
+		};
+		for (uint32_t pass = 0; pass < passCount; pass++)
+		{
+			passIndex = graph.AddPass("Pass");
+			Access(firstTarget + pass, RenderTarget, true);
+			if (pass > 0)
+				Access(firstTarget + pass - 1, ShaderResource, false);
+			if (pass >= 8 && pass % 10 == 0)
+				Access(firstTarget + pass - 8, ShaderResource, false);
+			if (pass == passCount / 2)
+			{
+				passIndex = graph.AddPass("Culled");
+				Access(unused, RenderTarget, true);
+			}
+		}
+		passIndex = graph.AddPass("Present");
+		Access(firstTarget + passCount - 1, ShaderResource, false);
+		graph.Write(output, RenderTarget);
+		CHECK(graph.Compile());
+		CHECK(graph.GetCulledCount() == 1 && !graph.IsUsed(unused));
+
+		// Lifetimes in execution order positions
+		std::vector<uint32_t> position(passIndex + 1, FrameGraph::InvalidId);
+		for (uint32_t i = 0; i < graph.GetOrder().size(); i++)
+			position[graph.GetOrder()[i]] = i;
+		std::vector<uint32_t> first(graph.GetResourceCount(), FrameGraph::InvalidId), last(graph.GetResourceCount(), 0);
+		for (const Use& use : uses)
+		{
+			if (position[use.Pass] == FrameGraph::InvalidId)
+				continue;
+			first[use.Resource] = std::min(first[use.Resource], position[use.Pass]);
+			last[use.Resource] = std::max(last[use.Resource], position[use.Pass]);
+		}
+
+		// Every pair of placed transients
+		bool disjoint = true, marked = true, aligned = true;
+		uint64_t total = 0;
+		for (uint32_t a = firstTarget; a < graph.GetResourceCount(); a++)
+		{
+			aligned &= graph.GetOffset(a) % Alignment == 0;
+			total += graph.GetSize(a);
+
+			bool shares = false;
+			for (uint32_t b = firstTarget; b < graph.GetResourceCount(); b++)
+			{
+				const bool overlapBytes = b != a && graph.GetOffset(a) < graph.GetOffset(b) + graph.GetSize(b) && graph.GetOffset(b) < graph.GetOffset(a) + graph.GetSize(a);
+				const bool overlapLifetime = first[a] <= last[b] && first[b] <= last[a];
+				if (overlapBytes && overlapLifetime)
+					disjoint = false;
+				shares |= overlapBytes;
+			}
+
+			// Only the first pass that uses a shared transient gets the aliasing barrier
+			const uint32_t firstPass = graph.GetOrder()[first[a]];
+			marked &= HasBarrier(graph, firstPass, a, 0, 0, true) == shares;
+		}
+		CHECK(disjoint);
+		CHECK(marked);
+		CHECK(aligned);
+		CHECK(graph.GetUnaliasedSize() == total);
+		CHECK(graph.GetPeakSize() < total || passCount < 4);
+	}
+}
+
+int main()
+{
+	TestSmallGraph();
+	for (uint32_t passCount : { 10, 100, 1000 })
+		TestSynthetic(passCount);
+	return TestResult();
+}
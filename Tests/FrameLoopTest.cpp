@@ -0,0 +1,352 @@
+/**************************************************************
+	Frame loop on the null device, with a platform that quits
+	after a set number of presents. Every frame clears its back
+	buffer to a color of its own: the update only ever sees a
+	slot whose last frame is done, no more than Count frames are
+	in flight, allocators are reset once per use, the clears land
+	in the right back buffers in submission order, and a slow gpu
+	shows up as fence wait time rather than anywhere else.
+
+	Then the app's own scene (CubeScene.h) for a second run, the
+	same init and recording WinMain does, with the per phase
+	report a headless run prints.
+**************************************************************/
+#include <cstdio>
+#include <vector>
+#include <wrl.h>
+#include "d3dx12.h"
+#include "CubeScene.h"
+#include "FrameLoop.h"
+#include "NullD3D12.h"
+#include "Test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	struct NullPlatform
+	{
+		UINT FrameLimit = 0;
+		UINT Presented = 0;
+		UINT Pumped = 0;
+
+		bool PumpMessages()
+		{
+			Pumped++;
+			return Presented < FrameLimit;
+		}
+
+		void Present() { Presented++; }
+	};
+
+	struct FrameContext
+	{
+		ID3D12CommandAllocator* CommandAllocator;
+		UINT64 FenceValue;		// What the slot's last frame was signaled with
+		UINT Frame;
+	};
+
+	const UINT SlotCount = 3;
+	typedef FrameLoop<NullPlatform, FrameContext, SlotCount> NullFrameLoop;
+
+	// The color frame 'frame' clears to, distinct for the first 255 frames
+	void FrameColor(UINT frame, float color[4])
+	{
+		color[0] = (frame % 256) / 255.0f;
+		color[1] = 1.0f - color[0];
+		color[2] = 0.5f;
+		color[3] = 1.0f;
+	}
+
+	bool IsCleared(ID3D12Resource* target, UINT frame)
+	{
+		float color[4];
+		FrameColor(frame, color);
+		const D3D12_RESOURCE_DESC desc = target->GetDesc();
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = {};
+		NullD3D12::GetCopyableFootprints(&desc, 0, 1, 0, &layout, nullptr, nullptr, nullptr);
+
+		const UINT8* memory = static_cast<NullD3D12::Resource*>(target)->GetMemory();
+		for (UINT y = 0; y < desc.Height; y++)
+		{
+			for (UINT x = 0; x < desc.Width; x++)
+			{
+				const UINT8* texel = memory + UINT64(y) * layout.Footprint.RowPitch + 4 * x;
+				for (int i = 0; i < 4; i++)
+				{
+					if (texel[i] != UINT8(color[i] * 255.0f + 0.5f))
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Frames clearing their back buffers, checked pixel by pixel
+	void TestClearFrames()
+	{
+		ComPtr<NullD3D12::Device> device;
+		device.Attach(new NullD3D12::Device());
+		device->QueueLatency = std::chrono::milliseconds(2);		// The gpu is the bottleneck
+
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+		ComPtr<ID3D12CommandQueue> queue;
+		CHECK(SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue))));
+
+		NullPlatform platform;
+		platform.FrameLimit = 30;
+		{
+			NullFrameLoop loop;
+			CHECK(SUCCEEDED(loop.Init(device.Get(), queue.Get(), &platform)));
+			CHECK(device->GetAllocatorCount() == SlotCount);
+
+			// Back buffers and their views, in a heap of their own like the app's
+			ComPtr<ID3D12Resource> backBuffers[SlotCount];
+			const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+			const CD3DX12_RESOURCE_DESC targetDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 40, 30, 1, 1, 1, 0,
+				D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+			for (ComPtr<ID3D12Resource>& backBuffer : backBuffers)
+			{
+				CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &targetDesc, D3D12_RESOURCE_STATE_PRESENT,
+					nullptr, IID_PPV_ARGS(&backBuffer))));
+			}
+
+			D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+			rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+			rtvHeapDesc.NumDescriptors = SlotCount;
+			ComPtr<ID3D12DescriptorHeap> rtvHeap;
+			CHECK(SUCCEEDED(device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&rtvHeap))));
+			const UINT rtvSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+			CHECK(rtvHeap->GetGPUDescriptorHandleForHeapStart().ptr == 0);
+			for (UINT slot = 0; slot < SlotCount; slot++)
+			{
+				const D3D12_CPU_DESCRIPTOR_HANDLE view = { rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr + slot * rtvSize };
+				device->CreateRenderTargetView(backBuffers[slot].Get(), nullptr, view);
+				CHECK(NullD3D12::GetDescriptor(view).Resource == backBuffers[slot].Get());
+				CHECK(NullD3D12::GetDescriptor(view).Format == DXGI_FORMAT_R8G8B8A8_UNORM);
+			}
+
+			ComPtr<ID3D12GraphicsCommandList> commandList;
+			CHECK(SUCCEEDED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, loop[0].CommandAllocator, nullptr, IID_PPV_ARGS(&commandList))));
+			commandList->Close();
+
+			// Frames as the app runs them
+			UINT frame = 0;
+			UINT64 lastFenceValue = 0;
+			bool slotsReady = true, inFlightBounded = true, fencesInOrder = true, listsClean = true;
+			while (loop.RunFrame(
+				[&](FrameContext& context, UINT64 completedFenceValue)
+				{
+					slotsReady &= completedFenceValue >= context.FenceValue;
+					inFlightBounded &= loop.GetFenceValue() - completedFenceValue < SlotCount;
+				},
+				[&](FrameContext& context, std::vector<ID3D12CommandList*>& lists)
+				{
+					const UINT slot = loop.GetIndex();
+					float color[4];
+					FrameColor(frame, color);
+					commandList->Reset(context.CommandAllocator, nullptr);
+					const CD3DX12_RESOURCE_BARRIER toTarget = CD3DX12_RESOURCE_BARRIER::Transition(backBuffers[slot].Get(),
+						D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+					commandList->ResourceBarrier(1, &toTarget);
+					commandList->ClearRenderTargetView({ rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr + slot * rtvSize }, color, 0, nullptr);
+					const CD3DX12_RESOURCE_BARRIER toPresent = CD3DX12_RESOURCE_BARRIER::Transition(backBuffers[slot].Get(),
+						D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+					commandList->ResourceBarrier(1, &toPresent);
+					commandList->Close();
+					listsClean &= static_cast<NullD3D12::GraphicsCommandList*>(commandList.Get())->GetErrorCount() == 0;
+					lists.push_back(commandList.Get());
+					context.Frame = frame;
+				},
+				[&](UINT64 fenceValue)
+				{
+					fencesInOrder &= fenceValue == lastFenceValue + 1;
+					lastFenceValue = fenceValue;
+					loop[loop.GetIndex()].FenceValue = fenceValue;
+					frame++;
+				}))
+			{
+			}
+
+			CHECK(slotsReady && inFlightBounded && fencesInOrder && listsClean);
+			CHECK(frame == platform.FrameLimit && platform.Presented == platform.FrameLimit);
+			CHECK(platform.Pumped == platform.FrameLimit + 1);		// The one that said quit didn't start a frame
+			CHECK(loop.GetFrameCount() == platform.FrameLimit);
+			CHECK(loop.GetFenceValue() == platform.FrameLimit);
+			CHECK(!loop.RunFrame([](FrameContext&, UINT64) { }, [](FrameContext&, std::vector<ID3D12CommandList*>&) { }, [](UINT64) { }));
+			CHECK(loop.GetFrameCount() == platform.FrameLimit);
+
+			// Each allocator was reset once for every frame its slot ran
+			for (UINT slot = 0; slot < SlotCount; slot++)
+				CHECK(static_cast<NullD3D12::CommandAllocator*>(loop[slot].CommandAllocator)->GetResetCount() == platform.FrameLimit / SlotCount);
+
+			// Two ms of "gpu" a frame against next to no cpu: nearly every frame after the
+			// first few waits for its slot, and that's where the time goes
+			CHECK(loop.GetWaitCount() >= platform.FrameLimit - SlotCount - 1);
+			CHECK(loop.GetWaitSeconds() > 0.0);
+			CHECK(loop.GetPhaseSeconds(NullFrameLoop::PHASE_WAIT) >= loop.GetWaitSeconds());
+			CHECK(loop.GetPhaseSeconds(NullFrameLoop::PHASE_WAIT) > loop.GetPhaseSeconds(NullFrameLoop::PHASE_RECORD));
+
+			// Every back buffer holds the clear of the last frame that used its slot
+			loop.Flush();
+			CHECK(loop.GetCompletedFenceValue() == loop.GetFenceValue());
+			CHECK(static_cast<NullD3D12::CommandQueue*>(queue.Get())->GetErrorCount() == 0);
+			for (UINT slot = 0; slot < SlotCount; slot++)
+				CHECK(IsCleared(backBuffers[slot].Get(), loop[slot].Frame));
+
+			for (int phase = 0; phase < NullFrameLoop::PHASE_COUNT; phase++)
+			{
+				std::printf("%s: %.3f ms/frame\n", NullFrameLoop::GetPhaseName(NullFrameLoop::Phase(phase)),
+					1000.0 * loop.GetPhaseSeconds(NullFrameLoop::Phase(phase)) / loop.GetFrameCount());
+			}
+
+			// Work outside a frame (the app's init and teardown) goes through Signal and Flush
+			const UINT64 signaled = loop.Signal();
+			loop.Flush();
+			CHECK(loop.GetCompletedFenceValue() == signaled);
+		}
+	}
+
+	// The app's own scene, as WinMain runs it: two materials streamed in, a couple
+	// hundred cubes recorded on four threads in every draw binding, then the
+	// instanced path, every frame captured. The root signatures and PSOs are made
+	// up, the null device only looks at what they're set on.
+	void TestCubeScene()
+	{
+		ComPtr<NullD3D12::Device> device;
+		device.Attach(new NullD3D12::Device());
+		device->QueueLatency = std::chrono::milliseconds(1);		// Gives the texture workers time to finish
+
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+		ComPtr<ID3D12CommandQueue> queue;
+		CHECK(SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue))));
+
+		NullPlatform platform;
+		platform.FrameLimit = 60;
+
+		ResourceHeapAllocator heaps;
+		CHECK(SUCCEEDED(heaps.Init(device.Get(), nullptr, 4 * 1024 * 1024)));
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), 1024 * 1024, 4, &heaps)));
+
+		NullFrameLoop loop;
+		CHECK(SUCCEEDED(loop.Init(device.Get(), queue.Get(), &platform)));
+
+		ComPtr<ID3D12Resource> backBuffers[SlotCount];
+		ID3D12Resource* backBufferPointers[SlotCount];
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		const CD3DX12_RESOURCE_DESC targetDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 800, 600, 1, 1, 1, 0,
+			D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+		for (UINT slot = 0; slot < SlotCount; slot++)
+		{
+			CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &targetDesc, D3D12_RESOURCE_STATE_PRESENT,
+				nullptr, IID_PPV_ARGS(&backBuffers[slot]))));
+			backBufferPointers[slot] = backBuffers[slot].Get();
+		}
+
+		CubeSceneSettings settings;
+		settings.MaterialFiles[0] = "checkboard.dds";
+		settings.MaterialFiles[1] = "bricks.dds";
+		settings.DrawCount = 200;
+		settings.InstanceCount = 200;
+		settings.RecordThreads = 4;
+		{
+			CubeScene scene;
+			CHECK(SUCCEEDED(scene.Init(device.Get(), queue.Get(), loop[0].CommandAllocator, backBufferPointers, SlotCount, &uploads, &heaps, settings)));
+
+			// Stand-ins for what WinMain compiles, registered the way it does
+			static int fakeObjects[2 + DRAW_BINDING_COUNT + 2 * DRAW_BINDING_COUNT * MATERIALCOUNT + 2];
+			int* fake = fakeObjects;
+			CubeScenePipelines pipelines = {};
+			pipelines.RootSignature = reinterpret_cast<ID3D12RootSignature*>(fake++);
+			pipelines.InitialState = reinterpret_cast<ID3D12PipelineState*>(fake++);
+			pipelines.UpscaleState = reinterpret_cast<ID3D12PipelineState*>(fake++);
+			CaptureObjectTable& captureObjects = scene.GetCaptureObjects();
+			captureObjects.Register(pipelines.RootSignature);
+			captureObjects.Register(pipelines.InitialState);
+			captureObjects.Register(pipelines.UpscaleState);
+			for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+			{
+				pipelines.DrawRootSignatures[binding] = binding ? reinterpret_cast<ID3D12RootSignature*>(fake++) : pipelines.RootSignature;
+				captureObjects.Register(pipelines.DrawRootSignatures[binding]);
+			}
+			for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+			{
+				for (UINT material = 0; material < MATERIALCOUNT; material++)
+				{
+					ID3D12PipelineState* specialized = reinterpret_cast<ID3D12PipelineState*>(fake++);
+					pipelines.MaterialPipelines[binding][material] = scene.RequestPipeline(pipelines.InitialState, [=]() { return specialized; });
+				}
+			}
+			ID3D12PipelineState* instanced = reinterpret_cast<ID3D12PipelineState*>(fake++);
+			pipelines.InstancedPipeline = scene.RequestPipeline(pipelines.InitialState, [=]() { return instanced; });
+			CHECK(fake <= std::end(fakeObjects));
+			scene.SetPipelines(pipelines);
+			loop.Flush();
+
+			// Per cube for the first half, going through the bindings every few frames, instanced after that
+			bool drawsCounted = true, listsClean = true;
+			while (loop.RunFrame(
+				[&](FrameContext&, UINT64 completedFenceValue)
+				{
+					const UINT64 frame = scene.GetFrameCount();
+					scene.SetInstanced(frame >= platform.FrameLimit / 2);
+					scene.SetDrawBinding(DrawBinding(frame / 5 % DRAW_BINDING_COUNT));
+					CHECK(SUCCEEDED(scene.Update(loop.GetIndex(), completedFenceValue)));
+				},
+				[&](FrameContext& context, std::vector<ID3D12CommandList*>& lists)
+				{
+					CHECK(SUCCEEDED(scene.Record(loop.GetIndex(), context.CommandAllocator, lists)));
+					UINT draws = 0;
+					for (ID3D12CommandList* list : lists)
+					{
+						const NullD3D12::GraphicsCommandList* nullList = static_cast<NullD3D12::GraphicsCommandList*>(list);
+						draws += nullList->GetCounts().Draws;
+						listsClean &= nullList->GetErrorCount() == 0 && nullList->IsClosed();
+					}
+
+					// Every cube and the upscale, or the instanced draw and the upscale
+					drawsCounted &= draws == (scene.IsInstanced() ? 2 : settings.DrawCount + 1);
+				},
+				[&](UINT64 fenceValue) { scene.Finish(fenceValue); }))
+			{
+			}
+			loop.Flush();
+
+			CHECK(drawsCounted && listsClean);
+			CHECK(scene.GetFrameCount() == platform.FrameLimit);
+			CHECK(scene.GetRecordedDraws() == platform.FrameLimit / 2 * (settings.DrawCount + 1));
+			CHECK(static_cast<NullD3D12::CommandQueue*>(queue.Get())->GetErrorCount() == 0);
+			CHECK(scene.GetLoadedMaterialCount() == MATERIALCOUNT);
+			CHECK(scene.GetPipelineQueue().GetReadyCount() == scene.GetPipelineQueue().GetRequestCount());
+			CHECK(!scene.GetFrameCapture().empty());
+
+			// The last frame plays back from its capture like -replay does
+			FrameContext& replayContext = loop.Begin();
+			CHECK(SUCCEEDED(scene.Replay(replayContext.CommandAllocator, loop.GetCompletedFenceValue())));
+			const NullD3D12::GraphicsCommandList* replayed = static_cast<NullD3D12::GraphicsCommandList*>(scene.GetCommandList());
+			CHECK(replayed->GetErrorCount() == 0 && replayed->GetCounts().Draws == 2);
+			ID3D12CommandList* replayList = scene.GetCommandList();
+			scene.FinishReplay(loop.Submit(1, &replayList, false));
+			loop.Flush();
+			CHECK(static_cast<NullD3D12::CommandQueue*>(queue.Get())->GetErrorCount() == 0);
+
+			std::printf("Cube scene, %u frames of %u cubes:\n", platform.FrameLimit, settings.DrawCount);
+			for (int phase = 0; phase < NullFrameLoop::PHASE_COUNT; phase++)
+			{
+				std::printf("%s: %.3f ms/frame\n", NullFrameLoop::GetPhaseName(NullFrameLoop::Phase(phase)),
+					1000.0 * loop.GetPhaseSeconds(NullFrameLoop::Phase(phase)) / loop.GetFrameCount());
+			}
+			std::printf("%s", scene.GetStatsString(loop.GetPhaseSeconds(NullFrameLoop::PHASE_RECORD)).c_str());
+		}
+	}
+}
+
+int main()
+{
+	TestClearFrames();
+	TestCubeScene();
+	return TestResult();
+}
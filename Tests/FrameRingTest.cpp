@@ -0,0 +1,192 @@
+/**************************************************************
+	Frame ring against a mock queue whose gpu takes a fixed time
+	per frame, in submission order, on a thread of its own. Checks
+	a slot is never handed out before its last frame completed,
+	that the only fence value it waits for is the one from Count
+	frames back, and that no more than Count frames are ever in
+	flight. The cpu wait a ring of BUFFERCOUNT removes compared to
+	waiting on every frame is printed, not checked, it's wall
+	clock time.
+
+	The same comparison on a made up clock is checked: the gpu
+	starts a frame when it's submitted and the one before is
+	done, so the waits come out the same on any machine.
+**************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameRing.h"
+#include "Test.h"
+
+class MockQueue
+{
+public:
+	explicit MockQueue(std::chrono::microseconds gpuTime)
+		: m_gpuTime(gpuTime), m_completed(0), m_quit(false), m_gpu([this] { GpuLoop(); }) { }
+
+	~MockQueue()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_changed.notify_all();
+		m_gpu.join();
+	}
+
+	void Signal(uint64_t value)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_submitted.push_back(value);
+		}
+		m_changed.notify_all();
+	}
+
+	uint64_t GetCompletedValue()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_completed;
+	}
+
+	void Wait(uint64_t value)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [&] { return m_completed >= value; });
+	}
+
+private:
+	void GpuLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_changed.wait(lock, [&] { return m_quit || !m_submitted.empty(); });
+			if (m_submitted.empty())
+				return;
+
+			const uint64_t value = m_submitted.front();
+			m_submitted.pop_front();
+			lock.unlock();
+			std::this_thread::sleep_for(m_gpuTime);
+			lock.lock();
+			m_completed = value;
+			m_changed.notify_all();
+		}
+	}
+
+	std::chrono::microseconds m_gpuTime;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::deque<uint64_t> m_submitted;
+	uint64_t m_completed;
+	bool m_quit;
+	std::thread m_gpu;
+};
+
+struct MockContext
+{
+	uint64_t Frame;
+};
+
+// Cpu time blocked on the fence per frame, in ms
+template <uint32_t Count>
+double RunFrames(uint32_t frameCount, std::chrono::microseconds cpuTime, std::chrono::microseconds gpuTime)
+{
+	MockQueue queue(gpuTime);
+	FrameRing<MockContext, Count> ring;
+	std::chrono::steady_clock::duration waited(0);
+	uint64_t fenceValue = 0;
+	bool waitedForOwnSlot = true;
+	uint64_t mostInFlight = 0;
+
+	for (uint32_t frame = 1; frame <= frameCount; frame++)
+	{
+		ring.Begin(queue.GetCompletedValue(), [&](uint64_t value)
+		{
+			waitedForOwnSlot &= value + Count == frame;
+			const auto waitStart = std::chrono::steady_clock::now();
+			queue.Wait(value);
+			waited += std::chrono::steady_clock::now() - waitStart;
+		});
+
+		// Whatever the slot's last frame used is free again
+		CHECK(queue.GetCompletedValue() >= ring.GetFenceValue(ring.GetIndex()));
+		CHECK(ring.GetCurrent().Frame == 0 || ring.GetCurrent().Frame + Count == frame);
+		ring.GetCurrent().Frame = frame;
+
+		std::this_thread::sleep_for(cpuTime);		// Recording
+		ring.End(++fenceValue);
+		queue.Signal(fenceValue);
+		mostInFlight = std::max(mostInFlight, fenceValue - queue.GetCompletedValue());
+	}
+	queue.Wait(fenceValue);
+	CHECK(waitedForOwnSlot);
+	CHECK(mostInFlight <= Count);
+
+	return std::chrono::duration<double, std::milli>(waited).count() / frameCount;
+}
+
+// Same as RunFrames() on a made up clock, in units of time per frame
+template <uint32_t Count>
+double RunVirtualFrames(uint32_t frameCount, double cpuTime, double gpuTime)
+{
+	FrameRing<MockContext, Count> ring;
+	std::vector<double> done(frameCount + 1, 0.0);		// When the gpu finished each fence value
+	double now = 0.0, waited = 0.0;
+	uint64_t completed = 0;
+
+	for (uint32_t frame = 1; frame <= frameCount; frame++)
+	{
+		while (completed + 1 < frame && done[completed + 1] <= now)
+			completed++;
+		ring.Begin(completed, [&](uint64_t value)
+		{
+			waited += done[value] - now;
+			now = done[value];
+			completed = value;
+		});
+
+		now += cpuTime;
+		ring.End(frame);
+		done[frame] = std::max(now, done[frame - 1]) + gpuTime;
+	}
+	return waited / frameCount;
+}
+
+int main()
+{
+	// Slots go round in order and only wait for their own last frame
+	FrameRing<MockContext, 3> ring;
+	uint64_t waitedFor = 0;
+	auto Wait = [&](uint64_t value) { waitedFor = value; };
+	for (uint32_t frame = 0; frame < 3; frame++)
+	{
+		CHECK(!ring.Begin(0, Wait));
+		CHECK(ring.GetIndex() == frame);
+		ring.End(frame + 1);
+	}
+	CHECK(ring.Begin(0, Wait));
+	CHECK(ring.GetIndex() == 0 && waitedFor == 1);
+	ring.End(4);
+	CHECK(!ring.Begin(2, Wait));
+	CHECK(ring.GetIndex() == 1);
+
+	// Cpu and gpu taking as long as each other, the worst case for waiting on every frame
+	const double virtualSingleWait = RunVirtualFrames<1>(100, 1.0, 1.0);
+	const double virtualRingWait = RunVirtualFrames<3>(100, 1.0, 1.0);
+	CHECK(virtualSingleWait > 0.9);
+	CHECK(virtualRingWait == 0.0);
+
+	const std::chrono::microseconds frameTime(2000);
+	const double singleWait = RunFrames<1>(100, frameTime, frameTime);
+	const double ringWait = RunFrames<3>(100, frameTime, frameTime);
+	std::printf("Fence wait, 2 ms cpu and 2 ms gpu: %f ms/frame with one context, %f ms/frame with three, %f ms/frame removed\n",
+		singleWait, ringWait, singleWait - ringWait);
+
+	return TestResult();
+}
@@ -0,0 +1,41 @@
+/**************************************************************
+	A command list that only keeps the arguments of the calls
+	DrawBinding records, packed the way a real one stores them:
+	4 bytes a root constant, 8 an address. The size of Bytes is
+	what a binding costs in command list memory.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct MockCommandList
+{
+	std::vector<uint8_t> Bytes;
+
+	void Append(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		Bytes.insert(Bytes.end(), bytes, bytes + size);
+	}
+	void SetGraphicsRoot32BitConstants(uint32_t parameter, uint32_t count, const void* data, uint32_t offset)
+	{
+		Append(&parameter, sizeof(parameter));
+		Append(&offset, sizeof(offset));
+		Append(data, count * sizeof(uint32_t));
+	}
+	void SetGraphicsRootConstantBufferView(uint32_t parameter, uint64_t address, const void*, uint32_t)
+	{
+		Append(&parameter, sizeof(parameter));
+		Append(&address, sizeof(address));
+	}
+	void SetGraphicsRootShaderResourceView(uint32_t parameter, uint64_t address, const void*, uint32_t)
+	{
+		Append(&parameter, sizeof(parameter));
+		Append(&address, sizeof(address));
+	}
+	void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		const uint32_t draw[] = { indexCount, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance };
+		Append(draw, sizeof(draw));
+	}
+};
@@ -0,0 +1,191 @@
+/**************************************************************
+	ParallelRecorder and CommandListPool, the way WinMain uses them
+	for the one-draw-per-cube path: chunk lists acquired from the
+	pool on the render thread, recorded on the workers, submitted
+	in chunk order. Every draw tags itself with its index through
+	StartInstanceLocation, which the null lists log, so the test
+	sees exactly which list each draw went into.
+
+	Checks that chunks cover every draw exactly once, contiguous
+	and in order, that the split only depends on the draw count,
+	that submitting in chunk order executes the draws in draw
+	order, and that the pool stops growing once frames retire.
+**************************************************************/
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "CommandListPool.h"
+#include "NullD3D12.h"
+#include "ParallelRecorder.h"
+#include "Test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	struct Chunk
+	{
+		unsigned int First, End;
+	};
+
+	// The chunks one Record() call produced, indexed by chunk
+	std::vector<Chunk> RecordChunks(ParallelRecorder& recorder, unsigned int drawCount, std::vector<std::atomic<unsigned int>>& hits)
+	{
+		std::vector<Chunk> chunks(recorder.GetChunkCount(drawCount), Chunk{ ~0u, ~0u });
+		recorder.Record(drawCount, [&](unsigned int chunk, unsigned int firstDraw, unsigned int endDraw)
+		{
+			chunks[chunk] = { firstDraw, endDraw };
+			for (unsigned int draw = firstDraw; draw < endDraw; draw++)
+				hits[draw]++;
+		});
+		return chunks;
+	}
+
+	void TestChunkCoverage()
+	{
+		const unsigned int drawCounts[] = { 0, 1, 5, 63, 64, 65, 127, 1000, 1001, 4096 };
+		for (unsigned int threadCount : { 1u, 2u, 3u, 4u, 8u })
+		{
+			for (unsigned int minDraws : { 1u, 64u })
+			{
+				ParallelRecorder recorder(threadCount, minDraws);
+				CHECK(recorder.GetThreadCount() == threadCount);
+
+				for (unsigned int drawCount : drawCounts)
+				{
+					const unsigned int chunkCount = recorder.GetChunkCount(drawCount);
+					CHECK(chunkCount >= 1 && chunkCount <= threadCount);
+					// A chunk is only added once the ones before it have minDraws each
+					CHECK(chunkCount == 1 || (chunkCount - 1) * minDraws < drawCount);
+
+					std::vector<std::atomic<unsigned int>> hits(drawCount);
+					const std::vector<Chunk> chunks = RecordChunks(recorder, drawCount, hits);
+
+					// Contiguous and ascending, first at 0 and last at the end
+					bool contiguous = chunks.front().First == 0 && chunks.back().End == drawCount;
+					for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+					{
+						contiguous &= chunks[chunk].First <= chunks[chunk].End;
+						if (chunk > 0)
+							contiguous &= chunks[chunk].First == chunks[chunk - 1].End;
+					}
+					CHECK(contiguous);
+
+					bool once = true;
+					for (std::atomic<unsigned int>& hit : hits)
+						once &= hit == 1;
+					CHECK(once);
+
+					// Same split every time, the app hands out lists before recording
+					std::vector<std::atomic<unsigned int>> again(drawCount);
+					const std::vector<Chunk> repeated = RecordChunks(recorder, drawCount, again);
+					bool same = repeated.size() == chunks.size();
+					for (size_t chunk = 0; same && chunk < chunks.size(); chunk++)
+						same &= repeated[chunk].First == chunks[chunk].First && repeated[chunk].End == chunks[chunk].End;
+					CHECK(same);
+				}
+			}
+		}
+	}
+
+	// Frames of varying draw counts through the pool on the null device, two frames in flight
+	void TestSubmitOrder()
+	{
+		ComPtr<NullD3D12::Device> device;
+		device.Attach(new NullD3D12::Device());
+		device->QueueLatency = std::chrono::microseconds(300);
+
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+		ComPtr<ID3D12CommandQueue> queue;
+		ComPtr<ID3D12Fence> fence;
+		CHECK(SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue))));
+		CHECK(SUCCEEDED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence))));
+
+		const unsigned int threadCount = 4;
+		const unsigned int framesInFlight = 2;
+		ParallelRecorder recorder(threadCount, 16);
+		{
+			CommandListPool pool;
+			pool.Init(device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+			std::vector<PooledCommandList> chunkLists;
+			std::vector<ID3D12CommandList*> submitLists;
+			bool ordered = true, distinct = true, closed = true;
+			UINT64 fenceValue = 0;
+			const unsigned int drawCounts[] = { 1000, 17, 64, 0, 333, 4000, 48, 1001 };
+			for (unsigned int frame = 0; frame < 40; frame++)
+			{
+				// Two frames in flight, their lists aren't free yet
+				while (fence->GetCompletedValue() + framesInFlight <= fenceValue)
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+				pool.ReleaseCompleted(fence->GetCompletedValue());
+
+				const unsigned int drawCount = drawCounts[frame % _countof(drawCounts)];
+				const unsigned int chunkCount = recorder.GetChunkCount(drawCount);
+				chunkLists.resize(chunkCount);
+				for (unsigned int chunk = 0; chunk < chunkCount; chunk++)
+					CHECK(SUCCEEDED(pool.Acquire(nullptr, &chunkLists[chunk])));
+				for (unsigned int chunk = 1; chunk < chunkCount; chunk++)
+					distinct &= chunkLists[chunk].List != chunkLists[chunk - 1].List && chunkLists[chunk].Allocator != chunkLists[chunk - 1].Allocator;
+
+				recorder.Record(drawCount, [&](unsigned int chunk, unsigned int firstDraw, unsigned int endDraw)
+				{
+					ID3D12GraphicsCommandList* list = chunkLists[chunk].List;
+					for (unsigned int draw = firstDraw; draw < endDraw; draw++)
+					{
+						list->SetGraphicsRoot32BitConstant(0, draw, 0);
+						list->DrawInstanced(36, 1, 0, draw);
+					}
+					list->Close();
+				});
+
+				// Chunk order is draw order
+				submitLists.clear();
+				std::vector<UINT> executed;
+				for (PooledCommandList& chunkList : chunkLists)
+				{
+					NullD3D12::GraphicsCommandList* list = static_cast<NullD3D12::GraphicsCommandList*>(chunkList.List);
+					closed &= list->IsClosed();
+					executed.insert(executed.end(), list->GetDraws().begin(), list->GetDraws().end());
+					submitLists.push_back(chunkList.List);
+				}
+				for (unsigned int draw = 0; draw < executed.size(); draw++)
+					ordered &= executed[draw] == draw;
+				ordered &= executed.size() == drawCount;
+
+				queue->ExecuteCommandLists(UINT(submitLists.size()), submitLists.data());
+				queue->Signal(fence.Get(), ++fenceValue);
+				pool.FinishFrame(fenceValue);
+			}
+			CHECK(ordered && distinct && closed);
+			CHECK(static_cast<NullD3D12::CommandQueue*>(queue.Get())->GetErrorCount() == 0);
+
+			// At most a frame's worth of lists per frame in flight plus the one being recorded
+			CHECK(pool.GetListCount() <= threadCount * (framesInFlight + 1));
+			CHECK(device->GetAllocatorCount() == pool.GetListCount());		// Created, the pool never frees one
+
+			// Drained, nothing is lost or created
+			const size_t listCount = pool.GetListCount();
+			while (fence->GetCompletedValue() < fenceValue)
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			pool.ReleaseCompleted(fenceValue);
+			PooledCommandList recycled = {};
+			CHECK(SUCCEEDED(pool.Acquire(nullptr, &recycled)));
+			recycled.List->Close();
+			pool.FinishFrame(fenceValue);
+			CHECK(pool.GetListCount() == listCount);
+			CHECK(device->GetAllocatorCount() == listCount);
+		}
+	}
+}
+
+int main()
+{
+	TestChunkCoverage();
+	TestSubmitOrder();
+	return TestResult();
+}
@@ -0,0 +1,105 @@
+/**************************************************************
+	Pipeline compile queue with sleeps standing in for the
+	device. With one worker held on the first request, the rest
+	are compiled most drawn first and equal ones in request
+	order, SetPriority() counting as much as the priority they
+	came with. A compile that fails leaves the fallback.
+
+	Then 48 requests taking 1 to 8 ms each, a frame every 2 ms
+	and every request drawn with by 1 to 100 draws a frame, once
+	in request order and once by draw count. Going by draw count
+	has to leave fewer draws on a fallback.
+**************************************************************/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <thread>
+#include <vector>
+#include "PipelineCompileQueue.h"
+#include "Test.h"
+
+namespace
+{
+	void TestOrder()
+	{
+		PipelineCompileQueue<uintptr_t> queue(1);
+		std::atomic<bool> started(false), release(false);
+		queue.Request(100, [&] { started = true; while (!release) std::this_thread::yield(); return uintptr_t(1); });
+		while (!started)
+			std::this_thread::yield();
+
+		const uint32_t priorities[] = { 5, 20, 5, 0, 20 };
+		for (uint32_t priority : priorities)
+			queue.Request(100, [] { return uintptr_t(1); }, priority);
+		queue.Request(100, [] { return uintptr_t(0); }, 1);		// Fails
+		queue.SetPriority(4, 50);
+		CHECK(queue.GetWaitingCount() == 7);
+		CHECK(queue.Get(1) == 100 && !queue.IsReady(1));
+
+		release = true;
+		queue.WaitIdle();
+		std::vector<uint32_t> order;
+		CHECK(queue.Update([&](uint32_t id, uintptr_t) { order.push_back(id); }) == 6);
+
+		const std::vector<uint32_t> expected = { 0, 4, 2, 5, 1, 3 };
+		CHECK(order == expected);
+		CHECK(queue.GetReadyCount() == 6 && queue.GetFailedCount() == 1 && queue.GetWaitingCount() == 0);
+		CHECK(queue.Get(1) == 1 && queue.IsReady(1));
+		CHECK(queue.Get(6) == 100 && !queue.IsReady(6));
+	}
+
+	// Percentage of the draws that used a fallback until everything was ready
+	double RunSynthetic(bool prioritized)
+	{
+		std::srand(7);
+		PipelineCompileQueue<uintptr_t> queue(2);
+		std::vector<uint32_t> draws(48);
+		for (uint32_t request = 0; request < draws.size(); request++)
+		{
+			draws[request] = 1 + std::rand() % 100;
+			const int compileMs = 1 + std::rand() % 8;
+			queue.Request(0, [request, compileMs]
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(compileMs));
+				return uintptr_t(request + 1);
+			}, prioritized ? draws[request] : 0);
+		}
+
+		uint64_t fallbackDraws = 0, totalDraws = 0;
+		uint32_t frames = 0;
+		while (queue.GetWaitingCount())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			queue.Update();
+			frames++;
+
+			for (uint32_t request = 0; request < draws.size(); request++)
+			{
+				totalDraws += draws[request];
+				if (!queue.IsReady(request))
+					fallbackDraws += draws[request];
+			}
+		}
+
+		const double fallbackPercent = 100.0 * fallbackDraws / totalDraws;
+		std::printf("%s: all ready after %u frames, %.1f%% of draws on a fallback\n", prioritized ? "By draw count" : "In request order",
+			frames, fallbackPercent);
+		return fallbackPercent;
+	}
+
+	void TestPrioritized()
+	{
+		const double inOrder = RunSynthetic(false);
+		const double prioritized = RunSynthetic(true);
+		CHECK(prioritized < inOrder);
+	}
+}
+
+int main()
+{
+	TestOrder();
+	TestPrioritized();
+	return TestResult();
+}
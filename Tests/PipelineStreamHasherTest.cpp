@@ -0,0 +1,233 @@
+/**************************************************************
+	Pipeline stream hasher: the same stream hashes the same every
+	time, and so does one built separately for the same state,
+	with the shader bytecode and the input layout (semantic names
+	included) copied somewhere else. That's what lets the cache
+	hand back one PSO for both. Changing any one field of the
+	state changes the hash, the cached PSO blob doesn't count.
+
+	Root signatures mapped to the same serialized blob hash the
+	same whatever their pointer, both depth stencil subobjects
+	hash alike for the same state, and a stream with a subobject
+	twice fails.
+**************************************************************/
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include <d3d12.h>
+#include "d3dx12.h"
+#include "PipelineStreamHasher.h"
+#include "Test.h"
+
+namespace
+{
+	// Made up bytecode, the hasher never looks inside it
+	std::vector<uint8_t> MakeBytecode(uint8_t seed, size_t size)
+	{
+		std::vector<uint8_t> bytecode(size);
+		for (size_t i = 0; i < size; i++)
+			bytecode[i] = uint8_t(seed + i * 31);
+		return bytecode;
+	}
+
+	// Everything a request points at, owned here so two of them are two copies
+	struct Request
+	{
+		std::vector<uint8_t> VS;
+		std::vector<uint8_t> PS;
+		std::vector<std::string> SemanticNames;
+		std::vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc;
+
+		explicit Request(ID3D12RootSignature* rootSignature)
+			: VS(MakeBytecode(1, 1200)), PS(MakeBytecode(2, 900)), SemanticNames({ "POSITION", "NORMAL", "TEXCOORD" })
+		{
+			InputElements.push_back({ nullptr, 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+			InputElements.push_back({ nullptr, 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+			InputElements.push_back({ nullptr, 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+
+			Desc = {};
+			Desc.pRootSignature = rootSignature;
+			Desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+			Desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+			Desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+			Desc.SampleMask = UINT_MAX;
+			Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			Desc.NumRenderTargets = 1;
+			Desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			Desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+			Desc.SampleDesc.Count = 1;
+			Point();
+		}
+
+		Request(const Request& other)
+			: VS(other.VS), PS(other.PS), SemanticNames(other.SemanticNames), InputElements(other.InputElements), Desc(other.Desc)
+		{
+			Point();
+		}
+
+		// The desc at this request's own copies
+		void Point()
+		{
+			for (size_t i = 0; i < InputElements.size(); i++)
+				InputElements[i].SemanticName = SemanticNames[i].c_str();
+			Desc.InputLayout = { InputElements.data(), UINT(InputElements.size()) };
+			Desc.VS = { VS.data(), VS.size() };
+			Desc.PS = { PS.data(), PS.size() };
+		}
+	};
+
+	uint64_t Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const std::unordered_map<ID3D12RootSignature*, uint64_t>* rootSignatures = nullptr)
+	{
+		CD3DX12_PIPELINE_STATE_STREAM stream(desc);
+		const D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(stream), &stream };
+		PipelineStreamHasher hasher(rootSignatures);
+		CHECK(SUCCEEDED(D3DX12ParsePipelineStream(streamDesc, &hasher)));
+		CHECK(!hasher.Failed());
+		return hasher.GetHash();
+	}
+
+	template <typename Stream>
+	bool HashStream(Stream& stream, uint64_t* hash)
+	{
+		const D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(stream), &stream };
+		PipelineStreamHasher hasher;
+		const bool parsed = SUCCEEDED(D3DX12ParsePipelineStream(streamDesc, &hasher)) && !hasher.Failed();
+		*hash = hasher.GetHash();
+		return parsed;
+	}
+
+	ID3D12RootSignature* FakeRootSignature(uintptr_t address) { return reinterpret_cast<ID3D12RootSignature*>(address); }
+
+	void TestSameState()
+	{
+		const Request request(FakeRootSignature(0x1000));
+		const uint64_t hash = Hash(request.Desc);
+		CHECK(Hash(request.Desc) == hash);
+
+		// Built again from scratch, nothing shared with the first one but the root signature
+		const Request copy(request);
+		CHECK(copy.Desc.VS.pShaderBytecode != request.Desc.VS.pShaderBytecode);
+		CHECK(copy.Desc.InputLayout.pInputElementDescs != request.Desc.InputLayout.pInputElementDescs);
+		CHECK(copy.Desc.InputLayout.pInputElementDescs[0].SemanticName != request.Desc.InputLayout.pInputElementDescs[0].SemanticName);
+		CHECK(Hash(copy.Desc) == hash);
+
+		// Not part of the state
+		Request cached(request);
+		const uint8_t blob[16] = {};
+		cached.Desc.CachedPSO = { blob, sizeof(blob) };
+		CHECK(Hash(cached.Desc) == hash);
+	}
+
+	void TestEveryField()
+	{
+		const Request base(FakeRootSignature(0x1000));
+		const uint64_t hash = Hash(base.Desc);
+
+		const std::vector<std::pair<const char*, std::function<void(Request&)>>> changes =
+		{
+			{ "root signature", [](Request& r) { r.Desc.pRootSignature = FakeRootSignature(0x2000); } },
+			{ "VS byte", [](Request& r) { r.VS[600] ^= 1; } },
+			{ "VS length", [](Request& r) { r.VS.pop_back(); r.Point(); } },
+			{ "PS byte", [](Request& r) { r.PS[0] ^= 0x80; } },
+			{ "GS added", [](Request& r) { static const uint8_t gs[4] = { 1, 2, 3, 4 }; r.Desc.GS = { gs, sizeof(gs) }; } },
+			{ "semantic name", [](Request& r) { r.SemanticNames[1] = "NORMAM"; r.Point(); } },
+			{ "semantic index", [](Request& r) { r.InputElements[2].SemanticIndex = 1; } },
+			{ "element format", [](Request& r) { r.InputElements[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT; } },
+			{ "element offset", [](Request& r) { r.InputElements[2].AlignedByteOffset = 28; } },
+			{ "element slot", [](Request& r) { r.InputElements[1].InputSlot = 1; } },
+			{ "element step rate", [](Request& r) { r.InputElements[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA; r.InputElements[2].InstanceDataStepRate = 1; } },
+			{ "element count", [](Request& r) { r.Desc.InputLayout.NumElements = 2; } },
+			{ "topology", [](Request& r) { r.Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; } },
+			{ "strip cut", [](Request& r) { r.Desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF; } },
+			{ "blend enable", [](Request& r) { r.Desc.BlendState.RenderTarget[0].BlendEnable = TRUE; } },
+			{ "write mask", [](Request& r) { r.Desc.BlendState.RenderTarget[3].RenderTargetWriteMask = 0; } },
+			{ "alpha to coverage", [](Request& r) { r.Desc.BlendState.AlphaToCoverageEnable = TRUE; } },
+			{ "cull mode", [](Request& r) { r.Desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; } },
+			{ "fill mode", [](Request& r) { r.Desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; } },
+			{ "depth bias", [](Request& r) { r.Desc.RasterizerState.DepthBias = 1; } },
+			{ "antialiased lines", [](Request& r) { r.Desc.RasterizerState.AntialiasedLineEnable = TRUE; } },
+			{ "depth func", [](Request& r) { r.Desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL; } },
+			{ "depth write", [](Request& r) { r.Desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; } },
+			{ "stencil op", [](Request& r) { r.Desc.DepthStencilState.BackFace.StencilPassOp = D3D12_STENCIL_OP_ZERO; } },
+			{ "DSV format", [](Request& r) { r.Desc.DSVFormat = DXGI_FORMAT_D32_FLOAT; } },
+			{ "RTV format", [](Request& r) { r.Desc.RTVFormats[0] = DXGI_FORMAT_B8G8R8A8_UNORM; } },
+			{ "render targets", [](Request& r) { r.Desc.NumRenderTargets = 2; r.Desc.RTVFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM; } },
+			{ "sample count", [](Request& r) { r.Desc.SampleDesc.Count = 4; } },
+			{ "sample mask", [](Request& r) { r.Desc.SampleMask = 0xf; } },
+			{ "node mask", [](Request& r) { r.Desc.NodeMask = 1; } },
+		};
+
+		std::vector<uint64_t> hashes;
+		for (const auto& change : changes)
+		{
+			Request changed(base);
+			change.second(changed);
+			hashes.push_back(Hash(changed.Desc));
+			if (hashes.back() == hash)
+				std::printf("Changing the %s didn't change the hash\n", change.first);
+			CHECK(hashes.back() != hash);
+		}
+
+		// And they all differ from each other too
+		bool distinct = true;
+		for (size_t i = 0; i < hashes.size(); i++)
+		{
+			for (size_t j = i + 1; j < hashes.size(); j++)
+				distinct &= hashes[i] != hashes[j];
+		}
+		CHECK(distinct);
+	}
+
+	void TestRootSignatures()
+	{
+		// Two runs' root signatures from the same serialized blob
+		ID3D12RootSignature* first = FakeRootSignature(0x1000);
+		ID3D12RootSignature* second = FakeRootSignature(0x5000);
+		const uint8_t blob[] = { 'R', 'S', 0, 1 };
+		const std::unordered_map<ID3D12RootSignature*, uint64_t> firstRun = { { first, HashBytes(blob, sizeof(blob)) } };
+		const std::unordered_map<ID3D12RootSignature*, uint64_t> secondRun = { { second, HashBytes(blob, sizeof(blob)) } };
+
+		const Request a(first), b(second);
+		CHECK(Hash(a.Desc) != Hash(b.Desc));
+		CHECK(Hash(a.Desc, &firstRun) == Hash(b.Desc, &secondRun));
+		CHECK(Hash(a.Desc, &firstRun) != Hash(a.Desc));
+	}
+
+	void TestSubobjects()
+	{
+		const CD3DX12_DEPTH_STENCIL_DESC depthStencil(D3D12_DEFAULT);
+		struct
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL DepthStencil;
+		} plain = { depthStencil };
+		struct
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1 DepthStencil;
+		} extended = { CD3DX12_DEPTH_STENCIL_DESC1(depthStencil) };
+
+		uint64_t plainHash = 0, extendedHash = 0;
+		CHECK(HashStream(plain, &plainHash));
+		CHECK(HashStream(extended, &extendedHash));
+		CHECK(plainHash == extendedHash);
+
+		const std::vector<uint8_t> vs = MakeBytecode(1, 64);
+		struct
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_VS First;
+			CD3DX12_PIPELINE_STATE_STREAM_VS Second;
+		} twice = { CD3DX12_SHADER_BYTECODE(vs.data(), vs.size()), CD3DX12_SHADER_BYTECODE(vs.data(), vs.size()) };
+		uint64_t twiceHash = 0;
+		CHECK(!HashStream(twice, &twiceHash));
+	}
+}
+
+int main()
+{
+	TestSameState();
+	TestEveryField();
+	TestRootSignatures();
+	TestSubobjects();
+	return TestResult();
+}
@@ -0,0 +1,127 @@
+/**************************************************************
+	A ReplayFrame() backend that keeps every call it gets instead
+	of issuing it, so a test can compare a replayed stream against
+	what was captured, op by op and byte by byte.
+
+	The same methods double as the "expected" side: call them with
+	the arguments given to the capturing list and compare the two
+	call lists.
+**************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include "FrameCapture.h"
+
+struct ReplayedCall
+{
+	CaptureOp Op;
+	std::vector<uint32_t> Args;		// Scalars in call order, refs as object then offset, floats by their bits
+	std::vector<uint8_t> Payload;	// Root CBV, root SRV and root constant contents
+
+	bool operator==(const ReplayedCall& other) const { return Op == other.Op && Args == other.Args && Payload == other.Payload; }
+	bool operator!=(const ReplayedCall& other) const { return !(*this == other); }
+};
+
+class RecordingReplayBackend
+{
+public:
+	const std::vector<ReplayedCall>& GetCalls() const { return m_calls; }
+	void Clear() { m_calls.clear(); }
+
+	void BeginList() { Add(CAPTURE_BEGIN_LIST); }
+	void SetPipelineState(uint16_t id) { Add(CAPTURE_SET_PIPELINE_STATE, { id }); }
+	void SetRootSignature(uint16_t id) { Add(CAPTURE_SET_ROOT_SIGNATURE, { id }); }
+	void SetDescriptorHeap(uint16_t id) { Add(CAPTURE_SET_DESCRIPTOR_HEAP, { id }); }
+
+	void SetRootDescriptorTable(uint8_t parameter, const CaptureRef& table)
+	{
+		Add(CAPTURE_SET_ROOT_DESCRIPTOR_TABLE, { parameter, table.Object, table.Offset });
+	}
+
+	void SetRootConstantBuffer(uint8_t parameter, const void* data, uint32_t size)
+	{
+		Add(CAPTURE_SET_ROOT_CONSTANT_BUFFER, { parameter, size }, data, size);
+	}
+
+	void SetRootShaderResource(uint8_t parameter, const void* data, uint32_t size)
+	{
+		Add(CAPTURE_SET_ROOT_SHADER_RESOURCE, { parameter, size }, data, size);
+	}
+
+	void SetRootConstants(uint8_t parameter, uint32_t offset, const void* values, uint32_t count)
+	{
+		Add(CAPTURE_SET_ROOT_CONSTANTS, { parameter, offset, count }, values, count * sizeof(uint32_t));
+	}
+
+	void SetVertexBuffer(uint8_t slot, const CaptureRef& buffer, uint32_t size, uint32_t stride)
+	{
+		Add(CAPTURE_SET_VERTEX_BUFFER, { slot, buffer.Object, buffer.Offset, size, stride });
+	}
+
+	void SetIndexBuffer(const CaptureRef& buffer, uint32_t size, uint32_t format)
+	{
+		Add(CAPTURE_SET_INDEX_BUFFER, { buffer.Object, buffer.Offset, size, format });
+	}
+
+	void SetTopology(uint32_t topology) { Add(CAPTURE_SET_TOPOLOGY, { topology }); }
+
+	void SetViewport(const float values[6])
+	{
+		Add(CAPTURE_SET_VIEWPORT, { Bits(values[0]), Bits(values[1]), Bits(values[2]), Bits(values[3]), Bits(values[4]), Bits(values[5]) });
+	}
+
+	void SetScissorRect(const int32_t values[4])
+	{
+		Add(CAPTURE_SET_SCISSOR_RECT, { uint32_t(values[0]), uint32_t(values[1]), uint32_t(values[2]), uint32_t(values[3]) });
+	}
+
+	void SetRenderTarget(const CaptureRef& renderTarget, const CaptureRef& depthStencil)
+	{
+		Add(CAPTURE_SET_RENDER_TARGET, { renderTarget.Object, renderTarget.Offset, depthStencil.Object, depthStencil.Offset });
+	}
+
+	void ClearRenderTarget(const CaptureRef& renderTarget, const float color[4])
+	{
+		Add(CAPTURE_CLEAR_RENDER_TARGET, { renderTarget.Object, renderTarget.Offset, Bits(color[0]), Bits(color[1]), Bits(color[2]), Bits(color[3]) });
+	}
+
+	void ClearDepthStencil(const CaptureRef& depthStencil, uint32_t flags, float depth, uint8_t stencil)
+	{
+		Add(CAPTURE_CLEAR_DEPTH_STENCIL, { depthStencil.Object, depthStencil.Offset, flags, Bits(depth), stencil });
+	}
+
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+	{
+		Add(CAPTURE_DRAW_INDEXED, { indexCount, instanceCount, firstIndex, uint32_t(baseVertex), firstInstance });
+	}
+
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		Add(CAPTURE_DRAW, { vertexCount, instanceCount, firstVertex, firstInstance });
+	}
+
+	void Barrier(uint16_t resource, uint32_t subresource, uint32_t before, uint32_t after, uint8_t flags)
+	{
+		Add(CAPTURE_BARRIER, { resource, subresource, before, after, flags });
+	}
+
+	void AliasingBarrier(uint16_t before, uint16_t after) { Add(CAPTURE_ALIASING_BARRIER, { before, after }); }
+
+private:
+	static uint32_t Bits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	void Add(CaptureOp op, std::initializer_list<uint32_t> args = {}, const void* payload = nullptr, size_t payloadSize = 0)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(payload);
+		m_calls.push_back({ op, args, std::vector<uint8_t>(bytes, bytes + payloadSize) });
+	}
+
+	std::vector<ReplayedCall> m_calls;
+};
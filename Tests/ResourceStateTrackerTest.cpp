@@ -0,0 +1,457 @@
+/**************************************************************
+	Resource state tracker against a list that only records the
+	barriers it's given. The tracker never looks inside a resource,
+	so the resources are fake pointers.
+
+	Hand written cases check the exact barriers for merging and
+	cancelling queued transitions, skipping ones already in the
+	state, per subresource transitions folding back into one,
+	split begin/end pairs, and aliasing barriers keeping
+	transitions on either side apart.
+
+	Then random sequences on resources with a few subresources:
+	every flushed barrier is applied to a simulated gpu, which
+	checks the before states and split pairs the way the debug
+	layer would, and has to end up where GetState() says. The
+	tracker's counts over all of them are printed, the same
+	report WinMain gives for a headless run.
+**************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <d3d12.h>
+#include "ResourceStateTracker.h"
+#include "Test.h"
+
+namespace
+{
+	const UINT All = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+	const D3D12_RESOURCE_STATES Common = D3D12_RESOURCE_STATE_COMMON;
+	const D3D12_RESOURCE_STATES RenderTarget = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	const D3D12_RESOURCE_STATES CopyDest = D3D12_RESOURCE_STATE_COPY_DEST;
+	const D3D12_RESOURCE_STATES CopySource = D3D12_RESOURCE_STATE_COPY_SOURCE;
+	const D3D12_RESOURCE_STATES PixelShader = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	const D3D12_RESOURCE_STATES AnyShader = D3D12_RESOURCE_STATES(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	int FakeResources[4];
+
+	ID3D12Resource* Fake(int index) { return reinterpret_cast<ID3D12Resource*>(&FakeResources[index]); }
+
+	struct RecordingList
+	{
+		std::vector<D3D12_RESOURCE_BARRIER> Barriers;
+		std::vector<UINT> Batches;
+
+		void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers)
+		{
+			Barriers.insert(Barriers.end(), barriers, barriers + count);
+			Batches.push_back(count);
+		}
+
+		void Clear()
+		{
+			Barriers.clear();
+			Batches.clear();
+		}
+	};
+
+	bool IsTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, UINT subresource, D3D12_RESOURCE_STATES before,
+		D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE)
+	{
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Flags == flags && barrier.Transition.pResource == resource
+			&& barrier.Transition.Subresource == subresource && barrier.Transition.StateBefore == before && barrier.Transition.StateAfter == after;
+	}
+
+	bool IsAliasing(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* before, ID3D12Resource* after)
+	{
+		return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING && barrier.Aliasing.pResourceBefore == before && barrier.Aliasing.pResourceAfter == after;
+	}
+
+	void TestMergeAndSkip()
+	{
+		ResourceStateTracker tracker;
+		RecordingList list;
+		tracker.Register(Fake(0), Common);
+		tracker.Register(Fake(1), AnyShader);
+
+		// A->B then B->C goes out as A->C
+		tracker.Transition(Fake(0), CopyDest);
+		tracker.Transition(Fake(0), PixelShader);
+		CHECK(tracker.GetQueuedCount() == 1);
+		CHECK(tracker.GetState(Fake(0)) == PixelShader);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 1 && IsTransition(list.Barriers[0], Fake(0), All, Common, PixelShader));
+		CHECK(list.Batches.size() == 1);
+
+		// Already there, or a read state that's already included, queues nothing
+		list.Clear();
+		tracker.Transition(Fake(0), PixelShader);
+		tracker.Transition(Fake(1), PixelShader);
+		tracker.Transition(Fake(1), AnyShader);
+		CHECK(tracker.GetQueuedCount() == 0);
+		CHECK(tracker.GetState(Fake(1)) == AnyShader);
+		tracker.Flush(list);
+		CHECK(list.Batches.empty());
+
+		// There and back is nothing at all
+		tracker.Transition(Fake(0), RenderTarget);
+		tracker.Transition(Fake(0), PixelShader);
+		CHECK(tracker.GetQueuedCount() == 0);
+
+		// Other resources in between don't stop a merge
+		tracker.Transition(Fake(0), RenderTarget);
+		tracker.Transition(Fake(1), CopySource);
+		tracker.Transition(Fake(0), CopySource);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 2);
+		CHECK(list.Barriers.size() == 2 && IsTransition(list.Barriers[0], Fake(0), All, PixelShader, CopySource)
+			&& IsTransition(list.Barriers[1], Fake(1), All, AnyShader, CopySource));
+
+		// Nothing merges with what was already flushed
+		list.Clear();
+		tracker.Transition(Fake(0), PixelShader);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 1 && IsTransition(list.Barriers[0], Fake(0), All, CopySource, PixelShader));
+
+		CHECK(tracker.GetRequestedCount() == 11);
+		CHECK(tracker.GetSkippedCount() == 3);
+		CHECK(tracker.GetMergedCount() == 3);
+		CHECK(tracker.GetIssuedCount() == 4);
+		CHECK(tracker.GetBatchCount() == 3);
+	}
+
+	void TestSubresources()
+	{
+		ResourceStateTracker tracker;
+		RecordingList list;
+		tracker.Register(Fake(0), PixelShader, 3);
+
+		// Mip by mip, like generating a chain
+		tracker.Transition(Fake(0), CopyDest, 1);
+		CHECK(tracker.GetState(Fake(0), 0) == PixelShader && tracker.GetState(Fake(0), 1) == CopyDest && tracker.GetState(Fake(0), 2) == PixelShader);
+		tracker.Transition(Fake(0), CopyDest, 0);
+		tracker.Transition(Fake(0), CopyDest, 2);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 3);
+		const UINT order[3] = { 1, 0, 2 };
+		bool perSubresource = list.Barriers.size() == 3;
+		for (UINT i = 0; perSubresource && i < 3; i++)
+			perSubresource &= IsTransition(list.Barriers[i], Fake(0), order[i], PixelShader, CopyDest);
+		CHECK(perSubresource);
+
+		// All in the same state again, so it's back to one barrier for the lot
+		list.Clear();
+		tracker.Transition(Fake(0), PixelShader);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 1 && IsTransition(list.Barriers[0], Fake(0), All, CopyDest, PixelShader));
+
+		// Not all the same, a whole resource transition goes per subresource and skips those already there
+		list.Clear();
+		tracker.Transition(Fake(0), RenderTarget, 2);
+		tracker.Flush(list);
+		list.Clear();
+		tracker.Transition(Fake(0), RenderTarget);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 2 && IsTransition(list.Barriers[0], Fake(0), 0, PixelShader, RenderTarget)
+			&& IsTransition(list.Barriers[1], Fake(0), 1, PixelShader, RenderTarget));
+		CHECK(tracker.GetState(Fake(0), 2) == RenderTarget);
+
+		// A whole resource barrier still queued can't merge past subresource barriers queued after it,
+		// and a subresource barrier can't merge past a whole resource one
+		list.Clear();
+		tracker.Transition(Fake(0), CopyDest);
+		tracker.Transition(Fake(0), CopySource, 1);
+		tracker.Transition(Fake(0), CopySource, 0);
+		tracker.Transition(Fake(0), CopySource, 2);
+		tracker.Transition(Fake(0), PixelShader);
+		tracker.Transition(Fake(0), CopyDest, 1);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 6);
+		CHECK(list.Barriers.size() == 6 && IsTransition(list.Barriers[0], Fake(0), All, RenderTarget, CopyDest)
+			&& IsTransition(list.Barriers[1], Fake(0), 1, CopyDest, CopySource) && IsTransition(list.Barriers[4], Fake(0), All, CopySource, PixelShader)
+			&& IsTransition(list.Barriers[5], Fake(0), 1, PixelShader, CopyDest));
+		CHECK(tracker.GetState(Fake(0), 0) == PixelShader && tracker.GetState(Fake(0), 1) == CopyDest && tracker.GetState(Fake(0), 2) == PixelShader);
+	}
+
+	void TestSplitBarriers()
+	{
+		ResourceStateTracker tracker;
+		RecordingList list;
+		tracker.Register(Fake(0), RenderTarget);
+		tracker.Register(Fake(1), RenderTarget, 2);
+
+		// Begin now, end later, the state only changes at the end
+		tracker.BeginTransition(Fake(0), PixelShader);
+		CHECK(tracker.GetState(Fake(0)) == RenderTarget);
+		tracker.Flush(list);
+		tracker.BeginTransition(Fake(0), PixelShader);		// Already on its way
+		CHECK(tracker.GetQueuedCount() == 0);
+		tracker.Transition(Fake(0), PixelShader);
+		CHECK(tracker.GetState(Fake(0)) == PixelShader);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 2
+			&& IsTransition(list.Barriers[0], Fake(0), All, RenderTarget, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+			&& IsTransition(list.Barriers[1], Fake(0), All, RenderTarget, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+		// Ending somewhere else ends the split first, and nothing merges into either half
+		list.Clear();
+		tracker.BeginTransition(Fake(0), RenderTarget);
+		tracker.Transition(Fake(0), CopySource);
+		tracker.Transition(Fake(0), CopyDest);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 3
+			&& IsTransition(list.Barriers[0], Fake(0), All, PixelShader, RenderTarget, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+			&& IsTransition(list.Barriers[1], Fake(0), All, PixelShader, RenderTarget, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+			&& IsTransition(list.Barriers[2], Fake(0), All, RenderTarget, CopyDest));
+
+		// Beginning somewhere else ends the first split and starts another
+		list.Clear();
+		tracker.BeginTransition(Fake(0), PixelShader);
+		tracker.BeginTransition(Fake(0), CopySource);
+		tracker.Transition(Fake(0), CopySource);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 4
+			&& IsTransition(list.Barriers[1], Fake(0), All, CopyDest, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+			&& IsTransition(list.Barriers[2], Fake(0), All, PixelShader, CopySource, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+			&& IsTransition(list.Barriers[3], Fake(0), All, PixelShader, CopySource, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+		// One subresource of a resource split as a whole ends the whole split first
+		list.Clear();
+		tracker.BeginTransition(Fake(1), PixelShader);
+		tracker.Transition(Fake(1), CopyDest, 1);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 3
+			&& IsTransition(list.Barriers[1], Fake(1), All, RenderTarget, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+			&& IsTransition(list.Barriers[2], Fake(1), 1, PixelShader, CopyDest));
+		CHECK(tracker.GetState(Fake(1), 0) == PixelShader && tracker.GetState(Fake(1), 1) == CopyDest);
+
+		// Splitting one subresource leaves the other alone
+		list.Clear();
+		tracker.BeginTransition(Fake(1), PixelShader, 1);
+		tracker.Transition(Fake(1), RenderTarget, 0);
+		tracker.Transition(Fake(1), PixelShader, 1);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 3
+			&& IsTransition(list.Barriers[0], Fake(1), 1, CopyDest, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+			&& IsTransition(list.Barriers[1], Fake(1), 0, PixelShader, RenderTarget)
+			&& IsTransition(list.Barriers[2], Fake(1), 1, CopyDest, PixelShader, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+	}
+
+	void TestAliasing()
+	{
+		ResourceStateTracker tracker;
+		RecordingList list;
+		for (int i = 0; i < 3; i++)
+			tracker.Register(Fake(i), Common);
+
+		// Queued in order with the transitions, and an unrelated one doesn't get in the way
+		tracker.Transition(Fake(0), RenderTarget);
+		tracker.Aliasing(Fake(1), Fake(2));
+		tracker.Transition(Fake(0), PixelShader);
+		tracker.Flush(list);
+		CHECK(list.Barriers.size() == 2 && IsTransition(list.Barriers[0], Fake(0), All, Common, PixelShader) && IsAliasing(list.Barriers[1], Fake(1), Fake(2)));
+
+		// Either side of it being the resource, or a null before standing for anything, keeps the halves apart
+		ID3D12Resource* const blocking[][2] = { { Fake(0), Fake(1) }, { Fake(1), Fake(0) }, { nullptr, Fake(2) } };
+		for (ID3D12Resource* const* aliasing : blocking)
+		{
+			list.Clear();
+			tracker.Transition(Fake(0), RenderTarget);
+			tracker.Aliasing(aliasing[0], aliasing[1]);
+			tracker.Transition(Fake(0), PixelShader);
+			tracker.Flush(list);
+			CHECK(list.Barriers.size() == 3 && IsTransition(list.Barriers[0], Fake(0), All, PixelShader, RenderTarget)
+				&& IsAliasing(list.Barriers[1], aliasing[0], aliasing[1]) && IsTransition(list.Barriers[2], Fake(0), All, RenderTarget, PixelShader));
+		}
+	}
+
+	// What the gpu would see. Checks every barrier against the state it thinks
+	// each subresource is in and keeps split barriers paired.
+	class SimulatedGpu
+	{
+	public:
+		void Register(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresourceCount)
+		{
+			m_resources.push_back({ resource, std::vector<Subresource>(subresourceCount, Subresource{ state, state, false }) });
+		}
+
+		// False on the first barrier the debug layer would complain about
+		bool Apply(const std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+		{
+			for (const D3D12_RESOURCE_BARRIER& barrier : barriers)
+			{
+				if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING)
+					continue;
+
+				const D3D12_RESOURCE_TRANSITION_BARRIER& transition = barrier.Transition;
+				if (transition.StateBefore == transition.StateAfter)
+					return false;
+
+				std::vector<Subresource>& subresources = Find(transition.pResource);
+				const UINT first = transition.Subresource == All ? 0 : transition.Subresource;
+				const UINT end = transition.Subresource == All ? UINT(subresources.size()) : first + 1;
+				for (UINT i = first; i < end; i++)
+				{
+					Subresource& subresource = subresources[i];
+					if (subresource.State != transition.StateBefore)
+						return false;
+
+					switch (barrier.Flags)
+					{
+					case D3D12_RESOURCE_BARRIER_FLAG_NONE:
+						if (subresource.Splitting)
+							return false;
+						subresource.State = transition.StateAfter;
+						break;
+					case D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY:
+						if (subresource.Splitting)
+							return false;
+						subresource.Splitting = true;
+						subresource.SplitState = transition.StateAfter;
+						break;
+					case D3D12_RESOURCE_BARRIER_FLAG_END_ONLY:
+						if (!subresource.Splitting || subresource.SplitState != transition.StateAfter)
+							return false;
+						subresource.Splitting = false;
+						subresource.State = transition.StateAfter;
+						break;
+					default:
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool Matches(ResourceStateTracker& tracker) const
+		{
+			for (const Resource& resource : m_resources)
+			{
+				for (UINT i = 0; i < resource.Subresources.size(); i++)
+				{
+					if (tracker.GetState(resource.Pointer, i) != resource.Subresources[i].State)
+						return false;
+				}
+			}
+			return true;
+		}
+
+	private:
+		struct Subresource
+		{
+			D3D12_RESOURCE_STATES State;
+			D3D12_RESOURCE_STATES SplitState;
+			bool Splitting;
+		};
+
+		struct Resource
+		{
+			ID3D12Resource* Pointer;
+			std::vector<Subresource> Subresources;
+		};
+
+		std::vector<Subresource>& Find(ID3D12Resource* resource)
+		{
+			for (Resource& tracked : m_resources)
+			{
+				if (tracked.Pointer == resource)
+					return tracked.Subresources;
+			}
+			return m_resources[0].Subresources;
+		}
+
+		std::vector<Resource> m_resources;
+	};
+
+	void TestRandomSequences()
+	{
+		const D3D12_RESOURCE_STATES states[] = { Common, RenderTarget, CopyDest, CopySource, PixelShader, AnyShader,
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS };
+		const UINT subresourceCounts[] = { 1, 2, 3, 6 };
+
+		bool valid = true, matches = true, reached = true;
+		UINT64 requested = 0, issued = 0, batches = 0, skipped = 0, merged = 0;
+		std::srand(17);
+		for (int sequence = 0; sequence < 2000; sequence++)
+		{
+			ResourceStateTracker tracker;
+			SimulatedGpu gpu;
+			RecordingList list;
+			for (int i = 0; i < 4; i++)
+			{
+				tracker.Register(Fake(i), states[i], subresourceCounts[i]);
+				gpu.Register(Fake(i), states[i], subresourceCounts[i]);
+			}
+
+			for (int step = 0; step < 40; step++)
+			{
+				const int resource = std::rand() % 4;
+				const UINT subresource = std::rand() % 2 ? All : std::rand() % subresourceCounts[resource];
+				const D3D12_RESOURCE_STATES state = states[std::rand() % _countof(states)];
+				switch (std::rand() % 8)
+				{
+				case 0:
+				case 1:
+					tracker.BeginTransition(Fake(resource), state, subresource);
+					break;
+				case 2:
+					tracker.Aliasing(std::rand() % 2 ? Fake(std::rand() % 4) : nullptr, Fake(resource));
+					break;
+				case 3:
+					tracker.Flush(list);
+					valid &= gpu.Apply(list.Barriers);
+					list.Clear();
+					break;
+				default:
+				{
+					tracker.Transition(Fake(resource), state, subresource);
+
+					// There now, or in a read state that includes it
+					const UINT first = subresource == All ? 0 : subresource;
+					const UINT end = subresource == All ? subresourceCounts[resource] : subresource + 1;
+					for (UINT i = first; i < end; i++)
+					{
+						const D3D12_RESOURCE_STATES current = tracker.GetState(Fake(resource), i);
+						reached &= current == state || (state && (current & state) == state
+							&& !(current & ~D3D12_RESOURCE_STATES(D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ)));
+					}
+					break;
+				}
+				}
+			}
+
+			// Finish every split so the simulated states are final
+			for (int i = 0; i < 4; i++)
+			{
+				for (UINT sub = 0; sub < subresourceCounts[i]; sub++)
+					tracker.Transition(Fake(i), tracker.GetState(Fake(i), sub), sub);
+			}
+			tracker.Flush(list);
+			valid &= gpu.Apply(list.Barriers);
+			matches &= gpu.Matches(tracker);
+
+			requested += tracker.GetRequestedCount();
+			issued += tracker.GetIssuedCount();
+			batches += tracker.GetBatchCount();
+			skipped += tracker.GetSkippedCount();
+			merged += tracker.GetMergedCount();
+		}
+		std::printf("Barriers: %llu transitions asked for, %llu barriers in %llu calls, %llu redundant, %llu merged\n",
+			(unsigned long long)requested, (unsigned long long)issued, (unsigned long long)batches, (unsigned long long)skipped,
+			(unsigned long long)merged);
+		CHECK(valid);
+		CHECK(matches);
+		CHECK(reached);
+	}
+}
+
+int main()
+{
+	TestMergeAndSkip();
+	TestSubresources();
+	TestSplitBarriers();
+	TestAliasing();
+	TestRandomSequences();
+	return TestResult();
+}
@@ -0,0 +1,111 @@
+/**************************************************************
+	Ring allocator: alignment padding, wrapping around the end,
+	memory coming back as fences complete and failing once the
+	ring is full. Then a few thousand random frames checked
+	against every slice still in flight.
+**************************************************************/
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include "RingAllocator.h"
+#include "Test.h"
+
+int main()
+{
+	RingAllocator ring(1024);
+
+	// Nothing that can never fit
+	CHECK(ring.Allocate(0, 1) == RingAllocator::InvalidOffset);
+	CHECK(ring.Allocate(1025, 1) == RingAllocator::InvalidOffset);
+
+	// Padding up to the alignment counts as used
+	CHECK(ring.Allocate(100, 1) == 0);
+	CHECK(ring.Allocate(10, 256) == 256);
+	CHECK(ring.GetUsedSize() == 266);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(800, 1) == RingAllocator::InvalidOffset);
+	ring.ReleaseCompletedFrames(0);
+	CHECK(ring.GetUsedSize() == 266);
+	ring.ReleaseCompletedFrames(1);
+	CHECK(ring.IsEmpty());
+
+	// Nothing in use, so it starts over from the beginning
+	ring.Reset(1024);
+	CHECK(ring.Allocate(400, 1) == 0);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(400, 1) == 400);
+	ring.FinishFrame(2);
+
+	// 300 doesn't fit behind 800, the rest of the ring is wasted and it wraps to the
+	// start, which is free once frame 1 is done
+	CHECK(ring.Allocate(300, 1) == RingAllocator::InvalidOffset);
+	ring.ReleaseCompletedFrames(1);
+	CHECK(ring.Allocate(300, 1) == 0);
+	CHECK(ring.GetUsedSize() == 400 + 224 + 300);
+
+	// Wrapped, only [300, 400) is left before frame 2
+	CHECK(ring.Allocate(200, 1) == RingAllocator::InvalidOffset);
+	CHECK(ring.Allocate(100, 1) == 300);
+	CHECK(ring.IsFull());
+	CHECK(ring.Allocate(1, 1) == RingAllocator::InvalidOffset);
+	ring.FinishFrame(3);
+
+	ring.ReleaseCompletedFrames(2);
+	CHECK(ring.GetUsedSize() == 624);
+	CHECK(ring.Allocate(300, 1) == 400);
+	ring.FinishFrame(4);
+	ring.ReleaseCompletedFrames(4);
+	CHECK(ring.IsEmpty());
+
+	// Random frames three fences behind, every slice has to be aligned, inside the
+	// ring and clear of every other slice not released yet
+	struct Slice
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		uint64_t FenceValue;
+	};
+	ring.Reset(64 * 1024);
+	std::deque<Slice> live;
+	uint64_t fenceValue = 0, allocations = 0, failures = 0, wraps = 0, lastOffset = 0;
+	srand(1);
+	for (uint32_t frame = 0; frame < 5000; frame++)
+	{
+		const uint64_t completed = fenceValue > 3 ? fenceValue - 3 : 0;
+		ring.ReleaseCompletedFrames(completed);
+		while (!live.empty() && live.front().FenceValue <= completed)
+			live.pop_front();
+
+		const uint32_t sliceCount = 1 + rand() % 16;
+		for (uint32_t slice = 0; slice < sliceCount; slice++)
+		{
+			const uint64_t size = 1 + rand() % 2048;
+			const uint64_t alignment = 1ull << (rand() % 9);
+			const uint64_t offset = ring.Allocate(size, alignment);
+			if (offset == RingAllocator::InvalidOffset)
+			{
+				failures++;
+				continue;
+			}
+
+			CHECK(offset % alignment == 0);
+			CHECK(offset + size <= ring.GetSize());
+			for (const Slice& other : live)
+				CHECK(offset + size <= other.Offset || other.Offset + other.Size <= offset);
+
+			wraps += offset < lastOffset;
+			lastOffset = offset;
+			live.push_back({ offset, size, fenceValue + 1 });
+			allocations++;
+		}
+		ring.FinishFrame(++fenceValue);
+	}
+	CHECK(wraps > 0);
+	CHECK(failures > 0);
+	ring.ReleaseCompletedFrames(fenceValue);
+	CHECK(ring.IsEmpty());
+	std::printf("Random frames: %llu allocations, %llu wraps, %llu didn't fit\n", (unsigned long long)allocations,
+		(unsigned long long)wraps, (unsigned long long)failures);
+
+	return TestResult();
+}
@@ -0,0 +1,143 @@
+/**************************************************************
+	Shader cache keys and files: the key is the same every time
+	for the same shader and changes with any one of the source,
+	a define's name or value, the entry point, the profile, the
+	flags and the compiler. Defines can't run into each other,
+	"AB"="" and "A"="B" are different keys.
+
+	A prebuilt shader's key is the one the build step writes it
+	under, different from the runtime cache's for the same
+	shader, and only 5.x profiles have one. A file made for a
+	shader parses back to the same includes, code, reflection and
+	instruction count, and one that's cut short, has the wrong
+	magic or bytes left over is turned down.
+**************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ShaderCacheFile.h"
+#include "Test.h"
+
+namespace
+{
+	const char Source[] = "float4 PSMain() : SV_TARGET { return LIGHT_COUNT; }";
+
+	uint64_t Key(const char* source, const D3D_SHADER_MACRO* defines, const char* entryPoint = "PSMain", const char* target = "ps_5_1",
+		uint32_t flags = 0, uint32_t compilerVersion = 47)
+	{
+		return ShaderCacheKey(source, std::strlen(source), defines, entryPoint, target, flags, compilerVersion);
+	}
+
+	void TestKeys()
+	{
+		const D3D_SHADER_MACRO defines[] = { { "LIGHT_COUNT", "2" }, { "TEXTURE", "1" }, { nullptr, nullptr } };
+		const uint64_t key = Key(Source, defines);
+		CHECK(key == Key(Source, defines));
+
+		// Copies of the strings, it's what they say that counts
+		const std::string name = "LIGHT_COUNT", value = "2";
+		const D3D_SHADER_MACRO copied[] = { { name.c_str(), value.c_str() }, { "TEXTURE", "1" }, { nullptr, nullptr } };
+		CHECK(key == Key(std::string(Source).c_str(), copied));
+
+		const D3D_SHADER_MACRO otherValue[] = { { "LIGHT_COUNT", "3" }, { "TEXTURE", "1" }, { nullptr, nullptr } };
+		const D3D_SHADER_MACRO otherName[] = { { "LIGHT_COUNT", "2" }, { "SPECULAR", "1" }, { nullptr, nullptr } };
+		const D3D_SHADER_MACRO fewer[] = { { "LIGHT_COUNT", "2" }, { nullptr, nullptr } };
+		const D3D_SHADER_MACRO swapped[] = { { "TEXTURE", "1" }, { "LIGHT_COUNT", "2" }, { nullptr, nullptr } };
+		CHECK(key != Key("float4 PSMain() : SV_TARGET { return LIGHT_COUNT * 2; }", defines));
+		CHECK(key != Key(Source, otherValue));
+		CHECK(key != Key(Source, otherName));
+		CHECK(key != Key(Source, fewer));
+		CHECK(key != Key(Source, swapped));
+		CHECK(key != Key(Source, nullptr));
+		CHECK(key != Key(Source, defines, "VSMain"));
+		CHECK(key != Key(Source, defines, "PSMain", "ps_5_0"));
+		CHECK(key != Key(Source, defines, "PSMain", "ps_5_1", 1));
+		CHECK(key != Key(Source, defines, "PSMain", "ps_5_1", 0, 48));
+
+		// A null definition is an empty one
+		const D3D_SHADER_MACRO empty[] = { { "AB", "" }, { nullptr, nullptr } };
+		const D3D_SHADER_MACRO null[] = { { "AB", nullptr }, { nullptr, nullptr } };
+		const D3D_SHADER_MACRO split[] = { { "A", "B" }, { nullptr, nullptr } };
+		CHECK(Key(Source, empty) == Key(Source, null));
+		CHECK(Key(Source, empty) != Key(Source, split));
+
+		const std::string fileName = ShaderCacheName(key);
+		CHECK(fileName.size() == 16);
+		CHECK(fileName.find_first_not_of("0123456789abcdef") == std::string::npos);
+		CHECK(ShaderCacheName(0x1F) == "000000000000001f");
+	}
+
+	void TestPrebuiltKeys()
+	{
+		CHECK(DxilTarget("vs_5_1") == "vs_6_0");
+		CHECK(DxilTarget("ps_5_0") == "ps_6_0");
+		CHECK(DxilTarget("cs_5_1") == "cs_6_0");
+		CHECK(DxilTarget("ps_6_0").empty());
+		CHECK(DxilTarget("ps_4_0").empty());
+		CHECK(DxilTarget("ps_5_1x").empty());
+		CHECK(DxilTarget("").empty());
+
+		const D3D_SHADER_MACRO defines[] = { { "BINDING", "1" }, { nullptr, nullptr } };
+		const uint64_t prebuilt = PrebuiltShaderKey(Source, std::strlen(Source), defines, "VSMain", "vs_5_1");
+		CHECK(prebuilt == PrebuiltShaderKey(Source, std::strlen(Source), defines, "VSMain", "vs_5_0"));
+		CHECK(prebuilt == Key(Source, defines, "VSMain", "vs_6_0", 0, ShaderBuildVersion));
+		CHECK(prebuilt != Key(Source, defines, "VSMain", "vs_5_1", 0, ShaderBuildVersion));
+		CHECK(prebuilt != PrebuiltShaderKey(Source, std::strlen(Source), defines, "VSMain", "ps_5_1"));
+	}
+
+	void TestFiles()
+	{
+		const std::vector<ShaderCacheInclude> includes = { { "Lighting.hlsli", 0x0123456789ABCDEFull }, { "", 7 } };
+		std::vector<uint8_t> code(301), reflection(45);
+		for (size_t i = 0; i < code.size(); i++)
+			code[i] = uint8_t(i * 13);
+		for (size_t i = 0; i < reflection.size(); i++)
+			reflection[i] = uint8_t(i * 7 + 1);
+
+		const std::vector<uint8_t> file = MakeShaderCacheFile(includes, code.data(), code.size(), reflection.data(), reflection.size(), 93);
+		ShaderCacheHeader header;
+		std::vector<ShaderCacheInclude> parsed;
+		const uint8_t* parsedCode = nullptr;
+		const uint8_t* parsedReflection = nullptr;
+		CHECK(ParseShaderCacheFile(file.data(), file.size(), header, parsed, &parsedCode, &parsedReflection));
+		CHECK(header.CodeSize == code.size() && header.ReflectionSize == reflection.size() && header.InstructionCount == 93);
+		CHECK(parsed.size() == 2 && parsed[0].Name == "Lighting.hlsli" && parsed[0].Hash == includes[0].Hash);
+		CHECK(parsed[1].Name.empty() && parsed[1].Hash == 7);
+		CHECK(parsedCode && std::vector<uint8_t>(parsedCode, parsedCode + header.CodeSize) == code);
+		CHECK(parsedReflection && std::vector<uint8_t>(parsedReflection, parsedReflection + header.ReflectionSize) == reflection);
+
+		// What the runtime cache writes, DXBC without reflection
+		const std::vector<uint8_t> runtime = MakeShaderCacheFile({}, code.data(), code.size());
+		CHECK(ParseShaderCacheFile(runtime.data(), runtime.size(), header, parsed, &parsedCode, &parsedReflection));
+		CHECK(parsed.empty() && header.ReflectionSize == 0 && header.InstructionCount == 0 && !parsedReflection);
+		CHECK(std::vector<uint8_t>(parsedCode, parsedCode + header.CodeSize) == code);
+
+		uint32_t truncated = 0;
+		for (size_t size = 0; size < file.size(); size++)
+			truncated += ParseShaderCacheFile(file.data(), size, header, parsed, &parsedCode, &parsedReflection);
+		CHECK(truncated == 0);
+
+		std::vector<uint8_t> longer = file;
+		longer.push_back(0);
+		CHECK(!ParseShaderCacheFile(longer.data(), longer.size(), header, parsed, &parsedCode, &parsedReflection));
+
+		std::vector<uint8_t> corrupt = file;
+		corrupt[0] ^= 1;
+		CHECK(!ParseShaderCacheFile(corrupt.data(), corrupt.size(), header, parsed, &parsedCode, &parsedReflection));
+
+		// An include name that claims more than the file holds
+		std::vector<uint8_t> longName = file;
+		longName[sizeof(ShaderCacheHeader) + sizeof(uint64_t)] = 0xFF;
+		CHECK(!ParseShaderCacheFile(longName.data(), longName.size(), header, parsed, &parsedCode, &parsedReflection));
+		std::printf("%zu byte file, %zu of code\n", file.size(), code.size());
+	}
+}
+
+int main()
+{
+	TestKeys();
+	TestPrebuiltKeys();
+	TestFiles();
+	return TestResult();
+}
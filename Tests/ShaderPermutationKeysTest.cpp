@@ -0,0 +1,56 @@
+/**************************************************************
+	Shader permutation keys, with PSMain's options: every
+	key from 0 to the count gives back its values and GetKey()
+	turns them back into it, so no two combinations share a key.
+	WithValue() changes one option and leaves the others alone.
+**************************************************************/
+#include <cstdio>
+#include <vector>
+#include "ShaderPermutationKeys.h"
+#include "Test.h"
+
+namespace
+{
+	void TestKeys()
+	{
+		ShaderPermutationKeys keys;
+		CHECK(keys.GetPermutationCount() == 1);
+
+		AddPixelShaderOptions(keys);
+		const uint32_t lightCount = PIXEL_SHADER_LIGHT_COUNT;
+		CHECK(keys.GetOptionCount() == PIXEL_SHADER_OPTION_COUNT);
+		CHECK(keys.GetPermutationCount() == 8 * (1 + PixelShaderFillLightCount));
+
+		bool roundTrip = true, inRange = true, withValue = true;
+		for (uint32_t key = 0; key < keys.GetPermutationCount(); key++)
+		{
+			std::vector<uint32_t> values(keys.GetOptionCount());
+			for (uint32_t option = 0; option < keys.GetOptionCount(); option++)
+				values[option] = keys.GetValue(key, option);
+			roundTrip &= keys.GetKey(values.data()) == key;
+			inRange &= values[0] < 2 && values[lightCount] >= 1 && values[lightCount] <= 1 + PixelShaderFillLightCount;
+
+			for (uint32_t value = 1; value <= 1 + PixelShaderFillLightCount; value++)
+			{
+				const uint32_t changed = keys.WithValue(key, lightCount, value);
+				withValue &= changed < keys.GetPermutationCount() && keys.GetValue(changed, lightCount) == value;
+				for (uint32_t option = 0; option < lightCount; option++)
+					withValue &= keys.GetValue(changed, option) == values[option];
+			}
+		}
+		CHECK(roundTrip);
+		CHECK(inRange);
+		CHECK(withValue);
+
+		// Option 0 is the least significant
+		const uint32_t values[] = { 1, 0, 1, 3 };
+		CHECK(keys.GetKey(values) == 1 + 2 * (0 + 2 * (1 + 2 * (3 - 1))));
+		CHECK(keys.GetName(keys.GetKey(values)) == "HALF_PRECISION=1 TEXTURE=0 SPECULAR=1 LIGHT_COUNT=3");
+	}
+}
+
+int main()
+{
+	TestKeys();
+	return TestResult();
+}
@@ -0,0 +1,134 @@
+/**************************************************************
+	Software rasterizer: the same small scene shaded by the SSE
+	tile loop and by the plain C++ one, compared pixel by pixel.
+	Random triangles, some behind the near plane and some facing
+	away, textured and untextured draws, and a screen that's
+	neither a multiple of 4 nor of the tile size. Coverage has to
+	match exactly, colors within one step per channel.
+
+	Without SSE both renders take the scalar path, which still
+	checks it draws something sensible.
+**************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "SoftwareRasterizer.h"
+#include "Test.h"
+
+namespace
+{
+	const uint32_t Width = 150, Height = 90;
+
+	float Random(float low, float high)
+	{
+		return low + (high - low) * rand() / RAND_MAX;
+	}
+
+	struct Scene
+	{
+		std::vector<SoftwareVertex> Vertices;
+		std::vector<uint16_t> Indices;
+		SoftwareConstants Constants[2];
+		SoftwareTexture Texture;
+	};
+
+	Scene MakeScene()
+	{
+		Scene scene;
+		srand(12);
+		for (uint32_t triangle = 0; triangle < 200; triangle++)
+		{
+			const float x = Random(-4.0f, 4.0f), y = Random(-3.0f, 3.0f), z = Random(-1.0f, 8.0f);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				SoftwareVertex vertex;
+				vertex.Position = DirectX::XMFLOAT3(x + Random(-1.5f, 1.5f), y + Random(-1.5f, 1.5f), z + Random(-1.0f, 1.0f));
+				vertex.TexCoord = DirectX::XMFLOAT2(Random(-1.0f, 2.0f), Random(-1.0f, 2.0f));
+				vertex.Normal = DirectX::XMFLOAT3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), -1.0f);
+				scene.Indices.push_back(uint16_t(scene.Vertices.size()));
+				scene.Vertices.push_back(vertex);
+			}
+		}
+
+		// 8x8 checker with a different color in every square
+		scene.Texture.Width = 8;
+		scene.Texture.Height = 8;
+		for (uint32_t texel = 0; texel < 64; texel++)
+			scene.Texture.Texels.push_back((texel * 0x9E3779B9u) | ((texel + texel / 8) % 2 ? 0xFF000000 : 0x80000000));
+
+		const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(0.0f, 0.0f, -2.0f, 1.0f),
+			DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(60.0f), float(Width) / Height, 0.1f, 100.0f);
+		for (int draw = 0; draw < 2; draw++)
+		{
+			// The second draw is the same triangles turned a little, so they cross the first ones
+			const DirectX::XMMATRIX model = DirectX::XMMatrixRotationY(0.3f * draw) * DirectX::XMMatrixTranslation(0.0f, 0.2f * draw, 0.0f);
+			SoftwareConstants& constants = scene.Constants[draw];
+			DirectX::XMStoreFloat4x4(&constants.World, DirectX::XMMatrixTranspose(model * view * proj));
+			DirectX::XMStoreFloat4x4(&constants.Model, DirectX::XMMatrixTranspose(model));
+			DirectX::XMStoreFloat4x4(&constants.ViewProj, DirectX::XMMatrixTranspose(view * proj));
+			constants.LightPosition = DirectX::XMFLOAT4(1.0f, 2.0f, 1.0f, 1.0f);
+			constants.LightColor = draw ? DirectX::XMFLOAT4(0.2f, 0.9f, 0.4f, 1.0f) : DirectX::XMFLOAT4(1.0f, 0.8f, 0.6f, 1.0f);
+			constants.Eye = DirectX::XMFLOAT4(0.0f, 0.0f, -2.0f, 1.0f);
+		}
+		return scene;
+	}
+
+	void Render(SoftwareRasterizer& software, const Scene& scene)
+	{
+		const float clearColor[] = { 0.0f, 0.0f, 0.2f, 1.0f };
+		software.Clear(clearColor);
+		software.DrawIndexed(scene.Vertices.data(), scene.Indices.data(), uint32_t(scene.Indices.size()), scene.Constants[0], &scene.Texture);
+		software.DrawIndexed(scene.Vertices.data(), scene.Indices.data(), uint32_t(scene.Indices.size()), scene.Constants[1], nullptr);
+		software.Flush();
+	}
+
+	void TestScalarMatchesSSE()
+	{
+		const Scene scene = MakeScene();
+		WorkerPool workers(3);
+		SoftwareRasterizer simd(Width, Height, workers), scalar(Width, Height, workers);
+		scalar.SetScalarShading(true);
+		Render(simd, scene);
+		Render(scalar, scene);
+
+		const SoftwareStats& simdStats = simd.GetStats();
+		const SoftwareStats& scalarStats = scalar.GetStats();
+		CHECK(simdStats.Triangles == 400);
+		CHECK(simdStats.Rasterized == scalarStats.Rasterized);
+		CHECK(simdStats.Rasterized > 0 && simdStats.Rasterized < simdStats.Triangles);
+		CHECK(simdStats.PixelsShaded == scalarStats.PixelsShaded);
+		CHECK(simdStats.PixelsShaded > Width * Height / 2);
+
+		uint32_t different = 0, maxDifference = 0, background = 0;
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				// Rows are padded to 4 pixels
+				const uint32_t a = simd.GetPixels()[y * ((Width + 3) & ~3u) + x];
+				const uint32_t b = scalar.GetPixels()[y * ((Width + 3) & ~3u) + x];
+				background += b == 0xFF330000;
+
+				uint32_t difference = 0;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					const int ca = (a >> (8 * channel)) & 0xFF, cb = (b >> (8 * channel)) & 0xFF;
+					difference = std::max(difference, uint32_t(abs(ca - cb)));
+				}
+				different += difference > 1;
+				maxDifference = std::max(maxDifference, difference);
+			}
+		}
+		std::printf("%u of %u pixels shaded, largest difference %u\n", uint32_t(simdStats.PixelsShaded), Width * Height, maxDifference);
+		CHECK(different == 0);
+		CHECK(background > 0 && background < Width * Height);
+	}
+}
+
+int main()
+{
+	TestScalarMatchesSSE();
+	return TestResult();
+}
@@ -0,0 +1,270 @@
+/**************************************************************
+	Staging descriptor allocator on the null device: handles in
+	address order inside real pages, freed slots reused before a
+	new page is made, batches all or nothing when a page can't be
+	created, and a Cache only going to the allocator a batch at a
+	time and giving everything back when it's destroyed.
+
+	Then threads allocating and freeing at once, half through a
+	Cache of their own and half straight from the allocator, each
+	claiming the slots it gets so one handed out twice shows up.
+	Last, views staged here and copied into the BindlessHeap in
+	one batch land in the slots they were queued for.
+**************************************************************/
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "d3dx12.h"
+#include "BindlessHeap.h"
+#include "NullD3D12.h"
+#include "StagingDescriptorAllocator.h"
+#include "Test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// In its page's heap, where the slot says
+	bool InPage(ID3D12Device* device, const StagingDescriptorAllocator& allocator, const StagingDescriptor& descriptor)
+	{
+		if (!descriptor.IsValid() || descriptor.Page >= allocator.GetPageCount())
+			return false;
+
+		ID3D12DescriptorHeap* heap = allocator.GetPageHeap(descriptor.Page);
+		const SIZE_T expected = heap->GetCPUDescriptorHandleForHeapStart().ptr + SIZE_T(descriptor.Slot) * device->GetDescriptorHandleIncrementSize(allocator.GetType());
+		return descriptor.Handle.ptr == expected && static_cast<NullD3D12::DescriptorHeap*>(heap)->Contains(descriptor.Handle)
+			&& heap->GetDesc().Type == allocator.GetType() && !(heap->GetDesc().Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+	}
+
+	void TestPages(NullD3D12::Device* device)
+	{
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 16);
+		CHECK(allocator.GetPageCount() == 0);
+
+		const UINT heapsBefore = device->GetDescriptorHeapCount();
+		std::vector<StagingDescriptor> descriptors;
+		bool inPage = true, ordered = true;
+		for (UINT i = 0; i < 40; i++)
+		{
+			descriptors.push_back(allocator.Allocate());
+			inPage &= InPage(device, allocator, descriptors.back());
+			if (i % 16)
+				ordered &= descriptors[i].Page == descriptors[i - 1].Page && descriptors[i].Handle.ptr > descriptors[i - 1].Handle.ptr;
+		}
+		CHECK(inPage && ordered);
+		CHECK(allocator.GetPageCount() == 3);
+		CHECK(device->GetDescriptorHeapCount() - heapsBefore == 3);
+		CHECK(allocator.GetAllocatedCount() == 40);
+
+		// The handles are real descriptors a view can be written into
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		const CD3DX12_RESOURCE_DESC targetDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 8, 8, 1, 1, 1, 0,
+			D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+		ComPtr<ID3D12Resource> target;
+		CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &targetDesc, D3D12_RESOURCE_STATE_RENDER_TARGET,
+			nullptr, IID_PPV_ARGS(&target))));
+		device->CreateRenderTargetView(target.Get(), nullptr, descriptors[37].Handle);
+		CHECK(NullD3D12::GetDescriptor(descriptors[37].Handle).Written);
+		CHECK(NullD3D12::GetDescriptor(descriptors[37].Handle).Resource == target.Get());
+		CHECK(!NullD3D12::GetDescriptor(descriptors[36].Handle).Written);
+
+		// Freed slots go out again before any new page
+		for (size_t i = 0; i < descriptors.size(); i += 2)
+			allocator.Free(descriptors[i]);
+		CHECK(allocator.GetAllocatedCount() == 20);
+		for (UINT i = 0; i < 28; i++)
+			CHECK(InPage(device, allocator, allocator.Allocate()));
+		CHECK(allocator.GetPageCount() == 3);
+		CHECK(allocator.GetAllocatedCount() == 48);
+		CHECK(InPage(device, allocator, allocator.Allocate()));
+		CHECK(allocator.GetPageCount() == 4);
+	}
+
+	void TestOutOfMemory(NullD3D12::Device* device)
+	{
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 8);
+		device->DescriptorHeapLimit = device->GetDescriptorHeapCount() + 1;
+
+		std::vector<StagingDescriptor> out;
+		CHECK(allocator.AllocateBatch(6, out) && out.size() == 6);
+
+		// Needs a second page it can't get, nothing changes
+		CHECK(!allocator.AllocateBatch(6, out));
+		CHECK(out.size() == 6);
+		CHECK(allocator.GetAllocatedCount() == 6);
+		CHECK(allocator.GetPageCount() == 1);
+
+		// What's left of the page still goes out
+		CHECK(allocator.AllocateBatch(2, out) && out.size() == 8);
+		CHECK(!allocator.Allocate().IsValid());
+		allocator.FreeBatch(out.data(), out.size());
+		CHECK(allocator.GetAllocatedCount() == 0);
+
+		device->DescriptorHeapLimit = ~0u;
+	}
+
+	void TestCache(NullD3D12::Device* device)
+	{
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64);
+		{
+			StagingDescriptorAllocator::Cache cache(allocator, 4);
+
+			// The first allocation takes a whole batch
+			std::vector<StagingDescriptor> held;
+			held.push_back(cache.Allocate());
+			CHECK(allocator.GetAllocatedCount() == 4);
+			for (UINT i = 0; i < 3; i++)
+				held.push_back(cache.Allocate());
+			CHECK(allocator.GetAllocatedCount() == 4);
+			held.push_back(cache.Allocate());
+			CHECK(allocator.GetAllocatedCount() == 8);
+
+			// Whenever two batches' worth are free one goes back, the last batch stays for later
+			for (UINT i = 0; i < 5; i++)
+				held.push_back(cache.Allocate());
+			CHECK(allocator.GetAllocatedCount() == 12);
+			for (const StagingDescriptor& descriptor : held)
+				cache.Free(descriptor);
+			CHECK(allocator.GetAllocatedCount() == 4);
+		}
+		CHECK(allocator.GetAllocatedCount() == 0);
+		CHECK(allocator.GetPageCount() == 1);
+	}
+
+	void TestContention(NullD3D12::Device* device)
+	{
+		const UINT pageSize = 64;
+		const unsigned int threadCount = 8;
+		const unsigned int held = 100;
+		const UINT batchSize = 16;
+
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, pageSize);
+
+		// Every page there could ever be, claimed per slot
+		const UINT maxPages = (threadCount * (held + 2 * batchSize) + pageSize - 1) / pageSize;
+		std::unique_ptr<std::atomic<int>[]> owners(new std::atomic<int>[maxPages * pageSize]);
+		for (UINT slot = 0; slot < maxPages * pageSize; slot++)
+			owners[slot] = -1;
+
+		std::atomic<unsigned int> conflicts(0), failures(0);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> threads;
+		for (unsigned int thread = 0; thread < threadCount; thread++)
+		{
+			threads.emplace_back([&, thread]()
+			{
+				// Odd threads share the allocator's lock on every call
+				std::unique_ptr<StagingDescriptorAllocator::Cache> cache(thread % 2 ? nullptr : new StagingDescriptorAllocator::Cache(allocator, batchSize));
+				auto Claim = [&](const StagingDescriptor& descriptor, int from, int to)
+				{
+					if (descriptor.Page >= maxPages || descriptor.Slot >= pageSize)
+					{
+						conflicts++;
+						return;
+					}
+					int expected = from;
+					if (!owners[descriptor.Page * pageSize + descriptor.Slot].compare_exchange_strong(expected, to))
+						conflicts++;
+				};
+
+				while (!go)
+					std::this_thread::yield();
+
+				std::vector<StagingDescriptor> mine;
+				for (unsigned int round = 0; round < 2000; round++)
+				{
+					const unsigned int want = 1 + (round * 13 + thread * 7) % held;
+					while (mine.size() < want)
+					{
+						const StagingDescriptor descriptor = cache ? cache->Allocate() : allocator.Allocate();
+						if (!descriptor.IsValid())
+						{
+							failures++;
+							break;
+						}
+						Claim(descriptor, -1, int(thread));
+						mine.push_back(descriptor);
+					}
+
+					const size_t keep = round % 3 == 0 ? 0 : mine.size() / 2;
+					while (mine.size() > keep)
+					{
+						Claim(mine.back(), int(thread), -1);
+						if (cache)
+							cache->Free(mine.back());
+						else
+							allocator.Free(mine.back());
+						mine.pop_back();
+					}
+				}
+
+				for (const StagingDescriptor& descriptor : mine)
+				{
+					Claim(descriptor, int(thread), -1);
+					allocator.Free(descriptor);
+				}
+			});
+		}
+		go = true;
+		for (std::thread& thread : threads)
+			thread.join();
+
+		CHECK(conflicts == 0);
+		CHECK(failures == 0);
+		CHECK(allocator.GetAllocatedCount() == 0);
+		CHECK(allocator.GetPageCount() <= maxPages);
+	}
+
+	// Staged views reach the shader visible heap in one CopyDescriptors
+	void TestBindlessCopy(NullD3D12::Device* device)
+	{
+		StagingDescriptorAllocator allocator;
+		allocator.Init(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 16);
+		BindlessHeap bindless;
+		CHECK(SUCCEEDED(bindless.Init(device, 32)));
+
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		const CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 8, 8, 1, 1);
+		std::vector<ComPtr<ID3D12Resource>> textures(20);
+		std::vector<UINT> slots;
+		const UINT copiedBefore = device->GetCopiedDescriptorCount();
+		for (ComPtr<ID3D12Resource>& texture : textures)
+		{
+			CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_COMMON,
+				nullptr, IID_PPV_ARGS(&texture))));
+			const StagingDescriptor view = allocator.Allocate();
+			device->CreateShaderResourceView(texture.Get(), nullptr, view.Handle);
+			slots.push_back(bindless.Allocate());
+			bindless.QueueCopy(slots.back(), view.Handle);
+		}
+		CHECK(device->GetCopiedDescriptorCount() == copiedBefore);
+
+		bindless.FlushCopies();
+		CHECK(bindless.GetCopyBatchCount() == 1);
+		CHECK(bindless.GetCopyCount() == textures.size());
+		CHECK(device->GetCopiedDescriptorCount() - copiedBefore == textures.size());
+		bool landed = true;
+		for (size_t i = 0; i < textures.size(); i++)
+			landed &= NullD3D12::GetDescriptor(bindless.GetCpuHandle(slots[i])).Resource == textures[i].Get();
+		CHECK(landed);
+	}
+}
+
+int main()
+{
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+
+	TestPages(device.Get());
+	TestOutOfMemory(device.Get());
+	TestCache(device.Get());
+	TestContention(device.Get());
+	TestBindlessCopy(device.Get());
+	return TestResult();
+}
@@ -0,0 +1,103 @@
+/**************************************************************
+	Synthetic DDS
+
+	Builds DDS files in memory for the parser tests, fuzzer and
+	benchmark: any dimension, array size, mip chain and format,
+	with a DX10 header or, for the formats that have one, the old
+	pixel format header. The bits after the header are a counting
+	pattern, sized with GetSurfaceInfo unless 'dataSize' says
+	otherwise.
+**************************************************************/
+#pragma once
+#include <cstring>
+#include <vector>
+#include "DDSParser.h"
+
+struct SyntheticDDSDesc
+{
+	DirectX::DDS_DIMENSION Dimension = DirectX::DDS_DIMENSION_TEXTURE2D;
+	uint32_t Width = 1;
+	uint32_t Height = 1;
+	uint32_t Depth = 1;
+	uint32_t ArraySize = 1;			// Cubes, not faces, for a cube map
+	uint32_t MipCount = 1;
+	DXGI_FORMAT Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	bool CubeMap = false;
+	bool DX10Header = true;			// Legacy header only does RGBA8 and BC1-3
+	size_t DataSize = ~size_t(0);	// Bytes after the headers, ~0 for exactly what the texture needs
+};
+
+// Bytes a full mip chain takes, the way FillDDSSubresources lays it out
+inline size_t SyntheticDDSDataSize(const SyntheticDDSDesc& desc)
+{
+	const uint32_t faces = desc.ArraySize * (desc.CubeMap ? 6 : 1);
+	size_t total = 0;
+	for (uint32_t slice = 0; slice < faces; slice++)
+	{
+		size_t w = desc.Width, h = desc.Height, d = desc.Depth;
+		for (uint32_t mip = 0; mip < desc.MipCount; mip++)
+		{
+			size_t numBytes = 0;
+			DirectX::GetSurfaceInfo(w, h, desc.Format, &numBytes, nullptr, nullptr);
+			total += numBytes * d;
+			w = w > 1 ? w >> 1 : 1;
+			h = h > 1 ? h >> 1 : 1;
+			d = d > 1 ? d >> 1 : 1;
+		}
+	}
+	return total;
+}
+
+inline std::vector<uint8_t> MakeSyntheticDDS(const SyntheticDDSDesc& desc)
+{
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = 0x1 | 0x1000 | DDS_WIDTH | DDS_HEIGHT;		// DDSD_CAPS | DDSD_PIXELFORMAT
+	header.width = desc.Width;
+	header.height = desc.Height;
+	header.depth = desc.Depth;
+	header.mipMapCount = desc.MipCount;
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.caps = 0x1000;										// DDSCAPS_TEXTURE
+	if (desc.Dimension == DirectX::DDS_DIMENSION_TEXTURE3D)
+		header.flags |= DDS_HEADER_FLAGS_VOLUME;
+	if (desc.CubeMap)
+		header.caps2 = DDS_CUBEMAP_ALLFACES;
+
+	DDS_HEADER_DXT10 dx10 = {};
+	if (desc.DX10Header)
+	{
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		dx10.dxgiFormat = desc.Format;
+		dx10.resourceDimension = desc.Dimension;
+		dx10.miscFlag = desc.CubeMap ? 0x4 : 0;						// D3D11_RESOURCE_MISC_TEXTURECUBE
+		dx10.arraySize = desc.ArraySize;
+	}
+	else if (desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		header.ddspf.flags = DDS_RGB | 0x1;							// DDPF_ALPHAPIXELS
+		header.ddspf.RGBBitCount = 32;
+		header.ddspf.RBitMask = 0x000000ff;
+		header.ddspf.GBitMask = 0x0000ff00;
+		header.ddspf.BBitMask = 0x00ff0000;
+		header.ddspf.ABitMask = 0xff000000;
+	}
+	else
+	{
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = desc.Format == DXGI_FORMAT_BC1_UNORM ? MAKEFOURCC('D', 'X', 'T', '1')
+			: desc.Format == DXGI_FORMAT_BC2_UNORM ? MAKEFOURCC('D', 'X', 'T', '3') : MAKEFOURCC('D', 'X', 'T', '5');
+	}
+
+	const size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + (desc.DX10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+	const size_t dataSize = desc.DataSize != ~size_t(0) ? desc.DataSize : SyntheticDDSDataSize(desc);
+	std::vector<uint8_t> file(headerSize + dataSize);
+	memcpy(file.data(), &DDS_MAGIC, sizeof(uint32_t));
+	memcpy(file.data() + sizeof(uint32_t), &header, sizeof(header));
+	if (desc.DX10Header)
+		memcpy(file.data() + sizeof(uint32_t) + sizeof(header), &dx10, sizeof(dx10));
+	for (size_t i = 0; i < dataSize; i++)
+		file[headerSize + i] = (uint8_t)i;
+	return file;
+}
@@ -0,0 +1,32 @@
+/**************************************************************
+	Test
+
+	Just enough of a harness for the tests that run without a
+	device. CHECK prints the expression that failed and where,
+	then carries on with the rest of the test. main() returns
+	TestResult(), so ctest sees the failure.
+**************************************************************/
+#pragma once
+#include <cstdio>
+
+inline int& TestFailureCount()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(expression) \
+	do { \
+		if (!(expression)) \
+		{ \
+			std::printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expression); \
+			TestFailureCount()++; \
+		} \
+	} while (0)
+
+inline int TestResult()
+{
+	if (TestFailureCount())
+		std::printf("%d checks failed\n", TestFailureCount());
+	return TestFailureCount() ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/**************************************************************
+	Texture streamer on the null device, with a sink standing in
+	for the UploadManager: every texture reaches the sink once
+	with the bits the parser found, futures only complete once
+	the batch's fence has passed, failures (missing file, broken
+	file, failed upload) come back through the future, and the
+	per-stage times add up. Then a burst of loads over a few
+	workers, placed through a ResourceHeapAllocator.
+**************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NullD3D12.h"
+#include "SyntheticDDS.h"
+#include "Test.h"
+#include "TextureStreamer.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Sums the bytes of every subresource, so the sink can be compared with
+	// a plain parse of the same file
+	uint64_t Checksum(const D3D12_SUBRESOURCE_DATA* subresources, UINT count)
+	{
+		uint64_t sum = 0;
+		for (UINT i = 0; i < count; i++)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(subresources[i].pData);
+			for (LONG_PTR b = 0; b < subresources[i].SlicePitch; b++)
+				sum = sum * 31 + bytes[b];
+		}
+		return sum;
+	}
+
+	uint64_t FileChecksum(const char* fileName)
+	{
+		MappedFile file;
+		if (!file.Open(fileName))
+			return 0;
+
+		DirectX::DDSTextureDesc desc;
+		std::vector<DirectX::DDSSubresource> subresources;
+		if (DirectX::ParseDDSTexture(file.Data(), file.Size(), 0, desc, subresources) != DirectX::DDS_PARSE_OK)
+			return 0;
+
+		std::vector<D3D12_SUBRESOURCE_DATA> data;
+		for (const DirectX::DDSSubresource& subresource : subresources)
+			data.push_back({ subresource.data, LONG_PTR(subresource.rowPitch), LONG_PTR(subresource.slicePitch) });
+		return Checksum(data.data(), UINT(data.size()));
+	}
+
+	// UploadManager::UploadTexture without a queue
+	struct MockUploadSink
+	{
+		struct Upload
+		{
+			ID3D12Resource* Texture;
+			UINT SubresourceCount;
+			uint64_t Checksum;
+		};
+
+		std::vector<Upload> Uploads;
+		UINT FailAfter = ~0u;		// Uploads past this many fail
+
+		HRESULT UploadTexture(ID3D12Resource* texture, const D3D12_SUBRESOURCE_DATA* subresources, UINT subresourceCount)
+		{
+			Uploads.push_back({ texture, subresourceCount, Checksum(subresources, subresourceCount) });
+			return Uploads.size() > FailAfter ? E_OUTOFMEMORY : S_OK;
+		}
+	};
+
+	bool IsReady(const std::future<TextureLoadResult>& future)
+	{
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// Records until 'count' textures have left the workers, one "frame" at a time
+	template <typename Sink>
+	UINT RecordAll(TextureStreamer& streamer, Sink& sink, UINT count, UINT* failedEarly)
+	{
+		const size_t uploadsBefore = sink.Uploads.size();
+		const UINT failedBefore = streamer.GetStats().Failed;
+
+		UINT recorded = 0;
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+		while (sink.Uploads.size() - uploadsBefore + streamer.GetStats().Failed - failedBefore < count
+			&& std::chrono::steady_clock::now() < deadline)
+		{
+			recorded += streamer.RecordUploads(sink);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		*failedEarly = streamer.GetStats().Failed - failedBefore;
+		return recorded;
+	}
+
+	bool WriteFile(const std::string& fileName, const std::vector<uint8_t>& data)
+	{
+		FILE* file = std::fopen(fileName.c_str(), "wb");
+		if (!file)
+			return false;
+		const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+		std::fclose(file);
+		return written;
+	}
+}
+
+int main()
+{
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+
+	// A cube map and a file cut off in the middle of its bits, next to the real ones
+	SyntheticDDSDesc cubeDesc;
+	cubeDesc.Width = cubeDesc.Height = 64;
+	cubeDesc.MipCount = 7;
+	cubeDesc.CubeMap = true;
+	const std::vector<uint8_t> cube = MakeSyntheticDDS(cubeDesc);
+	std::vector<uint8_t> truncated = cube;
+	truncated.resize(truncated.size() / 2);
+
+	const std::string cubeFile = "TextureStreamerTest.cube.dds";
+	const std::string truncatedFile = "TextureStreamerTest.truncated.dds";
+	CHECK(WriteFile(cubeFile, cube));
+	CHECK(WriteFile(truncatedFile, truncated));
+
+	// Committed textures, everything through the sink
+	{
+		TextureStreamer streamer(device.Get(), nullptr, 2);
+		MockUploadSink sink;
+
+		std::future<TextureLoadResult> bricks = streamer.LoadAsync("bricks.dds");
+		std::future<TextureLoadResult> checkboard = streamer.LoadAsync("checkboard.dds");
+		std::future<TextureLoadResult> cubeMap = streamer.LoadAsync(cubeFile.c_str());
+		std::future<TextureLoadResult> missing = streamer.LoadAsync("TextureStreamerTest.missing.dds");
+		std::future<TextureLoadResult> broken = streamer.LoadAsync(truncatedFile.c_str());
+
+		UINT failedEarly = 0;
+		const UINT recorded = RecordAll(streamer, sink, 5, &failedEarly);
+		CHECK(recorded == 3);
+		CHECK(sink.Uploads.size() == 3);
+		CHECK(failedEarly == 2);
+
+		// Nothing to copy, so they fail right away without waiting for a fence
+		CHECK(IsReady(missing) && FAILED(missing.get().Result));
+		CHECK(IsReady(broken) && broken.get().Result == HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+
+		// The others are only done once the copy is
+		CHECK(!IsReady(bricks) && !IsReady(checkboard) && !IsReady(cubeMap));
+		streamer.Submitted(1);
+		CHECK(!streamer.IsIdle());
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		streamer.Update(0);
+		CHECK(!IsReady(bricks) && !IsReady(checkboard) && !IsReady(cubeMap));
+		streamer.Update(1);
+		CHECK(IsReady(bricks) && IsReady(checkboard) && IsReady(cubeMap));
+		CHECK(streamer.IsIdle());
+
+		// Each upload carries exactly what a plain parse of the file sees, whatever
+		// order the workers finished in
+		const uint64_t bricksSum = FileChecksum("bricks.dds");
+		const uint64_t checkboardSum = FileChecksum("checkboard.dds");
+		const uint64_t cubeSum = FileChecksum(cubeFile.c_str());
+		CHECK(bricksSum && checkboardSum && cubeSum);
+
+		const TextureLoadResult results[3] = { bricks.get(), checkboard.get(), cubeMap.get() };
+		const uint64_t sums[3] = { bricksSum, checkboardSum, cubeSum };
+		for (int i = 0; i < 3; i++)
+		{
+			CHECK(SUCCEEDED(results[i].Result) && results[i].Texture);
+			bool uploaded = false;
+			for (const MockUploadSink::Upload& upload : sink.Uploads)
+			{
+				if (upload.Texture == results[i].Texture.Get())
+				{
+					uploaded = upload.Checksum == sums[i]
+						&& upload.SubresourceCount == NullD3D12::SubresourceCount(upload.Texture->GetDesc());
+				}
+			}
+			CHECK(uploaded);
+		}
+
+		// Cube maps are 2D arrays of 6 as far as D3D12 knows
+		const D3D12_RESOURCE_DESC cubeResource = results[2].Texture->GetDesc();
+		CHECK(results[2].IsCubeMap && !results[0].IsCubeMap);
+		CHECK(cubeResource.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D && cubeResource.DepthOrArraySize == 6 && cubeResource.MipLevels == 7);
+		CHECK(device->GetCommittedCount() == 3);
+
+		// Stage times, the gpu one includes the 5 ms "copy"
+		const TextureStreamer::StageStats& stats = streamer.GetStats();
+		CHECK(stats.Completed == 3 && stats.Failed == 2);
+		CHECK(stats.Read >= 0.0 && stats.Parse >= 0.0 && stats.Record >= 0.0);
+		CHECK(stats.Gpu >= 3 * 5.0);
+		std::printf("%s", streamer.GetStatsString().c_str());
+	}
+
+	// A failed upload still holds on to its texture until the fence, since some
+	// of its copies may have been recorded
+	{
+		TextureStreamer streamer(device.Get(), nullptr, 1);
+		MockUploadSink sink;
+		sink.FailAfter = 0;
+
+		std::future<TextureLoadResult> bricks = streamer.LoadAsync("bricks.dds");
+		UINT failedEarly = 0;
+		CHECK(RecordAll(streamer, sink, 1, &failedEarly) == 1);
+		CHECK(failedEarly == 0);
+		CHECK(!IsReady(bricks));
+
+		streamer.Submitted(7);
+		streamer.Update(7);
+		CHECK(IsReady(bricks));
+		const TextureLoadResult result = bricks.get();
+		CHECK(result.Result == E_OUTOFMEMORY && !result.Texture);
+		CHECK(streamer.GetStats().Failed == 1 && streamer.GetStats().Completed == 0);
+	}
+
+	// A burst over four workers, placed in heaps. Two batches, the second one
+	// recorded while the first is still in flight.
+	{
+		ResourceHeapAllocator heaps;
+		CHECK(SUCCEEDED(heaps.Init(device.Get(), nullptr, 4 * 1024 * 1024)));
+
+		TextureStreamer streamer(device.Get(), &heaps, 4);
+		MockUploadSink sink;
+		const UINT placedBefore = device->GetPlacedCount();
+
+		std::vector<std::future<TextureLoadResult>> first, second;
+		for (int i = 0; i < 16; i++)
+			first.push_back(streamer.LoadAsync(i % 2 ? "bricks.dds" : cubeFile.c_str()));
+
+		UINT failedEarly = 0;
+		CHECK(RecordAll(streamer, sink, 16, &failedEarly) == 16);
+		streamer.Submitted(1);
+
+		for (int i = 0; i < 16; i++)
+			second.push_back(streamer.LoadAsync("checkboard.dds"));
+		CHECK(RecordAll(streamer, sink, 16, &failedEarly) == 16);
+		streamer.Submitted(2);
+
+		// Placed textures go back to the heaps like any other resource
+		std::vector<TextureLoadResult> results;
+		streamer.Update(1);
+		for (std::future<TextureLoadResult>& future : first)
+		{
+			CHECK(IsReady(future));
+			results.push_back(future.get());
+		}
+		for (std::future<TextureLoadResult>& future : second)
+			CHECK(!IsReady(future));
+
+		streamer.Update(2);
+		for (std::future<TextureLoadResult>& future : second)
+		{
+			CHECK(IsReady(future));
+			results.push_back(future.get());
+		}
+		CHECK(streamer.IsIdle());
+		CHECK(streamer.GetStats().Completed == 32);
+		CHECK(device->GetPlacedCount() - placedBefore == 32);
+		CHECK(heaps.GetPlacedCount() == 32);
+
+		const UINT64 allocated = heaps.GetAllocatedSize();
+		for (TextureLoadResult& result : results)
+		{
+			CHECK(SUCCEEDED(result.Result) && result.Texture);
+			if (result.Texture)
+				heaps.Free(result.Texture.Detach());
+		}
+		CHECK(allocated > 0);
+		heaps.FinishFrame(3);
+		heaps.ReleaseCompleted(3);
+		CHECK(heaps.GetAllocatedSize() == 0);
+		std::printf("%s", streamer.GetStatsString().c_str());
+	}
+
+	std::remove(cubeFile.c_str());
+	std::remove(truncatedFile.c_str());
+	return TestResult();
+}
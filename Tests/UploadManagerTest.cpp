@@ -0,0 +1,316 @@
+/**************************************************************
+	Upload manager on the null device, whose copy queue runs the
+	recorded copies on a thread of its own: uploads batch into one
+	list until Submit(), nothing lands before the fence, allocators
+	are reused once their batch is done, textures bigger than a
+	staging block go up in chunks (and a dedicated heap that lives
+	until the fence), a full pool stalls on the fence and carries
+	on, and GpuWait holds another queue back until the copies are
+	done. Buffers placed by a ResourceHeapAllocator don't overlap,
+	whatever alignment their desc came with.
+**************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <wrl.h>
+#include "NullD3D12.h"
+#include "Test.h"
+#include "UploadManager.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	std::vector<UINT8> RandomBytes(size_t size)
+	{
+		std::vector<UINT8> bytes(size);
+		for (UINT8& byte : bytes)
+			byte = UINT8(std::rand());
+		return bytes;
+	}
+
+	NullD3D12::CommandQueue* QueueOf(UploadManager& uploads)
+	{
+		return static_cast<NullD3D12::CommandQueue*>(uploads.GetQueue());
+	}
+
+	bool Matches(ID3D12Resource* buffer, const std::vector<UINT8>& data)
+	{
+		return memcmp(static_cast<NullD3D12::Resource*>(buffer)->GetMemory(), data.data(), data.size()) == 0;
+	}
+
+	// Compares every subresource of 'texture' with the source rows
+	bool Matches(ID3D12Resource* texture, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+	{
+		const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+		const UINT count = UINT(subresources.size());
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(count);
+		std::vector<UINT> rows(count);
+		std::vector<UINT64> rowSizes(count);
+		NullD3D12::GetCopyableFootprints(&desc, 0, count, 0, layouts.data(), rows.data(), rowSizes.data(), nullptr);
+
+		const UINT8* memory = static_cast<NullD3D12::Resource*>(texture)->GetMemory();
+		for (UINT i = 0; i < count; i++)
+		{
+			for (UINT z = 0; z < layouts[i].Footprint.Depth; z++)
+			{
+				for (UINT row = 0; row < rows[i]; row++)
+				{
+					const UINT8* source = static_cast<const UINT8*>(subresources[i].pData) + z * subresources[i].SlicePitch + row * subresources[i].RowPitch;
+					const UINT8* copied = memory + layouts[i].Offset + (UINT64(z) * rows[i] + row) * layouts[i].Footprint.RowPitch;
+					if (memcmp(source, copied, size_t(rowSizes[i])) != 0)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	UINT ListErrors(UploadManager& uploads)
+	{
+		return static_cast<NullD3D12::GraphicsCommandList*>(uploads.GetCommandList())->GetErrorCount();
+	}
+}
+
+int main()
+{
+	ComPtr<NullD3D12::Device> device;
+	device.Attach(new NullD3D12::Device());
+	const UINT64 blockSize = 64 * 1024;
+
+	// Buffers batch up until Submit, and only land once the gpu gets to them
+	{
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), blockSize, 4)));
+		QueueOf(uploads)->Pause();
+
+		const std::vector<UINT8> small = RandomBytes(1000), medium = RandomBytes(10000), large = RandomBytes(40000);
+		ID3D12Resource* buffers[3] = {};
+		CHECK(SUCCEEDED(uploads.CreateBuffer(small.data(), small.size(), &buffers[0])));
+		CHECK(SUCCEEDED(uploads.CreateBuffer(medium.data(), medium.size(), &buffers[1])));
+		CHECK(SUCCEEDED(uploads.CreateBuffer(large.data(), large.size(), &buffers[2])));
+		CHECK(ListErrors(uploads) == 0);
+		CHECK(device->GetAllocatorCount() == 1 && device->GetCommandListCount() == 1);
+		CHECK(uploads.GetBytesUploaded() == 51000);
+
+		CHECK(uploads.Submit() == 1);
+		CHECK(uploads.Submit() == 1);		// Nothing new recorded
+		CHECK(uploads.GetSubmitCount() == 1);
+		CHECK(QueueOf(uploads)->GetExecuteCount() == 1);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		CHECK(uploads.GetCompletedFenceValue() == 0);
+		CHECK(!Matches(buffers[2], large));
+
+		QueueOf(uploads)->Resume();
+		uploads.Flush();
+		CHECK(uploads.GetCompletedFenceValue() == 1);
+		CHECK(Matches(buffers[0], small) && Matches(buffers[1], medium) && Matches(buffers[2], large));
+		CHECK(QueueOf(uploads)->GetErrorCount() == 0);
+
+		// Allocators come back once their batch is done, and only then
+		for (int i = 0; i < 10; i++)
+		{
+			ID3D12Resource* buffer = nullptr;
+			CHECK(SUCCEEDED(uploads.CreateBuffer(small.data(), small.size(), &buffer)));
+			uploads.Submit();
+			uploads.Flush();
+			buffer->Release();
+		}
+		CHECK(device->GetAllocatorCount() == 1);
+
+		QueueOf(uploads)->Pause();
+		ID3D12Resource* pending[3] = {};
+		for (ID3D12Resource*& buffer : pending)
+		{
+			CHECK(SUCCEEDED(uploads.CreateBuffer(small.data(), small.size(), &buffer)));
+			uploads.Submit();
+		}
+		CHECK(device->GetAllocatorCount() == 3);
+		QueueOf(uploads)->Resume();
+		uploads.Flush();
+		for (ID3D12Resource* buffer : pending)
+			buffer->Release();
+
+		for (ID3D12Resource* buffer : buffers)
+			buffer->Release();
+	}
+
+	// A texture with mips from 256 KB down, bigger than a block at the top: the
+	// first mip gets its own upload heap, the rest are packed into chunks
+	{
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), blockSize, 4)));
+
+		const CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 2, 9);
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		ComPtr<ID3D12Resource> texture;
+		CHECK(SUCCEEDED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON,
+			nullptr, IID_PPV_ARGS(&texture))));
+
+		std::vector<std::vector<UINT8>> bits;
+		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		for (UINT slice = 0; slice < 2; slice++)
+		{
+			for (UINT mip = 0; mip < 9; mip++)
+			{
+				const UINT size = std::max(256u >> mip, 1u);
+				bits.push_back(RandomBytes(size * size * 4));
+				subresources.push_back({ bits.back().data(), LONG_PTR(size * 4), LONG_PTR(size * size * 4) });
+			}
+		}
+
+		QueueOf(uploads)->Pause();
+		const int liveBefore = NullD3D12::LiveResourceCount();
+		CHECK(SUCCEEDED(uploads.UploadTexture(texture.Get(), subresources.data(), UINT(subresources.size()))));
+		CHECK(ListErrors(uploads) == 0);
+		CHECK(uploads.GetDedicatedCount() == 2);		// Mip 0 of each slice
+
+		// Each slice's other mips add up to 85 KB, so about two chunks a slice
+		CHECK(uploads.GetStaging().GetAllocationCount() >= 4);
+		CHECK(uploads.GetStaging().GetPeakUsedSize() <= 4 * blockSize);
+
+		const int stagingBlocks = int(uploads.GetStaging().GetCommittedSize() / blockSize);
+		const UINT64 fence = uploads.Submit();
+		uploads.ReleaseCompleted();
+		CHECK(NullD3D12::LiveResourceCount() == liveBefore + stagingBlocks + 2);		// The dedicated heaps wait for the fence...
+
+		QueueOf(uploads)->Resume();
+		uploads.Flush();
+		CHECK(uploads.GetCompletedFenceValue() == fence);
+		uploads.ReleaseCompleted();
+		CHECK(NullD3D12::LiveResourceCount() == liveBefore + stagingBlocks);		// ...and go right after it
+		CHECK(Matches(texture.Get(), subresources));
+	}
+
+	// More in one go than the pool holds: it pushes out the batch, waits for the
+	// gpu to free a block, and carries on
+	{
+		device->QueueLatency = std::chrono::milliseconds(2);
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), blockSize, 2)));
+		device->QueueLatency = std::chrono::microseconds(0);
+
+		std::vector<std::vector<UINT8>> data;
+		std::vector<ID3D12Resource*> buffers;
+		for (int i = 0; i < 40; i++)
+		{
+			data.push_back(RandomBytes(16 * 1024));
+			ID3D12Resource* buffer = nullptr;
+			CHECK(SUCCEEDED(uploads.CreateBuffer(data.back().data(), data.back().size(), &buffer)));
+			buffers.push_back(buffer);
+		}
+		uploads.Submit();
+		uploads.Flush();
+
+		// 8 fit in two blocks, every stall frees at least one more block's worth
+		CHECK(uploads.GetStallCount() >= 4);
+		CHECK(uploads.GetSubmitCount() == uploads.GetStallCount() + 1);
+		CHECK(uploads.GetStaging().GetCommittedSize() == 2 * blockSize);
+		for (int i = 0; i < 40; i++)
+			CHECK(Matches(buffers[i], data[i]));
+		for (ID3D12Resource* buffer : buffers)
+			buffer->Release();
+	}
+
+	// GpuWait: the direct queue doesn't get past the wait before the copy fence
+	{
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), blockSize, 1)));
+
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+		ComPtr<ID3D12CommandQueue> direct;
+		ComPtr<ID3D12Fence> directFence;
+		CHECK(SUCCEEDED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&direct))));
+		CHECK(SUCCEEDED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&directFence))));
+
+		QueueOf(uploads)->Pause();
+		const std::vector<UINT8> data = RandomBytes(5000);
+		ID3D12Resource* buffer = nullptr;
+		CHECK(SUCCEEDED(uploads.CreateBuffer(data.data(), data.size(), &buffer)));
+		const UINT64 fence = uploads.Submit();
+
+		uploads.GpuWait(direct.Get(), fence);
+		direct->Signal(directFence.Get(), 1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		CHECK(directFence->GetCompletedValue() == 0);
+
+		QueueOf(uploads)->Resume();
+		HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		directFence->SetEventOnCompletion(1, event);
+		CHECK(WaitForSingleObject(event, 5000) == WAIT_OBJECT_0);
+		CloseHandle(event);
+		CHECK(Matches(buffer, data));
+		buffer->Release();
+	}
+
+	// Buffers placed through a ResourceHeapAllocator instead of committed
+	{
+		ResourceHeapAllocator heaps;
+		CHECK(SUCCEEDED(heaps.Init(device.Get(), nullptr, 1024 * 1024)));
+		UploadManager uploads;
+		CHECK(SUCCEEDED(uploads.Init(device.Get(), blockSize, 2, &heaps)));
+
+		const UINT committedBefore = device->GetCommittedCount();
+		const std::vector<UINT8> data = RandomBytes(3000);
+		ID3D12Resource* buffer = nullptr;
+		CHECK(SUCCEEDED(uploads.CreateBuffer(data.data(), data.size(), &buffer)));
+		uploads.Submit();
+		uploads.Flush();
+		CHECK(Matches(buffer, data));
+		CHECK(heaps.GetPlacedCount() == 1);
+		CHECK(device->GetCommittedCount() - committedBefore == 1);		// Just the staging block
+
+		heaps.Free(buffer);
+		heaps.FinishFrame(1);
+		heaps.ReleaseCompleted(1);
+		CHECK(heaps.GetAllocatedSize() == 0);
+	}
+
+	// Descs that come with an alignment of their own still take their real size in the
+	// heap, and a committed resource the device refuses isn't counted
+	{
+		ResourceHeapAllocator heaps;
+		CHECK(SUCCEEDED(heaps.Init(device.Get(), nullptr, 1024 * 1024)));
+
+		ID3D12Resource* buffers[3] = {};
+		for (ID3D12Resource*& buffer : buffers)
+		{
+			const CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(100000, D3D12_RESOURCE_FLAG_NONE,
+				D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+			CHECK(SUCCEEDED(heaps.CreateResource(desc, D3D12_RESOURCE_STATE_COMMON, nullptr, &buffer)));
+		}
+		CHECK(heaps.GetPlacedCount() == 3 && heaps.GetAllocatedSize() >= 3 * 100000);
+		bool disjoint = true;
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = a + 1; b < 3; b++)
+			{
+				if (!buffers[a] || !buffers[b])
+					continue;
+				const UINT64 first = buffers[a]->GetGPUVirtualAddress(), second = buffers[b]->GetGPUVirtualAddress();
+				disjoint &= first + 100000 <= second || second + 100000 <= first;
+			}
+		}
+		CHECK(disjoint);
+
+		ID3D12Resource* refused = nullptr;
+		const CD3DX12_RESOURCE_DESC bad = CD3DX12_RESOURCE_DESC::Buffer(~UINT64(0));
+		CHECK(FAILED(heaps.CreateResource(bad, D3D12_RESOURCE_STATE_COMMON, nullptr, &refused)));
+		CHECK(heaps.GetCommittedCount() == 0);
+
+		for (ID3D12Resource* buffer : buffers)
+		{
+			if (buffer)
+				heaps.Free(buffer);
+		}
+		heaps.FinishFrame(1);
+		heaps.ReleaseCompleted(1);
+		CHECK(heaps.GetAllocatedSize() == 0);
+	}
+
+	return TestResult();
+}
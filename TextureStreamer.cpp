@@ -0,0 +1,171 @@
+/**************************************************************
+	Texture Streamer
+**************************************************************/
+#include "TextureStreamer.h"
+
+namespace
+{
+	double Milliseconds(const TextureStreamer::Clock::time_point& from, const TextureStreamer::Clock::time_point& to)
+	{
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+}
+
+TextureStreamer::TextureStreamer(ID3D12Device* device, ResourceHeapAllocator* heaps, unsigned int workerCount)
+	: m_device(device), m_heaps(heaps), m_queued(0), m_stats(), m_workers(workerCount)
+{
+}
+
+std::future<TextureLoadResult> TextureStreamer::LoadAsync(const MappedFile::PathChar* fileName, size_t maxsize)
+{
+	Request* request = new Request();
+	request->FileName = fileName;
+	request->MaxSize = maxsize;
+	request->Result = S_OK;
+	request->FenceValue = 0;
+	request->Queued = Clock::now();
+
+	std::future<TextureLoadResult> future = request->Promise.get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queued++;
+	}
+	m_workers.Submit([this, request] { LoadAndParse(request); });
+
+	return future;
+}
+
+// Runs on a worker thread
+void TextureStreamer::LoadAndParse(Request* request)
+{
+	if (!request->File.Open(request->FileName.c_str()))
+	{
+		request->Result = HRESULT_FROM_WIN32(GetLastError());
+	}
+	request->Read = Clock::now();
+
+	if (SUCCEEDED(request->Result))
+	{
+		// Subresources point straight into the mapping, which stays open until
+		// the render thread has copied them into the upload heap
+		request->Result = DirectX::HResultFromDDSParseResult(DirectX::ParseDDSTexture(
+			request->File.Data(), request->File.Size(), request->MaxSize, request->Desc, request->Subresources));
+	}
+	request->Parsed = Clock::now();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_parsed.emplace_back(request);
+	m_queued--;
+}
+
+std::vector<std::unique_ptr<TextureStreamer::Request>> TextureStreamer::TakeParsed()
+{
+	std::vector<std::unique_ptr<Request>> parsed;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	parsed.swap(m_parsed);
+	return parsed;
+}
+
+HRESULT TextureStreamer::CreateTexture(Request& request)
+{
+	if (!m_heaps)
+		return DirectX::CreateDDSTextureResource12(m_device, request.Desc, request.Texture);
+
+	D3D12_RESOURCE_DESC desc;
+	HRESULT hr = DirectX::GetDDSResourceDesc12(request.Desc, &desc);
+	if (SUCCEEDED(hr))
+		hr = m_heaps->CreateResource(desc, D3D12_RESOURCE_STATE_COMMON, nullptr, request.Texture.ReleaseAndGetAddressOf());
+	return hr;
+}
+
+void TextureStreamer::Recorded(std::vector<std::unique_ptr<Request>>& parsed, UINT* recorded)
+{
+	for (std::unique_ptr<Request>& request : parsed)
+	{
+		// The bits are in staging memory now (or never will be), the file can go
+		request->Subresources.clear();
+		request->File.Close();
+
+		// Once the texture exists some of its copies may have been recorded, so even
+		// a failed one has to stay alive until the batch is done with it
+		if (!request->Texture)
+		{
+			Complete(request, request->Recorded);
+			continue;
+		}
+
+		m_recorded.push_back(std::move(request));
+		(*recorded)++;
+	}
+}
+
+void TextureStreamer::Submitted(UINT64 fenceValue)
+{
+	for (std::unique_ptr<Request>& request : m_recorded)
+	{
+		request->FenceValue = fenceValue;
+		m_inFlight.push_back(std::move(request));
+	}
+	m_recorded.clear();
+}
+
+void TextureStreamer::Update(UINT64 completedFenceValue)
+{
+	const Clock::time_point now = Clock::now();
+
+	for (size_t i = 0; i < m_inFlight.size();)
+	{
+		if (m_inFlight[i]->FenceValue <= completedFenceValue)
+		{
+			Complete(m_inFlight[i], now);
+			m_inFlight.erase(m_inFlight.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+void TextureStreamer::Complete(std::unique_ptr<Request>& request, const Clock::time_point& now)
+{
+	if (SUCCEEDED(request->Result))
+	{
+		m_stats.Read += Milliseconds(request->Queued, request->Read);
+		m_stats.Parse += Milliseconds(request->Read, request->Parsed);
+		m_stats.Record += Milliseconds(request->Parsed, request->Recorded);
+		m_stats.Gpu += Milliseconds(request->Recorded, now);
+		m_stats.Completed++;
+	}
+	else
+	{
+		m_stats.Failed++;
+	}
+
+	TextureLoadResult result;
+	result.Result = request->Result;
+	if (SUCCEEDED(request->Result))
+		result.Texture = request->Texture;
+	else if (request->Texture && m_heaps)
+		m_heaps->Free(request->Texture.Detach());		// Its range goes back to the heap
+	result.IsCubeMap = request->Desc.isCubeMap;
+	request->Promise.set_value(result);
+}
+
+bool TextureStreamer::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_queued == 0 && m_parsed.empty() && m_recorded.empty() && m_inFlight.empty();
+}
+
+std::string TextureStreamer::GetStatsString() const
+{
+	const double count = m_stats.Completed ? m_stats.Completed : 1.0;
+
+	return "Textures: " + std::to_string(m_stats.Completed) + " loaded, " + std::to_string(m_stats.Failed) + " failed"
+		+ " | avg ms read " + std::to_string(m_stats.Read / count)
+		+ ", parse " + std::to_string(m_stats.Parse / count)
+		+ ", record " + std::to_string(m_stats.Record / count)
+		+ ", gpu " + std::to_string(m_stats.Gpu / count) + "\n";
+}
@@ -0,0 +1,144 @@
+/**************************************************************
+	Texture Streamer
+
+	Loads DDS textures without blocking the render thread. Worker
+	threads map and parse the file, the render thread only records
+	the copies through the UploadManager, and the future is
+	completed once the copy fence of that batch is reached.
+
+		LoadAsync       any thread, queues the file
+		RecordUploads   render thread, once per frame
+		Submitted       render thread, with the fence the batch signals
+		Update          render thread, with the fence's completed value
+
+	With a ResourceHeapAllocator the textures are placed in its
+	heaps, otherwise each one is a committed resource.
+
+	RecordUploads takes anything with UploadManager's UploadTexture,
+	so the scheduling can be tested without a copy queue.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DDSParser.h"
+#include "DDSTextureLoader12.h"
+#include "MappedFile.h"
+#include "ResourceHeapAllocator.h"
+#include "UploadManager.h"
+#include "WorkerPool.h"
+
+struct TextureLoadResult
+{
+	HRESULT Result;
+	Microsoft::WRL::ComPtr<ID3D12Resource> Texture;
+	bool IsCubeMap;		// Needed for the SRV, D3D12 only sees a 2D array
+};
+
+class TextureStreamer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// Running totals for each stage a texture goes through, in milliseconds
+	struct StageStats
+	{
+		double Read;		// Queued -> file mapped (includes waiting for a worker)
+		double Parse;		// Mapped -> header and subresources parsed
+		double Record;		// Parsed -> upload recorded by the render thread
+		double Gpu;			// Recorded -> copy finished on the gpu
+		UINT Completed;
+		UINT Failed;
+	};
+
+	// 'heaps' can be null
+	TextureStreamer(ID3D12Device* device, ResourceHeapAllocator* heaps = nullptr, unsigned int workerCount = 0);
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	std::future<TextureLoadResult> LoadAsync(const MappedFile::PathChar* fileName, size_t maxsize = 0);
+
+	// Returns how many uploads were recorded. 'uploads' is an UploadManager or
+	// has the same UploadTexture.
+	template <typename UploadSink>
+	UINT RecordUploads(UploadSink& uploads);
+	void Submitted(UINT64 fenceValue);
+	void Update(UINT64 completedFenceValue);
+
+	bool IsIdle();
+	const StageStats& GetStats() const { return m_stats; }
+	std::string GetStatsString() const;
+
+private:
+	struct Request
+	{
+		std::basic_string<MappedFile::PathChar> FileName;
+		size_t MaxSize;
+		MappedFile File;
+		DirectX::DDSTextureDesc Desc;
+		std::vector<DirectX::DDSSubresource> Subresources;
+		HRESULT Result;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> Texture;
+		UINT64 FenceValue;
+		std::promise<TextureLoadResult> Promise;
+
+		Clock::time_point Queued, Read, Parsed, Recorded;
+	};
+
+	void LoadAndParse(Request* request);
+	std::vector<std::unique_ptr<Request>> TakeParsed();
+	HRESULT CreateTexture(Request& request);
+	void Recorded(std::vector<std::unique_ptr<Request>>& parsed, UINT* recorded);
+	void Complete(std::unique_ptr<Request>& request, const Clock::time_point& now);
+
+	ID3D12Device* m_device;
+	ResourceHeapAllocator* m_heaps;
+
+	std::mutex m_mutex;
+	UINT m_queued;										// Waiting for or running on a worker
+	std::vector<std::unique_ptr<Request>> m_parsed;		// Waiting for the render thread
+
+	// Only touched by the render thread
+	std::vector<std::unique_ptr<Request>> m_recorded;	// Waiting for Submitted()
+	std::vector<std::unique_ptr<Request>> m_inFlight;	// Waiting for their fence
+	StageStats m_stats;
+
+	// Declared last so the workers are joined before anything they use goes away
+	WorkerPool m_workers;
+};
+
+template <typename UploadSink>
+UINT TextureStreamer::RecordUploads(UploadSink& uploads)
+{
+	std::vector<std::unique_ptr<Request>> parsed = TakeParsed();
+
+	UINT recorded = 0;
+	for (std::unique_ptr<Request>& request : parsed)
+	{
+		if (SUCCEEDED(request->Result))
+			request->Result = CreateTexture(*request);
+		if (SUCCEEDED(request->Result))
+		{
+			std::vector<D3D12_SUBRESOURCE_DATA> initData(request->Subresources.size());
+			for (size_t i = 0; i < initData.size(); i++)
+			{
+				initData[i].pData = request->Subresources[i].data;
+				initData[i].RowPitch = static_cast<LONG_PTR>(request->Subresources[i].rowPitch);
+				initData[i].SlicePitch = static_cast<LONG_PTR>(request->Subresources[i].slicePitch);
+			}
+
+			request->Result = uploads.UploadTexture(request->Texture.Get(), initData.data(), static_cast<UINT>(initData.size()));
+		}
+		request->Recorded = Clock::now();
+	}
+
+	Recorded(parsed, &recorded);
+	return recorded;
+}
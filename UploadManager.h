@@ -0,0 +1,402 @@
+/**************************************************************
+	Upload Manager
+
+	Records copies on its own COPY queue so uploads never sit in
+	the direct command list. Everything copied here lands in a
+	DEFAULT heap. The source data is staged in a StagingPool whose
+	space is handed back once the copy fence has passed, only
+	subresources bigger than a whole staging block get an upload
+	heap of their own.
+
+	Resources are left in COMMON. Anything touched on a copy queue
+	decays back to COMMON once the copy is done, and the graphics
+	queue promotes them to whatever read state it needs on first
+	use, so no barriers are needed on either side. The graphics
+	queue just has to Wait() on the fence Submit() returned.
+
+	Given a ResourceHeapAllocator, buffers are placed in its heaps
+	instead of being committed resources of their own.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include <deque>
+#include <vector>
+#include "d3dx12.h"
+#include "ResourceHeapAllocator.h"
+#include "StagingPool.h"
+
+class UploadManager
+{
+public:
+	UploadManager()
+		: m_device(nullptr), m_heaps(nullptr), m_queue(nullptr), m_commandList(nullptr), m_allocator(nullptr),
+		m_fence(nullptr), m_fenceEvent(nullptr), m_fenceValue(0), m_recording(false),
+		m_bytesUploaded(0), m_submitCount(0), m_stallCount(0), m_dedicatedCount(0), m_dedicatedSize(0) { }
+
+	~UploadManager()
+	{
+		if (m_fence)
+		{
+			Flush();
+			ReleaseCompleted();
+		}
+
+		for (ID3D12Resource* resource : m_batchResources)
+			resource->Release();
+		for (PendingAllocator& pending : m_allocators)
+			pending.Allocator->Release();
+		if (m_allocator) m_allocator->Release();
+		if (m_commandList) m_commandList->Release();
+		if (m_fence) m_fence->Release();
+		if (m_queue) m_queue->Release();
+		if (m_fenceEvent) CloseHandle(m_fenceEvent);
+	}
+
+	UploadManager(const UploadManager&) = delete;
+	UploadManager& operator=(const UploadManager&) = delete;
+
+	// 'heaps' can be null
+	HRESULT Init(ID3D12Device* device, UINT64 stagingBlockSize, UINT stagingBlockCount, ResourceHeapAllocator* heaps = nullptr)
+	{
+		m_device = device;
+		m_heaps = heaps;
+		m_staging.Init(device, stagingBlockSize, stagingBlockCount);
+
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+		HRESULT hr = device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_queue));
+		if (FAILED(hr))
+			return hr;
+
+		hr = device->CreateFence(m_fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+		if (FAILED(hr))
+			return hr;
+
+		m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		if (!m_fenceEvent)
+			return HRESULT_FROM_WIN32(GetLastError());
+
+		return S_OK;
+	}
+
+	// The copy list for this batch, opened on first use. Anything recorded
+	// into it goes out with the next Submit().
+	ID3D12GraphicsCommandList* GetCommandList()
+	{
+		if (m_recording)
+			return m_commandList;
+
+		// Reuse the oldest allocator if the gpu is done with it
+		if (!m_allocators.empty() && m_allocators.front().FenceValue <= m_fence->GetCompletedValue())
+		{
+			m_allocator = m_allocators.front().Allocator;
+			m_allocators.pop_front();
+			m_allocator->Reset();
+		}
+		else if (FAILED(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_allocator))))
+		{
+			return nullptr;
+		}
+
+		if (!m_commandList)
+		{
+			if (FAILED(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_allocator, nullptr, IID_PPV_ARGS(&m_commandList))))
+				return nullptr;
+		}
+		else
+		{
+			m_commandList->Reset(m_allocator, nullptr);
+		}
+
+		m_recording = true;
+		return m_commandList;
+	}
+
+	// Creates a DEFAULT heap buffer and records a copy of 'data' into it
+	HRESULT CreateBuffer(const void* data, UINT64 size, ID3D12Resource** buffer)
+	{
+		HRESULT hr;
+		if (m_heaps)
+		{
+			hr = m_heaps->CreateResource(CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_COMMON, nullptr, buffer);
+		}
+		else
+		{
+			const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+			const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+			hr = m_device->CreateCommittedResource(
+				&heapProperties,
+				D3D12_HEAP_FLAG_NONE,
+				&bufferDesc,
+				D3D12_RESOURCE_STATE_COMMON,
+				nullptr,
+				IID_PPV_ARGS(buffer));
+		}
+		if (FAILED(hr))
+			return hr;
+
+		ID3D12Resource* uploadHeap = nullptr;
+		StagingAllocation staging;
+		if (size > m_staging.GetBlockSize())
+		{
+			hr = CreateUploadHeap(size, &uploadHeap);
+			if (SUCCEEDED(hr))
+			{
+				CD3DX12_RANGE readRange(0, 0);
+				hr = uploadHeap->Map(0, &readRange, reinterpret_cast<void**>(&staging.CpuAddress));
+				staging.Buffer = uploadHeap;
+				staging.Offset = 0;
+				m_dedicatedCount++;
+				m_dedicatedSize += size;
+			}
+		}
+		else if (!AllocateStaging(size, 256, &staging))
+		{
+			hr = E_OUTOFMEMORY;
+		}
+
+		// Fetched after the allocation, which may have had to submit the previous batch
+		ID3D12GraphicsCommandList* cmdList = SUCCEEDED(hr) ? GetCommandList() : nullptr;
+		if (cmdList)
+		{
+			memcpy(staging.CpuAddress, data, static_cast<size_t>(size));
+			cmdList->CopyBufferRegion(*buffer, 0, staging.Buffer, staging.Offset, size);
+			m_bytesUploaded += size;
+		}
+		else if (SUCCEEDED(hr))
+		{
+			hr = E_FAIL;
+		}
+
+		if (uploadHeap)
+		{
+			if (SUCCEEDED(hr))
+			{
+				uploadHeap->Unmap(0, nullptr);
+				KeepAlive(uploadHeap);
+			}
+			uploadHeap->Release();
+		}
+
+		if (FAILED(hr))
+		{
+			if (m_heaps)
+				m_heaps->Free(*buffer);
+			else
+				(*buffer)->Release();
+			*buffer = nullptr;
+		}
+		return hr;
+	}
+
+	// Records copies of every subresource of 'texture', which has to be in COMMON.
+	// Subresources are staged in runs that fit in one staging block, so a texture
+	// bigger than a block goes up in several chunks.
+	HRESULT UploadTexture(ID3D12Resource* texture, const D3D12_SUBRESOURCE_DATA* subresources, UINT subresourceCount)
+	{
+		const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+		const UINT64 blockSize = m_staging.GetBlockSize();
+
+		UINT first = 0;
+		while (first < subresourceCount)
+		{
+			UINT64 runSize = GetStagingSize(desc, first);
+			UINT count = 1;
+			while (first + count < subresourceCount)
+			{
+				const UINT64 next = runSize + GetStagingSize(desc, first + count);
+				if (next > blockSize)
+					break;
+				runSize = next;
+				count++;
+			}
+
+			ID3D12Resource* uploadHeap = nullptr;
+			StagingAllocation staging;
+			if (runSize > blockSize)
+			{
+				// A single subresource that doesn't fit anywhere, give it its own heap
+				const UINT64 heapSize = GetRequiredIntermediateSize(texture, first, 1);
+				HRESULT hr = CreateUploadHeap(heapSize, &uploadHeap);
+				if (FAILED(hr))
+					return hr;
+
+				staging.Buffer = uploadHeap;
+				staging.Offset = 0;
+				m_dedicatedCount++;
+				m_dedicatedSize += heapSize;
+			}
+			else if (!AllocateStaging(runSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &staging))
+			{
+				return E_OUTOFMEMORY;
+			}
+
+			ID3D12GraphicsCommandList* cmdList = GetCommandList();
+			if (!cmdList)
+			{
+				if (uploadHeap) uploadHeap->Release();
+				return E_FAIL;
+			}
+
+			const UINT64 copied = UpdateSubresources(cmdList, texture, staging.Buffer, staging.Offset, first, count,
+				const_cast<D3D12_SUBRESOURCE_DATA*>(subresources + first));
+
+			if (uploadHeap)
+			{
+				KeepAlive(uploadHeap);
+				uploadHeap->Release();
+			}
+
+			if (copied == 0)
+				return E_FAIL;
+
+			m_bytesUploaded += copied;
+			first += count;
+		}
+
+		return S_OK;
+	}
+
+	// Holds a reference to an upload heap until the batch it's used in is done
+	void KeepAlive(ID3D12Resource* uploadHeap)
+	{
+		uploadHeap->AddRef();
+		m_batchResources.push_back(uploadHeap);
+	}
+
+	// Closes and executes the current batch, returns the fence value it signals
+	// or the last one if there was nothing to submit.
+	UINT64 Submit()
+	{
+		if (!m_recording)
+			return m_fenceValue;
+
+		m_commandList->Close();
+		ID3D12CommandList* commandLists[] = { m_commandList };
+		m_queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+		m_queue->Signal(m_fence, ++m_fenceValue);
+
+		m_allocators.push_back({ m_fenceValue, m_allocator });
+		m_allocator = nullptr;
+		m_staging.FinishBatch(m_fenceValue);
+
+		for (ID3D12Resource* resource : m_batchResources)
+			m_pendingResources.push_back({ m_fenceValue, resource });
+		m_batchResources.clear();
+
+		m_recording = false;
+		m_submitCount++;
+		return m_fenceValue;
+	}
+
+	// Makes 'queue' wait on the gpu for the copies up to 'fenceValue', the cpu doesn't block
+	void GpuWait(ID3D12CommandQueue* queue, UINT64 fenceValue)
+	{
+		if (fenceValue > m_fence->GetCompletedValue())
+			queue->Wait(m_fence, fenceValue);
+	}
+
+	// Hands back the staging space and upload heaps of every batch the gpu has finished
+	void ReleaseCompleted()
+	{
+		const UINT64 completed = m_fence->GetCompletedValue();
+		m_staging.ReleaseCompleted(completed);
+		while (!m_pendingResources.empty() && m_pendingResources.front().FenceValue <= completed)
+		{
+			m_pendingResources.front().Resource->Release();
+			m_pendingResources.pop_front();
+		}
+	}
+
+	// Blocks the cpu until everything submitted so far is done
+	void Flush()
+	{
+		if (m_fence->GetCompletedValue() >= m_fenceValue)
+			return;
+
+		m_fence->SetEventOnCompletion(m_fenceValue, m_fenceEvent);
+		WaitForSingleObject(m_fenceEvent, INFINITE);
+	}
+
+	ID3D12CommandQueue* GetQueue() const { return m_queue; }
+	UINT64 GetCompletedFenceValue() const { return m_fence->GetCompletedValue(); }
+	UINT64 GetBytesUploaded() const { return m_bytesUploaded; }
+	UINT GetSubmitCount() const { return m_submitCount; }
+	UINT GetStallCount() const { return m_stallCount; }
+	UINT GetDedicatedCount() const { return m_dedicatedCount; }
+	UINT64 GetDedicatedSize() const { return m_dedicatedSize; }		// All of them together, not just the live ones
+	const StagingPool& GetStaging() const { return m_staging; }
+
+private:
+	HRESULT CreateUploadHeap(UINT64 size, ID3D12Resource** uploadHeap)
+	{
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+		return m_device->CreateCommittedResource(
+			&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(uploadHeap));
+	}
+
+	// If the pool is full, pushes out the current batch and waits for the gpu to
+	// give some space back. Only happens when more is in flight than the pool holds.
+	bool AllocateStaging(UINT64 size, UINT64 alignment, StagingAllocation* staging)
+	{
+		if (m_staging.Allocate(size, alignment, staging))
+			return true;
+
+		Submit();
+		Flush();
+		ReleaseCompleted();
+		m_stallCount++;
+
+		return m_staging.Allocate(size, alignment, staging);
+	}
+
+	// Upper bound of what one subresource takes up in the staging buffer
+	UINT64 GetStagingSize(const D3D12_RESOURCE_DESC& desc, UINT subresource)
+	{
+		UINT64 size = 0;
+		m_device->GetCopyableFootprints(&desc, subresource, 1, 0, nullptr, nullptr, nullptr, &size);
+		return RingAllocator::AlignUp(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	}
+
+	struct PendingAllocator
+	{
+		UINT64 FenceValue;
+		ID3D12CommandAllocator* Allocator;
+	};
+
+	struct PendingResource
+	{
+		UINT64 FenceValue;
+		ID3D12Resource* Resource;
+	};
+
+	ID3D12Device* m_device;
+	ResourceHeapAllocator* m_heaps;
+	ID3D12CommandQueue* m_queue;
+	ID3D12GraphicsCommandList* m_commandList;
+	ID3D12CommandAllocator* m_allocator;			// The one m_commandList is recording into
+	std::deque<PendingAllocator> m_allocators;		// Submitted, oldest first
+
+	ID3D12Fence* m_fence;
+	HANDLE m_fenceEvent;
+	UINT64 m_fenceValue;
+	bool m_recording;
+
+	std::vector<ID3D12Resource*> m_batchResources;		// Used by the batch being recorded
+	std::deque<PendingResource> m_pendingResources;		// Submitted, oldest first
+
+	StagingPool m_staging;
+
+	UINT64 m_bytesUploaded;
+	UINT m_submitCount;
+	UINT m_stallCount;			// Times we had to wait on the gpu for staging space
+	UINT m_dedicatedCount;		// Subresources too big for the pool
+	UINT64 m_dedicatedSize;
+};
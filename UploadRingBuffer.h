@@ -0,0 +1,74 @@
+/**************************************************************
+	Upload Ring Buffer
+
+	A single upload heap buffer that stays mapped for the life of
+	the app, with a RingAllocator deciding which part of it each
+	draw gets to write into.
+**************************************************************/
+#pragma once
+#include <d3d12.h>
+#include "d3dx12.h"
+#include "RingAllocator.h"
+
+class UploadRingBuffer
+{
+public:
+	UploadRingBuffer() : m_buffer(nullptr), m_mappedData(nullptr) { }
+
+	HRESULT Init(ID3D12Device* device, UINT64 size)
+	{
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+		HRESULT hr = device->CreateCommittedResource(
+			&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&m_buffer));
+		if (FAILED(hr))
+			return hr;
+
+		// We never read this memory back on the cpu
+		CD3DX12_RANGE readRange(0, 0);
+		hr = m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedData));
+		if (FAILED(hr))
+			return hr;
+
+		m_ring.Reset(size);
+		return S_OK;
+	}
+
+	// Reserves 'size' bytes and returns where the cpu should write them, or
+	// nullptr if every slice is still in use by the gpu.
+	void* Allocate(UINT64 size, UINT64 alignment, D3D12_GPU_VIRTUAL_ADDRESS* gpuAddress)
+	{
+		const UINT64 offset = m_ring.Allocate(size, alignment);
+		if (offset == RingAllocator::InvalidOffset)
+			return nullptr;
+
+		*gpuAddress = m_buffer->GetGPUVirtualAddress() + offset;
+		return m_mappedData + offset;
+	}
+
+	// Reserves a slice and copies 'data' into it in one go
+	D3D12_GPU_VIRTUAL_ADDRESS Upload(const void* data, UINT64 size, UINT64 alignment)
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+		void* cpuAddress = Allocate(size, alignment, &gpuAddress);
+		if (cpuAddress)
+			memcpy(cpuAddress, data, static_cast<size_t>(size));
+		return gpuAddress;
+	}
+
+	void FinishFrame(UINT64 fenceValue) { m_ring.FinishFrame(fenceValue); }
+	void ReleaseCompletedFrames(UINT64 completedFenceValue) { m_ring.ReleaseCompletedFrames(completedFenceValue); }
+
+	ID3D12Resource* GetResource() const { return m_buffer; }
+	const RingAllocator& GetRing() const { return m_ring; }
+
+private:
+	ID3D12Resource* m_buffer;
+	UINT8* m_mappedData;
+	RingAllocator m_ring;
+};
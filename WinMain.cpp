@@ -10,20 +10,27 @@
 #include <dxgi1_4.h>		// For DirectX Graphics Infrastructure Objects
 #include "d3dx12.h"			// Extensions of D3D12
 #include <d3dcompiler.h>	// Compiling Shaders
-#include <DirectXMath.h>	// For World Transforms and Lighting
-#include <DirectXColors.h>	// For Light Colors
-#include <ctime>			
-#include <array>
+#include <cstdio>
 #include <string>
-#include "DDSTextureLoader.h"	// Loading Textures (see example 08)
+#include <vector>
+#include "CubeScene.h"				// The cubes, their textures and everything a frame records
+#include "UploadManager.h"		// Copy queue for static geometry and textures
+#include "ResourceHeapAllocator.h"	// Buffers and textures placed in shared heaps
+#include "ShaderCache.h"				// Compiled shaders kept on disk between runs
+#include "PipelineCache.h"			// Pipeline states deduplicated and kept in a pipeline library
+#include "ShaderPermutations.h"		// One shader compiled for every combination of its defines
+#include "DrawBinding.h"			// Ways of getting each draw's data to the vertex shader
+#include "FrameLoop.h"				// Waiting for, submitting and presenting each frame in flight
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxguid.lib")
 #define ThrowIfFailed(hr) if (!SUCCEEDED(hr)) { DebugBreak(); } 
 #define BUFFERCOUNT 3
-#define cos_radians(x) cos(DirectX::XMConvertToRadians(x))
-#define sin_radians(y) sin(DirectX::XMConvertToRadians(y))
+#define STAGINGBLOCKSIZE (4 * 1024 * 1024)	// Upload space shared by every copy on the copy queue
+#define STAGINGBLOCKCOUNT 4
+#define HEAPBLOCKSIZE (64 * 1024 * 1024)	// Default heap memory buffers and textures are placed in
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -37,8 +44,85 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hwnd, msg, wParam, lParam);
 }
 
+// What the frame loop runs on here: the window's messages and the swap chain, or
+// offscreen targets and a fixed number of frames when headless. Keys pressed since
+// the last frame are left for the update to act on.
+struct Win32Platform
+{
+	IDXGISwapChain1* SwapChain = nullptr;	// Null when headless
+	UINT64 FrameLimit = 0;					// 0 runs until the window closes
+	UINT64 Presented = 0;
+	std::vector<WPARAM> Keys;
+
+	bool PumpMessages()
+	{
+		bool quit = FrameLimit && Presented >= FrameLimit;
+
+		MSG msg = { 0 };
+		while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+		{
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+
+			if (msg.message == WM_QUIT || (msg.message == WM_KEYDOWN && msg.wParam == 27))
+				quit = true;
+			else if (msg.message == WM_KEYDOWN)
+				Keys.push_back(msg.wParam);
+		}
+		return !quit;
+	}
+
+	void Present()
+	{
+		if (SwapChain)
+			ThrowIfFailed(SwapChain->Present(1, 0));
+		Presented++;
+	}
+};
+
 int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int mCmdShow)
 {
+	// "-headless N" renders N frames on the WARP device into offscreen targets, with
+	// no visible window and no swap chain, then prints the cpu cost of each phase.
+	// A smoke test for machines without a usable gpu, not a cpu baseline: WARP runs
+	// the "gpu" on the same cores, so the numbers move with it. Cpu regressions in
+	// the frame loop and the scene (CubeScene.h) are measured on the null device, see
+	// Tests/FrameLoopTest.cpp.
+	// The same scene drawn on the cpu rasterizer is SoftwareMain.cpp.
+	UINT m_headlessFrames = 0;
+	if (const char* headlessArg = strstr(lpCmdLine, "-headless"))
+	{
+		m_headlessFrames = (UINT)atoi(headlessArg + strlen("-headless"));
+		if (m_headlessFrames == 0)
+			m_headlessFrames = 1000;
+	}
+
+	const bool m_bHeadless = m_headlessFrames > 0;
+
+	// "-threads N" records the draws on N threads (including this one), one per core by default
+	UINT m_recordThreads = 0;
+	if (const char* threadsArg = strstr(lpCmdLine, "-threads"))
+		m_recordThreads = (UINT)atoi(threadsArg + strlen("-threads"));
+
+	// Every frame is captured into a compact command stream unless "-nocapture" is
+	// given. "-replay N" replays the last one N times at the end of a headless run and
+	// saves it to frame.cap, so a change can be measured on exactly the same commands.
+	const bool m_bCapture = strstr(lpCmdLine, "-nocapture") == nullptr;
+	UINT m_replayFrames = 0;
+	if (const char* replayArg = strstr(lpCmdLine, "-replay"))
+	{
+		m_replayFrames = (UINT)atoi(replayArg + strlen("-replay"));
+		if (m_replayFrames == 0)
+			m_replayFrames = 1000;
+	}
+
+	// "-binding N" picks how the one-draw-per-cube path binds each draw's data, see
+	// DrawBinding.h: 0 root constants, 1 root CBV (the default), 2 structured buffer.
+	// 'B' cycles through them.
+	DrawBinding m_drawBinding = DRAW_BINDING_ROOT_CBV;
+	if (const char* bindingArg = strstr(lpCmdLine, "-binding"))
+		m_drawBinding = (DrawBinding)(atoi(bindingArg + strlen("-binding")) % DRAW_BINDING_COUNT);
+
 	WNDCLASS wc = { 0 };
 	wc.lpfnWndProc = WndProc;
 	wc.lpszClassName = "hw3d";
@@ -51,44 +135,73 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	HWND hwnd = CreateWindow("hw3d", "D3D12 App - Lights! Camera! Action!", WS_CAPTION | WS_SYSMENU | WS_SIZEBOX | WS_MINIMIZEBOX | WS_MAXIMIZEBOX,
 		100, 100, 800, 600, nullptr, nullptr, hInstance, nullptr);
 
-	ShowWindow(hwnd, mCmdShow);
+	if (!m_bHeadless)
+		ShowWindow(hwnd, mCmdShow);
 
 	// Init D3D
 	IDXGISwapChain1* m_dxgiSwapChain;
 	IDXGIFactory2* m_dxgiFactory;
 	ID3D12Device* m_device;
 	ID3D12CommandQueue* m_commandQueue;
-	ID3D12CommandAllocator* m_commandAllocator;
-	ID3D12GraphicsCommandList* m_commandList;
-	ID3D12Fence* m_fence;
-	HANDLE m_fenceEvent;
-	UINT64 m_iCurrentFence = 0;
 
-	// Render target
-	ID3D12DescriptorHeap* m_rtvDescHeap;
-	UINT m_iCurrentFrameIndex = 2;
+	// One context per back buffer so the cpu can record frame N+1 while the gpu
+	// is still working on frame N, see FrameLoop.h
+	struct FrameContext
+	{
+		ID3D12CommandAllocator* CommandAllocator;
+	};
+	Win32Platform m_platform;
+	FrameLoop<Win32Platform, FrameContext, BUFFERCOUNT> m_frameLoop;
+
+	// Buffers and textures are placed in a few big heaps instead of getting one each
+	ResourceHeapAllocator m_resourceHeaps;
+
+	// Static data goes to default heaps through a copy queue of its own
+	UploadManager m_uploads;
+
+	// Render target (offscreen ones stand in for the swap chain when headless)
+	ID3D12Resource* m_offscreenTargets[BUFFERCOUNT] = {};
+	ID3D12Resource* m_backBuffers[BUFFERCOUNT] = {};
 
 	// Triangle
 	ID3D12PipelineState* m_pipelineState;
 	ID3D12RootSignature* m_rootSignature;
 	ID3DBlob* m_rootSignatureBlob;
-	ID3D12Resource* m_vertexBuffer;
-	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-	ID3D12Resource* m_indexBuffer;
-	D3D12_INDEX_BUFFER_VIEW m_indexBufferView;
-
-	// Constant Buffer
-	ID3D12Resource* m_cbvResource[2];
 
 	ThrowIfFailed(CreateDXGIFactory(IID_PPV_ARGS(&m_dxgiFactory)));
 
-	ThrowIfFailed(D3D12CreateDevice(0, D3D_FEATURE_LEVEL_12_1, IID_PPV_ARGS(&m_device)));
+	if (m_bHeadless)
+	{
+		IDXGIFactory4* factory4;
+		IDXGIAdapter* warpAdapter;
+		ThrowIfFailed(m_dxgiFactory->QueryInterface(IID_PPV_ARGS(&factory4)));
+		ThrowIfFailed(factory4->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
+		ThrowIfFailed(D3D12CreateDevice(warpAdapter, D3D_FEATURE_LEVEL_12_1, IID_PPV_ARGS(&m_device)));
+		warpAdapter->Release();
+		factory4->Release();
+	}
+	else
+	{
+		ThrowIfFailed(D3D12CreateDevice(0, D3D_FEATURE_LEVEL_12_1, IID_PPV_ARGS(&m_device)));
+	}
 
 	D3D12_COMMAND_QUEUE_DESC cmdQueueDesc = {};
 	cmdQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
 	ThrowIfFailed(m_device->CreateCommandQueue(&cmdQueueDesc, IID_PPV_ARGS(&m_commandQueue)));
 
+	// The adapter the device ended up on, for its memory budget
+	IDXGIFactory4* factory4;
+	IDXGIAdapter3* adapter;
+	ThrowIfFailed(m_dxgiFactory->QueryInterface(IID_PPV_ARGS(&factory4)));
+	ThrowIfFailed(factory4->EnumAdapterByLuid(m_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)));
+	ThrowIfFailed(m_resourceHeaps.Init(m_device, adapter, HEAPBLOCKSIZE));
+	m_resourceHeaps.RecordTrace(m_bHeadless);
+	adapter->Release();
+	factory4->Release();
+
+	ThrowIfFailed(m_uploads.Init(m_device, STAGINGBLOCKSIZE, STAGINGBLOCKCOUNT, &m_resourceHeaps));
+
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
 	swapChainDesc.BufferCount = BUFFERCOUNT;
 	swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -96,134 +209,65 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	swapChainDesc.SampleDesc.Count = 1;
 	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 
-	ThrowIfFailed(m_dxgiFactory->CreateSwapChainForHwnd(
-		m_commandQueue,
-		hwnd,
-		&swapChainDesc,
-		0,
-		0,
-		&m_dxgiSwapChain
-	));
-
-	ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocator)));
-
-	ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator, 0, IID_PPV_ARGS(&m_commandList)));
-	m_commandList->Close();
-
-	ThrowIfFailed(m_device->CreateFence(m_iCurrentFence, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-	m_fenceEvent = CreateEvent(0, 0, 0, 0);
-
-	D3D12_DESCRIPTOR_HEAP_DESC rtvDescHeap = {};
-	rtvDescHeap.NumDescriptors = BUFFERCOUNT;
-	rtvDescHeap.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-
-	ThrowIfFailed(m_device->CreateDescriptorHeap(&rtvDescHeap, IID_PPV_ARGS(&m_rtvDescHeap)));
-
-	CD3DX12_CPU_DESCRIPTOR_HANDLE m_rtvHeapHandle(m_rtvDescHeap->GetCPUDescriptorHandleForHeapStart());
-
-	for (UINT frame = 0; frame < BUFFERCOUNT; frame++)
+	m_dxgiSwapChain = nullptr;
+	if (m_bHeadless)
 	{
-		ID3D12Resource* pBackBuffer;
-		ThrowIfFailed(m_dxgiSwapChain->GetBuffer(frame, IID_PPV_ARGS(&pBackBuffer)));
-
-		m_device->CreateRenderTargetView(
-			pBackBuffer,
-			0,
-			m_rtvHeapHandle
-		);
-		m_rtvHeapHandle.Offset(1, m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV));
+		// Same size and format as the swap chain would have. They start out in
+		// PRESENT (COMMON) too, so they go through the same transitions.
+		D3D12_CLEAR_VALUE targetClear = {};
+		targetClear.Format = swapChainDesc.Format;
+		targetClear.Color[2] = 0.2f;
+		targetClear.Color[3] = 1.0f;
+
+		for (UINT frame = 0; frame < BUFFERCOUNT; frame++)
+		{
+			ThrowIfFailed(m_device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+				D3D12_HEAP_FLAG_NONE,
+				&CD3DX12_RESOURCE_DESC::Tex2D(swapChainDesc.Format, 800, 600, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
+				D3D12_RESOURCE_STATE_PRESENT,
+				&targetClear,
+				IID_PPV_ARGS(&m_offscreenTargets[frame])));
+		}
 	}
-	struct Light
+	else
 	{
-		DirectX::XMFLOAT4 Position;
-		DirectX::XMFLOAT4 Color;
-	};
-
-	struct ConstantBuffer
-	{
-		DirectX::XMMATRIX World;
-		DirectX::XMMATRIX Model;
-
-		Light light;
-
-		DirectX::XMFLOAT4 Eye;
-	};
-	UINT s = sizeof(ConstantBuffer);
-
-	OutputDebugString((std::to_string(s)).c_str());
-
-	ConstantBuffer cBuffer;
-	 
-	// 4-Component vectors representing our view matrix info
-	DirectX::XMFLOAT4 Eye = DirectX::XMFLOAT4(0.0f, 0.0f, -2.0f, 1.0f );
-	DirectX::XMFLOAT4 Focus = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
-	DirectX::XMFLOAT4 Up = DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
-
-	// 3D Model matrix
-	DirectX::XMMATRIX Model = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f);
-
-	// 3D View matrix
-	DirectX::XMMATRIX View = DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat4(&Eye), DirectX::XMLoadFloat4(&Focus), DirectX::XMLoadFloat4(&Up));
-
-	// 3D Projection matrix
-	DirectX::XMMATRIX Proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(45.0f), 4.0f / 3.0f, 0.1f, 300.0f);
-
-	cBuffer.World = DirectX::XMMatrixTranspose(Model * View * Proj);
-	//cBuffer.Color = DirectX::Colors::LightBlue;
-	cBuffer.light.Position = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
-	cBuffer.light.Color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	
-	// Fill out a decscriptor heap with our data and attach it to 
-	// the root signature so we can use it in our shaders.
-	const UINT cBufferSize = sizeof(cBuffer);
-
-	for (UINT i = 0; i < 2; i++)
-	{
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(256U),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
+		ThrowIfFailed(m_dxgiFactory->CreateSwapChainForHwnd(
+			m_commandQueue,
+			hwnd,
+			&swapChainDesc,
+			0,
 			0,
-			IID_PPV_ARGS(&m_cbvResource[i])
+			&m_dxgiSwapChain
 		));
-		void* data;
-		m_cbvResource[i]->Map(0, 0, reinterpret_cast<void**>(&data));
-		CopyMemory(data, &cBuffer, cBufferSize);
-		m_cbvResource[i]->Unmap(0, nullptr);
-
 	}
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_srvResource;
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_srvResourceUpload;
-	CD3DX12_STATIC_SAMPLER_DESC m_samplerState;
-	ID3D12DescriptorHeap* m_srvHeap;
 
-	m_commandList->Reset(m_commandAllocator, nullptr);
+	m_platform.SwapChain = m_bHeadless ? nullptr : m_dxgiSwapChain;
+	m_platform.FrameLimit = m_headlessFrames;
+	ThrowIfFailed(m_frameLoop.Init(m_device, m_commandQueue, &m_platform));
 
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(
-		m_device,
-		m_commandList,
-		L"checkboard.dds",
-		m_srvResource,
-		m_srvResourceUpload
-	));
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = { };
-	srvHeapDesc.NumDescriptors = 1;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-	ThrowIfFailed(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap)));
-
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc;
-	ZeroMemory(&shaderResourceViewDesc, sizeof(D3D12_SHADER_RESOURCE_VIEW_DESC));
+	for (UINT frame = 0; frame < BUFFERCOUNT; frame++)
+	{
+		m_backBuffers[frame] = m_offscreenTargets[frame];
+		if (!m_bHeadless)
+			ThrowIfFailed(m_dxgiSwapChain->GetBuffer(frame, IID_PPV_ARGS(&m_backBuffers[frame])));
+	}
 
-	shaderResourceViewDesc.Format = m_srvResource->GetDesc().Format;
-	shaderResourceViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	shaderResourceViewDesc.Texture2D.MipLevels = m_srvResource->GetDesc().MipLevels;
-	shaderResourceViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	// Everything drawn from here on, see CubeScene.h. The textures start loading on
+	// the scene's workers now, while the shaders and pipelines below are built.
+	CubeSceneSettings m_sceneSettings;
+	m_sceneSettings.MaterialFiles[0] = L"checkboard.dds";
+	m_sceneSettings.MaterialFiles[1] = L"bricks.dds";
+	m_sceneSettings.RecordThreads = m_recordThreads;
+	m_sceneSettings.Capture = m_bCapture;
+	m_sceneSettings.Log = [](const char* text) { OutputDebugString(text); };
+	CubeScene m_scene;
+	ThrowIfFailed(m_scene.Init(m_device, m_commandQueue, m_frameLoop[0].CommandAllocator, m_backBuffers, BUFFERCOUNT, &m_uploads,
+		&m_resourceHeaps, m_sceneSettings));
+	m_scene.SetDrawBinding(m_drawBinding);
 
-	m_device->CreateShaderResourceView(m_srvResource.Get(), &shaderResourceViewDesc, m_srvHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_STATIC_SAMPLER_DESC m_samplerState;
+	CD3DX12_STATIC_SAMPLER_DESC m_upscaleSamplerState;
 
 	m_samplerState.Init(
 		0, // shaderRegister
@@ -233,26 +277,134 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 		D3D12_TEXTURE_ADDRESS_MODE_WRAP
 	);
 
-	CD3DX12_ROOT_PARAMETER slotParameters[2];
+	// Bilinear for stretching the scene over the back buffer
+	m_upscaleSamplerState.Init(
+		1,
+		D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP
+	);
+	const D3D12_STATIC_SAMPLER_DESC staticSamplers[] = { m_samplerState, m_upscaleSamplerState };
+
+	CD3DX12_ROOT_PARAMETER slotParameters[3];
 	
 	CD3DX12_DESCRIPTOR_RANGE srvRange;
-	srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+	srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1);		// Unbounded, t0 onwards in space1
 
 
 	slotParameters[0].InitAsConstantBufferView(0);
 	slotParameters[1].InitAsDescriptorTable(1, &srvRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotParameters[2].InitAsShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);	// Instance data
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
-	rootSignatureDesc.Init(_countof(slotParameters), slotParameters, 1, &m_samplerState, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+	rootSignatureDesc.Init(_countof(slotParameters), slotParameters, _countof(staticSamplers), staticSamplers, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 	
 	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &m_rootSignatureBlob, 0));
 	
 	ThrowIfFailed(m_device->CreateRootSignature(0, m_rootSignatureBlob->GetBufferPointer(), 
 		m_rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
+
+	// The same again plus a parameter for each draw's InstanceData, one per DrawBinding
+	ID3D12RootSignature* m_drawRootSignatures[DRAW_BINDING_COUNT];
+	ID3DBlob* m_drawRootSignatureBlobs[DRAW_BINDING_COUNT];
+	CD3DX12_ROOT_PARAMETER drawParameters[DrawBindingParameter + 1];
+	for (UINT parameter = 0; parameter < _countof(slotParameters); parameter++)
+		drawParameters[parameter] = slotParameters[parameter];
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+	{
+		if (binding == DRAW_BINDING_ROOT_CONSTANTS)
+			drawParameters[DrawBindingParameter].InitAsConstants(DrawRootConstantCount, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+		else if (binding == DRAW_BINDING_ROOT_CBV)
+			drawParameters[DrawBindingParameter].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+		else
+			drawParameters[DrawBindingParameter].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);	// Index into the instance buffer
+
+		rootSignatureDesc.Init(_countof(drawParameters), drawParameters, _countof(staticSamplers), staticSamplers, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+		ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &m_drawRootSignatureBlobs[binding], 0));
+		ThrowIfFailed(m_device->CreateRootSignature(0, m_drawRootSignatureBlobs[binding]->GetBufferPointer(),
+			m_drawRootSignatureBlobs[binding]->GetBufferSize(), IID_PPV_ARGS(&m_drawRootSignatures[binding])));
+	}
 	
-	ID3DBlob* vs, *ps;
-	ThrowIfFailed(D3DCompileFromFile(L"Shaders.hlsl", 0, 0, "VSMain", "vs_5_0", 0, 0, &vs, 0));
-	ThrowIfFailed(D3DCompileFromFile(L"Shaders.hlsl", 0, 0, "PSMain", "ps_5_0", 0, 0, &ps, 0));
+	ID3DBlob* vsInstanced, *ps, *vsUpscale, *psUpscale;
+	// The build's DXIL is used when there is some (see ShaderBuild.cpp), otherwise only
+	// shaders whose source, includes or compile settings changed since the last run are
+	// compiled, the rest are read back from the ShaderCache directory. The first run
+	// after a change shows what startup costs without either.
+	ShaderCache m_shaderCache;
+	LARGE_INTEGER shaderFrequency, shaderStart, shaderEnd;
+	QueryPerformanceFrequency(&shaderFrequency);
+	QueryPerformanceCounter(&shaderStart);
+
+	// 5.1 for the unbounded texture array
+	ThrowIfFailed(m_shaderCache.Compile(L"Shaders.hlsl", nullptr, "VSMainInstanced", "vs_5_1", 0, &vsInstanced));
+	ThrowIfFailed(m_shaderCache.Compile(L"Shaders.hlsl", nullptr, "PSMain", "ps_5_1", 0, &ps));
+	ThrowIfFailed(m_shaderCache.Compile(L"Shaders.hlsl", nullptr, "VSUpscale", "vs_5_1", 0, &vsUpscale));
+	ThrowIfFailed(m_shaderCache.Compile(L"Shaders.hlsl", nullptr, "PSUpscale", "ps_5_1", 0, &psUpscale));
+
+	// VSMain once per DrawBinding
+	ID3DBlob* m_drawVertexShaders[DRAW_BINDING_COUNT];
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+	{
+		const std::string bindingValue = std::to_string(binding);
+		const D3D_SHADER_MACRO bindingDefines[] = { { "BINDING", bindingValue.c_str() }, { nullptr, nullptr } };
+		ThrowIfFailed(m_shaderCache.Compile(L"Shaders.hlsl", bindingDefines, "VSMain", "vs_5_1", 0, &m_drawVertexShaders[binding]));
+	}
+
+	// PSMain for every combination of what a material can ask for, see Shaders.hlsl
+	ShaderPermutations m_pixelShaders;
+	AddPixelShaderOptions(m_pixelShaders);
+	ThrowIfFailed(m_pixelShaders.Compile(m_shaderCache, L"Shaders.hlsl", "PSMain", "ps_5_1", 0));
+
+	// Also on stdout, so a run redirected to a file can be compared with ShaderBuild's compile time
+	QueryPerformanceCounter(&shaderEnd);
+	const std::string shaderReport = "Shaders: " + std::to_string(m_shaderCache.GetPrebuiltCount()) + " prebuilt, "
+		+ std::to_string(m_shaderCache.GetHitCount()) + " from the cache, " + std::to_string(m_shaderCache.GetMissCount()) + " compiled, "
+		+ std::to_string(1000.0 * (shaderEnd.QuadPart - shaderStart.QuadPart) / shaderFrequency.QuadPart) + " ms\n";
+	OutputDebugString(shaderReport.c_str());
+	std::printf("%s", shaderReport.c_str());
+	std::fflush(stdout);
+	for (uint32_t key = 0; key < m_pixelShaders.GetPermutationCount(); key++)
+	{
+		const ShaderPermutations::Variant& variant = m_pixelShaders.GetVariant(key);
+		OutputDebugString(("  PSMain " + m_pixelShaders.GetName(key) + ": " + std::to_string(variant.InstructionCount) + " instructions, "
+			+ std::to_string(variant.TempRegisterCount) + " temps\n").c_str());
+	}
+
+	// What each material needs from PSMain. Where half precision is good enough the
+	// cheaper of the two variants is used, the checkerboard's hard edges show banding
+	// in the specular so it stays at full precision.
+	struct MaterialShading
+	{
+		bool Texture;
+		bool Specular;
+		UINT LightCount;
+		bool AllowHalfPrecision;
+	};
+	const MaterialShading m_materialShading[MATERIALCOUNT] = { { true, true, 1, false }, { true, false, 1 + FILLLIGHTCOUNT, true } };
+
+	auto PickPixelShader = [&](const MaterialShading& shading)
+	{
+		const uint32_t values[] = { 0, shading.Texture, shading.Specular, shading.LightCount };
+		const uint32_t fullPrecision = m_pixelShaders.GetKey(values);
+		const uint32_t candidates[] = { fullPrecision, m_pixelShaders.WithValue(fullPrecision, PIXEL_SHADER_HALF_PRECISION, 1) };
+		return m_pixelShaders.GetCheapest(candidates, shading.AllowHalfPrecision ? 2 : 1);
+	};
+
+	// An instanced draw mixes every material, so it gets everything any of them asks for
+	uint32_t m_materialPixelShaders[MATERIALCOUNT];
+	MaterialShading instancedShading = { false, false, 1, true };
+	for (UINT material = 0; material < MATERIALCOUNT; material++)
+	{
+		const MaterialShading& shading = m_materialShading[material];
+		m_materialPixelShaders[material] = PickPixelShader(shading);
+		instancedShading.Texture |= shading.Texture;
+		instancedShading.Specular |= shading.Specular;
+		instancedShading.LightCount = shading.LightCount > instancedShading.LightCount ? shading.LightCount : instancedShading.LightCount;
+		instancedShading.AllowHalfPrecision &= shading.AllowHalfPrecision;
+		OutputDebugString(("Material " + std::to_string(material) + ": PSMain " + m_pixelShaders.GetName(m_materialPixelShaders[material]) + "\n").c_str());
+	}
+	const uint32_t m_instancedPixelShader = PickPixelShader(instancedShading);
 	
 	D3D12_INPUT_ELEMENT_DESC inputLayoutDesc[] =
 	{
@@ -261,57 +413,13 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 20, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
 	};
 
-	// Depth Stencil Resources:
-	ID3D12DescriptorHeap* m_dsvHeap;
-	ID3D12Resource* m_depthStencilResource;
-
-	D3D12_DESCRIPTOR_HEAP_DESC depthStencilHeap = {};
-	depthStencilHeap.NumDescriptors = 1;
-	depthStencilHeap.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-
-	ThrowIfFailed(m_device->CreateDescriptorHeap(&depthStencilHeap, IID_PPV_ARGS(&m_dsvHeap)));
-
-	{
-		DXGI_FORMAT mDepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		// Create the depth/stencil buffer and view.
-		D3D12_RESOURCE_DESC depthStencilDesc = {};
-		depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		depthStencilDesc.Width = 800;
-		depthStencilDesc.Height = 600;
-		depthStencilDesc.DepthOrArraySize = 1;
-		depthStencilDesc.MipLevels = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
-		depthStencilDesc.SampleDesc.Count = 1;
-		depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-		D3D12_CLEAR_VALUE optClear;
-		optClear.Format = mDepthStencilFormat;
-		optClear.DepthStencil.Depth = 1.0f;
-		optClear.DepthStencil.Stencil = 0;
-
-		ThrowIfFailed(m_device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			&depthStencilDesc,
-			D3D12_RESOURCE_STATE_COMMON,
-			&optClear,
-			IID_PPV_ARGS(&m_depthStencilResource)));
-
-		// Create descriptor to mip level 0 of entire resource using the format of the resource.
-		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-		dsvDesc.Format = mDepthStencilFormat;
-		dsvDesc.Texture2D.MipSlice = 0;
-		m_device->CreateDepthStencilView(m_depthStencilResource, &dsvDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-	}
 	D3D12_RASTERIZER_DESC rasterizerDesc = {};
 	rasterizerDesc.AntialiasedLineEnable = true;			// Anti-Aliasing turned on
 	rasterizerDesc.CullMode = D3D12_CULL_MODE_BACK;			// Back face culling
 	rasterizerDesc.FillMode = D3D12_FILL_MODE_SOLID;	// Wire frame primitive instead of solid
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = { 0 };
-	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vs);
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vsInstanced);
 	psoDesc.PS = CD3DX12_SHADER_BYTECODE(ps);
 	psoDesc.pRootSignature = m_rootSignature;
 	psoDesc.SampleDesc.Count = 1;
@@ -324,295 +432,210 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 	psoDesc.InputLayout = { inputLayoutDesc, _countof(inputLayoutDesc) };
 	psoDesc.NumRenderTargets = 1;
+
+	// Pipeline states go through the cache, asking twice for the same state gives the
+	// same PSO, and ones compiled in an earlier run are loaded from pipelines.bin
+	PipelineCache m_pipelineCache;
+	ThrowIfFailed(m_pipelineCache.Init(m_device, L"pipelines.bin"));
+	m_pipelineCache.RegisterRootSignature(m_rootSignature, m_rootSignatureBlob);
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
+		m_pipelineCache.RegisterRootSignature(m_drawRootSignatures[binding], m_drawRootSignatureBlobs[binding]);
+	LARGE_INTEGER pipelineStart, pipelineEnd;
+	QueryPerformanceCounter(&pipelineStart);
 	
-	ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
-	
-	struct Vertex 
+	// The generic PSMain, what every material draws with until its own is ready. One
+	// per DrawBinding, the vertex shader and root signature differ.
+	ID3D12PipelineState* m_drawPipelineStates[DRAW_BINDING_COUNT];
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC drawDescs[DRAW_BINDING_COUNT];
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
 	{
-		DirectX::XMFLOAT3 Position;
-		DirectX::XMFLOAT2 TexCoord;
-		DirectX::XMFLOAT3 Normal;
-
-		Vertex(float px, float py, float pz, float u, float v, float nx, float ny, float nz) 
-			: Position(px, py, pz), TexCoord(u, v), Normal(nx, ny, nz) { }
+		drawDescs[binding] = psoDesc;
+		drawDescs[binding].VS = CD3DX12_SHADER_BYTECODE(m_drawVertexShaders[binding]);
+		drawDescs[binding].pRootSignature = m_drawRootSignatures[binding];
+		ThrowIfFailed(m_pipelineCache.Create(drawDescs[binding], &m_drawPipelineStates[binding]));
+	}
 
-		Vertex() { }
+	// Lists start out with this one, every draw sets the PSO it needs anyway
+	m_pipelineState = m_drawPipelineStates[DRAW_BINDING_ROOT_CBV];
 
-	};
+	// The instanced path keeps the base root signature, all its draw data is in the instance buffer
+	ID3D12PipelineState* m_instancedPipelineState;
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedDesc = psoDesc;
 
-	// Frank luna and hooman used the std::array so I'm following in their
-	// footsteps :)
-	std::array<Vertex, 24> vertices;
-	// Fill in the front face vertex data.
-	vertices[0] =  Vertex(-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f);
-	vertices[1] =  Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-	vertices[2] =  Vertex(+0.5f, +0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-	vertices[3] =  Vertex(+0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, 0.0f, -1.0f);
-														   
-	vertices[4] =  Vertex(-0.5f, -0.5f, +0.5f, 1.0f, 1.0f, 0.0f, 0.0f, +1.0f);
-	vertices[5] =  Vertex(+0.5f, -0.5f, +0.5f, 0.0f, 1.0f, 0.0f, 0.0f, +1.0f);
-	vertices[6] =  Vertex(+0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, 0.0f, +1.0f);
-	vertices[7] =  Vertex(-0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, 0.0f, +1.0f);
-														  
-	vertices[8] =  Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 1.0f, 0.0f, +1.0f, 0.0f);
-	vertices[9] =  Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 0.0f, +1.0f, 0.0f);
-	vertices[10] = Vertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, +1.0f, 0.0f);
-	vertices[11] = Vertex(+0.5f, +0.5f, -0.5f, 1.0f, 1.0f, 0.0f, +1.0f, 0.0f);
-														   
-	vertices[12] = Vertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f, -1.0f, 0.0f);
-	vertices[13] = Vertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f);
-	vertices[14] = Vertex(+0.5f, -0.5f, +0.5f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f);
-	vertices[15] = Vertex(-0.5f, -0.5f, +0.5f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f);
-														  
-	vertices[16] = Vertex(-0.5f, -0.5f, +0.5f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-	vertices[17] = Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-	vertices[18] = Vertex(-0.5f, +0.5f, -0.5f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-	vertices[19] = Vertex(-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-														  
-	vertices[20] = Vertex(+0.5f, -0.5f, -0.5f, 0.0f, 1.0f, +1.0f, 0.0f, 0.0f);
-	vertices[21] = Vertex(+0.5f, +0.5f, -0.5f, 0.0f, 0.0f, +1.0f, 0.0f, 0.0f);
-	vertices[22] = Vertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, +1.0f, 0.0f, 0.0f);
-	vertices[23] = Vertex(+0.5f, -0.5f, +0.5f, 1.0f, 1.0f, +1.0f, 0.0f, 0.0f);
-
-	std::array<std::uint16_t, 36> indices;
-	// Fill in the front face index data
-	indices[0] = 0; indices[1] = 1; indices[2] = 2;
-	indices[3] = 0; indices[4] = 2; indices[5] = 3;
-
-	// Fill in the back face index data
-	indices[6] = 4; indices[7] = 5; indices[8] = 6;
-	indices[9] = 4; indices[10] = 6; indices[11] = 7;
-
-	// Fill in the top face index data
-	indices[12] = 8; indices[13] = 9; indices[14] = 10;
-	indices[15] = 8; indices[16] = 10; indices[17] = 11;
-
-	// Fill in the bottom face index data
-	indices[18] = 12; indices[19] = 13; indices[20] = 14;
-	indices[21] = 12; indices[22] = 14; indices[23] = 15;
-
-	// Fill in the left face index data
-	indices[24] = 16; indices[25] = 17; indices[26] = 18;
-	indices[27] = 16; indices[28] = 18; indices[29] = 19;
-
-	// Fill in the right face index data
-	indices[30] = 20; indices[31] = 21; indices[32] = 22;
-	indices[33] = 20; indices[34] = 22; indices[35] = 23;
-
-	const UINT vBufferSize = sizeof(Vertex) * std::size(vertices);
-	const UINT iBufferSize = sizeof(std::uint16_t) * std::size(indices);
+	ThrowIfFailed(m_pipelineCache.Create(instancedDesc, &m_instancedPipelineState));
 
-	
-	ThrowIfFailed(m_device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(vBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		0,
-		IID_PPV_ARGS(&m_vertexBuffer)));
-	
-	void* data2;
-	CD3DX12_RANGE readRange(0, 0);
-	m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&data2));
-	CopyMemory(data2, &vertices, sizeof(vertices));
-	m_vertexBuffer->Unmap(0, nullptr);
-	
-	m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-	m_vertexBufferView.SizeInBytes = vBufferSize;
-	m_vertexBufferView.StrideInBytes = sizeof(Vertex);	
-
-	ThrowIfFailed(m_device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(iBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&m_indexBuffer)
-	));
-
-	void* data3;
-	CD3DX12_RANGE readRange2;
-	m_indexBuffer->Map(0, &readRange2, reinterpret_cast<void**>(&data3));
-	CopyMemory(data3, &indices, iBufferSize);
-
-	m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
-	m_indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	m_indexBufferView.SizeInBytes = iBufferSize;
-
-	D3D12_VIEWPORT viewPort = {};
-	viewPort.TopLeftX = 0;
-	viewPort.TopLeftY = 0;
-	viewPort.Width = 800;
-	viewPort.Height = 600;
-	viewPort.MinDepth = 0.0f;
-	viewPort.MaxDepth = 1.0f;
-
-	CD3DX12_RECT scissorsRect = {};
-	scissorsRect.left = 0;
-	scissorsRect.top = 0;
-	scissorsRect.right = 800;
-	scissorsRect.bottom = 600;
-
-	MSG msg = { 0 };
-	bool quit = false;
-	srand((unsigned)time(NULL));
-
-	DirectX::XMVECTOR RandomColors[20] = 
+	// PSOs with the PSMain variants the materials picked are compiled on worker
+	// threads, so the first frame doesn't wait for them. Draws use the generic ones
+	// above until the scene swaps them in at the start of a frame. The fallbacks go
+	// in the capture table first so a draw still using one finds the fallback's own
+	// id, see CubeScene::RequestPipeline.
+	CaptureObjectTable& m_captureObjects = m_scene.GetCaptureObjects();
+	m_captureObjects.Register(m_rootSignature);
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
 	{
-		DirectX::Colors::Blue,
-		DirectX::Colors::DarkGreen,
-		DirectX::Colors::Aqua,
-		DirectX::Colors::Gold,
-		DirectX::Colors::MediumPurple,
-
-		DirectX::Colors::Lavender,
-		DirectX::Colors::Lavender,
-		DirectX::Colors::DarkTurquoise,
-		DirectX::Colors::DarkTurquoise,
-		DirectX::Colors::Cyan,
-		
-		DirectX::Colors::ForestGreen,
-		DirectX::Colors::Wheat,
-		DirectX::Colors::Plum,
-		DirectX::Colors::Tomato,
-		DirectX::Colors::Silver,
-
-		DirectX::Colors::OrangeRed,
-		DirectX::Colors::Violet,
-		DirectX::Colors::RoyalBlue,
-		DirectX::Colors::LimeGreen,
-		DirectX::Colors::Bisque
+		m_captureObjects.Register(m_drawRootSignatures[binding]);
+		m_captureObjects.Register(m_drawPipelineStates[binding]);	// m_pipelineState is one of them
+	}
+	m_captureObjects.Register(m_instancedPipelineState);
 
+	auto RequestPipeline = [&](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3D12PipelineState* fallback)
+	{
+		return m_scene.RequestPipeline(fallback, [&m_pipelineCache, desc]
+		{
+			ID3D12PipelineState* pipelineState = nullptr;
+			m_pipelineCache.Create(desc, &pipelineState);
+			return pipelineState;
+		});
 	};
-	int index[2] = { 0, 9 };
-	int random = 0;
-	
-	float pitch = 30.0f;
-	float yaw = -90.0f;
 
-	while (!quit)
+	CubeScenePipelines m_pipelines = {};
+	m_pipelines.RootSignature = m_rootSignature;
+	m_pipelines.InitialState = m_pipelineState;
+	for (UINT binding = 0; binding < DRAW_BINDING_COUNT; binding++)
 	{
-		// Our descriptor heap already knows the location of our constant buffer.
-		// So we don't have to re-create the constant buffer view or descriptor heap for it.
-		// This is the benefit of using DirectX 12!
-		
-		//yaw += 1.0f;
-		//pitch += 1.0f;
-		//
-		// Outer camera
-		Eye.x = 5.0f * (cos_radians(yaw) * cos_radians(pitch));
-		Eye.y = 5.0f * (sin_radians(pitch));			   
-		Eye.z = 5.0f * (sin_radians(yaw) * cos_radians(pitch)); 
-
-		cBuffer.Eye = Eye;
-
-		if (m_iCurrentFence % 60 == 0)
+		m_pipelines.DrawRootSignatures[binding] = m_drawRootSignatures[binding];
+		for (UINT material = 0; material < MATERIALCOUNT; material++)
 		{
-			index[0] = (index[0] + 1) % _countof(RandomColors);
-			index[1] = (index[1] + 1) % _countof(RandomColors);
+			drawDescs[binding].PS = m_pixelShaders.GetBytecode(m_materialPixelShaders[material]);
+			m_pipelines.MaterialPipelines[binding][material] = RequestPipeline(drawDescs[binding], m_drawPipelineStates[binding]);
 		}
-
-		// Camera eye position, Camera eye focus position, Camera orientation
-		View = DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat4(&Eye), DirectX::XMLoadFloat4(&Focus), DirectX::XMLoadFloat4(&Up));
-
-		cBuffer.World = DirectX::XMMatrixTranspose(Model * View * Proj);
-
-		// After one second, change the color of our box.
-		// Work: 1 fence passed per frame * 60 fps = 60.
-			
-		while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+	}
+	instancedDesc.PS = m_pixelShaders.GetBytecode(m_instancedPixelShader);
+	m_pipelines.InstancedPipeline = RequestPipeline(instancedDesc, m_instancedPipelineState);
+
+	// A full screen triangle made up in the vertex shader, no input and no depth
+	ID3D12PipelineState* m_upscalePipelineState;
+	psoDesc.VS = CD3DX12_SHADER_BYTECODE(vsUpscale);
+	psoDesc.PS = CD3DX12_SHADER_BYTECODE(psUpscale);
+	psoDesc.InputLayout = { nullptr, 0 };
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	psoDesc.DepthStencilState.DepthEnable = false;
+
+	ThrowIfFailed(m_pipelineCache.Create(psoDesc, &m_upscalePipelineState));
+	m_captureObjects.Register(m_upscalePipelineState);
+	m_pipelines.UpscaleState = m_upscalePipelineState;
+	m_scene.SetPipelines(m_pipelines);
+
+	QueryPerformanceCounter(&pipelineEnd);
+	if (FAILED(m_pipelineCache.Save()))
+		OutputDebugString("Couldn't write pipelines.bin\n");
+	OutputDebugString(("Pipelines: " + std::to_string(m_pipelineCache.GetLoadedCount()) + " from the library, "
+		+ std::to_string(m_pipelineCache.GetCompiledCount()) + " compiled, " + std::to_string(m_pipelineCache.GetDedupedCount())
+		+ " deduplicated, " + std::to_string(1000.0 * (pipelineEnd.QuadPart - pipelineStart.QuadPart) / shaderFrequency.QuadPart) + " ms"
+		+ (m_pipelineCache.HasLibrary() ? "\n" : ", no pipeline library on this device\n")).c_str());
+	
+	// Wait for the scene's copies, so every frame context starts out idle
+	m_frameLoop.Signal();
+	m_frameLoop.Flush();
+
+	// Cpu time spent blocked on the fence, reported once a second so we can see
+	// how much the frame ring saves compared to waiting on every frame. The frame
+	// loop keeps the time of each phase over the whole run, printed when a headless
+	// run ends.
+	LARGE_INTEGER m_frequency;
+	QueryPerformanceFrequency(&m_frequency);
+	double m_reportedWaitSeconds = 0.0;
+
+	// The frame loop waits for the slot, times each phase, executes what the record
+	// step hands back, presents and signals, see FrameLoop.h. The scene does the rest.
+	auto UpdateFrame = [&](FrameContext&, UINT64 completedFence)
+	{
+		// 'I' switches between one draw per cube and a single instanced draw, 'B' cycles
+		// the draw bindings and 'R' switches dynamic resolution off and on
+		for (WPARAM key : m_platform.Keys)
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-
-			switch (msg.message)
-			{
-			case WM_QUIT:
-				quit = true;
-				break;
-			case WM_KEYDOWN:
-				if (msg.wParam == 27)
-					quit = true;
-				break;
-			}
+			if (key == 'I')
+				m_scene.SetInstanced(!m_scene.IsInstanced());
+			else if (key == 'B')
+				m_scene.SetDrawBinding((DrawBinding)((m_scene.GetDrawBinding() + 1) % DRAW_BINDING_COUNT));
+			else if (key == 'R')
+				m_scene.SetDynamicResolution(!m_scene.IsDynamicResolution());
 		}
-		m_commandAllocator->Reset();
-		m_commandList->Reset(m_commandAllocator, m_pipelineState);
-
-		m_iCurrentFrameIndex = (m_iCurrentFrameIndex + 1) % BUFFERCOUNT;
-
-		// Point our cpu handle to the memory address of the first desriptor
-		m_rtvHeapHandle = m_rtvDescHeap->GetCPUDescriptorHandleForHeapStart();
-
-		// Now off set the cpu to whatever frame index we are at
-		// simple math: (render target view size * currentFrameIndex)
-		m_rtvHeapHandle.Offset(1, m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) * m_iCurrentFrameIndex);
-		
-		m_commandList->OMSetRenderTargets(1, &m_rtvHeapHandle, false, &m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-
-		float clear_color[4] = { 0.0f, 0.0f, 0.2f, 1.0f };
-		m_commandList->ClearRenderTargetView(m_rtvHeapHandle, clear_color, 0, 0);
-		m_commandList->ClearDepthStencilView(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(),
-			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-
-		m_commandList->SetGraphicsRootSignature(m_rootSignature);
-		m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-		m_commandList->IASetIndexBuffer(&m_indexBufferView);
-		m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		m_commandList->RSSetScissorRects(1, &scissorsRect);
-		m_commandList->RSSetViewports(1, &viewPort);
-
-		m_commandList->SetDescriptorHeaps(1, &m_srvHeap);
-		m_commandList->SetGraphicsRootDescriptorTable(1, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
-		
-		{
-			Model = DirectX::XMMatrixRotationY(0.0f) *
-				DirectX::XMMatrixTranslation(2.0f*cos(DirectX::XMConvertToRadians((float)m_iCurrentFence+180.0f)), 0.0f, 2.0f*sin(DirectX::XMConvertToRadians((float)m_iCurrentFence + 180.0f)));
+		m_platform.Keys.clear();
 
-			cBuffer.Model = DirectX::XMMatrixTranspose(Model);
-			cBuffer.World = DirectX::XMMatrixTranspose(Model * View * Proj);
+		ThrowIfFailed(m_scene.Update(m_frameLoop.GetIndex(), completedFence));
+	};
 
+	// Closed lists go into m_submitLists, main first, then chunk by chunk, then the present list
+	auto RecordFrame = [&](FrameContext& frame, std::vector<ID3D12CommandList*>& m_submitLists)
+	{
+		ThrowIfFailed(m_scene.Record(m_frameLoop.GetIndex(), frame.CommandAllocator, m_submitLists));
+	};
 
-			void* data4;
-			m_cbvResource[0]->Map(0, 0, reinterpret_cast<void**>(&data4));
-			CopyMemory(data4, &cBuffer, cBufferSize);
-			m_cbvResource[0]->Unmap(0, nullptr);
+	auto FinishFrame = [&](UINT64 fenceValue)
+	{
+		m_scene.Finish(fenceValue);
 
-			m_commandList->SetGraphicsRootConstantBufferView(0, m_cbvResource[0]->GetGPUVirtualAddress());
-			m_commandList->DrawIndexedInstanced(std::size(indices), 1, 0, 0, 0);
-		}
+		if (m_scene.GetFrameCount() % 60 == 0)
 		{
+			const double waitMs = 1000.0 * (m_frameLoop.GetWaitSeconds() - m_reportedWaitSeconds);
+			OutputDebugString(("Fence wait: " + std::to_string(waitMs / 60.0) + " ms/frame\n").c_str());
+			m_reportedWaitSeconds = m_frameLoop.GetWaitSeconds();
+		}
+	};
 
-			Model = DirectX::XMMatrixRotationY(0.0f) *
-				DirectX::XMMatrixTranslation(2.0f*cos(DirectX::XMConvertToRadians((float)m_iCurrentFence)), 0.0f, 2.0f*sin(DirectX::XMConvertToRadians((float)m_iCurrentFence)));
-
-			cBuffer.Model = DirectX::XMMatrixTranspose(Model);
-			cBuffer.World = DirectX::XMMatrixTranspose(Model * View * Proj);
-
-			DirectX::XMStoreFloat4(&cBuffer.light.Color, RandomColors[index[1]]);
-			void* data4;
-			m_cbvResource[1]->Map(0, 0, reinterpret_cast<void**>(&data4));
-			CopyMemory(data4, &cBuffer, cBufferSize);
-			m_cbvResource[1]->Unmap(0, nullptr);
+	while (m_frameLoop.RunFrame(UpdateFrame, RecordFrame, FinishFrame))
+	{
+	}
 
-			m_commandList->SetGraphicsRootConstantBufferView(0, m_cbvResource[1]->GetGPUVirtualAddress());
-			m_commandList->DrawIndexedInstanced(std::size(indices), 1, 0, 0, 0);
+	const UINT64 m_iFrameCount = m_scene.GetFrameCount();
+	if (m_bHeadless && m_iFrameCount)
+	{
+		typedef decltype(m_frameLoop) Win32FrameLoop;
+		double totalMs = 0.0;
+		for (UINT phase = 0; phase < Win32FrameLoop::PHASE_COUNT; phase++)
+		{
+			const double phaseMs = 1000.0 * m_frameLoop.GetPhaseSeconds(Win32FrameLoop::Phase(phase));
+			totalMs += phaseMs;
+			OutputDebugString((std::string(Win32FrameLoop::GetPhaseName(Win32FrameLoop::Phase(phase))) + ": " + std::to_string(phaseMs / m_iFrameCount) + " ms/frame\n").c_str());
 		}
-		m_commandList->Close();
+		OutputDebugString(("Headless: " + std::to_string(m_iFrameCount) + " frames, " + std::to_string(totalMs / m_iFrameCount) + " ms/frame cpu\n").c_str());
+		OutputDebugString(m_scene.GetStatsString(m_frameLoop.GetPhaseSeconds(Win32FrameLoop::PHASE_RECORD)).c_str());
+
+		OutputDebugString(("Resource heaps: " + std::to_string(m_resourceHeaps.GetBlockCount()) + " blocks, "
+			+ std::to_string(m_resourceHeaps.GetAllocatedSize() / 1024) + " KB used of " + std::to_string(m_resourceHeaps.GetHeapSize() / 1024) + " KB, "
+			+ std::to_string(m_resourceHeaps.GetPlacedCount()) + " placed, " + std::to_string(m_resourceHeaps.GetCommittedCount()) + " committed, "
+			+ std::to_string(m_resourceHeaps.GetOverBudgetCount()) + " blocks cut short by the budget\n").c_str());
+		// Replayed by AllocationTraceBenchmark
+		if (!SaveAllocationTrace("allocations.trace", m_resourceHeaps.GetTrace()))
+			OutputDebugString("Couldn't write allocations.trace\n");
+	}
 
-		ID3D12CommandList* commandLists[] = { m_commandList };
-		m_commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+	// Replays are timed from the list reset to its Close, the same span as the
+	// record phase above, so the two numbers compare directly
+	const std::vector<uint8_t>& m_frameCapture = m_scene.GetFrameCapture();
+	if (m_bHeadless && m_replayFrames && !m_frameCapture.empty())
+	{
+		if (!SaveFrameCapture("frame.cap", m_frameCapture))
+			OutputDebugString("Couldn't write frame.cap\n");
 
-		m_commandQueue->Signal(m_fence, m_iCurrentFence);
-		if (m_fence->GetCompletedValue() < m_iCurrentFence)
+		LONGLONG replayTicks = 0;
+		for (UINT replay = 0; replay < m_replayFrames; replay++)
 		{
-			ThrowIfFailed(m_fence->SetEventOnCompletion(m_iCurrentFence, m_fenceEvent));
-			WaitForSingleObject(m_fenceEvent, INFINITE);
+			FrameContext& frame = m_frameLoop.Begin();
+
+			LARGE_INTEGER replayStart, replayEnd;
+			QueryPerformanceCounter(&replayStart);
+			ThrowIfFailed(m_scene.Replay(frame.CommandAllocator, m_frameLoop.GetCompletedFenceValue()));
+			QueryPerformanceCounter(&replayEnd);
+			replayTicks += replayEnd.QuadPart - replayStart.QuadPart;
+
+			ID3D12CommandList* replayLists[] = { m_scene.GetCommandList() };
+			m_scene.FinishReplay(m_frameLoop.Submit(_countof(replayLists), replayLists, false));
 		}
-		m_iCurrentFence++;
 
-		ThrowIfFailed(m_dxgiSwapChain->Present(1, 0));
+		const double replayMs = 1000.0 * replayTicks / m_frequency.QuadPart;
+		OutputDebugString(("Replay: " + std::to_string(m_replayFrames) + " frames of " + std::to_string(m_frameCapture.size()) + " bytes, "
+			+ std::to_string(replayMs / m_replayFrames) + " ms/frame cpu\n").c_str());
 	}
 
+	// Drain the frames and copies still in flight before tearing down.
+	m_uploads.Flush();
+	m_frameLoop.Flush();
+
+	// Specialized PSOs compiled since startup go into the library for the next run
+	if (FAILED(m_pipelineCache.Save()))
+		OutputDebugString("Couldn't write pipelines.bin\n");
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**************************************************************
+	Worker Pool
+
+	A fixed set of threads pulling jobs off a shared queue. Only
+	uses the standard library so anything built on it can run
+	without a device.
+**************************************************************/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned int threadCount = 0)
+		: m_pending(0), m_quit(false)
+	{
+		if (threadCount == 0)
+		{
+			// Leave one core for the render thread
+			const unsigned int cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			m_threads.emplace_back([this] { WorkerLoop(); });
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(std::move(job));
+			m_pending++;
+		}
+		m_wake.notify_one();
+	}
+
+	// Blocks until every job submitted so far has finished running
+	void WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this] { return m_pending == 0; });
+	}
+
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+	void WorkerLoop()
+	{
+		for (;;)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+				if (m_jobs.empty())
+					return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_pending == 0)
+					m_idle.notify_all();
+			}
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	std::deque<std::function<void()>> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_idle;
+	size_t m_pending;
+	bool m_quit;
+};